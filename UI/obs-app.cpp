@@ -2094,6 +2094,15 @@ bool WindowPositionValid(QRect rect)
 	return false;
 }
 
+static bool log_leaked_tags(void *, const struct bmem_tag_stats *stats)
+{
+	if (stats->allocs)
+		blog(LOG_INFO, "    %s: %llu leaked allocations (%llu bytes)",
+		     stats->tag, (unsigned long long)stats->allocs,
+		     (unsigned long long)stats->bytes);
+	return true;
+}
+
 static inline bool arg_is(const char *arg, const char *long_form,
 			  const char *short_form)
 {
@@ -2425,6 +2434,9 @@ int main(int argc, char *argv[])
 		} else if (arg_is(argv[i], "--allow-opengl", nullptr)) {
 			opt_allow_opengl = true;
 
+		} else if (arg_is(argv[i], "--track-memory", nullptr)) {
+			bmem_enable_tracking(true);
+
 		} else if (arg_is(argv[i], "--help", "-h")) {
 			std::cout
 				<< "--help, -h: Get list of available commands.\n\n"
@@ -2443,6 +2455,7 @@ int main(int argc, char *argv[])
 				<< "--always-on-top: Start in 'always on top' mode.\n\n"
 				<< "--unfiltered_log: Make log unfiltered.\n\n"
 				<< "--allow-opengl: Allow OpenGL on Windows.\n\n"
+				<< "--track-memory: Track memory usage by module.\n\n"
 				<< "--version, -V: Get current version.\n";
 
 			exit(0);
@@ -2472,6 +2485,8 @@ int main(int argc, char *argv[])
 	int ret = run_program(logFile, argc, argv);
 
 	blog(LOG_INFO, "Number of memory leaks: %ld", bnum_allocs());
+	if (bmem_tracking_enabled())
+		bmem_enum_tags(log_leaked_tags, nullptr);
 	base_set_log_handler(nullptr, nullptr);
 	return ret;
 }
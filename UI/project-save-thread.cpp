@@ -0,0 +1,182 @@
+#include "project-save-thread.hpp"
+
+#include <util/threading.h>
+#include <util/platform.h>
+#include <util/base.h>
+
+#include <vector>
+
+using namespace std;
+
+void SourceSaveCache::Begin()
+{
+	generation++;
+	saved = 0;
+	reserialized = 0;
+}
+
+OBSData SourceSaveCache::Save(obs_source_t *source)
+{
+	long serial = obs_source_get_save_serial(source);
+	auto it = entries.find(source);
+
+	saved++;
+
+	if (it != entries.end() && it->second.serial == serial) {
+		it->second.generation = generation;
+		return it->second.data;
+	}
+
+	obs_data_t *data = obs_save_source(source);
+	obs_data_t *snapshot = obs_data_create();
+	obs_data_apply(snapshot, data);
+	obs_data_release(data);
+
+	Entry &entry = entries[source];
+	entry.serial = serial;
+	entry.data = snapshot;
+	entry.generation = generation;
+	obs_data_release(snapshot);
+
+	reserialized++;
+	return entry.data;
+}
+
+obs_data_array_t *SourceSaveCache::SaveSources(obs_save_source_filter_cb cb,
+					       void *param)
+{
+	struct EnumData {
+		obs_save_source_filter_cb cb;
+		void *param;
+		vector<OBSSource> sources;
+	} enumData = {cb, param, {}};
+
+	/* use the same set of sources (and order) that libobs would save,
+	 * but save them through the cache */
+	obs_data_array_t *unused = obs_save_sources_filtered(
+		[](void *data, obs_source_t *source) {
+			EnumData &enumData = *static_cast<EnumData *>(data);
+			if (enumData.cb(enumData.param, source))
+				enumData.sources.emplace_back(source);
+			return false;
+		},
+		&enumData);
+	obs_data_array_release(unused);
+
+	obs_data_array_t *array = obs_data_array_create();
+	for (obs_source_t *source : enumData.sources) {
+		OBSData data = Save(source);
+		obs_data_array_push_back(array, data);
+	}
+
+	return array;
+}
+
+void SourceSaveCache::End()
+{
+	for (auto it = entries.begin(); it != entries.end();) {
+		if (it->second.generation != generation)
+			it = entries.erase(it);
+		else
+			++it;
+	}
+}
+
+ProjectSaveThread::ProjectSaveThread()
+{
+	thread = std::thread([this]() { Thread(); });
+}
+
+ProjectSaveThread::~ProjectSaveThread()
+{
+	{
+		unique_lock<mutex> lock(m);
+		stopping = true;
+	}
+
+	cv.notify_one();
+	thread.join();
+
+	if (coalesced)
+		blog(LOG_INFO, "Scene collection saves coalesced: %zu",
+		     coalesced);
+}
+
+void ProjectSaveThread::Queue(obs_data_t *data, const char *path,
+			      uint64_t snapshotTime, size_t sources,
+			      size_t reserialized)
+{
+	{
+		unique_lock<mutex> lock(m);
+
+		/* a newer snapshot always contains everything the pending
+		 * one did, so the pending one doesn't need to be written */
+		if (hasPending)
+			coalesced++;
+
+		pending.data = data;
+		pending.path = path;
+		pending.snapshotTime = snapshotTime;
+		pending.sources = sources;
+		pending.reserialized = reserialized;
+		hasPending = true;
+	}
+
+	cv.notify_one();
+}
+
+void ProjectSaveThread::Flush()
+{
+	unique_lock<mutex> lock(m);
+	idleCV.wait(lock, [this]() { return !hasPending && !writing; });
+}
+
+void ProjectSaveThread::Write(Job &job)
+{
+	uint64_t startTime = os_gettime_ns();
+	const char *file = job.path.c_str();
+
+	if (!obs_data_save_json_safe(job.data, file, "tmp", "bak"))
+		blog(LOG_ERROR, "Could not save scene data to %s", file);
+
+	uint64_t writeTime = os_gettime_ns() - startTime;
+
+	blog(LOG_DEBUG,
+	     "Saved scene collection (%zu sources, %zu re-serialized): "
+	     "snapshot %.2f ms, encode/write %.2f ms",
+	     job.sources, job.reserialized,
+	     double(job.snapshotTime) / 1000000.0,
+	     double(writeTime) / 1000000.0);
+}
+
+void ProjectSaveThread::Thread()
+{
+	os_set_thread_name("project save thread");
+
+	for (;;) {
+		Job job;
+
+		{
+			unique_lock<mutex> lock(m);
+			cv.wait(lock,
+				[this]() { return hasPending || stopping; });
+
+			if (!hasPending)
+				break;
+
+			job = std::move(pending);
+			pending = Job();
+			hasPending = false;
+			writing = true;
+		}
+
+		Write(job);
+
+		{
+			unique_lock<mutex> lock(m);
+			writing = false;
+		}
+
+		idleCV.notify_all();
+	}
+}
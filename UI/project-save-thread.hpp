@@ -0,0 +1,71 @@
+#pragma once
+
+#include <obs.hpp>
+#include <condition_variable>
+#include <unordered_map>
+#include <string>
+#include <thread>
+#include <mutex>
+
+/* Keeps a snapshot of the saved data of each source, which is only
+ * re-generated when the source's save serial changes.  Snapshots are never
+ * modified once created, so they can be shared with the save thread. */
+class SourceSaveCache {
+	struct Entry {
+		long serial;
+		OBSData data;
+		uint64_t generation;
+	};
+
+	std::unordered_map<obs_source_t *, Entry> entries;
+	uint64_t generation = 0;
+
+public:
+	size_t saved = 0;
+	size_t reserialized = 0;
+
+	void Begin();
+	OBSData Save(obs_source_t *source);
+	obs_data_array_t *SaveSources(obs_save_source_filter_cb cb,
+				      void *param);
+	void End();
+
+	inline void Clear() { entries.clear(); }
+};
+
+/* Encodes and writes scene collection snapshots on a separate thread.  The
+ * snapshot must not be modified after it is queued.  If saves are queued
+ * faster than they can be written, only the most recent one is written. */
+class ProjectSaveThread {
+	struct Job {
+		OBSData data;
+		std::string path;
+		uint64_t snapshotTime = 0;
+		size_t sources = 0;
+		size_t reserialized = 0;
+	};
+
+	std::thread thread;
+	std::condition_variable cv;
+	std::condition_variable idleCV;
+	std::mutex m;
+
+	Job pending;
+	bool hasPending = false;
+	bool writing = false;
+	bool stopping = false;
+	size_t coalesced = 0;
+
+	void Thread();
+	void Write(Job &job);
+
+public:
+	ProjectSaveThread();
+	~ProjectSaveThread();
+
+	void Queue(obs_data_t *data, const char *path, uint64_t snapshotTime,
+		   size_t sources, size_t reserialized);
+
+	/* waits until everything that was queued has been written */
+	void Flush();
+};
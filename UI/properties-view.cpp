@@ -29,6 +29,7 @@
 #include "properties-view.moc.hpp"
 #include "obs-app.hpp"
 
+#include <algorithm>
 #include <cstdlib>
 #include <initializer_list>
 #include <string>
@@ -98,12 +99,381 @@ void OBSPropertiesView::ReloadProperties()
 
 #define NO_PROPERTIES_STRING QTStr("Basic.PropertiesWindow.NoProperties")
 
+static inline void AppendState(string &state, const char *str)
+{
+	if (str)
+		state += str;
+	state += '\x1f';
+}
+
+template<typename T> static inline void AppendState(string &state, T val)
+{
+	state += to_string(val);
+	state += '\x1f';
+}
+
+static void AppendListState(string &state, obs_property_t *prop)
+{
+	obs_combo_format format = obs_property_list_format(prop);
+	size_t count = obs_property_list_item_count(prop);
+
+	AppendState(state, (int)obs_property_list_type(prop));
+	AppendState(state, (int)format);
+	AppendState(state, count);
+
+	for (size_t i = 0; i < count; i++) {
+		AppendState(state, obs_property_list_item_name(prop, i));
+		AppendState(state, obs_property_list_item_disabled(prop, i));
+
+		if (format == OBS_COMBO_FORMAT_INT)
+			AppendState(state, obs_property_list_item_int(prop, i));
+		else if (format == OBS_COMBO_FORMAT_FLOAT)
+			AppendState(state,
+				    obs_property_list_item_float(prop, i));
+		else if (format == OBS_COMBO_FORMAT_STRING)
+			AppendState(state,
+				    obs_property_list_item_string(prop, i));
+	}
+}
+
+static void AppendFrameRateState(string &state, obs_property_t *prop)
+{
+	size_t count = obs_property_frame_rate_options_count(prop);
+
+	AppendState(state, count);
+	for (size_t i = 0; i < count; i++) {
+		AppendState(state,
+			    obs_property_frame_rate_option_name(prop, i));
+		AppendState(state, obs_property_frame_rate_option_description(
+					   prop, i));
+	}
+
+	count = obs_property_frame_rate_fps_ranges_count(prop);
+
+	AppendState(state, count);
+	for (size_t i = 0; i < count; i++) {
+		media_frames_per_second min, max;
+		min = obs_property_frame_rate_fps_range_min(prop, i);
+		max = obs_property_frame_rate_fps_range_max(prop, i);
+
+		AppendState(state, min.numerator);
+		AppendState(state, min.denominator);
+		AppendState(state, max.numerator);
+		AppendState(state, max.denominator);
+	}
+}
+
+/* everything about a property that its widgets are created from, other than
+ * the value of its setting */
+static void AppendPropertyState(string &state, obs_property_t *prop)
+{
+	obs_property_type type = obs_property_get_type(prop);
+
+	AppendState(state, obs_property_name(prop));
+	AppendState(state, (int)type);
+	AppendState(state, obs_property_visible(prop));
+	AppendState(state, obs_property_enabled(prop));
+	AppendState(state, obs_property_description(prop));
+	AppendState(state, obs_property_long_description(prop));
+
+	switch (type) {
+	case OBS_PROPERTY_INT:
+		AppendState(state, obs_property_int_min(prop));
+		AppendState(state, obs_property_int_max(prop));
+		AppendState(state, obs_property_int_step(prop));
+		AppendState(state, (int)obs_property_int_type(prop));
+		AppendState(state, obs_property_int_suffix(prop));
+		break;
+	case OBS_PROPERTY_FLOAT:
+		AppendState(state, obs_property_float_min(prop));
+		AppendState(state, obs_property_float_max(prop));
+		AppendState(state, obs_property_float_step(prop));
+		AppendState(state, (int)obs_property_float_type(prop));
+		AppendState(state, obs_property_float_suffix(prop));
+		break;
+	case OBS_PROPERTY_TEXT:
+		AppendState(state, (int)obs_property_text_type(prop));
+		AppendState(state, (int)obs_property_text_monospace(prop));
+		break;
+	case OBS_PROPERTY_PATH:
+		AppendState(state, (int)obs_property_path_type(prop));
+		AppendState(state, obs_property_path_filter(prop));
+		AppendState(state, obs_property_path_default_path(prop));
+		break;
+	case OBS_PROPERTY_LIST:
+		AppendListState(state, prop);
+		break;
+	case OBS_PROPERTY_EDITABLE_LIST:
+		AppendState(state, (int)obs_property_editable_list_type(prop));
+		AppendState(state, obs_property_editable_list_filter(prop));
+		AppendState(state,
+			    obs_property_editable_list_default_path(prop));
+		break;
+	case OBS_PROPERTY_FRAME_RATE:
+		AppendFrameRateState(state, prop);
+		break;
+	case OBS_PROPERTY_GROUP: {
+		obs_properties_t *content = obs_property_group_content(prop);
+		obs_property_t *el = obs_properties_first(content);
+
+		AppendState(state, (int)obs_property_group_type(prop));
+		while (el) {
+			AppendPropertyState(state, el);
+			obs_property_next(&el);
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static void AppendSettingState(string &state, obs_data_t *settings,
+			       const char *name)
+{
+	obs_data_item_t *item = obs_data_item_byname(settings, name);
+	obs_data_t *obj;
+	obs_data_array_t *array;
+
+	if (!item) {
+		AppendState(state, "");
+		return;
+	}
+
+	switch (obs_data_item_gettype(item)) {
+	case OBS_DATA_STRING:
+		AppendState(state, obs_data_item_get_string(item));
+		break;
+	case OBS_DATA_NUMBER:
+		if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT)
+			AppendState(state, obs_data_item_get_int(item));
+		else
+			AppendState(state, obs_data_item_get_double(item));
+		break;
+	case OBS_DATA_BOOLEAN:
+		AppendState(state, obs_data_item_get_bool(item));
+		break;
+	case OBS_DATA_OBJECT:
+		obj = obs_data_item_get_obj(item);
+		AppendState(state, obs_data_get_json(obj));
+		obs_data_release(obj);
+		break;
+	case OBS_DATA_ARRAY:
+		array = obs_data_item_get_array(item);
+		for (size_t i = 0; i < obs_data_array_count(array); i++) {
+			obj = obs_data_array_item(array, i);
+			AppendState(state, obs_data_get_json(obj));
+			obs_data_release(obj);
+		}
+		obs_data_array_release(array);
+		break;
+	default:
+		AppendState(state, "");
+	}
+
+	obs_data_item_release(&item);
+}
+
+static void AppendValueState(string &state, obs_data_t *settings,
+			     obs_property_t *prop)
+{
+	AppendSettingState(state, settings, obs_property_name(prop));
+
+	if (obs_property_get_type(prop) == OBS_PROPERTY_GROUP) {
+		obs_properties_t *content = obs_property_group_content(prop);
+		obs_property_t *el = obs_properties_first(content);
+
+		while (el) {
+			AppendValueState(state, settings, el);
+			obs_property_next(&el);
+		}
+	}
+}
+
+static void GetGroupProperties(vector<obs_property_t *> &props,
+			       obs_property_t *prop)
+{
+	props.push_back(prop);
+
+	if (obs_property_get_type(prop) == OBS_PROPERTY_GROUP) {
+		obs_properties_t *content = obs_property_group_content(prop);
+		obs_property_t *el = obs_properties_first(content);
+
+		while (el) {
+			GetGroupProperties(props, el);
+			obs_property_next(&el);
+		}
+	}
+}
+
+OBSPropertiesView::PropertyRows
+OBSPropertiesView::GetPropertyRows(obs_property_t *property, int count)
+{
+	PropertyRows rows = {property, count};
+
+	AppendPropertyState(rows.state, property);
+	AppendValueState(rows.value, settings, property);
+	return rows;
+}
+
+void OBSPropertiesView::UpdatePropertyValue(obs_property_t *property)
+{
+	/* the widget of a property the user changed already shows its new
+	 * value, so it doesn't need to be recreated for it */
+	for (PropertyRows &rows : propertyRows) {
+		vector<obs_property_t *> props;
+		GetGroupProperties(props, rows.property);
+
+		if (find(props.begin(), props.end(), property) != props.end()) {
+			rows.value.clear();
+			AppendValueState(rows.value, settings, rows.property);
+			break;
+		}
+	}
+}
+
+void OBSPropertiesView::RemovePropertyRows(QFormLayout *layout, int row,
+					   const PropertyRows &rows)
+{
+	vector<obs_property_t *> props;
+	GetGroupProperties(props, rows.property);
+
+	auto usesRemovedProperty = [&](const unique_ptr<WidgetInfo> &info) {
+		return find(props.begin(), props.end(), info->property) !=
+		       props.end();
+	};
+
+	children.erase(remove_if(children.begin(), children.end(),
+				 usesRemovedProperty),
+		       children.end());
+
+	for (int i = 0; i < rows.count; i++)
+		layout->removeRow(row);
+}
+
+static void InsertLayoutRow(QFormLayout *layout, int row, bool spanning,
+			    QFormLayout::TakeRowResult &taken)
+{
+	QLayoutItem *labelItem = taken.labelItem;
+	QLayoutItem *fieldItem = taken.fieldItem;
+
+	if (spanning && !fieldItem) {
+		fieldItem = labelItem;
+		labelItem = nullptr;
+	}
+
+	QWidget *label = labelItem ? labelItem->widget() : nullptr;
+	QWidget *fieldWidget = fieldItem ? fieldItem->widget() : nullptr;
+	QLayout *fieldLayout = fieldItem ? fieldItem->layout() : nullptr;
+
+	/* taken layouts still have the form layout as their parent */
+	if (fieldLayout)
+		fieldLayout->setParent(nullptr);
+
+	if (spanning && fieldLayout)
+		layout->insertRow(row, fieldLayout);
+	else if (spanning)
+		layout->insertRow(row, fieldWidget);
+	else if (fieldLayout)
+		layout->insertRow(row, label, fieldLayout);
+	else
+		layout->insertRow(row, label, fieldWidget);
+
+	delete labelItem;
+	if (!fieldLayout)
+		delete fieldItem;
+}
+
+int OBSPropertiesView::InsertPropertyRows(QFormLayout *layout, int row,
+					  obs_property_t *property)
+{
+	int end = layout->rowCount();
+
+	AddProperty(property, layout);
+
+	int count = layout->rowCount() - end;
+
+	/* properties are always added at the end of the layout, so move
+	 * their rows to where they belong */
+	if (row != end) {
+		for (int i = 0; i < count; i++) {
+			bool spanning = !!layout->itemAt(
+				end + i, QFormLayout::SpanningRole);
+			QFormLayout::TakeRowResult taken =
+				layout->takeRow(end + i);
+			InsertLayoutRow(layout, row + i, spanning, taken);
+		}
+	}
+
+	return count;
+}
+
+bool OBSPropertiesView::UpdateChangedProperties()
+{
+	QFormLayout *layout =
+		widget ? qobject_cast<QFormLayout *>(widget->layout())
+		       : nullptr;
+
+	if (!layout || propertyRows.empty())
+		return false;
+
+	/* the widgets can only be updated in place if the properties
+	 * themselves are the same, only their state may have changed */
+	obs_property_t *property = obs_properties_first(properties.get());
+	size_t idx = 0;
+
+	for (; property; obs_property_next(&property), idx++) {
+		if (idx == propertyRows.size() ||
+		    propertyRows[idx].property != property)
+			return false;
+	}
+	if (idx != propertyRows.size())
+		return false;
+
+	int row = 0;
+	for (PropertyRows &rows : propertyRows) {
+		PropertyRows cur = GetPropertyRows(rows.property, rows.count);
+
+		if (cur.state == rows.state && cur.value == rows.value) {
+			row += rows.count;
+			continue;
+		}
+
+		RemovePropertyRows(layout, row, rows);
+		cur.count = InsertPropertyRows(layout, row, rows.property);
+		row += cur.count;
+		rows = move(cur);
+	}
+
+	return true;
+}
+
 void OBSPropertiesView::RefreshProperties()
+{
+	/* usually only a few properties change on refresh, so only recreate
+	 * their widgets if possible.  PropertiesRefreshed is only emitted
+	 * when the whole widget has been recreated. */
+	bool rebuild = !UpdateChangedProperties();
+	if (rebuild)
+		RebuildProperties();
+
+	lastFocused.clear();
+	if (lastWidget) {
+		lastWidget->setFocus(Qt::OtherFocusReason);
+		lastWidget = nullptr;
+	}
+
+	if (rebuild)
+		emit PropertiesRefreshed();
+}
+
+void OBSPropertiesView::RebuildProperties()
 {
 	int h, v;
 	GetScrollPos(h, v);
 
 	children.clear();
+	propertyRows.clear();
 	if (widget)
 		widget->deleteLater();
 
@@ -121,7 +491,11 @@ void OBSPropertiesView::RefreshProperties()
 	bool hasNoProperties = !property;
 
 	while (property) {
+		int start = layout->rowCount();
 		AddProperty(property, layout);
+
+		int count = layout->rowCount() - start;
+		propertyRows.push_back(GetPropertyRows(property, count));
 		obs_property_next(&property);
 	}
 
@@ -130,18 +504,10 @@ void OBSPropertiesView::RefreshProperties()
 	SetScrollPos(h, v);
 	setSizePolicy(mainPolicy);
 
-	lastFocused.clear();
-	if (lastWidget) {
-		lastWidget->setFocus(Qt::OtherFocusReason);
-		lastWidget = nullptr;
-	}
-
 	if (hasNoProperties) {
 		QLabel *noPropertiesLabel = new QLabel(NO_PROPERTIES_STRING);
 		layout->addWidget(noPropertiesLabel);
 	}
-
-	emit PropertiesRefreshed();
 }
 
 void OBSPropertiesView::SetScrollPos(int h, int v)
@@ -1860,6 +2226,8 @@ void WidgetInfo::ControlChanged()
 		break;
 	}
 
+	view->UpdatePropertyValue(property);
+
 	if (view->callback && !view->deferUpdate)
 		view->callback(view->obj, view->settings);
 
@@ -4,6 +4,7 @@
 #include <obs.hpp>
 #include <vector>
 #include <memory>
+#include <string>
 
 class QFormLayout;
 class OBSPropertiesView;
@@ -71,6 +72,15 @@ class OBSPropertiesView : public VScrollArea {
 	using properties_t =
 		std::unique_ptr<obs_properties_t, properties_delete_t>;
 
+	/* what each top level property looked like when its widgets were
+	 * created, used to only rebuild the widgets of changed properties */
+	struct PropertyRows {
+		obs_property_t *property;
+		int count;
+		std::string state;
+		std::string value;
+	};
+
 private:
 	QWidget *widget = nullptr;
 	properties_t properties;
@@ -81,6 +91,7 @@ private:
 	PropertiesUpdateCallback callback = nullptr;
 	int minSize;
 	std::vector<std::unique_ptr<WidgetInfo>> children;
+	std::vector<PropertyRows> propertyRows;
 	std::string lastFocused;
 	QWidget *lastWidget = nullptr;
 	bool deferUpdate;
@@ -109,6 +120,15 @@ private:
 
 	void AddProperty(obs_property_t *property, QFormLayout *layout);
 
+	PropertyRows GetPropertyRows(obs_property_t *property, int count);
+	void UpdatePropertyValue(obs_property_t *property);
+	void RemovePropertyRows(QFormLayout *layout, int row,
+				const PropertyRows &rows);
+	int InsertPropertyRows(QFormLayout *layout, int row,
+			       obs_property_t *property);
+	bool UpdateChangedProperties();
+	void RebuildProperties();
+
 	void resizeEvent(QResizeEvent *event) override;
 
 	void GetScrollPos(int &h, int &v);
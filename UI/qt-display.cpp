@@ -33,6 +33,8 @@ OBSQTDisplay::OBSQTDisplay(QWidget *parent, Qt::WindowFlags flags)
 	setAttribute(Qt::WA_NativeWindow);
 
 	auto windowVisible = [this](bool visible) {
+		UpdateDisplayVisibility();
+
 		if (!visible)
 			return;
 
@@ -50,10 +52,14 @@ OBSQTDisplay::OBSQTDisplay(QWidget *parent, Qt::WindowFlags flags)
 
 		QSize size = GetPixelSize(this);
 		obs_display_resize(display, size.width(), size.height());
+		UpdateDisplayMaxFPS();
 	};
 
 	connect(windowHandle(), &QWindow::visibleChanged, windowVisible);
 	connect(windowHandle(), &QWindow::screenChanged, sizeChanged);
+
+	/* expose events tell us when the window is occluded or minimized */
+	windowHandle()->installEventFilter(this);
 }
 
 QColor OBSQTDisplay::GetDisplayBackgroundColor() const
@@ -93,9 +99,43 @@ void OBSQTDisplay::CreateDisplay()
 
 	display = obs_display_create(&info, backgroundColor);
 
+	QString name = window()->metaObject()->className();
+	if (!objectName().isEmpty())
+		name += "." + objectName();
+	obs_display_set_name(display, QT_TO_UTF8(name));
+
+	UpdateDisplayMaxFPS();
+	UpdateDisplayVisibility();
+
 	emit DisplayCreated(this);
 }
 
+void OBSQTDisplay::UpdateDisplayVisibility()
+{
+	if (!display)
+		return;
+
+	QWindow *handle = windowHandle();
+	bool visible = isVisible() && handle && handle->isExposed() &&
+		       !window()->isMinimized();
+
+	obs_display_set_visible(display, visible);
+}
+
+void OBSQTDisplay::UpdateDisplayMaxFPS()
+{
+	QWindow *handle = windowHandle();
+	QScreen *screen = handle ? handle->screen() : nullptr;
+
+	if (!display || !screen)
+		return;
+
+	/* there's no point in drawing more often than the monitor the
+	 * display is on can show */
+	uint32_t fps = (uint32_t)qRound(screen->refreshRate());
+	obs_display_set_max_fps(display, fps);
+}
+
 void OBSQTDisplay::resizeEvent(QResizeEvent *event)
 {
 	QWidget::resizeEvent(event);
@@ -117,6 +157,35 @@ void OBSQTDisplay::paintEvent(QPaintEvent *event)
 	QWidget::paintEvent(event);
 }
 
+void OBSQTDisplay::showEvent(QShowEvent *event)
+{
+	QWidget::showEvent(event);
+
+	/* minimizing changes the state of the top level window, not ours */
+	window()->installEventFilter(this);
+	UpdateDisplayVisibility();
+}
+
+void OBSQTDisplay::hideEvent(QHideEvent *event)
+{
+	QWidget::hideEvent(event);
+
+	UpdateDisplayVisibility();
+}
+
+bool OBSQTDisplay::eventFilter(QObject *obj, QEvent *event)
+{
+	switch (event->type()) {
+	case QEvent::Expose:
+	case QEvent::WindowStateChange:
+		UpdateDisplayVisibility();
+		break;
+	default:;
+	}
+
+	return QWidget::eventFilter(obj, event);
+}
+
 QPaintEngine *OBSQTDisplay::paintEngine() const
 {
 	return nullptr;
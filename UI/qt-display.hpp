@@ -14,9 +14,14 @@ class OBSQTDisplay : public QWidget {
 	OBSDisplay display;
 
 	void CreateDisplay();
+	void UpdateDisplayVisibility();
+	void UpdateDisplayMaxFPS();
 
 	void resizeEvent(QResizeEvent *event) override;
 	void paintEvent(QPaintEvent *event) override;
+	void showEvent(QShowEvent *event) override;
+	void hideEvent(QHideEvent *event) override;
+	bool eventFilter(QObject *obj, QEvent *event) override;
 
 signals:
 	void DisplayCreated(OBSQTDisplay *window);
@@ -717,6 +717,7 @@ void OBSBasic::SetCurrentScene(OBSSource scene, bool force)
 void OBSBasic::CreateProgramDisplay()
 {
 	program = new OBSQTDisplay();
+	program->setObjectName(QStringLiteral("program"));
 
 	program->setContextMenuPolicy(Qt::CustomContextMenu);
 	connect(program.data(), &QWidget::customContextMenuRequested, this,
@@ -196,6 +196,8 @@ OBSBasic::OBSBasic(QWidget *parent)
 
 	setAttribute(Qt::WA_NativeWindow);
 
+	saveThread.reset(new ProjectSaveThread);
+
 #if TWITCH_ENABLED
 	RegisterTwitchAuth();
 #endif
@@ -410,7 +412,8 @@ OBSBasic::OBSBasic(QWidget *parent)
 }
 
 static void SaveAudioDevice(const char *name, int channel, obs_data_t *parent,
-			    vector<OBSSource> &audioSources)
+			    vector<OBSSource> &audioSources,
+			    SourceSaveCache &cache)
 {
 	obs_source_t *source = obs_get_output_source(channel);
 	if (!source)
@@ -418,11 +421,10 @@ static void SaveAudioDevice(const char *name, int channel, obs_data_t *parent,
 
 	audioSources.push_back(source);
 
-	obs_data_t *data = obs_save_source(source);
+	OBSData data = cache.Save(source);
 
 	obs_data_set_obj(parent, name, data);
 
-	obs_data_release(data);
 	obs_source_release(source);
 }
 
@@ -431,19 +433,22 @@ static obs_data_t *GenerateSaveData(obs_data_array_t *sceneOrder,
 				    int transitionDuration,
 				    obs_data_array_t *transitions,
 				    OBSScene &scene, OBSSource &curProgramScene,
-				    obs_data_array_t *savedProjectorList)
+				    obs_data_array_t *savedProjectorList,
+				    SourceSaveCache &cache,
+				    obs_data_array_t **sourcesArray,
+				    obs_data_array_t **groupsArray)
 {
 	obs_data_t *saveData = obs_data_create();
 
 	vector<OBSSource> audioSources;
 	audioSources.reserve(6);
 
-	SaveAudioDevice(DESKTOP_AUDIO_1, 1, saveData, audioSources);
-	SaveAudioDevice(DESKTOP_AUDIO_2, 2, saveData, audioSources);
-	SaveAudioDevice(AUX_AUDIO_1, 3, saveData, audioSources);
-	SaveAudioDevice(AUX_AUDIO_2, 4, saveData, audioSources);
-	SaveAudioDevice(AUX_AUDIO_3, 5, saveData, audioSources);
-	SaveAudioDevice(AUX_AUDIO_4, 6, saveData, audioSources);
+	SaveAudioDevice(DESKTOP_AUDIO_1, 1, saveData, audioSources, cache);
+	SaveAudioDevice(DESKTOP_AUDIO_2, 2, saveData, audioSources, cache);
+	SaveAudioDevice(AUX_AUDIO_1, 3, saveData, audioSources, cache);
+	SaveAudioDevice(AUX_AUDIO_2, 4, saveData, audioSources, cache);
+	SaveAudioDevice(AUX_AUDIO_3, 5, saveData, audioSources, cache);
+	SaveAudioDevice(AUX_AUDIO_4, 6, saveData, audioSources, cache);
 
 	/* -------------------------------- */
 	/* save non-group sources           */
@@ -457,7 +462,7 @@ static obs_data_t *GenerateSaveData(obs_data_array_t *sceneOrder,
 	};
 	using FilterAudioSources_t = decltype(FilterAudioSources);
 
-	obs_data_array_t *sourcesArray = obs_save_sources_filtered(
+	*sourcesArray = cache.SaveSources(
 		[](void *data, obs_source_t *source) {
 			return (*static_cast<FilterAudioSources_t *>(data))(
 				source);
@@ -468,7 +473,7 @@ static obs_data_t *GenerateSaveData(obs_data_array_t *sceneOrder,
 	/* save group sources separately    */
 
 	/* saving separately ensures they won't be loaded in older versions */
-	obs_data_array_t *groupsArray = obs_save_sources_filtered(
+	*groupsArray = cache.SaveSources(
 		[](void *, obs_source_t *source) {
 			return obs_source_is_group(source);
 		},
@@ -488,13 +493,9 @@ static obs_data_t *GenerateSaveData(obs_data_array_t *sceneOrder,
 	obs_data_set_string(saveData, "current_program_scene", programName);
 	obs_data_set_array(saveData, "scene_order", sceneOrder);
 	obs_data_set_string(saveData, "name", sceneCollection);
-	obs_data_set_array(saveData, "sources", sourcesArray);
-	obs_data_set_array(saveData, "groups", groupsArray);
 	obs_data_set_array(saveData, "quick_transitions", quickTransitionData);
 	obs_data_set_array(saveData, "transitions", transitions);
 	obs_data_set_array(saveData, "saved_projectors", savedProjectorList);
-	obs_data_array_release(sourcesArray);
-	obs_data_array_release(groupsArray);
 
 	obs_data_set_string(saveData, "current_transition",
 			    obs_source_get_name(transition));
@@ -618,18 +619,25 @@ obs_data_array_t *OBSBasic::SaveProjectors()
 
 void OBSBasic::Save(const char *file)
 {
+	uint64_t startTime = os_gettime_ns();
+
 	OBSScene scene = GetCurrentScene();
 	OBSSource curProgramScene = OBSGetStrongRef(programScene);
 	if (!curProgramScene)
 		curProgramScene = obs_scene_get_source(scene);
 
+	sourceSaveCache.Begin();
+
+	obs_data_array_t *sourcesArray = nullptr;
+	obs_data_array_t *groupsArray = nullptr;
 	obs_data_array_t *sceneOrder = SaveSceneListOrder();
 	obs_data_array_t *transitions = SaveTransitions();
 	obs_data_array_t *quickTrData = SaveQuickTransitions();
 	obs_data_array_t *savedProjectorList = SaveProjectors();
 	obs_data_t *saveData = GenerateSaveData(
 		sceneOrder, quickTrData, ui->transitionDuration->value(),
-		transitions, scene, curProgramScene, savedProjectorList);
+		transitions, scene, curProgramScene, savedProjectorList,
+		sourceSaveCache, &sourcesArray, &groupsArray);
 
 	obs_data_set_bool(saveData, "preview_locked", ui->preview->Locked());
 	obs_data_set_bool(saveData, "scaling_enabled",
@@ -648,10 +656,23 @@ void OBSBasic::Save(const char *file)
 		obs_data_release(moduleObj);
 	}
 
-	if (!obs_data_save_json_safe(saveData, file, "tmp", "bak"))
-		blog(LOG_ERROR, "Could not save scene data to %s", file);
+	/* everything but the (already snapshotted) sources may still be
+	 * referenced and modified by the UI or plugins, so copy it before
+	 * handing it to the save thread */
+	obs_data_t *snapshot = obs_data_create();
+	obs_data_apply(snapshot, saveData);
+	obs_data_set_array(snapshot, "sources", sourcesArray);
+	obs_data_set_array(snapshot, "groups", groupsArray);
 
+	sourceSaveCache.End();
+
+	saveThread->Queue(snapshot, file, os_gettime_ns() - startTime,
+			  sourceSaveCache.saved, sourceSaveCache.reserialized);
+
+	obs_data_release(snapshot);
 	obs_data_release(saveData);
+	obs_data_array_release(sourcesArray);
+	obs_data_array_release(groupsArray);
 	obs_data_array_release(sceneOrder);
 	obs_data_array_release(quickTrData);
 	obs_data_array_release(transitions);
@@ -2429,8 +2450,13 @@ void OBSBasic::SaveProjectNow()
 	if (disableSaving)
 		return;
 
+	/* re-serialize everything, and wait until it's on disk, as the
+	 * collection file is about to be used (or the program is exiting) */
+	sourceSaveCache.Clear();
+
 	projectChanged = true;
 	SaveProjectDeferred();
+	saveThread->Flush();
 }
 
 void OBSBasic::SaveProject()
@@ -34,6 +34,7 @@
 #include "window-projector.hpp"
 #include "window-basic-about.hpp"
 #include "auth-base.hpp"
+#include "project-save-thread.hpp"
 
 #include <obs-frontend-internal.hpp>
 
@@ -187,6 +188,8 @@ private:
 	bool loaded = false;
 	long disableSaving = 1;
 	bool projectChanged = false;
+	SourceSaveCache sourceSaveCache;
+	std::unique_ptr<ProjectSaveThread> saveThread;
 	bool previewEnabled = true;
 
 	std::list<const char *> copyStrings;
@@ -26,9 +26,12 @@
 #include <QScreen>
 #include <QWindow>
 #include <QMessageBox>
+#include <QTimer>
 
 using namespace std;
 
+#define STATIC_PREVIEW_REFRESH_MS 100
+
 static void CreateTransitionScene(OBSSource scene, const char *text,
 				  uint32_t color);
 
@@ -84,6 +87,7 @@ OBSBasicProperties::OBSBasicProperties(QWidget *parent, OBSSource source_)
 		(PropertiesUpdateCallback)obs_source_update);
 	view->setMinimumHeight(150);
 
+	preview->setObjectName(QStringLiteral("preview"));
 	preview->setMinimumSize(20, 150);
 	preview->setSizePolicy(
 		QSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding));
@@ -142,6 +146,29 @@ OBSBasicProperties::OBSBasicProperties(QWidget *parent, OBSSource source_)
 		connect(preview.data(), &OBSQTDisplay::DisplayCreated,
 			addDrawCallback);
 
+		/* static sources only change when their settings do, so only
+		 * redraw their preview on changes and otherwise at a low rate
+		 * to pick up anything else, such as a modified file */
+		if ((caps & OBS_SOURCE_STATIC_VIDEO) != 0) {
+			auto setOnDemand = [this]() {
+				obs_display_set_redraw_on_demand(
+					preview->GetDisplay(), true);
+			};
+			auto requestRedraw = [this]() {
+				obs_display_request_redraw(
+					preview->GetDisplay());
+			};
+
+			QTimer *refresh = new QTimer(this);
+			connect(refresh, &QTimer::timeout, requestRedraw);
+			refresh->start(STATIC_PREVIEW_REFRESH_MS);
+
+			connect(preview.data(), &OBSQTDisplay::DisplayCreated,
+				setOnDemand);
+			connect(view, &OBSPropertiesView::Changed,
+				requestRedraw);
+		}
+
 	} else if (type == OBS_SOURCE_TYPE_TRANSITION) {
 		sourceA =
 			obs_source_create_private("scene", "sourceA", nullptr);
@@ -8,12 +8,15 @@
 
 #include <QDesktopWidget>
 #include <QPushButton>
+#include <QCheckBox>
 #include <QScrollArea>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGridLayout>
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #define TIMER_INTERVAL 2000
 #define REC_TIME_LEFT_INTERVAL 30000
@@ -74,19 +77,28 @@ OBSBasicStats::OBSBasicStats(QWidget *parent, bool closeable)
 	renderTime = new QLabel(this);
 	skippedFrames = new QLabel(this);
 	missedFrames = new QLabel(this);
+	drawCalls = new QLabel(this);
+	renderCache = new QLabel(this);
+	filterPasses = new QLabel(this);
 	row = 0;
 
 	newStatBare("FPS", fps, 2);
 	newStat("AverageTimeToRender", renderTime, 2);
 	newStat("MissedFrames", missedFrames, 2);
 	newStat("SkippedFrames", skippedFrames, 2);
+	newStat("DrawCalls", drawCalls, 2);
+	newStat("RenderCache", renderCache, 2);
+	newStat("FilterPasses", filterPasses, 2);
 
 	/* --------------------------------------------- */
 	QPushButton *closeButton = nullptr;
 	if (closeable)
 		closeButton = new QPushButton(QTStr("Close"));
 	QPushButton *resetButton = new QPushButton(QTStr("Reset"));
+	trackMemory = new QCheckBox(QTStr("Basic.Stats.TrackMemory"));
+	trackMemory->setChecked(bmem_tracking_enabled());
 	QHBoxLayout *buttonLayout = new QHBoxLayout;
+	buttonLayout->addWidget(trackMemory);
 	buttonLayout->addStretch();
 	buttonLayout->addWidget(resetButton);
 	if (closeable)
@@ -114,8 +126,29 @@ OBSBasicStats::OBSBasicStats(QWidget *parent, bool closeable)
 
 	/* --------------------------------------------- */
 
+	memoryLayout = new QGridLayout();
+
+	col = 0;
+	auto addMemoryCol = [&](const char *loc) {
+		QLabel *label = new QLabel(QTStr(loc), this);
+		label->setStyleSheet("font-weight: bold");
+		memoryLayout->addWidget(label, 0, col++);
+	};
+
+	addMemoryCol("Basic.Stats.Memory.Tag");
+	addMemoryCol("Basic.Stats.MemoryUsage");
+	addMemoryCol("Basic.Stats.Memory.Peak");
+	addMemoryCol("Basic.Stats.Memory.Allocations");
+
+	memoryWidget = new QWidget(this);
+	memoryWidget->setLayout(memoryLayout);
+	memoryWidget->setVisible(bmem_tracking_enabled());
+
+	/* --------------------------------------------- */
+
 	QVBoxLayout *outputContainerLayout = new QVBoxLayout();
 	outputContainerLayout->addLayout(outputLayout);
+	outputContainerLayout->addWidget(memoryWidget);
 	outputContainerLayout->addStretch();
 
 	QWidget *widget = new QWidget(this);
@@ -137,6 +170,10 @@ OBSBasicStats::OBSBasicStats(QWidget *parent, bool closeable)
 		connect(closeButton, &QPushButton::clicked,
 			[this]() { close(); });
 	connect(resetButton, &QPushButton::clicked, [this]() { Reset(); });
+	connect(trackMemory, &QCheckBox::toggled, [this](bool checked) {
+		bmem_enable_tracking(checked);
+		UpdateMemory();
+	});
 
 	delete shortcutFilter;
 	shortcutFilter = CreateShortcutFilter();
@@ -230,6 +267,102 @@ void OBSBasicStats::AddOutputLabels(QString name)
 	outputLabels.push_back(ol);
 }
 
+void OBSBasicStats::AddMemoryLabels()
+{
+	MemoryLabels ml;
+	ml.tag = new QLabel(this);
+	ml.usage = new QLabel(this);
+	ml.peak = new QLabel(this);
+	ml.allocs = new QLabel(this);
+
+	int col = 0;
+	int row = memoryLabels.size() + 1;
+	memoryLayout->addWidget(ml.tag, row, col++);
+	memoryLayout->addWidget(ml.usage, row, col++);
+	memoryLayout->addWidget(ml.peak, row, col++);
+	memoryLayout->addWidget(ml.allocs, row, col++);
+	memoryLabels.push_back(ml);
+}
+
+void OBSBasicStats::UpdateMemory()
+{
+	bool enabled = bmem_tracking_enabled();
+	memoryWidget->setVisible(enabled);
+	if (!enabled)
+		return;
+
+	std::vector<bmem_tag_stats> tags;
+
+	auto enumTags = [](void *param, const bmem_tag_stats *stats) {
+		auto &tags = *reinterpret_cast<std::vector<bmem_tag_stats> *>(
+			param);
+		tags.push_back(*stats);
+		return true;
+	};
+	bmem_enum_tags(enumTags, &tags);
+
+	std::sort(tags.begin(), tags.end(),
+		  [](const bmem_tag_stats &a, const bmem_tag_stats &b) {
+			  return a.bytes > b.bytes;
+		  });
+
+	while (memoryLabels.size() < (int)tags.size())
+		AddMemoryLabels();
+
+	for (int i = 0; i < memoryLabels.size(); i++) {
+		bool used = i < (int)tags.size();
+		memoryLabels[i].SetVisible(used);
+		if (used)
+			memoryLabels[i].Update(&tags[i]);
+	}
+}
+
+static QString FormatMegabytes(uint64_t bytes)
+{
+	long double num = (long double)bytes / (1024.0l * 1024.0l);
+	return QString::number(num, 'f', 1) + QStringLiteral(" MB");
+}
+
+void OBSBasicStats::MemoryLabels::Update(const struct bmem_tag_stats *stats)
+{
+	tag->setText(QT_UTF8(stats->tag));
+	usage->setText(FormatMegabytes(stats->bytes));
+	peak->setText(FormatMegabytes(stats->peak_bytes));
+	allocs->setText(QString("%1 / %2").arg(
+		QString::number(stats->allocs),
+		QString::number(stats->total_allocs)));
+
+	/* size histogram of the current allocations */
+	QString histogram;
+	for (size_t i = 0; i < BMEM_SIZE_BUCKETS; i++) {
+		if (!stats->size_buckets[i])
+			continue;
+
+		uint64_t max = 64ULL << i;
+		QString size = max < 1024 ? QString("%1 B").arg(max)
+					  : QString("%1 KB").arg(max / 1024);
+		if (i == BMEM_SIZE_BUCKETS - 1)
+			size = QStringLiteral("> ") + size;
+		else
+			size = QStringLiteral("<= ") + size;
+
+		if (!histogram.isEmpty())
+			histogram += QStringLiteral("\n");
+		histogram += QString("%1: %2").arg(
+			size, QString::number(stats->size_buckets[i]));
+	}
+
+	usage->setToolTip(histogram);
+}
+
+void OBSBasicStats::MemoryLabels::SetVisible(bool visible)
+{
+	tag->setVisible(visible);
+	usage->setVisible(visible);
+	peak->setVisible(visible);
+	allocs->setVisible(visible);
+}
+
 static uint32_t first_encoded = 0xFFFFFFFF;
 static uint32_t first_skipped = 0xFFFFFFFF;
 static uint32_t first_rendered = 0xFFFFFFFF;
@@ -258,6 +391,8 @@ void OBSBasicStats::Update()
 	obs_output_release(strOutput);
 	obs_output_release(recOutput);
 
+	UpdateMemory();
+
 	if (!strOutput && !recOutput)
 		return;
 
@@ -398,6 +533,36 @@ void OBSBasicStats::Update()
 	else
 		setThemeID(missedFrames, "");
 
+	/* ------------------ */
+
+	drawCalls->setText(QString::number(obs_get_draw_call_count()));
+
+	struct obs_render_cache_stats cacheStats;
+	obs_get_render_cache_stats(&cacheStats);
+	renderCache->setText(QString("%1 / %2").arg(
+		QString::number(cacheStats.hits),
+		QString::number(cacheStats.hits + cacheStats.renders)));
+
+	filterPasses->setText(QString::number(obs_get_filter_pass_count()));
+
+	QString passesPerSource;
+	auto addSourcePasses = [](void *param, obs_source_t *source) {
+		QString &str = *static_cast<QString *>(param);
+		uint32_t passes = obs_source_get_filter_passes(source);
+
+		if (passes) {
+			if (!str.isEmpty())
+				str += "\n";
+			str += QString("%1: %2").arg(
+				QT_UTF8(obs_source_get_name(source)),
+				QString::number(passes));
+		}
+		return true;
+	};
+	obs_enum_sources(addSourcePasses, &passesPerSource);
+	obs_enum_scenes(addSourcePasses, &passesPerSource);
+	filterPasses->setToolTip(passesPerSource);
+
 	/* ------------------------------------------- */
 	/* recording/streaming stats                   */
 
@@ -453,6 +618,8 @@ void OBSBasicStats::Reset()
 	first_rendered = 0xFFFFFFFF;
 	first_lagged = 0xFFFFFFFF;
 
+	bmem_reset_peaks();
+
 	OBSOutput strOutput = obs_frontend_get_streaming_output();
 	OBSOutput recOutput = obs_frontend_get_recording_output();
 	obs_output_release(strOutput);
@@ -11,6 +11,7 @@
 
 class QGridLayout;
 class QCloseEvent;
+class QCheckBox;
 
 class OBSBasicStats : public QWidget {
 	Q_OBJECT
@@ -24,8 +25,14 @@ class OBSBasicStats : public QWidget {
 	QLabel *renderTime = nullptr;
 	QLabel *skippedFrames = nullptr;
 	QLabel *missedFrames = nullptr;
+	QLabel *drawCalls = nullptr;
+	QLabel *renderCache = nullptr;
+	QLabel *filterPasses = nullptr;
 
 	QGridLayout *outputLayout = nullptr;
+	QGridLayout *memoryLayout = nullptr;
+	QWidget *memoryWidget = nullptr;
+	QCheckBox *trackMemory = nullptr;
 
 	os_cpu_usage_info_t *cpu_info = nullptr;
 
@@ -55,7 +62,21 @@ class OBSBasicStats : public QWidget {
 
 	QList<OutputLabels> outputLabels;
 
+	struct MemoryLabels {
+		QPointer<QLabel> tag;
+		QPointer<QLabel> usage;
+		QPointer<QLabel> peak;
+		QPointer<QLabel> allocs;
+
+		void Update(const struct bmem_tag_stats *stats);
+		void SetVisible(bool visible);
+	};
+
+	QList<MemoryLabels> memoryLabels;
+
 	void AddOutputLabels(QString name);
+	void AddMemoryLabels();
+	void UpdateMemory();
 	void Update();
 
 	virtual void closeEvent(QCloseEvent *event) override;
@@ -30,13 +30,39 @@ struct obs_script {
 	struct dstr path;
 	struct dstr file;
 	struct dstr desc;
+
+	/* tick/timer time accounting and throttling, only touched by the
+	 * script thread */
+	const char *profile_tick_name;
+	uint64_t tick_time_ns;
+	uint64_t tick_batch;
+	uint64_t throttle_until;
+	float batch_seconds;
+	float skipped_seconds;
+	bool batch_skipped;
+	bool throttled;
 };
 
 struct script_callback;
 typedef void (*defer_call_cb)(void *param);
+typedef void (*script_tick_cb)(void *param, float seconds);
 
 extern void defer_call_post(defer_call_cb call, void *cb);
 
+/* Tick callbacks registered here run on the script thread rather than the
+ * graphics thread.  Graphics frames that arrive while the script thread is
+ * still busy are coalesced into a single tick with the combined time. */
+extern void script_add_tick_callback(script_tick_cb tick, void *param);
+extern void script_remove_tick_callback(script_tick_cb tick, void *param);
+
+/* Brackets a call into a script from the script thread for time accounting
+ * and throttling.  Returns false if the script is over its time budget and
+ * should be skipped this time; seconds (if not NULL) is adjusted to include
+ * the time of any skipped ticks. */
+extern bool script_call_begin(obs_script_t *script, float *seconds,
+			      uint64_t *start);
+extern void script_call_end(obs_script_t *script, uint64_t start);
+
 extern void script_log(obs_script_t *script, int level, const char *format,
 		       ...);
 extern void script_log_va(obs_script_t *script, int level, const char *format,
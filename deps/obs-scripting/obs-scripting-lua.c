@@ -287,13 +287,18 @@ static int timer_remove(lua_State *script)
 static void timer_call(struct script_callback *p_cb)
 {
 	struct lua_obs_callback *cb = (struct lua_obs_callback *)p_cb;
+	uint64_t start;
 
 	if (p_cb->removed)
 		return;
+	if (!script_call_begin(p_cb->script, NULL, &start))
+		return;
 
 	lock_callback();
 	call_func_(cb->script, cb->reg_idx, 0, 0, "timer_cb", __FUNCTION__);
 	unlock_callback();
+
+	script_call_end(p_cb->script, start);
 }
 
 static void defer_timer_init(void *p_cb)
@@ -376,11 +381,14 @@ static void obs_lua_tick_callback(void *priv, float seconds)
 {
 	struct lua_obs_callback *cb = priv;
 	lua_State *script = cb->script;
+	uint64_t start;
 
 	if (cb->base.removed) {
-		obs_remove_tick_callback(obs_lua_tick_callback, cb);
+		script_remove_tick_callback(obs_lua_tick_callback, cb);
 		return;
 	}
+	if (!script_call_begin(cb->base.script, &seconds, &start))
+		return;
 
 	lock_callback();
 
@@ -388,6 +396,8 @@ static void obs_lua_tick_callback(void *priv, float seconds)
 	call_func(obs_lua_tick_callback, 1, 0);
 
 	unlock_callback();
+
+	script_call_end(cb->base.script, start);
 }
 
 static int obs_lua_remove_tick_callback(lua_State *script)
@@ -403,7 +413,7 @@ static int obs_lua_remove_tick_callback(lua_State *script)
 
 static void defer_add_tick(void *cb)
 {
-	obs_add_tick_callback(obs_lua_tick_callback, cb);
+	script_add_tick_callback(obs_lua_tick_callback, cb);
 }
 
 static int obs_lua_add_tick_callback(lua_State *script)
@@ -1055,15 +1065,25 @@ static void lua_tick(void *param, float seconds)
 	data = first_tick_script;
 	while (data) {
 		lua_State *script = data->script;
+		float script_seconds = seconds;
+		uint64_t start;
+
+		if (!script_call_begin(&data->base, &script_seconds, &start)) {
+			data = data->next_tick;
+			continue;
+		}
+
 		current_lua_script = data;
 
 		pthread_mutex_lock(&data->mutex);
 
-		lua_pushnumber(script, (double)seconds);
+		lua_pushnumber(script, (double)script_seconds);
 		call_func_(script, data->tick, 1, 0, "tick", __FUNCTION__);
 
 		pthread_mutex_unlock(&data->mutex);
 
+		script_call_end(&data->base, start);
+
 		data = data->next_tick;
 	}
 	current_lua_script = NULL;
@@ -1340,12 +1360,12 @@ void obs_lua_load(void)
 
 	dstr_free(&dep_paths);
 
-	obs_add_tick_callback(lua_tick, NULL);
+	script_add_tick_callback(lua_tick, NULL);
 }
 
 void obs_lua_unload(void)
 {
-	obs_remove_tick_callback(lua_tick, NULL);
+	script_remove_tick_callback(lua_tick, NULL);
 
 	bfree(startup_script);
 	pthread_mutex_destroy(&tick_mutex);
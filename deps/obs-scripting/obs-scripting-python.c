@@ -424,15 +424,20 @@ static PyObject *timer_remove(PyObject *self, PyObject *args)
 static void timer_call(struct script_callback *p_cb)
 {
 	struct python_obs_callback *cb = (struct python_obs_callback *)p_cb;
+	uint64_t start;
 
 	if (p_cb->removed)
 		return;
+	if (!script_call_begin(p_cb->script, NULL, &start))
+		return;
 
 	lock_callback(cb);
 	PyObject *py_ret = PyObject_CallObject(cb->func, NULL);
 	py_error();
 	Py_XDECREF(py_ret);
 	unlock_callback();
+
+	script_call_end(p_cb->script, start);
 }
 
 static void defer_timer_init(void *p_cb)
@@ -469,11 +474,14 @@ static PyObject *timer_add(PyObject *self, PyObject *args)
 static void obs_python_tick_callback(void *priv, float seconds)
 {
 	struct python_obs_callback *cb = priv;
+	uint64_t start;
 
 	if (cb->base.removed) {
-		obs_remove_tick_callback(obs_python_tick_callback, cb);
+		script_remove_tick_callback(obs_python_tick_callback, cb);
 		return;
 	}
+	if (!script_call_begin(cb->base.script, &seconds, &start))
+		return;
 
 	lock_callback(cb);
 
@@ -484,6 +492,13 @@ static void obs_python_tick_callback(void *priv, float seconds)
 	Py_XDECREF(args);
 
 	unlock_callback();
+
+	script_call_end(cb->base.script, start);
+}
+
+static void defer_add_tick(void *cb)
+{
+	script_add_tick_callback(obs_python_tick_callback, cb);
 }
 
 static PyObject *obs_python_remove_tick_callback(PyObject *self, PyObject *args)
@@ -530,7 +545,7 @@ static PyObject *obs_python_add_tick_callback(PyObject *self, PyObject *args)
 		return python_none();
 
 	struct python_obs_callback *cb = add_python_obs_callback(script, py_cb);
-	obs_add_tick_callback(obs_python_tick_callback, cb);
+	defer_call_post(defer_add_tick, cb);
 	return python_none();
 }
 
@@ -1493,18 +1508,29 @@ static void python_tick(void *param, float seconds)
 	if (valid) {
 		lock_python();
 
-		PyObject *args = Py_BuildValue("(f)", seconds);
-
 		pthread_mutex_lock(&tick_mutex);
 		data = first_tick_script;
 		while (data) {
+			float script_seconds = seconds;
+			uint64_t start;
+
+			if (!script_call_begin(&data->base, &script_seconds,
+					       &start)) {
+				data = data->next_tick;
+				continue;
+			}
+
 			cur_python_script = data;
 
+			PyObject *args = Py_BuildValue("(f)", script_seconds);
 			PyObject *py_ret =
 				PyObject_CallObject(data->tick, args);
 			Py_XDECREF(py_ret);
+			Py_XDECREF(args);
 			py_error();
 
+			script_call_end(&data->base, start);
+
 			data = data->next_tick;
 		}
 
@@ -1512,8 +1538,6 @@ static void python_tick(void *param, float seconds)
 
 		pthread_mutex_unlock(&tick_mutex);
 
-		Py_XDECREF(args);
-
 		unlock_python();
 	}
 
@@ -1688,7 +1712,7 @@ out:
 	python_loaded_at_all = success;
 
 	if (python_loaded)
-		obs_add_tick_callback(python_tick, NULL);
+		script_add_tick_callback(python_tick, NULL);
 
 	return python_loaded;
 }
@@ -1698,6 +1722,9 @@ void obs_python_unload(void)
 	if (!python_loaded_at_all)
 		return;
 
+	/* make sure the script thread is done with python before finalizing */
+	script_remove_tick_callback(python_tick, NULL);
+
 	if (python_loaded && Py_IsInitialized()) {
 		PyGILState_Ensure();
 
@@ -1707,8 +1734,6 @@ void obs_python_unload(void)
 
 	/* ---------------------- */
 
-	obs_remove_tick_callback(python_tick, NULL);
-
 	for (size_t i = 0; i < python_paths.num; i++)
 		bfree(python_paths.array[i]);
 	da_free(python_paths);
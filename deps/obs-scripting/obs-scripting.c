@@ -17,9 +17,11 @@
 
 #include <obs.h>
 #include <util/dstr.h>
+#include <util/darray.h>
 #include <util/platform.h>
 #include <util/threading.h>
 #include <util/circlebuf.h>
+#include <util/profiler.h>
 
 #include "obs-scripting-internal.h"
 #include "obs-scripting-callback.h"
@@ -120,6 +122,227 @@ void defer_call_post(defer_call_cb call, void *cb)
 
 /* -------------------------------------------- */
 
+struct script_tick_callback {
+	script_tick_cb tick;
+	void *param;
+};
+
+static pthread_mutex_t script_tick_mutex;
+static bool script_tick_exit = false;
+static bool script_tick_pending = false;
+static float script_tick_seconds = 0.0f;
+static os_sem_t *script_tick_semaphore;
+static pthread_t script_tick_thread;
+
+static pthread_mutex_t script_callbacks_mutex;
+static DARRAY(struct script_tick_callback) script_tick_callbacks;
+
+static volatile long script_tick_budget_ms = 0;
+static uint64_t cur_tick_batch = 0;
+static float cur_tick_seconds = 0.0f;
+
+static const char *script_thread_name = "obs_script_thread";
+
+/* called from the graphics thread; only one tick can be queued at a time,
+ * later frames are folded into it until the script thread picks it up */
+static void post_script_tick(void *param, float seconds)
+{
+	bool post;
+
+	pthread_mutex_lock(&script_tick_mutex);
+	script_tick_seconds += seconds;
+	post = !script_tick_pending;
+	script_tick_pending = true;
+	pthread_mutex_unlock(&script_tick_mutex);
+
+	if (post)
+		os_sem_post(script_tick_semaphore);
+
+	UNUSED_PARAMETER(param);
+}
+
+static uint64_t get_frame_interval(void)
+{
+	struct obs_video_info ovi;
+
+	if (!obs_get_video_info(&ovi) || !ovi.fps_num)
+		return 0;
+
+	return 1000000000ULL * ovi.fps_den / ovi.fps_num;
+}
+
+static void *script_thread(void *unused)
+{
+	os_set_thread_name("obs-scripting: script thread");
+	profile_register_root(script_thread_name, get_frame_interval());
+
+	while (os_sem_wait(script_tick_semaphore) == 0) {
+		pthread_mutex_lock(&script_tick_mutex);
+		if (script_tick_exit) {
+			pthread_mutex_unlock(&script_tick_mutex);
+			break;
+		}
+
+		cur_tick_seconds = script_tick_seconds;
+		script_tick_seconds = 0.0f;
+		script_tick_pending = false;
+		pthread_mutex_unlock(&script_tick_mutex);
+
+		cur_tick_batch++;
+
+		profile_start(script_thread_name);
+		pthread_mutex_lock(&script_callbacks_mutex);
+
+		for (size_t i = script_tick_callbacks.num; i > 0; i--) {
+			struct script_tick_callback *cb =
+				script_tick_callbacks.array + (i - 1);
+			cb->tick(cb->param, cur_tick_seconds);
+		}
+
+		pthread_mutex_unlock(&script_callbacks_mutex);
+		profile_end(script_thread_name);
+
+		profile_reenable_thread();
+	}
+
+	UNUSED_PARAMETER(unused);
+	return NULL;
+}
+
+void script_add_tick_callback(script_tick_cb tick, void *param)
+{
+	struct script_tick_callback data = {tick, param};
+
+	pthread_mutex_lock(&script_callbacks_mutex);
+	da_insert(script_tick_callbacks, 0, &data);
+	pthread_mutex_unlock(&script_callbacks_mutex);
+}
+
+void script_remove_tick_callback(script_tick_cb tick, void *param)
+{
+	struct script_tick_callback data = {tick, param};
+
+	pthread_mutex_lock(&script_callbacks_mutex);
+	da_erase_item(script_tick_callbacks, &data);
+	pthread_mutex_unlock(&script_callbacks_mutex);
+}
+
+bool script_call_begin(obs_script_t *script, float *seconds, uint64_t *start)
+{
+	/* the throttle decision is made once per tick so that all of a
+	 * script's callbacks are skipped or run together */
+	if (script->tick_batch != cur_tick_batch) {
+		script->tick_batch = cur_tick_batch;
+		script->batch_skipped = cur_tick_batch < script->throttle_until;
+
+		if (script->batch_skipped) {
+			script->skipped_seconds += cur_tick_seconds;
+		} else {
+			script->batch_seconds =
+				cur_tick_seconds + script->skipped_seconds;
+			script->skipped_seconds = 0.0f;
+		}
+	}
+
+	if (script->batch_skipped)
+		return false;
+
+	if (seconds)
+		*seconds = script->batch_seconds;
+
+	if (!script->profile_tick_name)
+		script->profile_tick_name = profile_store_name(
+			obs_get_profiler_name_store(), "script_tick(%s)",
+			script->file.array);
+
+	profile_start(script->profile_tick_name);
+	*start = os_gettime_ns();
+	return true;
+}
+
+void script_call_end(obs_script_t *script, uint64_t start)
+{
+	uint64_t elapsed = os_gettime_ns() - start;
+	long budget_ms = os_atomic_load_long(&script_tick_budget_ms);
+	uint64_t budget = (uint64_t)budget_ms * 1000000ULL;
+
+	profile_end(script->profile_tick_name);
+	script->tick_time_ns += elapsed;
+
+	if (budget && elapsed > budget) {
+		script->throttle_until = cur_tick_batch + elapsed / budget + 1;
+
+		if (!script->throttled)
+			script_warn(script,
+				    "Tick took %.1f ms (budget %ld ms), "
+				    "throttling script",
+				    (double)elapsed / 1000000.0, budget_ms);
+		script->throttled = true;
+
+	} else if (cur_tick_batch >= script->throttle_until) {
+		script->throttled = false;
+	}
+}
+
+void obs_scripting_set_tick_budget(uint32_t budget_ms)
+{
+	os_atomic_set_long(&script_tick_budget_ms, (long)budget_ms);
+}
+
+static bool script_thread_init(void)
+{
+	pthread_mutexattr_t attr;
+
+	if (pthread_mutexattr_init(&attr) != 0)
+		return false;
+	if (pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE) != 0)
+		goto fail_attr;
+	if (pthread_mutex_init(&script_callbacks_mutex, &attr) != 0)
+		goto fail_attr;
+	if (pthread_mutex_init(&script_tick_mutex, NULL) != 0)
+		goto fail_tick_mutex;
+	if (os_sem_init(&script_tick_semaphore, 0) != 0)
+		goto fail_sem;
+
+	script_tick_exit = false;
+	if (pthread_create(&script_tick_thread, NULL, script_thread, NULL) !=
+	    0)
+		goto fail_thread;
+
+	pthread_mutexattr_destroy(&attr);
+	obs_add_tick_callback(post_script_tick, NULL);
+	return true;
+
+fail_thread:
+	os_sem_destroy(script_tick_semaphore);
+fail_sem:
+	pthread_mutex_destroy(&script_tick_mutex);
+fail_tick_mutex:
+	pthread_mutex_destroy(&script_callbacks_mutex);
+fail_attr:
+	pthread_mutexattr_destroy(&attr);
+	return false;
+}
+
+static void script_thread_free(void)
+{
+	obs_remove_tick_callback(post_script_tick, NULL);
+
+	pthread_mutex_lock(&script_tick_mutex);
+	script_tick_exit = true;
+	pthread_mutex_unlock(&script_tick_mutex);
+
+	os_sem_post(script_tick_semaphore);
+	pthread_join(script_tick_thread, NULL);
+
+	da_free(script_tick_callbacks);
+	os_sem_destroy(script_tick_semaphore);
+	pthread_mutex_destroy(&script_tick_mutex);
+	pthread_mutex_destroy(&script_callbacks_mutex);
+}
+
+/* -------------------------------------------- */
+
 bool obs_scripting_load(void)
 {
 	circlebuf_init(&defer_call_queue);
@@ -144,6 +367,16 @@ bool obs_scripting_load(void)
 		return false;
 	}
 
+	if (!script_thread_init()) {
+		defer_call_exit = true;
+		os_sem_post(defer_call_semaphore);
+		pthread_join(defer_call_thread, NULL);
+		os_sem_destroy(defer_call_semaphore);
+		pthread_mutex_destroy(&defer_call_mutex);
+		pthread_mutex_destroy(&detach_mutex);
+		return false;
+	}
+
 #if COMPILE_LUA
 	obs_lua_load();
 #endif
@@ -174,6 +407,8 @@ void obs_scripting_unload(void)
 	obs_python_unload();
 #endif
 
+	script_thread_free();
+
 	dstr_free(&file_filter);
 
 	/* ---------------------- */
@@ -418,6 +653,11 @@ bool obs_script_loaded(const obs_script_t *script)
 	return ptr_valid(script) ? script->loaded : false;
 }
 
+uint64_t obs_script_get_tick_time_ns(const obs_script_t *script)
+{
+	return ptr_valid(script) ? script->tick_time_ns : 0;
+}
+
 void obs_script_destroy(obs_script_t *script)
 {
 	if (!script)
@@ -65,6 +65,16 @@ EXPORT void obs_script_update(obs_script_t *script, obs_data_t *settings);
 EXPORT bool obs_script_loaded(const obs_script_t *script);
 EXPORT bool obs_script_reload(obs_script_t *script);
 
+/**
+ * Sets the time a script may spend in a single tick or timer callback before
+ * it is throttled (0 to disable).  A throttled script skips ticks in
+ * proportion to how far it went over the budget.
+ */
+EXPORT void obs_scripting_set_tick_budget(uint32_t budget_ms);
+
+/** Total time the script has spent in tick and timer callbacks */
+EXPORT uint64_t obs_script_get_tick_time_ns(const obs_script_t *script);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,280 @@
+/******************************************************************************
+    Copyright (C) 2013 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <util/crc32.h>
+#include <util/platform.h>
+#include "gl-subsystem.h"
+
+/*
+ * Linked programs are stored with glGetProgramBinary in a directory per
+ * driver (vendor/renderer/version string), keyed by the crc and size of the
+ * GLSL of both shaders.  Shaders that compiled once on the driver are marked
+ * so that on the next run they don't need to be compiled at all unless their
+ * program is missing from the cache.
+ */
+
+#define PROGRAM_CACHE_MAGIC 0x5047424F /* "OBGP" */
+#define PROGRAM_CACHE_VERSION 1
+#define PROGRAM_CACHE_MAX_SIZE (16 * 1024 * 1024)
+
+struct program_cache_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vs_crc;
+	uint32_t vs_size;
+	uint32_t ps_crc;
+	uint32_t ps_size;
+	uint32_t format;
+	uint32_t size;
+};
+
+static inline bool program_cache_enabled(const gs_device_t *device)
+{
+	return !dstr_is_empty(&device->program_cache_path);
+}
+
+static void get_program_cache_file(struct dstr *path,
+				   const struct gs_program *program)
+{
+	const struct gs_shader *vs = program->vertex_shader;
+	const struct gs_shader *ps = program->pixel_shader;
+
+	dstr_printf(path, "%s/%08X%08X.bin",
+		    program->device->program_cache_path.array, vs->gl_crc,
+		    ps->gl_crc);
+}
+
+static void get_shader_mark_file(struct dstr *path,
+				 const struct gs_shader *shader)
+{
+	dstr_printf(path, "%s/%08X%08X.ok",
+		    shader->device->program_cache_path.array, shader->gl_crc,
+		    shader->gl_size);
+}
+
+void device_set_shader_cache_path(gs_device_t *device, const char *path)
+{
+	const char *vendor = (const char *)glGetString(GL_VENDOR);
+	const char *renderer = (const char *)glGetString(GL_RENDERER);
+	const char *version = (const char *)glGetString(GL_VERSION);
+	uint32_t driver_crc = 0;
+
+	dstr_free(&device->program_cache_path);
+
+	if (!path || !*path)
+		return;
+
+	if (!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary) {
+		blog(LOG_INFO, "Shader program cache: program binaries not "
+			       "supported by the driver");
+		return;
+	}
+
+	if (vendor)
+		driver_crc = calc_crc32(driver_crc, vendor, strlen(vendor));
+	if (renderer)
+		driver_crc = calc_crc32(driver_crc, renderer, strlen(renderer));
+	if (version)
+		driver_crc = calc_crc32(driver_crc, version, strlen(version));
+
+	dstr_printf(&device->program_cache_path, "%s/gl-%08X", path,
+		    driver_crc);
+
+	if (os_mkdirs(device->program_cache_path.array) == MKDIR_ERROR) {
+		blog(LOG_WARNING, "Shader program cache: failed to create '%s'",
+		     device->program_cache_path.array);
+		dstr_free(&device->program_cache_path);
+		return;
+	}
+
+	blog(LOG_INFO, "Shader program cache: %s",
+	     device->program_cache_path.array);
+}
+
+bool gl_shader_cache_known(const struct gs_shader *shader)
+{
+	struct dstr path = {0};
+	bool known;
+
+	if (!program_cache_enabled(shader->device))
+		return false;
+
+	get_shader_mark_file(&path, shader);
+	known = os_file_exists(path.array);
+	dstr_free(&path);
+	return known;
+}
+
+void gl_shader_cache_mark(const struct gs_shader *shader)
+{
+	struct dstr path = {0};
+	FILE *f;
+
+	if (!program_cache_enabled(shader->device))
+		return;
+
+	get_shader_mark_file(&path, shader);
+	if (!os_file_exists(path.array)) {
+		f = os_fopen(path.array, "wb");
+		if (f)
+			fclose(f);
+	}
+	dstr_free(&path);
+}
+
+static bool read_program_binary(struct gs_program *program, FILE *f)
+{
+	const struct gs_shader *vs = program->vertex_shader;
+	const struct gs_shader *ps = program->pixel_shader;
+	struct program_cache_header header;
+	GLint linked = GL_FALSE;
+	void *data;
+
+	if (fread(&header, 1, sizeof(header), f) != sizeof(header))
+		return false;
+
+	if (header.magic != PROGRAM_CACHE_MAGIC ||
+	    header.version != PROGRAM_CACHE_VERSION ||
+	    header.vs_crc != vs->gl_crc || header.vs_size != vs->gl_size ||
+	    header.ps_crc != ps->gl_crc || header.ps_size != ps->gl_size ||
+	    !header.size || header.size > PROGRAM_CACHE_MAX_SIZE)
+		return false;
+
+	data = bmalloc(header.size);
+	if (fread(data, 1, header.size, f) != header.size) {
+		bfree(data);
+		return false;
+	}
+
+	glProgramBinary(program->obj, (GLenum)header.format, data,
+			(GLsizei)header.size);
+	bfree(data);
+
+	/* the driver is free to reject binaries (e.g. after an update), in
+	 * which case the program just gets linked normally */
+	if (!gl_success("glProgramBinary"))
+		return false;
+
+	glGetProgramiv(program->obj, GL_LINK_STATUS, &linked);
+	if (!gl_success("glGetProgramiv"))
+		return false;
+
+	return linked == GL_TRUE;
+}
+
+bool gl_program_cache_load(struct gs_program *program)
+{
+	gs_device_t *device = program->device;
+	struct dstr path = {0};
+	bool success = false;
+	FILE *f;
+
+	if (!program_cache_enabled(device))
+		return false;
+
+	get_program_cache_file(&path, program);
+
+	f = os_fopen(path.array, "rb");
+	if (f) {
+		success = read_program_binary(program, f);
+		fclose(f);
+	}
+
+	dstr_free(&path);
+
+	if (success)
+		device->program_cache_hits++;
+	else
+		device->program_cache_misses++;
+	return success;
+}
+
+void gl_program_cache_prepare(struct gs_program *program)
+{
+	if (!program_cache_enabled(program->device))
+		return;
+
+	glProgramParameteri(program->obj, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+			    GL_TRUE);
+	gl_success("glProgramParameteri");
+}
+
+void gl_program_cache_save(struct gs_program *program)
+{
+	const struct gs_shader *vs = program->vertex_shader;
+	const struct gs_shader *ps = program->pixel_shader;
+	struct program_cache_header header = {0};
+	struct dstr path = {0};
+	struct dstr temp_path = {0};
+	GLint size = 0;
+	GLsizei written = 0;
+	GLenum format = 0;
+	bool success;
+	void *data;
+	FILE *f;
+
+	if (!program_cache_enabled(program->device))
+		return;
+
+	glGetProgramiv(program->obj, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (!gl_success("glGetProgramiv") || size <= 0 ||
+	    size > PROGRAM_CACHE_MAX_SIZE)
+		return;
+
+	data = bmalloc(size);
+	glGetProgramBinary(program->obj, size, &written, &format, data);
+	if (!gl_success("glGetProgramBinary") || written <= 0)
+		goto cleanup;
+
+	header.magic = PROGRAM_CACHE_MAGIC;
+	header.version = PROGRAM_CACHE_VERSION;
+	header.vs_crc = vs->gl_crc;
+	header.vs_size = vs->gl_size;
+	header.ps_crc = ps->gl_crc;
+	header.ps_size = ps->gl_size;
+	header.format = (uint32_t)format;
+	header.size = (uint32_t)written;
+
+	get_program_cache_file(&path, program);
+	dstr_copy_dstr(&temp_path, &path);
+	dstr_cat(&temp_path, ".tmp");
+
+	f = os_fopen(temp_path.array, "wb");
+	if (!f)
+		goto cleanup;
+
+	success = fwrite(&header, 1, sizeof(header), f) == sizeof(header) &&
+		  fwrite(data, 1, written, f) == (size_t)written;
+	fclose(f);
+
+	if (!success || os_safe_replace(path.array, temp_path.array, NULL) != 0)
+		os_unlink(temp_path.array);
+
+cleanup:
+	dstr_free(&temp_path);
+	dstr_free(&path);
+	bfree(data);
+}
+
+void gl_program_cache_free(gs_device_t *device)
+{
+	if (program_cache_enabled(device))
+		blog(LOG_INFO, "Shader program cache: %u hits, %u misses",
+		     device->program_cache_hits, device->program_cache_misses);
+
+	dstr_free(&device->program_cache_path);
+}
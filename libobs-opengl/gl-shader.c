@@ -22,6 +22,7 @@
 #include <graphics/vec4.h>
 #include <graphics/matrix3.h>
 #include <graphics/matrix4.h>
+#include <util/crc32.h>
 #include "gl-subsystem.h"
 #include "gl-shaderparser.h"
 
@@ -189,9 +190,8 @@ static inline bool gl_process_attribs(struct gs_shader *shader,
 	return true;
 }
 
-static bool gl_shader_init(struct gs_shader *shader,
-			   struct gl_shader_parser *glsp, const char *file,
-			   char **error_string)
+static bool gl_shader_compile(struct gs_shader *shader, const char *source,
+			      const char *file, char **error_string)
 {
 	GLenum type = convert_shader_type(shader->type);
 	int compiled = 0;
@@ -201,8 +201,7 @@ static bool gl_shader_init(struct gs_shader *shader,
 	if (!gl_success("glCreateShader") || !shader->obj)
 		return false;
 
-	glShaderSource(shader->obj, 1, (const GLchar **)&glsp->gl_string.array,
-		       0);
+	glShaderSource(shader->obj, 1, (const GLchar **)&source, 0);
 	if (!gl_success("glShaderSource"))
 		return false;
 
@@ -214,7 +213,7 @@ static bool gl_shader_init(struct gs_shader *shader,
 	blog(LOG_DEBUG, "+++++++++++++++++++++++++++++++++++");
 	blog(LOG_DEBUG, "  GL shader string for: %s", file);
 	blog(LOG_DEBUG, "-----------------------------------");
-	blog(LOG_DEBUG, "%s", glsp->gl_string.array);
+	blog(LOG_DEBUG, "%s", source);
 	blog(LOG_DEBUG, "+++++++++++++++++++++++++++++++++++");
 #endif
 
@@ -240,6 +239,46 @@ static bool gl_shader_init(struct gs_shader *shader,
 
 	gl_get_shader_info(shader->obj, file, error_string);
 
+	if (success)
+		gl_shader_cache_mark(shader);
+
+	return success;
+}
+
+/* compiles a shader whose compilation was deferred because it was already
+ * known to compile, and its program could not be loaded from the cache */
+static bool gl_shader_ensure_compiled(struct gs_shader *shader)
+{
+	bool success;
+
+	if (shader->obj)
+		return true;
+	if (!shader->gl_string)
+		return false;
+
+	success = gl_shader_compile(shader, shader->gl_string, "(cached)",
+				    NULL);
+
+	bfree(shader->gl_string);
+	shader->gl_string = NULL;
+	return success;
+}
+
+static bool gl_shader_init(struct gs_shader *shader,
+			   struct gl_shader_parser *glsp, const char *file,
+			   char **error_string)
+{
+	const char *source = glsp->gl_string.array;
+	bool success = true;
+
+	shader->gl_size = (uint32_t)glsp->gl_string.len;
+	shader->gl_crc = calc_crc32(0, source, glsp->gl_string.len);
+
+	if (gl_shader_cache_known(shader))
+		shader->gl_string = bstrdup(source);
+	else
+		success = gl_shader_compile(shader, source, file, error_string);
+
 	if (success)
 		success = gl_add_params(shader, glsp);
 	/* Only vertex shaders actually require input attributes */
@@ -346,6 +385,7 @@ void gs_shader_destroy(gs_shader_t *shader)
 		gl_success("glDeleteShader");
 	}
 
+	bfree(shader->gl_string);
 	da_free(shader->samplers);
 	da_free(shader->params);
 	da_free(shader->attribs);
@@ -629,50 +669,71 @@ static inline bool assign_program_params(struct gs_program *program)
 	return true;
 }
 
-struct gs_program *gs_program_create(struct gs_device *device)
+static bool gs_program_link(struct gs_program *program)
 {
-	struct gs_program *program = bzalloc(sizeof(*program));
+	bool success = false;
 	int linked = false;
 
-	program->device = device;
-	program->vertex_shader = device->cur_vertex_shader;
-	program->pixel_shader = device->cur_pixel_shader;
+	if (!gl_shader_ensure_compiled(program->vertex_shader) ||
+	    !gl_shader_ensure_compiled(program->pixel_shader))
+		return false;
 
-	program->obj = glCreateProgram();
-	if (!gl_success("glCreateProgram"))
-		goto error_detach_neither;
+	gl_program_cache_prepare(program);
 
 	glAttachShader(program->obj, program->vertex_shader->obj);
 	if (!gl_success("glAttachShader (vertex)"))
-		goto error_detach_neither;
+		return false;
 
 	glAttachShader(program->obj, program->pixel_shader->obj);
 	if (!gl_success("glAttachShader (pixel)"))
-		goto error_detach_vertex;
+		goto detach_vertex;
 
 	glLinkProgram(program->obj);
 	if (!gl_success("glLinkProgram"))
-		goto error;
+		goto detach;
 
 	glGetProgramiv(program->obj, GL_LINK_STATUS, &linked);
 	if (!gl_success("glGetProgramiv"))
-		goto error;
+		goto detach;
 
 	if (linked == GL_FALSE) {
 		print_link_errors(program->obj);
-		goto error;
+		goto detach;
 	}
 
-	if (!assign_program_attribs(program))
-		goto error;
-	if (!assign_program_params(program))
-		goto error;
+	gl_program_cache_save(program);
+	success = true;
 
+detach:
+	glDetachShader(program->obj, program->pixel_shader->obj);
+	gl_success("glDetachShader (pixel)");
+
+detach_vertex:
 	glDetachShader(program->obj, program->vertex_shader->obj);
 	gl_success("glDetachShader (vertex)");
 
-	glDetachShader(program->obj, program->pixel_shader->obj);
-	gl_success("glDetachShader (pixel)");
+	return success;
+}
+
+struct gs_program *gs_program_create(struct gs_device *device)
+{
+	struct gs_program *program = bzalloc(sizeof(*program));
+
+	program->device = device;
+	program->vertex_shader = device->cur_vertex_shader;
+	program->pixel_shader = device->cur_pixel_shader;
+
+	program->obj = glCreateProgram();
+	if (!gl_success("glCreateProgram"))
+		goto error;
+
+	if (!gl_program_cache_load(program) && !gs_program_link(program))
+		goto error;
+
+	if (!assign_program_attribs(program))
+		goto error;
+	if (!assign_program_params(program))
+		goto error;
 
 	program->next = device->first_program;
 	program->prev_next = &device->first_program;
@@ -683,14 +744,6 @@ struct gs_program *gs_program_create(struct gs_device *device)
 	return program;
 
 error:
-	glDetachShader(program->obj, program->pixel_shader->obj);
-	gl_success("glDetachShader (pixel)");
-
-error_detach_vertex:
-	glDetachShader(program->obj, program->vertex_shader->obj);
-	gl_success("glDetachShader (vertex)");
-
-error_detach_neither:
 	gs_program_destroy(program);
 	return NULL;
 }
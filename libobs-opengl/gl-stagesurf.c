@@ -66,9 +66,30 @@ gs_stagesurf_t *device_stagesurface_create(gs_device_t *device, uint32_t width,
 	return surf;
 }
 
+static inline void delete_fence(struct gs_stage_surface *surf)
+{
+	if (surf->fence) {
+		glDeleteSync(surf->fence);
+		surf->fence = NULL;
+	}
+}
+
+/* lets gs_stagesurface_ready check whether the copy has completed without
+ * waiting on it */
+static inline void insert_fence(struct gs_stage_surface *surf)
+{
+	delete_fence(surf);
+
+	surf->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	if (!gl_success("glFenceSync"))
+		surf->fence = NULL;
+}
+
 void gs_stagesurface_destroy(gs_stagesurf_t *stagesurf)
 {
 	if (stagesurf) {
+		delete_fence(stagesurf);
+
 		if (stagesurf->pack_buffer)
 			gl_delete_buffers(1, &stagesurf->pack_buffer);
 
@@ -142,6 +163,7 @@ void device_stage_texture(gs_device_t *device, gs_stagesurf_t *dst,
 	if (!gl_success("glReadPixels"))
 		goto failed_unbind_all;
 
+	insert_fence(dst);
 	success = true;
 
 failed_unbind_all:
@@ -175,6 +197,8 @@ void device_stage_texture(gs_device_t *device, gs_stagesurf_t *dst,
 	if (!gl_success("glGetTexImage"))
 		goto failed;
 
+	insert_fence(dst);
+
 	gl_bind_texture(GL_TEXTURE_2D, 0);
 	gl_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
 	return;
@@ -205,9 +229,27 @@ gs_stagesurface_get_color_format(const gs_stagesurf_t *stagesurf)
 	return stagesurf->format;
 }
 
+bool gs_stagesurface_ready(gs_stagesurf_t *stagesurf)
+{
+	GLenum status;
+
+	if (!stagesurf->fence)
+		return true;
+
+	status = glClientWaitSync(stagesurf->fence, 0, 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+		return false;
+
+	/* signaled, or failed, in which case mapping will just wait */
+	delete_fence(stagesurf);
+	return true;
+}
+
 bool gs_stagesurface_map(gs_stagesurf_t *stagesurf, uint8_t **data,
 			 uint32_t *linesize)
 {
+	delete_fence(stagesurf);
+
 	if (!gl_bind_buffer(GL_PIXEL_PACK_BUFFER, stagesurf->pack_buffer))
 		goto fail;
 
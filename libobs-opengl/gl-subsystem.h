@@ -18,6 +18,7 @@
 #pragma once
 
 #include <util/darray.h>
+#include <util/dstr.h>
 #include <util/threading.h>
 #include <graphics/graphics.h>
 #include <graphics/device-exports.h>
@@ -437,6 +438,12 @@ struct gs_shader {
 	enum gs_shader_type type;
 	GLuint obj;
 
+	/* GLSL source identity for the program cache; the source itself is
+	 * only kept while compiling is deferred */
+	uint32_t gl_crc;
+	uint32_t gl_size;
+	char *gl_string;
+
 	struct gs_shader_param *viewproj;
 	struct gs_shader_param *world;
 
@@ -555,6 +562,9 @@ struct gs_stage_surface {
 	GLint gl_internal_format;
 	GLenum gl_type;
 	GLuint pack_buffer;
+
+	/* signaled once the last staged copy has completed */
+	GLsync fence;
 };
 
 struct gs_zstencil_buffer {
@@ -621,6 +631,10 @@ struct gs_device {
 	DARRAY(struct matrix4) proj_stack;
 
 	struct fbo_info *cur_fbo;
+
+	struct dstr program_cache_path;
+	uint32_t program_cache_hits;
+	uint32_t program_cache_misses;
 };
 
 extern struct fbo_info *get_fbo(gs_texture_t *tex, uint32_t width,
@@ -629,6 +643,13 @@ extern struct fbo_info *get_fbo(gs_texture_t *tex, uint32_t width,
 extern void gl_update(gs_device_t *device);
 extern void gl_clear_context(gs_device_t *device);
 
+extern bool gl_shader_cache_known(const struct gs_shader *shader);
+extern void gl_shader_cache_mark(const struct gs_shader *shader);
+extern bool gl_program_cache_load(struct gs_program *program);
+extern void gl_program_cache_prepare(struct gs_program *program);
+extern void gl_program_cache_save(struct gs_program *program);
+extern void gl_program_cache_free(gs_device_t *device);
+
 extern struct gl_platform *gl_platform_create(gs_device_t *device,
 					      uint32_t adapter);
 extern void gl_platform_destroy(struct gl_platform *platform);
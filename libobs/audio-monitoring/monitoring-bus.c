@@ -0,0 +1,535 @@
+#include "monitoring-bus.h"
+#include <inttypes.h>
+
+#define blog(level, msg, ...) blog(level, "monitoring: " msg, ##__VA_ARGS__)
+
+/* sources are mixed in blocks of this many frames (~5ms at 48khz) */
+#define BUS_BLOCK_FRAMES 256
+
+/* upper bound of mixed audio held back if the device stops consuming */
+#define BUS_MAX_OUTPUT_MS 1000
+
+struct monitoring_bus;
+
+struct audio_monitor {
+	obs_source_t *source;
+	struct monitoring_bus *bus;
+
+	struct circlebuf buf[MAX_AUDIO_CHANNELS];
+	float volume;
+
+	/* an input that ran out of data is left out of the mix decision until
+	 * it sends audio again, so stopped sources don't hold the bus back */
+	bool idle;
+	bool ignore;
+};
+
+/* the open device; a new one is opened separately and swapped in, so that
+ * the bus is never locked while waiting on the device */
+struct bus_sink {
+	char *device_id;
+	const struct monitoring_sink_info *sink;
+	void *sink_data;
+	struct resample_info format;
+	size_t bytes_per_frame;
+	audio_resampler_t *resampler;
+	struct circlebuf output;
+
+	uint64_t blocks;
+	uint64_t starved_blocks;
+	uint64_t dropped_bytes;
+};
+
+struct monitoring_bus {
+	pthread_mutex_t mutex;
+	DARRAY(struct audio_monitor *) inputs;
+
+	uint32_t samples_per_sec;
+	size_t channels;
+	float mix[MAX_AUDIO_CHANNELS][BUS_BLOCK_FRAMES];
+	float temp[BUS_BLOCK_FRAMES];
+
+	struct bus_sink dev;
+};
+
+/* ------------------------------------------------------------------------- */
+
+static inline size_t get_latency_frames(const struct monitoring_bus *bus)
+{
+	return (size_t)((uint64_t)obs->audio.monitoring_latency_ms *
+			bus->samples_per_sec / 1000);
+}
+
+static void sink_close(struct bus_sink *dev)
+{
+	if (dev->sink_data) {
+		blog(LOG_INFO,
+		     "Closed '%s': %" PRIu64 " blocks mixed, %" PRIu64
+		     " with starved inputs, %" PRIu64 " bytes dropped",
+		     dev->device_id, dev->blocks, dev->starved_blocks,
+		     dev->dropped_bytes);
+		dev->sink->destroy(dev->sink_data);
+	}
+
+	audio_resampler_destroy(dev->resampler);
+	circlebuf_free(&dev->output);
+	bfree(dev->device_id);
+
+	memset(dev, 0, sizeof(*dev));
+}
+
+static void sink_open(struct bus_sink *dev)
+{
+	const struct audio_output_info *info =
+		audio_output_get_info(obs->audio.audio);
+	const char *id = obs->audio.monitoring_device_id;
+	uint32_t latency_ms = obs->audio.monitoring_latency_ms;
+	struct resample_info from = {.samples_per_sec = info->samples_per_sec,
+				     .speakers = info->speakers,
+				     .format = AUDIO_FORMAT_FLOAT_PLANAR};
+
+	if (!id)
+		return;
+
+	/* kept even if the device fails to open, so that it isn't retried
+	 * for every monitor until the device changes */
+	dev->device_id = bstrdup(id);
+
+	dev->sink = monitoring_get_sink(id);
+	dev->sink_data = dev->sink->create(id, latency_ms, &dev->format);
+	if (!dev->sink_data) {
+		blog(LOG_WARNING, "Failed to open '%s' (%s)", id,
+		     dev->sink->name);
+		dev->sink = NULL;
+		return;
+	}
+
+	dev->resampler = audio_resampler_create(&dev->format, &from);
+	if (!dev->resampler) {
+		blog(LOG_WARNING, "Failed to create resampler");
+		dev->sink->destroy(dev->sink_data);
+		dev->sink = NULL;
+		dev->sink_data = NULL;
+		return;
+	}
+
+	dev->bytes_per_frame = get_audio_size(dev->format.format,
+					      dev->format.speakers, 1);
+
+	blog(LOG_INFO, "Opened '%s' (%s), target latency: %" PRIu32 " ms", id,
+	     dev->sink->name, latency_ms);
+}
+
+/* opening a device can block for a while, and the audio thread of every
+ * monitored source waits on the bus lock, so only the swap is locked */
+static void bus_reopen_sink(struct monitoring_bus *bus)
+{
+	struct bus_sink dev = {0};
+	struct bus_sink old;
+
+	sink_open(&dev);
+
+	pthread_mutex_lock(&bus->mutex);
+	old = bus->dev;
+	bus->dev = dev;
+	pthread_mutex_unlock(&bus->mutex);
+
+	sink_close(&old);
+}
+
+static struct monitoring_bus *bus_create(void)
+{
+	const struct audio_output_info *info =
+		audio_output_get_info(obs->audio.audio);
+	struct monitoring_bus *bus = bzalloc(sizeof(*bus));
+
+	if (pthread_mutex_init(&bus->mutex, NULL) != 0) {
+		bfree(bus);
+		return NULL;
+	}
+
+	bus->samples_per_sec = info->samples_per_sec;
+	bus->channels = audio_output_get_channels(obs->audio.audio);
+
+	/* inputs are still tracked if the device fails to open, their audio
+	 * is just discarded until the device is reset */
+	sink_open(&bus->dev);
+	return bus;
+}
+
+static void bus_destroy(struct monitoring_bus *bus)
+{
+	sink_close(&bus->dev);
+	da_free(bus->inputs);
+	pthread_mutex_destroy(&bus->mutex);
+	bfree(bus);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline void mix_input(float *dst, const float *src, size_t frames,
+			     float vol)
+{
+	if (close_float(vol, 1.0f, EPSILON)) {
+		for (size_t i = 0; i < frames; i++)
+			dst[i] += src[i];
+	} else {
+		for (size_t i = 0; i < frames; i++)
+			dst[i] += src[i] * vol;
+	}
+}
+
+static void bus_mix_block(struct monitoring_bus *bus)
+{
+	const uint8_t *planes[MAX_AV_PLANES] = {0};
+	uint8_t *out[MAX_AV_PLANES];
+	uint32_t out_frames;
+	uint64_t ts_offset;
+	bool starved = false;
+
+	for (size_t ch = 0; ch < bus->channels; ch++)
+		memset(bus->mix[ch], 0, sizeof(bus->mix[ch]));
+
+	for (size_t i = 0; i < bus->inputs.num; i++) {
+		struct audio_monitor *monitor = bus->inputs.array[i];
+		size_t frames = monitor->buf[0].size / sizeof(float);
+
+		if (monitor->ignore)
+			continue;
+
+		if (frames < BUS_BLOCK_FRAMES) {
+			if (!monitor->idle)
+				starved = true;
+			monitor->idle = true;
+		} else {
+			frames = BUS_BLOCK_FRAMES;
+		}
+
+		for (size_t ch = 0; ch < bus->channels; ch++) {
+			circlebuf_pop_front(&monitor->buf[ch], bus->temp,
+					    frames * sizeof(float));
+			mix_input(bus->mix[ch], bus->temp, frames,
+				  monitor->volume);
+		}
+	}
+
+	bus->dev.blocks++;
+	if (starved)
+		bus->dev.starved_blocks++;
+
+	if (!bus->dev.resampler)
+		return;
+
+	for (size_t ch = 0; ch < bus->channels; ch++)
+		planes[ch] = (const uint8_t *)bus->mix[ch];
+
+	if (audio_resampler_resample(bus->dev.resampler, out, &out_frames,
+				     &ts_offset, planes, BUS_BLOCK_FRAMES))
+		circlebuf_push_back(&bus->dev.output, out[0],
+				    out_frames * bus->dev.bytes_per_frame);
+}
+
+/* mixes a block once every active input has one, or once an input has
+ * waited for the target latency on the ones that don't */
+static void bus_mix(struct monitoring_bus *bus)
+{
+	struct bus_sink *dev = &bus->dev;
+	size_t latency_frames = get_latency_frames(bus);
+	size_t max_output;
+
+	for (;;) {
+		size_t min_frames = SIZE_MAX;
+		size_t max_frames = 0;
+
+		for (size_t i = 0; i < bus->inputs.num; i++) {
+			struct audio_monitor *monitor = bus->inputs.array[i];
+			size_t frames = monitor->buf[0].size / sizeof(float);
+
+			if (monitor->ignore)
+				continue;
+			if (frames > max_frames)
+				max_frames = frames;
+			if (!monitor->idle && frames < min_frames)
+				min_frames = frames;
+		}
+
+		if (max_frames < BUS_BLOCK_FRAMES)
+			break;
+		if (min_frames < BUS_BLOCK_FRAMES &&
+		    max_frames < latency_frames + BUS_BLOCK_FRAMES)
+			break;
+
+		bus_mix_block(bus);
+	}
+
+	if (!dev->sink_data)
+		return;
+
+	if (dev->output.size)
+		dev->sink->write(dev->sink_data, &dev->output);
+
+	max_output = (size_t)dev->format.samples_per_sec * BUS_MAX_OUTPUT_MS /
+		     1000 * dev->bytes_per_frame;
+	if (dev->output.size > max_output) {
+		size_t drop = dev->output.size - max_output;
+		circlebuf_pop_front(&dev->output, NULL, drop);
+		dev->dropped_bytes += drop;
+	}
+}
+
+static void on_audio_playback(void *param, obs_source_t *source,
+			      const struct audio_data *audio_data, bool muted)
+{
+	struct audio_monitor *monitor = param;
+	struct monitoring_bus *bus = monitor->bus;
+	size_t size = audio_data->frames * sizeof(float);
+
+	pthread_mutex_lock(&bus->mutex);
+
+	if (monitor->ignore || os_atomic_load_long(&source->activate_refs) == 0)
+		goto unlock;
+
+	for (size_t ch = 0; ch < bus->channels; ch++) {
+		if (muted || !audio_data->data[ch])
+			circlebuf_push_back_zero(&monitor->buf[ch], size);
+		else
+			circlebuf_push_back(&monitor->buf[ch],
+					    audio_data->data[ch], size);
+	}
+
+	monitor->volume = source->user_volume;
+	monitor->idle = false;
+
+	bus_mix(bus);
+
+unlock:
+	pthread_mutex_unlock(&bus->mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static bool should_ignore(obs_source_t *source)
+{
+	const char *id = obs->audio.monitoring_device_id;
+	bool match;
+
+	if (!id ||
+	    (source->info.output_flags & OBS_SOURCE_DO_NOT_SELF_MONITOR) == 0)
+		return false;
+
+	obs_data_t *s = obs_source_get_settings(source);
+	const char *s_dev_id = obs_data_get_string(s, "device_id");
+	match = devices_match(s_dev_id, id);
+	if (match)
+		blog(LOG_INFO, "Prevented feedback-loop in '%s'", s_dev_id);
+	obs_data_release(s);
+
+	return match;
+}
+
+static inline void clear_input(struct audio_monitor *monitor)
+{
+	for (size_t ch = 0; ch < MAX_AUDIO_CHANNELS; ch++)
+		circlebuf_pop_front(&monitor->buf[ch], NULL,
+				    monitor->buf[ch].size);
+}
+
+struct audio_monitor *audio_monitor_create(obs_source_t *source)
+{
+	struct audio_monitor *monitor;
+	struct monitoring_bus *bus;
+	bool ignore = should_ignore(source);
+
+	pthread_mutex_lock(&obs->audio.monitoring_mutex);
+
+	bus = obs->audio.monitoring_bus;
+	if (!bus)
+		bus = obs->audio.monitoring_bus = bus_create();
+	if (!bus) {
+		pthread_mutex_unlock(&obs->audio.monitoring_mutex);
+		return NULL;
+	}
+
+	monitor = bzalloc(sizeof(*monitor));
+	monitor->source = source;
+	monitor->bus = bus;
+	monitor->volume = 1.0f;
+	monitor->idle = true;
+	monitor->ignore = ignore;
+
+	pthread_mutex_lock(&bus->mutex);
+	da_push_back(bus->inputs, &monitor);
+	pthread_mutex_unlock(&bus->mutex);
+
+	da_push_back(obs->audio.monitors, &monitor);
+	pthread_mutex_unlock(&obs->audio.monitoring_mutex);
+
+	obs_source_add_audio_capture_callback(source, on_audio_playback,
+					      monitor);
+	return monitor;
+}
+
+void audio_monitor_reset(struct audio_monitor *monitor)
+{
+	struct monitoring_bus *bus = monitor->bus;
+	const char *id = obs->audio.monitoring_device_id;
+	bool ignore = should_ignore(monitor->source);
+	bool reopen;
+
+	pthread_mutex_lock(&bus->mutex);
+
+	monitor->ignore = ignore;
+	if (ignore)
+		clear_input(monitor);
+
+	/* the first monitor reset after a device change reopens the bus */
+	reopen = !bus->dev.device_id || !id ||
+		 strcmp(bus->dev.device_id, id) != 0;
+
+	pthread_mutex_unlock(&bus->mutex);
+
+	if (reopen)
+		bus_reopen_sink(bus);
+}
+
+void audio_monitor_destroy(struct audio_monitor *monitor)
+{
+	struct monitoring_bus *bus;
+
+	if (!monitor)
+		return;
+
+	bus = monitor->bus;
+
+	obs_source_remove_audio_capture_callback(monitor->source,
+						 on_audio_playback, monitor);
+
+	pthread_mutex_lock(&obs->audio.monitoring_mutex);
+	da_erase_item(obs->audio.monitors, &monitor);
+
+	pthread_mutex_lock(&bus->mutex);
+	da_erase_item(bus->inputs, &monitor);
+	pthread_mutex_unlock(&bus->mutex);
+
+	if (!bus->inputs.num) {
+		bus_destroy(bus);
+		obs->audio.monitoring_bus = NULL;
+	}
+
+	pthread_mutex_unlock(&obs->audio.monitoring_mutex);
+
+	for (size_t ch = 0; ch < MAX_AUDIO_CHANNELS; ch++)
+		circlebuf_free(&monitor->buf[ch]);
+	bfree(monitor);
+}
+
+/* reopens the device, e.g. to apply a new latency target */
+void audio_monitoring_bus_reset(void)
+{
+	struct monitoring_bus *bus;
+
+	pthread_mutex_lock(&obs->audio.monitoring_mutex);
+
+	bus = obs->audio.monitoring_bus;
+	if (bus)
+		bus_reopen_sink(bus);
+
+	pthread_mutex_unlock(&obs->audio.monitoring_mutex);
+}
+
+/* time from a source sending audio until the device plays it: the worst
+ * case input buffering, plus the mixed audio not yet taken by the device,
+ * plus the device's own latency */
+uint64_t audio_monitoring_bus_get_latency(void)
+{
+	struct monitoring_bus *bus;
+	uint64_t latency = 0;
+
+	pthread_mutex_lock(&obs->audio.monitoring_mutex);
+
+	bus = obs->audio.monitoring_bus;
+	if (bus) {
+		size_t max_frames = 0;
+
+		pthread_mutex_lock(&bus->mutex);
+
+		for (size_t i = 0; i < bus->inputs.num; i++) {
+			struct audio_monitor *monitor = bus->inputs.array[i];
+			size_t frames = monitor->buf[0].size / sizeof(float);
+
+			if (!monitor->ignore && frames > max_frames)
+				max_frames = frames;
+		}
+
+		latency = audio_frames_to_ns(bus->samples_per_sec,
+					     max_frames);
+
+		struct bus_sink *dev = &bus->dev;
+		if (dev->sink_data) {
+			size_t out_frames =
+				dev->output.size / dev->bytes_per_frame;
+			latency += audio_frames_to_ns(
+				dev->format.samples_per_sec, out_frames);
+			latency += dev->sink->get_latency(dev->sink_data);
+		}
+
+		pthread_mutex_unlock(&bus->mutex);
+	}
+
+	pthread_mutex_unlock(&obs->audio.monitoring_mutex);
+	return latency;
+}
+
+/* ------------------------------------------------------------------------- */
+
+struct null_sink {
+	size_t bytes_per_frame;
+	uint64_t frames;
+};
+
+static void *null_sink_create(const char *device_id, uint32_t latency_ms,
+			      struct resample_info *format)
+{
+	const struct audio_output_info *info =
+		audio_output_get_info(obs->audio.audio);
+	struct null_sink *sink = bzalloc(sizeof(*sink));
+
+	format->samples_per_sec = info->samples_per_sec;
+	format->speakers = info->speakers;
+	format->format = AUDIO_FORMAT_FLOAT;
+	sink->bytes_per_frame = get_audio_size(format->format,
+					       format->speakers, 1);
+
+	UNUSED_PARAMETER(device_id);
+	UNUSED_PARAMETER(latency_ms);
+	return sink;
+}
+
+static void null_sink_destroy(void *data)
+{
+	struct null_sink *sink = data;
+	blog(LOG_INFO, "Null sink: discarded %" PRIu64 " frames", sink->frames);
+	bfree(sink);
+}
+
+static void null_sink_write(void *data, struct circlebuf *output)
+{
+	struct null_sink *sink = data;
+
+	sink->frames += output->size / sink->bytes_per_frame;
+	circlebuf_pop_front(output, NULL, output->size);
+}
+
+static uint64_t null_sink_get_latency(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return 0;
+}
+
+const struct monitoring_sink_info null_monitoring_sink = {
+	.name = "null",
+	.create = null_sink_create,
+	.destroy = null_sink_destroy,
+	.write = null_sink_write,
+	.get_latency = null_sink_get_latency,
+};
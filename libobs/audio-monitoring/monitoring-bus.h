@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../obs-internal.h"
+
+/*
+ * The monitoring bus mixes every monitored source into a single stream for
+ * the monitoring device, instead of opening one device stream (with its own
+ * resampler and buffering) per source.  The platform provides the sink that
+ * the mixed audio is written to.
+ */
+
+struct monitoring_sink_info {
+	const char *name;
+
+	/* opens the device, and sets the format the bus should mix to */
+	void *(*create)(const char *device_id, uint32_t latency_ms,
+			struct resample_info *format);
+	void (*destroy)(void *data);
+
+	/* consumes as much of the mixed (interleaved) audio as the device
+	 * currently accepts.  called with the bus locked */
+	void (*write)(void *data, struct circlebuf *output);
+
+	/* latency of the audio already handed to the device, in nanoseconds */
+	uint64_t (*get_latency)(void *data);
+};
+
+/* discards the mixed audio; used for the "null" device */
+extern const struct monitoring_sink_info null_monitoring_sink;
+
+/* implemented by the platform */
+extern const struct monitoring_sink_info *
+monitoring_get_sink(const char *device_id);
+extern bool devices_match(const char *id1, const char *id2);
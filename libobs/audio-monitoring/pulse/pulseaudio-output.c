@@ -1,31 +1,29 @@
 #include "obs-internal.h"
 #include "pulseaudio-wrapper.h"
+#include "../monitoring-bus.h"
 
-#define PULSE_DATA(voidptr) struct audio_monitor *data = voidptr;
+#define PULSE_DATA(voidptr) struct pulse_sink *data = voidptr;
 #define blog(level, msg, ...) blog(level, "pulse-am: " msg, ##__VA_ARGS__)
 
-struct audio_monitor {
-	obs_source_t *source;
+/* underflows grow the target latency up to this */
+#define PULSE_MAX_TLENGTH_MS 500
+
+struct pulse_sink {
 	pa_stream *stream;
 	char *device;
 	pa_buffer_attr attr;
-	enum speaker_layout speakers;
 	pa_sample_format_t format;
 	uint_fast32_t samples_per_sec;
 	uint_fast32_t bytes_per_frame;
 	uint_fast8_t channels;
 
-	uint_fast32_t packets;
 	uint_fast64_t frames;
+	uint_fast32_t underflows;
+	uint32_t max_tlength;
+	uint64_t last_write_ts;
 
-	struct circlebuf new_data;
-	audio_resampler_t *resampler;
-	size_t buffer_size;
-	size_t bytesRemaining;
-	size_t bytes_per_channel;
-
-	bool ignore;
-	pthread_mutex_t playback_mutex;
+	size_t bytes_remaining;
+	pthread_mutex_t mutex;
 };
 
 static enum speaker_layout
@@ -125,132 +123,14 @@ static pa_channel_map pulseaudio_channel_map(enum speaker_layout layout)
 	return ret;
 }
 
-static void process_byte(void *p, size_t frames, size_t channels, float vol)
-{
-	register char *cur = (char *)p;
-	register char *end = cur + frames * channels;
-
-	while (cur < end)
-		*(cur++) *= vol;
-}
-
-static void process_short(void *p, size_t frames, size_t channels, float vol)
-{
-	register short *cur = (short *)p;
-	register short *end = cur + frames * channels;
-
-	while (cur < end)
-		*(cur++) *= vol;
-}
-
-static void process_float(void *p, size_t frames, size_t channels, float vol)
-{
-	register float *cur = (float *)p;
-	register float *end = cur + frames * channels;
-
-	while (cur < end)
-		*(cur++) *= vol;
-}
-
-void process_volume(const struct audio_monitor *monitor, float vol,
-		    uint8_t *const *resample_data, uint32_t resample_frames)
-{
-	switch (monitor->bytes_per_channel) {
-	case 1:
-		process_byte(resample_data[0], resample_frames,
-			     monitor->channels, vol);
-		break;
-	case 2:
-		process_short(resample_data[0], resample_frames,
-			      monitor->channels, vol);
-		break;
-	default:
-		process_float(resample_data[0], resample_frames,
-			      monitor->channels, vol);
-		break;
-	}
-}
-
-static void do_stream_write(void *param)
-{
-	PULSE_DATA(param);
-	uint8_t *buffer = NULL;
-
-	while (data->new_data.size >= data->buffer_size &&
-	       data->bytesRemaining > 0) {
-		size_t bytesToFill = data->buffer_size;
-
-		if (bytesToFill > data->bytesRemaining)
-			bytesToFill = data->bytesRemaining;
-
-		pa_stream_begin_write(data->stream, (void **)&buffer,
-				      &bytesToFill);
-
-		circlebuf_pop_front(&data->new_data, buffer, bytesToFill);
-
-		pulseaudio_lock();
-		pa_stream_write(data->stream, buffer, bytesToFill, NULL, 0LL,
-				PA_SEEK_RELATIVE);
-		pulseaudio_unlock();
-
-		data->bytesRemaining -= bytesToFill;
-	}
-}
-
-static void on_audio_playback(void *param, obs_source_t *source,
-			      const struct audio_data *audio_data, bool muted)
-{
-	struct audio_monitor *monitor = param;
-	float vol = source->user_volume;
-	size_t bytes;
-
-	uint8_t *resample_data[MAX_AV_PLANES];
-	uint32_t resample_frames;
-	uint64_t ts_offset;
-	bool success;
-
-	if (pthread_mutex_trylock(&monitor->playback_mutex) != 0)
-		return;
-
-	if (os_atomic_load_long(&source->activate_refs) == 0)
-		goto unlock;
-
-	success = audio_resampler_resample(
-		monitor->resampler, resample_data, &resample_frames, &ts_offset,
-		(const uint8_t *const *)audio_data->data,
-		(uint32_t)audio_data->frames);
-
-	if (!success)
-		goto unlock;
-
-	bytes = monitor->bytes_per_frame * resample_frames;
-
-	if (muted) {
-		memset(resample_data[0], 0, bytes);
-	} else {
-		if (!close_float(vol, 1.0f, EPSILON)) {
-			process_volume(monitor, vol, resample_data,
-				       resample_frames);
-		}
-	}
-
-	circlebuf_push_back(&monitor->new_data, resample_data[0], bytes);
-	monitor->packets++;
-	monitor->frames += resample_frames;
-
-unlock:
-	pthread_mutex_unlock(&monitor->playback_mutex);
-	do_stream_write(param);
-}
-
 static void pulseaudio_stream_write(pa_stream *p, size_t nbytes, void *userdata)
 {
 	UNUSED_PARAMETER(p);
 	PULSE_DATA(userdata);
 
-	pthread_mutex_lock(&data->playback_mutex);
-	data->bytesRemaining += nbytes;
-	pthread_mutex_unlock(&data->playback_mutex);
+	pthread_mutex_lock(&data->mutex);
+	data->bytes_remaining += nbytes;
+	pthread_mutex_unlock(&data->mutex);
 
 	pulseaudio_signal(0);
 }
@@ -260,12 +140,27 @@ static void pulseaudio_underflow(pa_stream *p, void *userdata)
 	UNUSED_PARAMETER(p);
 	PULSE_DATA(userdata);
 
-	pthread_mutex_lock(&data->playback_mutex);
-	if (obs_source_active(data->source))
-		data->attr.tlength = (data->attr.tlength * 3) / 2;
-
-	pa_stream_set_buffer_attr(data->stream, &data->attr, NULL, NULL);
-	pthread_mutex_unlock(&data->playback_mutex);
+	pthread_mutex_lock(&data->mutex);
+	data->underflows++;
+
+	/* the stream is shared by every monitored source, so it underflows
+	 * whenever they all go quiet.  only grow the buffer if audio was
+	 * still being written within half the current target latency */
+	uint64_t tlength_ns = audio_frames_to_ns(
+		data->samples_per_sec,
+		data->attr.tlength / data->bytes_per_frame);
+	bool feeding = os_gettime_ns() - data->last_write_ts < tlength_ns / 2;
+
+	if (feeding && data->attr.tlength < data->max_tlength) {
+		uint32_t tlength = (data->attr.tlength * 3) / 2;
+		if (tlength > data->max_tlength)
+			tlength = data->max_tlength;
+
+		data->attr.tlength = tlength;
+		pa_stream_set_buffer_attr(data->stream, &data->attr, NULL,
+					  NULL);
+	}
+	pthread_mutex_unlock(&data->mutex);
 
 	pulseaudio_signal(0);
 }
@@ -328,231 +223,184 @@ skip:
 	pulseaudio_signal(0);
 }
 
-static void pulseaudio_stop_playback(struct audio_monitor *monitor)
+static void pulse_sink_destroy(void *param)
 {
-	if (monitor->stream) {
-		pa_stream_disconnect(monitor->stream);
-		pa_stream_unref(monitor->stream);
-		monitor->stream = NULL;
-	}
+	PULSE_DATA(param);
 
-	blog(LOG_INFO, "Stopped Monitoring in '%s'", monitor->device);
-	blog(LOG_INFO,
-	     "Got %" PRIuFAST32 " packets with %" PRIuFAST64 " frames",
-	     monitor->packets, monitor->frames);
+	if (data->stream) {
+		pa_stream_disconnect(data->stream);
+		pa_stream_unref(data->stream);
 
-	monitor->packets = 0;
-	monitor->frames = 0;
+		blog(LOG_INFO, "Stopped Monitoring in '%s'", data->device);
+		blog(LOG_INFO,
+		     "Wrote %" PRIuFAST64 " frames, %" PRIuFAST32 " underflows",
+		     data->frames, data->underflows);
+	}
+
+	pulseaudio_unref();
+	pthread_mutex_destroy(&data->mutex);
+	bfree(data->device);
+	bfree(data);
 }
 
-static bool audio_monitor_init(struct audio_monitor *monitor,
-			       obs_source_t *source)
+static void *pulse_sink_create(const char *id, uint32_t latency_ms,
+			       struct resample_info *format)
 {
-	pthread_mutex_init_value(&monitor->playback_mutex);
-
-	monitor->source = source;
-
-	const char *id = obs->audio.monitoring_device_id;
-	if (!id)
-		return false;
-
-	if (source->info.output_flags & OBS_SOURCE_DO_NOT_SELF_MONITOR) {
-		obs_data_t *s = obs_source_get_settings(source);
-		const char *s_dev_id = obs_data_get_string(s, "device_id");
-		bool match = devices_match(s_dev_id, id);
-		obs_data_release(s);
-
-		if (match) {
-			monitor->ignore = true;
-			blog(LOG_INFO, "Prevented feedback-loop in '%s'",
-			     s_dev_id);
-			return true;
-		}
+	struct pulse_sink *data = bzalloc(sizeof(struct pulse_sink));
+
+	pthread_mutex_init_value(&data->mutex);
+	if (pthread_mutex_init(&data->mutex, NULL) != 0) {
+		blog(LOG_WARNING, "%s: %s", __FUNCTION__,
+		     "Failed to init mutex");
+		bfree(data);
+		return NULL;
 	}
 
 	pulseaudio_init();
 
 	if (strcmp(id, "default") == 0)
-		get_default_id(&monitor->device);
+		get_default_id(&data->device);
 	else
-		monitor->device = bstrdup(id);
+		data->device = bstrdup(id);
 
-	if (!monitor->device)
-		return false;
+	if (!data->device)
+		goto fail;
 
-	if (pulseaudio_get_server_info(pulseaudio_server_info,
-				       (void *)monitor) < 0) {
+	if (pulseaudio_get_server_info(pulseaudio_server_info, (void *)data) <
+	    0) {
 		blog(LOG_ERROR, "Unable to get server info !");
-		return false;
+		goto fail;
 	}
 
-	if (pulseaudio_get_source_info(pulseaudio_source_info, monitor->device,
-				       (void *)monitor) < 0) {
+	if (pulseaudio_get_source_info(pulseaudio_source_info, data->device,
+				       (void *)data) < 0) {
 		blog(LOG_ERROR, "Unable to get source info !");
-		return false;
+		goto fail;
 	}
-	if (monitor->format == PA_SAMPLE_INVALID) {
+	if (data->format == PA_SAMPLE_INVALID) {
 		blog(LOG_ERROR,
 		     "An error occurred while getting the source info!");
-		return false;
+		goto fail;
 	}
 
 	pa_sample_spec spec;
-	spec.format = monitor->format;
-	spec.rate = (uint32_t)monitor->samples_per_sec;
-	spec.channels = monitor->channels;
+	spec.format = data->format;
+	spec.rate = (uint32_t)data->samples_per_sec;
+	spec.channels = data->channels;
 
 	if (!pa_sample_spec_valid(&spec)) {
 		blog(LOG_ERROR, "Sample spec is not valid");
-		return false;
+		goto fail;
 	}
 
-	const struct audio_output_info *info =
-		audio_output_get_info(obs->audio.audio);
-
-	struct resample_info from = {.samples_per_sec = info->samples_per_sec,
-				     .speakers = info->speakers,
-				     .format = AUDIO_FORMAT_FLOAT_PLANAR};
-	struct resample_info to = {
-		.samples_per_sec = (uint32_t)monitor->samples_per_sec,
-		.speakers =
-			pulseaudio_channels_to_obs_speakers(monitor->channels),
-		.format = pulseaudio_to_obs_audio_format(monitor->format)};
-
-	monitor->resampler = audio_resampler_create(&to, &from);
-	if (!monitor->resampler) {
-		blog(LOG_WARNING, "%s: %s", __FUNCTION__,
-		     "Failed to create resampler");
-		return false;
-	}
+	format->samples_per_sec = (uint32_t)data->samples_per_sec;
+	format->speakers = pulseaudio_channels_to_obs_speakers(data->channels);
+	format->format = pulseaudio_to_obs_audio_format(data->format);
 
-	monitor->bytes_per_channel = get_audio_bytes_per_channel(
-		pulseaudio_to_obs_audio_format(monitor->format));
-	monitor->speakers = pulseaudio_channels_to_obs_speakers(spec.channels);
-	monitor->bytes_per_frame = pa_frame_size(&spec);
+	data->bytes_per_frame = pa_frame_size(&spec);
 
-	pa_channel_map channel_map = pulseaudio_channel_map(monitor->speakers);
+	pa_channel_map channel_map = pulseaudio_channel_map(format->speakers);
 
-	monitor->stream = pulseaudio_stream_new(
-		obs_source_get_name(monitor->source), &spec, &channel_map);
-	if (!monitor->stream) {
+	data->stream = pulseaudio_stream_new("Monitoring", &spec, &channel_map);
+	if (!data->stream) {
 		blog(LOG_ERROR, "Unable to create stream");
-		return false;
+		goto fail;
 	}
 
-	monitor->attr.fragsize = (uint32_t)-1;
-	monitor->attr.maxlength = (uint32_t)-1;
-	monitor->attr.minreq = (uint32_t)-1;
-	monitor->attr.prebuf = (uint32_t)-1;
-	monitor->attr.tlength = pa_usec_to_bytes(25000, &spec);
-
-	monitor->buffer_size =
-		monitor->bytes_per_frame * pa_usec_to_bytes(5000, &spec);
+	data->attr.fragsize = (uint32_t)-1;
+	data->attr.maxlength = (uint32_t)-1;
+	data->attr.minreq = (uint32_t)-1;
+	data->attr.prebuf = (uint32_t)-1;
+	data->attr.tlength = pa_usec_to_bytes(latency_ms * 1000, &spec);
+	data->max_tlength =
+		pa_usec_to_bytes(PULSE_MAX_TLENGTH_MS * 1000, &spec);
+	if (data->max_tlength < data->attr.tlength)
+		data->max_tlength = data->attr.tlength;
 
 	pa_stream_flags_t flags = PA_STREAM_INTERPOLATE_TIMING |
 				  PA_STREAM_AUTO_TIMING_UPDATE;
 
-	if (pthread_mutex_init(&monitor->playback_mutex, NULL) != 0) {
-		blog(LOG_WARNING, "%s: %s", __FUNCTION__,
-		     "Failed to init mutex");
-		return false;
-	}
+	pulseaudio_write_callback(data->stream, pulseaudio_stream_write,
+				  (void *)data);
+	pulseaudio_set_underflow_callback(data->stream, pulseaudio_underflow,
+					  (void *)data);
 
 	int_fast32_t ret = pulseaudio_connect_playback(
-		monitor->stream, monitor->device, &monitor->attr, flags);
+		data->stream, data->device, &data->attr, flags);
 	if (ret < 0) {
-		pulseaudio_stop_playback(monitor);
 		blog(LOG_ERROR, "Unable to connect to stream");
-		return false;
+		goto fail;
 	}
 
-	blog(LOG_INFO, "Started Monitoring in '%s'", monitor->device);
-	return true;
-}
-
-static void audio_monitor_init_final(struct audio_monitor *monitor)
-{
-	if (monitor->ignore)
-		return;
-
-	obs_source_add_audio_capture_callback(monitor->source,
-					      on_audio_playback, monitor);
-
-	pulseaudio_write_callback(monitor->stream, pulseaudio_stream_write,
-				  (void *)monitor);
+	blog(LOG_INFO, "Started Monitoring in '%s'", data->device);
+	return data;
 
-	pulseaudio_set_underflow_callback(monitor->stream, pulseaudio_underflow,
-					  (void *)monitor);
+fail:
+	pulse_sink_destroy(data);
+	return NULL;
 }
 
-static inline void audio_monitor_free(struct audio_monitor *monitor)
+static void pulse_sink_write(void *param, struct circlebuf *output)
 {
-	if (monitor->ignore)
-		return;
-
-	if (monitor->source)
-		obs_source_remove_audio_capture_callback(
-			monitor->source, on_audio_playback, monitor);
+	PULSE_DATA(param);
+	uint8_t *buffer = NULL;
+	size_t bytes;
 
-	audio_resampler_destroy(monitor->resampler);
-	circlebuf_free(&monitor->new_data);
+	pthread_mutex_lock(&data->mutex);
+	bytes = data->bytes_remaining;
+	pthread_mutex_unlock(&data->mutex);
 
-	if (monitor->stream)
-		pulseaudio_stop_playback(monitor);
-	pulseaudio_unref();
+	if (bytes > output->size)
+		bytes = output->size;
+	bytes -= bytes % data->bytes_per_frame;
+	if (!bytes)
+		return;
 
-	bfree(monitor->device);
+	pulseaudio_lock();
+	if (pa_stream_begin_write(data->stream, (void **)&buffer, &bytes) < 0) {
+		bytes = 0;
+	} else {
+		bytes -= bytes % data->bytes_per_frame;
+		circlebuf_pop_front(output, buffer, bytes);
+		pa_stream_write(data->stream, buffer, bytes, NULL, 0LL,
+				PA_SEEK_RELATIVE);
+	}
+	pulseaudio_unlock();
+
+	pthread_mutex_lock(&data->mutex);
+	data->bytes_remaining -= bytes;
+	data->frames += bytes / data->bytes_per_frame;
+	if (bytes)
+		data->last_write_ts = os_gettime_ns();
+	pthread_mutex_unlock(&data->mutex);
 }
 
-struct audio_monitor *audio_monitor_create(obs_source_t *source)
+static uint64_t pulse_sink_get_latency(void *param)
 {
-	struct audio_monitor monitor = {0};
-	struct audio_monitor *out;
-
-	if (!audio_monitor_init(&monitor, source))
-		goto fail;
-
-	out = bmemdup(&monitor, sizeof(monitor));
-
-	pthread_mutex_lock(&obs->audio.monitoring_mutex);
-	da_push_back(obs->audio.monitors, &out);
-	pthread_mutex_unlock(&obs->audio.monitoring_mutex);
+	PULSE_DATA(param);
+	pa_usec_t usec = 0;
+	int negative = 0;
+	int ret;
 
-	audio_monitor_init_final(out);
-	return out;
+	pulseaudio_lock();
+	ret = pa_stream_get_latency(data->stream, &usec, &negative);
+	pulseaudio_unlock();
 
-fail:
-	audio_monitor_free(&monitor);
-	return NULL;
+	return (ret == 0 && !negative) ? (uint64_t)usec * 1000 : 0;
 }
 
-void audio_monitor_reset(struct audio_monitor *monitor)
-{
-	struct audio_monitor new_monitor = {0};
-	bool success;
-	audio_monitor_free(monitor);
-
-	pthread_mutex_lock(&monitor->playback_mutex);
-	success = audio_monitor_init(&new_monitor, monitor->source);
-	pthread_mutex_unlock(&monitor->playback_mutex);
-
-	if (success) {
-		*monitor = new_monitor;
-		audio_monitor_init_final(monitor);
-	} else {
-		audio_monitor_free(&new_monitor);
-	}
-}
+static const struct monitoring_sink_info pulse_monitoring_sink = {
+	.name = "pulse",
+	.create = pulse_sink_create,
+	.destroy = pulse_sink_destroy,
+	.write = pulse_sink_write,
+	.get_latency = pulse_sink_get_latency,
+};
 
-void audio_monitor_destroy(struct audio_monitor *monitor)
+const struct monitoring_sink_info *monitoring_get_sink(const char *device_id)
 {
-	if (monitor) {
-		audio_monitor_free(monitor);
-
-		pthread_mutex_lock(&obs->audio.monitoring_mutex);
-		da_erase_item(obs->audio.monitors, &monitor);
-		pthread_mutex_unlock(&obs->audio.monitoring_mutex);
+	if (strcmp(device_id, "null") == 0)
+		return &null_monitoring_sink;
 
-		bfree(monitor);
-	}
+	return &pulse_monitoring_sink;
 }
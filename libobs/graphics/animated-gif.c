@@ -0,0 +1,688 @@
+/******************************************************************************
+    Copyright (C) 2016 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <sys/stat.h>
+
+#include "animated-gif.h"
+#include "libnsgif/libnsgif.h"
+#include "../util/threading.h"
+#include "../util/platform.h"
+#include "../util/darray.h"
+#include "../util/bmem.h"
+#include "../util/base.h"
+
+#define blog(level, format, ...) \
+	blog(level, "%s: " format, __FUNCTION__, __VA_ARGS__)
+
+#define DEFAULT_CACHE_LIMIT (256ULL * 1024ULL * 1024ULL)
+
+struct gif_stream {
+	long refs;
+	char *path;
+	time_t mtime;
+	size_t file_size;
+
+	/* only used by whoever holds decode_mutex */
+	pthread_mutex_t decode_mutex;
+	gif_animation gif;
+	gif_bitmap_callback_vt bitmap_callbacks;
+	uint8_t *file_data;
+	int last_decoded;
+
+	uint32_t cx;
+	uint32_t cy;
+	int frame_count;
+	int loop_count;
+	uint64_t *frame_times;
+
+	/* protected by the global mutex */
+	struct gif_stream_frame **frames;
+	bool *pending;
+
+	struct gif_stream *next;
+	struct gif_stream **prev_next;
+};
+
+struct decode_request {
+	struct gif_stream *stream;
+	int idx;
+};
+
+static pthread_mutex_t gif_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct gif_stream *first_stream = NULL;
+static DARRAY(struct decode_request) requests;
+static size_t cache_size = 0;
+static size_t cache_limit = DEFAULT_CACHE_LIMIT;
+static uint64_t use_counter = 0;
+static bool stopping = false;
+
+/* the decode thread only runs while there are streams open */
+static pthread_mutex_t thread_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t decode_thread;
+static os_sem_t *decode_sem = NULL;
+static long open_count = 0;
+
+/* ------------------------------------------------------------------------- */
+
+static void *bi_def_bitmap_create(int width, int height)
+{
+	return bmalloc(width * height * 4);
+}
+
+static void bi_def_bitmap_set_opaque(void *bitmap, bool opaque)
+{
+	UNUSED_PARAMETER(bitmap);
+	UNUSED_PARAMETER(opaque);
+}
+
+static bool bi_def_bitmap_test_opaque(void *bitmap)
+{
+	UNUSED_PARAMETER(bitmap);
+	return false;
+}
+
+static unsigned char *bi_def_bitmap_get_buffer(void *bitmap)
+{
+	return (unsigned char *)bitmap;
+}
+
+static void bi_def_bitmap_destroy(void *bitmap)
+{
+	bfree(bitmap);
+}
+
+static void bi_def_bitmap_modified(void *bitmap)
+{
+	UNUSED_PARAMETER(bitmap);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline size_t get_frame_size(const struct gif_stream *stream)
+{
+	return (size_t)stream->cx * (size_t)stream->cy * 4;
+}
+
+void gif_stream_frame_release(struct gif_stream_frame *frame)
+{
+	if (frame && os_atomic_dec_long(&frame->refs) == 0)
+		bfree(frame);
+}
+
+static inline void uncache_frame(struct gif_stream *stream, int idx)
+{
+	struct gif_stream_frame *frame = stream->frames[idx];
+
+	stream->frames[idx] = NULL;
+	cache_size -= frame->size;
+	gif_stream_frame_release(frame);
+}
+
+/* evicts least recently used frames until the cache is within its limit.
+ * frames that are still held by image files are only freed once released. */
+static void enforce_cache_limit(const struct gif_stream_frame *keep)
+{
+	while (cache_size > cache_limit) {
+		struct gif_stream *lru_stream = NULL;
+		uint64_t lru_time = UINT64_MAX;
+		int lru_idx = 0;
+
+		for (struct gif_stream *s = first_stream; s; s = s->next) {
+			for (int i = 0; i < s->frame_count; i++) {
+				struct gif_stream_frame *frame = s->frames[i];
+
+				if (frame && frame != keep &&
+				    frame->last_used < lru_time) {
+					lru_stream = s;
+					lru_time = frame->last_used;
+					lru_idx = i;
+				}
+			}
+		}
+
+		if (!lru_stream)
+			break;
+
+		uncache_frame(lru_stream, lru_idx);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* frames can depend on the previous frame, so frames have to be decoded in
+ * order.  the decoder only needs the image of the previous frame though, so
+ * decoding resumes from the closest earlier frame that is either the last
+ * one decoded or still cached, and only starts over from frame 0 if there is
+ * none.  this keeps image files that share a stream at different points of
+ * the animation (or loop after frames were evicted) from restarting from
+ * frame 0 every time. */
+static void decode_to_frame(struct gif_stream *stream, int idx)
+{
+	struct gif_stream_frame *restart = NULL;
+	int prev;
+
+	if (idx == stream->last_decoded)
+		return;
+
+	pthread_mutex_lock(&gif_mutex);
+	for (prev = idx - 1; prev >= 0; prev--) {
+		if (prev == stream->last_decoded)
+			break;
+
+		restart = stream->frames[prev];
+		if (restart) {
+			os_atomic_inc_long(&restart->refs);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&gif_mutex);
+
+	if (restart) {
+		memcpy(stream->gif.frame_image, restart->data, restart->size);
+		stream->gif.decoded_frame = prev;
+		gif_stream_frame_release(restart);
+	}
+
+	for (int i = prev + 1; i <= idx; i++) {
+		if (gif_decode_frame(&stream->gif, i) != GIF_OK)
+			blog(LOG_WARNING, "Couldn't decode frame %d of '%s'",
+			     i, stream->path);
+		stream->last_decoded = i;
+	}
+}
+
+static struct gif_stream_frame *decode_frame(struct gif_stream *stream,
+					     int idx)
+{
+	size_t size = get_frame_size(stream);
+	struct gif_stream_frame *frame;
+
+	pthread_mutex_lock(&stream->decode_mutex);
+
+	decode_to_frame(stream, idx);
+
+	/* a frame that failed to decode still gets cached (with whatever
+	 * the decoder left in its buffer) so it isn't requested forever */
+	frame = bmalloc(sizeof(*frame) + size);
+	frame->refs = 1;
+	frame->size = size;
+	frame->last_used = 0;
+	memcpy(frame->data, stream->gif.frame_image, size);
+
+	pthread_mutex_unlock(&stream->decode_mutex);
+	return frame;
+}
+
+/* stores a newly decoded frame in the cache.  returns the frame that ends up
+ * in the cache with a new reference, which may not be the one passed in if
+ * another thread decoded it first. */
+static struct gif_stream_frame *cache_frame(struct gif_stream *stream,
+					    int idx,
+					    struct gif_stream_frame *frame)
+{
+	struct gif_stream_frame *cached;
+
+	pthread_mutex_lock(&gif_mutex);
+
+	cached = stream->frames[idx];
+	if (!cached) {
+		cached = frame;
+		frame = NULL;
+
+		stream->frames[idx] = cached;
+		cache_size += cached->size;
+	}
+
+	stream->pending[idx] = false;
+	cached->last_used = ++use_counter;
+	os_atomic_inc_long(&cached->refs);
+
+	enforce_cache_limit(cached);
+
+	pthread_mutex_unlock(&gif_mutex);
+
+	gif_stream_frame_release(frame);
+	return cached;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void stream_destroy(struct gif_stream *stream)
+{
+	pthread_mutex_lock(&gif_mutex);
+	for (int i = 0; i < stream->frame_count; i++) {
+		if (stream->frames[i])
+			uncache_frame(stream, i);
+	}
+	pthread_mutex_unlock(&gif_mutex);
+
+	gif_finalise(&stream->gif);
+	pthread_mutex_destroy(&stream->decode_mutex);
+	bfree(stream->frame_times);
+	bfree(stream->frames);
+	bfree(stream->pending);
+	bfree(stream->file_data);
+	bfree(stream->path);
+	bfree(stream);
+}
+
+static void stream_release(struct gif_stream *stream)
+{
+	bool destroy;
+
+	pthread_mutex_lock(&gif_mutex);
+	destroy = --stream->refs == 0;
+	if (destroy && stream->prev_next) {
+		*stream->prev_next = stream->next;
+		if (stream->next)
+			stream->next->prev_next = stream->prev_next;
+	}
+	pthread_mutex_unlock(&gif_mutex);
+
+	if (destroy)
+		stream_destroy(stream);
+}
+
+/* must be called with gif_mutex held */
+static void queue_request(struct gif_stream *stream, int idx, bool urgent)
+{
+	struct decode_request req = {stream, idx};
+
+	if (stopping || stream->frames[idx] || stream->pending[idx])
+		return;
+
+	stream->pending[idx] = true;
+	stream->refs++;
+
+	/* frames that are needed now go before frames that are decoded
+	 * ahead of time */
+	if (urgent)
+		da_insert(requests, 0, &req);
+	else
+		da_push_back(requests, &req);
+
+	os_sem_post(decode_sem);
+}
+
+static void *decode_thread_func(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+
+	os_set_thread_name("gif decode thread");
+
+	for (;;) {
+		struct decode_request req;
+		struct gif_stream_frame *frame;
+
+		if (os_sem_wait(decode_sem) != 0)
+			break;
+
+		pthread_mutex_lock(&gif_mutex);
+		if (stopping) {
+			pthread_mutex_unlock(&gif_mutex);
+			break;
+		}
+		if (!requests.num) {
+			pthread_mutex_unlock(&gif_mutex);
+			continue;
+		}
+
+		req = requests.array[0];
+		da_erase(requests, 0);
+		if (!requests.num)
+			da_free(requests);
+		pthread_mutex_unlock(&gif_mutex);
+
+		frame = decode_frame(req.stream, req.idx);
+		frame = cache_frame(req.stream, req.idx, frame);
+		gif_stream_frame_release(frame);
+		stream_release(req.stream);
+	}
+
+	return NULL;
+}
+
+static bool start_decode_thread(const char *path)
+{
+	bool success = true;
+
+	pthread_mutex_lock(&thread_mutex);
+
+	if (open_count++ == 0) {
+		stopping = false;
+
+		if (os_sem_init(&decode_sem, 0) != 0) {
+			success = false;
+		} else if (pthread_create(&decode_thread, NULL,
+					  decode_thread_func, NULL) != 0) {
+			os_sem_destroy(decode_sem);
+			decode_sem = NULL;
+			success = false;
+		}
+
+		if (!success) {
+			blog(LOG_ERROR,
+			     "Failed to create decode thread for '%s'",
+			     path);
+			open_count--;
+		}
+	}
+
+	pthread_mutex_unlock(&thread_mutex);
+	return success;
+}
+
+static void stop_decode_thread(void)
+{
+	pthread_mutex_lock(&thread_mutex);
+
+	if (--open_count == 0) {
+		struct decode_request *reqs;
+		size_t num;
+
+		pthread_mutex_lock(&gif_mutex);
+		stopping = true;
+		pthread_mutex_unlock(&gif_mutex);
+
+		os_sem_post(decode_sem);
+		pthread_join(decode_thread, NULL);
+		os_sem_destroy(decode_sem);
+		decode_sem = NULL;
+
+		pthread_mutex_lock(&gif_mutex);
+		reqs = requests.array;
+		num = requests.num;
+		da_init(requests);
+		pthread_mutex_unlock(&gif_mutex);
+
+		for (size_t i = 0; i < num; i++)
+			stream_release(reqs[i].stream);
+		bfree(reqs);
+	}
+
+	pthread_mutex_unlock(&thread_mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static bool load_file(struct gif_stream *stream)
+{
+	size_t size_read;
+	FILE *file;
+
+	file = os_fopen(stream->path, "rb");
+	if (!file) {
+		blog(LOG_WARNING, "Failed to open file '%s'", stream->path);
+		return false;
+	}
+
+	stream->file_data = bmalloc(stream->file_size);
+	size_read = fread(stream->file_data, 1, stream->file_size, file);
+	fclose(file);
+
+	if (size_read != stream->file_size) {
+		blog(LOG_WARNING, "Failed to fully read gif file '%s'.",
+		     stream->path);
+		return false;
+	}
+
+	return true;
+}
+
+static bool init_stream(struct gif_stream *stream)
+{
+	gif_result result;
+
+	stream->bitmap_callbacks.bitmap_create = bi_def_bitmap_create;
+	stream->bitmap_callbacks.bitmap_destroy = bi_def_bitmap_destroy;
+	stream->bitmap_callbacks.bitmap_get_buffer = bi_def_bitmap_get_buffer;
+	stream->bitmap_callbacks.bitmap_modified = bi_def_bitmap_modified;
+	stream->bitmap_callbacks.bitmap_set_opaque = bi_def_bitmap_set_opaque;
+	stream->bitmap_callbacks.bitmap_test_opaque = bi_def_bitmap_test_opaque;
+
+	gif_create(&stream->gif, &stream->bitmap_callbacks);
+
+	if (!load_file(stream))
+		return false;
+
+	do {
+		result = gif_initialise(&stream->gif, stream->file_size,
+					stream->file_data);
+		if (result < 0) {
+			blog(LOG_WARNING,
+			     "Failed to initialize gif '%s', "
+			     "possible file corruption",
+			     stream->path);
+			return false;
+		}
+	} while (result != GIF_OK);
+
+	if (stream->gif.width > 4096 || stream->gif.height > 4096) {
+		blog(LOG_WARNING, "Bad texture dimensions (%dx%d) in '%s'",
+		     stream->gif.width, stream->gif.height, stream->path);
+		return false;
+	}
+
+	if (stream->gif.frame_count <= 1)
+		return false;
+
+	stream->cx = (uint32_t)stream->gif.width;
+	stream->cy = (uint32_t)stream->gif.height;
+	stream->frame_count = (int)stream->gif.frame_count;
+	stream->loop_count = stream->gif.loop_count;
+	stream->last_decoded = -1;
+
+	stream->frame_times =
+		bmalloc(stream->frame_count * sizeof(*stream->frame_times));
+	stream->frames = bzalloc(stream->frame_count * sizeof(*stream->frames));
+	stream->pending = bzalloc(stream->frame_count * sizeof(bool));
+
+	for (int i = 0; i < stream->frame_count; i++) {
+		uint64_t val = (uint64_t)stream->gif.frames[i].frame_delay *
+			       10000000ULL;
+		stream->frame_times[i] = val ? val : 100000000ULL;
+	}
+
+	return true;
+}
+
+static inline bool stream_matches(const struct gif_stream *stream,
+				  const char *path, const struct stat *st)
+{
+	return stream->mtime == st->st_mtime &&
+	       stream->file_size == (size_t)st->st_size &&
+	       strcmp(stream->path, path) == 0;
+}
+
+static struct gif_stream *find_stream(const char *path, const struct stat *st)
+{
+	for (struct gif_stream *s = first_stream; s; s = s->next) {
+		if (stream_matches(s, path, st)) {
+			s->refs++;
+			return s;
+		}
+	}
+
+	return NULL;
+}
+
+struct gif_stream *gif_stream_open(const char *path)
+{
+	struct gif_stream *stream;
+	struct gif_stream *existing;
+	struct stat st;
+
+	if (os_stat(path, &st) != 0) {
+		blog(LOG_WARNING, "Failed to open file '%s'", path);
+		return NULL;
+	}
+
+	if (!start_decode_thread(path))
+		return NULL;
+
+	/* image files that use the same unmodified file share the same
+	 * stream, and thus the same decoded frames */
+	pthread_mutex_lock(&gif_mutex);
+	stream = find_stream(path, &st);
+	pthread_mutex_unlock(&gif_mutex);
+
+	if (stream)
+		return stream;
+
+	stream = bzalloc(sizeof(*stream));
+	stream->refs = 1;
+	stream->path = bstrdup(path);
+	stream->mtime = st.st_mtime;
+	stream->file_size = (size_t)st.st_size;
+	pthread_mutex_init(&stream->decode_mutex, NULL);
+
+	if (!init_stream(stream)) {
+		stream_destroy(stream);
+		stop_decode_thread();
+		return NULL;
+	}
+
+	pthread_mutex_lock(&gif_mutex);
+	existing = find_stream(path, &st);
+	if (!existing) {
+		stream->next = first_stream;
+		stream->prev_next = &first_stream;
+		if (first_stream)
+			first_stream->prev_next = &stream->next;
+		first_stream = stream;
+	}
+	pthread_mutex_unlock(&gif_mutex);
+
+	/* opened by another thread at the same time */
+	if (existing) {
+		stream_destroy(stream);
+		stream = existing;
+	}
+
+	return stream;
+}
+
+void gif_stream_close(struct gif_stream *stream)
+{
+	if (!stream)
+		return;
+
+	stream_release(stream);
+	stop_decode_thread();
+}
+
+/* ------------------------------------------------------------------------- */
+
+uint32_t gif_stream_get_width(const struct gif_stream *stream)
+{
+	return stream->cx;
+}
+
+uint32_t gif_stream_get_height(const struct gif_stream *stream)
+{
+	return stream->cy;
+}
+
+int gif_stream_get_frame_count(const struct gif_stream *stream)
+{
+	return stream->frame_count;
+}
+
+int gif_stream_get_loop_count(const struct gif_stream *stream)
+{
+	return stream->loop_count;
+}
+
+uint64_t gif_stream_get_frame_time(const struct gif_stream *stream, int idx)
+{
+	return stream->frame_times[idx];
+}
+
+size_t gif_stream_get_file_size(const struct gif_stream *stream)
+{
+	return stream->file_size;
+}
+
+/* must be called with gif_mutex held */
+static struct gif_stream_frame *get_cached_frame(struct gif_stream *stream,
+						 int idx)
+{
+	struct gif_stream_frame *frame = stream->frames[idx];
+
+	if (frame) {
+		frame->last_used = ++use_counter;
+		os_atomic_inc_long(&frame->refs);
+	}
+
+	return frame;
+}
+
+struct gif_stream_frame *gif_stream_get_frame(struct gif_stream *stream,
+					      int idx)
+{
+	struct gif_stream_frame *frame;
+
+	pthread_mutex_lock(&gif_mutex);
+	frame = get_cached_frame(stream, idx);
+	if (!frame)
+		queue_request(stream, idx, true);
+	pthread_mutex_unlock(&gif_mutex);
+
+	return frame;
+}
+
+struct gif_stream_frame *gif_stream_decode_frame(struct gif_stream *stream,
+						 int idx)
+{
+	struct gif_stream_frame *frame;
+
+	pthread_mutex_lock(&gif_mutex);
+	frame = get_cached_frame(stream, idx);
+	pthread_mutex_unlock(&gif_mutex);
+
+	if (frame)
+		return frame;
+
+	return cache_frame(stream, idx, decode_frame(stream, idx));
+}
+
+void gif_stream_prefetch(struct gif_stream *stream, int idx)
+{
+	pthread_mutex_lock(&gif_mutex);
+	queue_request(stream, idx, false);
+	pthread_mutex_unlock(&gif_mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void gif_cache_set_limit(size_t bytes)
+{
+	pthread_mutex_lock(&gif_mutex);
+	cache_limit = bytes;
+	enforce_cache_limit(NULL);
+	pthread_mutex_unlock(&gif_mutex);
+}
+
+size_t gif_cache_get_size(void)
+{
+	size_t size;
+
+	pthread_mutex_lock(&gif_mutex);
+	size = cache_size;
+	pthread_mutex_unlock(&gif_mutex);
+	return size;
+}
@@ -0,0 +1,74 @@
+/******************************************************************************
+    Copyright (C) 2016 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "../util/c99defs.h"
+
+/*
+ * Animated gifs are decoded on demand on a worker thread instead of all at
+ * once.  Decoded frames are kept in a cache shared by every animated gif,
+ * which is limited in size and evicts the least recently used frames first.
+ * Image files that open the same (unmodified) file share the same stream, and
+ * thus the same decoded frames.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct gif_stream;
+
+struct gif_stream_frame {
+	volatile long refs;
+	size_t size;
+	uint64_t last_used;
+	uint8_t data[];
+};
+
+extern struct gif_stream *gif_stream_open(const char *path);
+extern void gif_stream_close(struct gif_stream *stream);
+
+extern uint32_t gif_stream_get_width(const struct gif_stream *stream);
+extern uint32_t gif_stream_get_height(const struct gif_stream *stream);
+extern int gif_stream_get_frame_count(const struct gif_stream *stream);
+extern int gif_stream_get_loop_count(const struct gif_stream *stream);
+extern uint64_t gif_stream_get_frame_time(const struct gif_stream *stream,
+					  int idx);
+extern size_t gif_stream_get_file_size(const struct gif_stream *stream);
+
+/* returns a new reference to the frame if it has been decoded, otherwise
+ * queues it to be decoded and returns NULL */
+extern struct gif_stream_frame *gif_stream_get_frame(struct gif_stream *stream,
+					      int idx);
+
+/* returns a new reference to the frame, decoding it on the calling thread if
+ * it isn't cached */
+extern struct gif_stream_frame *
+gif_stream_decode_frame(struct gif_stream *stream, int idx);
+
+/* queues a frame to be decoded if it isn't already cached */
+extern void gif_stream_prefetch(struct gif_stream *stream, int idx);
+
+extern void gif_stream_frame_release(struct gif_stream_frame *frame);
+
+extern void gif_cache_set_limit(size_t bytes);
+extern size_t gif_cache_get_size(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,4 +1,4 @@
-#include "graphics.h"
+#include "graphics-internal.h"
 
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
@@ -15,7 +15,9 @@ struct ffmpeg_image {
 	int stream_idx;
 
 	int cx, cy;
+	int out_cx, out_cy;
 	enum AVPixelFormat format;
+	enum AVPixelFormat out_format;
 };
 
 static bool ffmpeg_image_open_decoder_context(struct ffmpeg_image *info)
@@ -89,7 +91,10 @@ static bool ffmpeg_image_init(struct ffmpeg_image *info, const char *file)
 
 	info->cx = info->decoder_ctx->width;
 	info->cy = info->decoder_ctx->height;
+	info->out_cx = info->cx;
+	info->out_cy = info->cy;
 	info->format = info->decoder_ctx->pix_fmt;
+	info->out_format = info->format;
 	return true;
 
 fail:
@@ -102,11 +107,12 @@ static bool ffmpeg_image_reformat_frame(struct ffmpeg_image *info,
 					int linesize)
 {
 	struct SwsContext *sws_ctx = NULL;
+	bool scaled = info->out_cx != info->cx || info->out_cy != info->cy;
 	int ret = 0;
 
-	if (info->format == AV_PIX_FMT_RGBA ||
-	    info->format == AV_PIX_FMT_BGRA ||
-	    info->format == AV_PIX_FMT_BGR0) {
+	if (!scaled && (info->format == AV_PIX_FMT_RGBA ||
+			info->format == AV_PIX_FMT_BGRA ||
+			info->format == AV_PIX_FMT_BGR0)) {
 
 		if (linesize != frame->linesize[0]) {
 			int min_line = linesize < frame->linesize[0]
@@ -121,10 +127,14 @@ static bool ffmpeg_image_reformat_frame(struct ffmpeg_image *info,
 			memcpy(out, frame->data[0], linesize * info->cy);
 		}
 
+		info->out_format = info->format;
+
 	} else {
 		sws_ctx = sws_getContext(info->cx, info->cy, info->format,
-					 info->cx, info->cy, AV_PIX_FMT_BGRA,
-					 SWS_POINT, NULL, NULL, NULL);
+					 info->out_cx, info->out_cy,
+					 AV_PIX_FMT_BGRA,
+					 scaled ? SWS_AREA : SWS_POINT, NULL,
+					 NULL, NULL);
 		if (!sws_ctx) {
 			blog(LOG_WARNING,
 			     "Failed to create scale context "
@@ -143,7 +153,8 @@ static bool ffmpeg_image_reformat_frame(struct ffmpeg_image *info,
 			return false;
 		}
 
-		info->format = AV_PIX_FMT_BGRA;
+		/* whenever sws ran, the output is BGRA whatever the source */
+		info->out_format = AV_PIX_FMT_BGRA;
 	}
 
 	return true;
@@ -226,17 +237,34 @@ static inline enum gs_color_format convert_format(enum AVPixelFormat format)
 uint8_t *gs_create_texture_file_data(const char *file,
 				     enum gs_color_format *format,
 				     uint32_t *cx_out, uint32_t *cy_out)
+{
+	return gs_create_texture_file_data_scaled(file, format, cx_out, cy_out,
+						  0, 0);
+}
+
+uint8_t *gs_create_texture_file_data_scaled(const char *file,
+					    enum gs_color_format *format,
+					    uint32_t *cx_out, uint32_t *cy_out,
+					    uint32_t max_cx, uint32_t max_cy)
 {
 	struct ffmpeg_image image;
 	uint8_t *data = NULL;
 
 	if (ffmpeg_image_init(&image, file)) {
-		data = bmalloc(image.cx * image.cy * 4);
+		uint32_t cx, cy;
+
+		/* scaling down while converting is much cheaper than
+		 * uploading the full image and letting the GPU scale it */
+		gs_fit_image_size(image.cx, image.cy, max_cx, max_cy, &cx, &cy);
+		image.out_cx = (int)cx;
+		image.out_cy = (int)cy;
+
+		data = bmalloc(image.out_cx * image.out_cy * 4);
 
-		if (ffmpeg_image_decode(&image, data, image.cx * 4)) {
-			*format = convert_format(image.format);
-			*cx_out = (uint32_t)image.cx;
-			*cy_out = (uint32_t)image.cy;
+		if (ffmpeg_image_decode(&image, data, image.out_cx * 4)) {
+			*format = convert_format(image.out_format);
+			*cx_out = (uint32_t)image.out_cx;
+			*cy_out = (uint32_t)image.out_cy;
 		} else {
 			bfree(data);
 			data = NULL;
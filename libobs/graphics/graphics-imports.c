@@ -191,6 +191,10 @@ bool load_graphics_imports(struct gs_exports *exports, void *module,
 	GRAPHICS_IMPORT(device_debug_marker_begin);
 	GRAPHICS_IMPORT(device_debug_marker_end);
 
+	GRAPHICS_IMPORT_OPTIONAL(device_set_shader_cache_path);
+
+	GRAPHICS_IMPORT_OPTIONAL(gs_stagesurface_ready);
+
 	/* OSX/Cocoa specific functions */
 #ifdef __APPLE__
 	GRAPHICS_IMPORT_OPTIONAL(device_texture_create_from_iosurface);
@@ -267,6 +267,11 @@ struct gs_exports {
 					  const float color[4]);
 	void (*device_debug_marker_end)(gs_device_t *device);
 
+	void (*device_set_shader_cache_path)(gs_device_t *device,
+					     const char *path);
+
+	bool (*gs_stagesurface_ready)(gs_stagesurf_t *stagesurf);
+
 #ifdef __APPLE__
 	/* OSX/Cocoa specific functions */
 	gs_texture_t *(*device_texture_create_from_iosurface)(gs_device_t *dev,
@@ -340,6 +345,10 @@ struct graphics_subsystem {
 	struct gs_effect *cur_effect;
 
 	gs_vertbuffer_t *sprite_buffer;
+	gs_vertbuffer_t *sprite_batch_buffer;
+	size_t sprite_batch_capacity;
+
+	uint64_t draw_calls;
 
 	bool using_immediate;
 	struct gs_vb_data *vbd;
@@ -358,3 +367,29 @@ struct graphics_subsystem {
 	struct blend_state cur_blend_state;
 	DARRAY(struct blend_state) blend_state_stack;
 };
+
+/* fits an image within max_cx x max_cy (0 for no limit) while keeping its
+ * aspect ratio.  images are never scaled up. */
+static inline void gs_fit_image_size(uint32_t cx, uint32_t cy, uint32_t max_cx,
+				     uint32_t max_cy, uint32_t *cx_out,
+				     uint32_t *cy_out)
+{
+	double scale = 1.0;
+
+	if (max_cx && cx > max_cx)
+		scale = (double)max_cx / (double)cx;
+	if (max_cy && cy > max_cy && (double)max_cy / (double)cy < scale)
+		scale = (double)max_cy / (double)cy;
+
+	*cx_out = cx;
+	*cy_out = cy;
+
+	if (scale < 1.0) {
+		*cx_out = (uint32_t)((double)cx * scale + 0.5);
+		*cy_out = (uint32_t)((double)cy * scale + 0.5);
+		if (!*cx_out)
+			*cx_out = 1;
+		if (!*cy_out)
+			*cy_out = 1;
+	}
+}
@@ -1,4 +1,4 @@
-#include "graphics.h"
+#include "graphics-internal.h"
 #include "obsconfig.h"
 
 #define MAGICKCORE_QUANTUM_DEPTH 16
@@ -20,9 +20,37 @@ void gs_free_image_deps()
 	MagickCoreTerminus();
 }
 
+static Image *scale_image(Image *image, uint32_t max_cx, uint32_t max_cy,
+			  ExceptionInfo *exception)
+{
+	uint32_t cx, cy;
+	Image *scaled;
+
+	gs_fit_image_size((uint32_t)image->columns, (uint32_t)image->rows,
+			  max_cx, max_cy, &cx, &cy);
+	if (cx == image->columns && cy == image->rows)
+		return image;
+
+	scaled = ThumbnailImage(image, cx, cy, exception);
+	if (!scaled)
+		return image;
+
+	DestroyImage(image);
+	return scaled;
+}
+
 uint8_t *gs_create_texture_file_data(const char *file,
 				     enum gs_color_format *format,
 				     uint32_t *cx_out, uint32_t *cy_out)
+{
+	return gs_create_texture_file_data_scaled(file, format, cx_out, cy_out,
+						  0, 0);
+}
+
+uint8_t *gs_create_texture_file_data_scaled(const char *file,
+					    enum gs_color_format *format,
+					    uint32_t *cx_out, uint32_t *cy_out,
+					    uint32_t max_cx, uint32_t max_cy)
 {
 	uint8_t *data = NULL;
 	ImageInfo *info;
@@ -37,9 +65,11 @@ uint8_t *gs_create_texture_file_data(const char *file,
 
 	strcpy(info->filename, file);
 	image = ReadImage(info, exception);
+	if (image && (max_cx || max_cy))
+		image = scale_image(image, max_cx, max_cy, exception);
 	if (image) {
-		size_t cx = image->magick_columns;
-		size_t cy = image->magick_rows;
+		size_t cx = image->columns;
+		size_t cy = image->rows;
 		data = bmalloc(cx * cy * 4);
 
 		ExportImagePixels(image, 0, 0, cx, cy, "BGRA", CharPixel, data,
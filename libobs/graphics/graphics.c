@@ -230,6 +230,9 @@ void gs_destroy(graphics_t *graphics)
 
 		graphics->exports.gs_vertexbuffer_destroy(
 			graphics->sprite_buffer);
+		if (graphics->sprite_batch_buffer)
+			graphics->exports.gs_vertexbuffer_destroy(
+				graphics->sprite_batch_buffer);
 		graphics->exports.gs_vertexbuffer_destroy(
 			graphics->immediate_vertbuffer);
 		graphics->exports.device_destroy(graphics->device);
@@ -1070,6 +1073,139 @@ void gs_draw_sprite_subregion(gs_texture_t *tex, uint32_t flip, uint32_t sub_x,
 	gs_draw(GS_TRISTRIP, 0, 0);
 }
 
+#define SPRITE_BATCH_VERTS 6
+#define SPRITE_BATCH_MIN 16
+
+static bool resize_sprite_batch(struct graphics_subsystem *graphics, size_t num)
+{
+	size_t capacity = graphics->sprite_batch_capacity;
+	size_t num_verts;
+	struct gs_vb_data *vbd;
+
+	if (num <= capacity)
+		return true;
+
+	if (!capacity)
+		capacity = SPRITE_BATCH_MIN;
+	while (capacity < num)
+		capacity *= 2;
+
+	num_verts = capacity * SPRITE_BATCH_VERTS;
+
+	vbd = gs_vbdata_create();
+	vbd->num = num_verts;
+	vbd->points = bzalloc(sizeof(struct vec3) * num_verts);
+	vbd->num_tex = 1;
+	vbd->tvarray = bzalloc(sizeof(struct gs_tvertarray));
+	vbd->tvarray[0].width = 2;
+	vbd->tvarray[0].array = bzalloc(sizeof(struct vec2) * num_verts);
+
+	if (graphics->sprite_batch_buffer)
+		gs_vertexbuffer_destroy(graphics->sprite_batch_buffer);
+	graphics->sprite_batch_capacity = 0;
+
+	graphics->sprite_batch_buffer =
+		gs_vertexbuffer_create(vbd, GS_DYNAMIC);
+	if (!graphics->sprite_batch_buffer)
+		return false;
+
+	graphics->sprite_batch_capacity = capacity;
+	return true;
+}
+
+static inline void draw_sprite_instances(gs_texture_t *tex, uint32_t flip,
+					 uint32_t width, uint32_t height,
+					 const struct matrix4 *transforms,
+					 size_t num)
+{
+	for (size_t i = 0; i < num; i++) {
+		gs_matrix_push();
+		gs_matrix_mul(&transforms[i]);
+		gs_draw_sprite(tex, flip, width, height);
+		gs_matrix_pop();
+	}
+}
+
+void gs_draw_sprite_batch(gs_texture_t *tex, uint32_t flip, uint32_t width,
+			  uint32_t height, const struct matrix4 *transforms,
+			  size_t num)
+{
+	graphics_t *graphics = thread_graphics;
+	struct gs_vb_data data;
+	struct gs_vb_data *vbd;
+	struct matrix4 cur_matrix;
+	struct vec3 corners[4];
+	struct vec2 uvs[4];
+	float fcx, fcy;
+
+	if (!gs_valid_p("gs_draw_sprite_batch", transforms) || !num)
+		return;
+
+	if (tex) {
+		if (gs_get_texture_type(tex) != GS_TEXTURE_2D) {
+			blog(LOG_ERROR, "A sprite must be a 2D texture");
+			return;
+		}
+	} else {
+		if (!width || !height) {
+			blog(LOG_ERROR, "A sprite cannot be drawn without "
+					"a width/height");
+			return;
+		}
+	}
+
+	/* nothing to merge, or rectangle textures which use unnormalized
+	 * coordinates: draw them one by one */
+	if (num == 1 || (tex && gs_texture_is_rect(tex)) ||
+	    !resize_sprite_batch(graphics, num)) {
+		draw_sprite_instances(tex, flip, width, height, transforms,
+				      num);
+		return;
+	}
+
+	fcx = width ? (float)width : (float)gs_texture_get_width(tex);
+	fcy = height ? (float)height : (float)gs_texture_get_height(tex);
+
+	data.points = corners;
+	data.tvarray = &(struct gs_tvertarray){2, uvs};
+	build_sprite_norm(&data, fcx, fcy, flip);
+
+	/* bake each sprite's transform into its vertices so the whole batch
+	 * can be drawn with a single world matrix */
+	gs_matrix_get(&cur_matrix);
+
+	vbd = gs_vertexbuffer_get_data(graphics->sprite_batch_buffer);
+
+	for (size_t i = 0; i < num; i++) {
+		static const size_t order[SPRITE_BATCH_VERTS] = {0, 1, 2,
+								 2, 1, 3};
+		struct vec3 *points = vbd->points + i * SPRITE_BATCH_VERTS;
+		struct vec2 *tv = (struct vec2 *)vbd->tvarray[0].array +
+				  i * SPRITE_BATCH_VERTS;
+		struct vec3 transformed[4];
+		struct matrix4 mat;
+
+		matrix4_mul(&mat, &transforms[i], &cur_matrix);
+
+		for (size_t c = 0; c < 4; c++)
+			vec3_transform(&transformed[c], &corners[c], &mat);
+
+		for (size_t v = 0; v < SPRITE_BATCH_VERTS; v++) {
+			points[v] = transformed[order[v]];
+			tv[v] = uvs[order[v]];
+		}
+	}
+
+	gs_vertexbuffer_flush(graphics->sprite_batch_buffer);
+	gs_load_vertexbuffer(graphics->sprite_batch_buffer);
+	gs_load_indexbuffer(NULL);
+
+	gs_matrix_push();
+	gs_matrix_identity();
+	gs_draw(GS_TRIS, 0, (uint32_t)(num * SPRITE_BATCH_VERTS));
+	gs_matrix_pop();
+}
+
 void gs_draw_cube_backdrop(gs_texture_t *cubetex, const struct quat *rot,
 			   float left, float right, float top, float bottom,
 			   float znear)
@@ -1765,10 +1901,21 @@ void gs_draw(enum gs_draw_mode draw_mode, uint32_t start_vert,
 	if (!gs_valid("gs_draw"))
 		return;
 
+	graphics->draw_calls++;
 	graphics->exports.device_draw(graphics->device, draw_mode, start_vert,
 				      num_verts);
 }
 
+uint64_t gs_get_draw_call_count(void)
+{
+	graphics_t *graphics = thread_graphics;
+
+	if (!gs_valid("gs_get_draw_call_count"))
+		return 0;
+
+	return graphics->draw_calls;
+}
+
 void gs_end_scene(void)
 {
 	graphics_t *graphics = thread_graphics;
@@ -2471,6 +2618,19 @@ void gs_stagesurface_unmap(gs_stagesurf_t *stagesurf)
 	graphics->exports.gs_stagesurface_unmap(stagesurf);
 }
 
+bool gs_stagesurface_ready(gs_stagesurf_t *stagesurf)
+{
+	graphics_t *graphics = thread_graphics;
+
+	if (!gs_valid_p("gs_stagesurface_ready", stagesurf))
+		return false;
+
+	if (!graphics->exports.gs_stagesurface_ready)
+		return true;
+
+	return graphics->exports.gs_stagesurface_ready(stagesurf);
+}
+
 void gs_zstencil_destroy(gs_zstencil_t *zstencil)
 {
 	if (!gs_valid("gs_zstencil_destroy"))
@@ -2684,6 +2844,18 @@ bool gs_nv12_available(void)
 		thread_graphics->device);
 }
 
+void gs_set_shader_cache_path(const char *path)
+{
+	if (!gs_valid("gs_set_shader_cache_path"))
+		return;
+
+	if (!thread_graphics->exports.device_set_shader_cache_path)
+		return;
+
+	thread_graphics->exports.device_set_shader_cache_path(
+		thread_graphics->device, path);
+}
+
 void gs_debug_marker_begin(const float color[4], const char *markername)
 {
 	if (!gs_valid("gs_debug_marker_begin"))
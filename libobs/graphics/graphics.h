@@ -554,6 +554,9 @@ EXPORT gs_texture_t *gs_texture_create_from_file(const char *file);
 EXPORT uint8_t *gs_create_texture_file_data(const char *file,
 					    enum gs_color_format *format,
 					    uint32_t *cx, uint32_t *cy);
+EXPORT uint8_t *gs_create_texture_file_data_scaled(
+	const char *file, enum gs_color_format *format, uint32_t *cx,
+	uint32_t *cy, uint32_t max_cx, uint32_t max_cy);
 
 #define GS_FLIP_U (1 << 0)
 #define GS_FLIP_V (1 << 1)
@@ -572,6 +575,15 @@ EXPORT void gs_draw_sprite_subregion(gs_texture_t *tex, uint32_t flip,
 				     uint32_t x, uint32_t y, uint32_t cx,
 				     uint32_t cy);
 
+/**
+ * Draws the same sprite once per transform (each applied on top of the
+ * current matrix) with a single draw call.  Everything else (effect,
+ * technique pass, textures, blend state) is shared by all the sprites.
+ */
+EXPORT void gs_draw_sprite_batch(gs_texture_t *tex, uint32_t flip,
+				 uint32_t width, uint32_t height,
+				 const struct matrix4 *transforms, size_t num);
+
 EXPORT void gs_draw_cube_backdrop(gs_texture_t *cubetex, const struct quat *rot,
 				  float left, float right, float top,
 				  float bottom, float znear);
@@ -678,6 +690,8 @@ EXPORT void gs_begin_frame(void);
 EXPORT void gs_begin_scene(void);
 EXPORT void gs_draw(enum gs_draw_mode draw_mode, uint32_t start_vert,
 		    uint32_t num_verts);
+/** Total number of draw calls issued on this graphics context */
+EXPORT uint64_t gs_get_draw_call_count(void);
 EXPORT void gs_end_scene(void);
 
 #define GS_CLEAR_COLOR (1 << 0)
@@ -766,6 +780,13 @@ EXPORT bool gs_stagesurface_map(gs_stagesurf_t *stagesurf, uint8_t **data,
 				uint32_t *linesize);
 EXPORT void gs_stagesurface_unmap(gs_stagesurf_t *stagesurf);
 
+/**
+ * Returns whether the data last staged to the surface can be mapped without
+ * waiting for the GPU.  Always returns true if the graphics subsystem can't
+ * tell.
+ */
+EXPORT bool gs_stagesurface_ready(gs_stagesurf_t *stagesurf);
+
 EXPORT void gs_zstencil_destroy(gs_zstencil_t *zstencil);
 
 EXPORT void gs_samplerstate_destroy(gs_samplerstate_t *samplerstate);
@@ -799,6 +820,12 @@ EXPORT bool gs_timer_range_get_data(gs_timer_range_t *range, bool *disjoint,
 
 EXPORT bool gs_nv12_available(void);
 
+/**
+ * Sets the directory compiled shader programs are cached in between runs,
+ * if the renderer supports it.  Call before creating any effects.
+ */
+EXPORT void gs_set_shader_cache_path(const char *path);
+
 #define GS_USE_DEBUG_MARKERS 0
 #if GS_USE_DEBUG_MARKERS
 static const float GS_DEBUG_COLOR_DEFAULT[] = {0.5f, 0.5f, 0.5f, 1.0f};
@@ -16,171 +16,57 @@
 ******************************************************************************/
 
 #include "image-file.h"
+#include "animated-gif.h"
 #include "../util/base.h"
 #include "../util/platform.h"
 
 #define blog(level, format, ...) \
 	blog(level, "%s: " format, __FUNCTION__, __VA_ARGS__)
 
-static void *bi_def_bitmap_create(int width, int height)
-{
-	return bmalloc(width * height * 4);
-}
-
-static void bi_def_bitmap_set_opaque(void *bitmap, bool opaque)
-{
-	UNUSED_PARAMETER(bitmap);
-	UNUSED_PARAMETER(opaque);
-}
-
-static bool bi_def_bitmap_test_opaque(void *bitmap)
-{
-	UNUSED_PARAMETER(bitmap);
-	return false;
-}
-
-static unsigned char *bi_def_bitmap_get_buffer(void *bitmap)
-{
-	return (unsigned char *)bitmap;
-}
-
-static void bi_def_bitmap_destroy(void *bitmap)
-{
-	bfree(bitmap);
-}
-
-static void bi_def_bitmap_modified(void *bitmap)
-{
-	UNUSED_PARAMETER(bitmap);
-}
-
-static inline int get_full_decoded_gif_size(gs_image_file_t *image)
-{
-	return image->gif.width * image->gif.height * 4 *
-	       image->gif.frame_count;
-}
-
-static inline void *alloc_mem(gs_image_file_t *image, uint64_t *mem_usage,
-			      size_t size)
-{
-	UNUSED_PARAMETER(image);
-
-	if (mem_usage)
-		*mem_usage += size;
-	return bzalloc(size);
-}
+struct gs_image_file_gif {
+	struct gif_stream *stream;
+	struct gif_stream_frame *frame;
+	int frame_idx;
+};
 
 static bool init_animated_gif(gs_image_file_t *image, const char *path,
 			      uint64_t *mem_usage)
 {
-	bool is_animated_gif = true;
-	gif_result result;
-	uint64_t max_size;
-	size_t size, size_read;
-	FILE *file;
-
-	image->bitmap_callbacks.bitmap_create = bi_def_bitmap_create;
-	image->bitmap_callbacks.bitmap_destroy = bi_def_bitmap_destroy;
-	image->bitmap_callbacks.bitmap_get_buffer = bi_def_bitmap_get_buffer;
-	image->bitmap_callbacks.bitmap_modified = bi_def_bitmap_modified;
-	image->bitmap_callbacks.bitmap_set_opaque = bi_def_bitmap_set_opaque;
-	image->bitmap_callbacks.bitmap_test_opaque = bi_def_bitmap_test_opaque;
-
-	gif_create(&image->gif, &image->bitmap_callbacks);
-
-	file = os_fopen(path, "rb");
-	if (!file) {
-		blog(LOG_WARNING, "Failed to open file '%s'", path);
-		goto fail;
-	}
-
-	fseek(file, 0, SEEK_END);
-	size = (size_t)os_ftelli64(file);
-	fseek(file, 0, SEEK_SET);
-
-	image->gif_data = bmalloc(size);
-	size_read = fread(image->gif_data, 1, size, file);
-	if (size_read != size) {
-		blog(LOG_WARNING, "Failed to fully read gif file '%s'.", path);
-		goto fail;
-	}
+	struct gif_stream *stream = gif_stream_open(path);
+	struct gs_image_file_gif *gif;
 
-	do {
-		result = gif_initialise(&image->gif, size, image->gif_data);
-		if (result < 0) {
-			blog(LOG_WARNING,
-			     "Failed to initialize gif '%s', "
-			     "possible file corruption",
-			     path);
-			goto fail;
-		}
-	} while (result != GIF_OK);
-
-	if (image->gif.width > 4096 || image->gif.height > 4096) {
-		blog(LOG_WARNING, "Bad texture dimensions (%dx%d) in '%s'",
-		     image->gif.width, image->gif.height, path);
-		goto fail;
-	}
-
-	max_size = (uint64_t)image->gif.width * (uint64_t)image->gif.height *
-		   (uint64_t)image->gif.frame_count * 4LLU;
-
-	if ((uint64_t)get_full_decoded_gif_size(image) != max_size) {
-		blog(LOG_WARNING, "Gif '%s' overflowed maximum pointer size",
-		     path);
-		goto fail;
-	}
+	if (!stream)
+		return false;
 
-	image->is_animated_gif = (image->gif.frame_count > 1 && result >= 0);
-	if (image->is_animated_gif) {
-		gif_decode_frame(&image->gif, 0);
-
-		image->animation_frame_cache =
-			alloc_mem(image, mem_usage,
-				  image->gif.frame_count * sizeof(uint8_t *));
-		image->animation_frame_data = alloc_mem(
-			image, mem_usage, get_full_decoded_gif_size(image));
-
-		for (unsigned int i = 0; i < image->gif.frame_count; i++) {
-			if (gif_decode_frame(&image->gif, i) != GIF_OK)
-				blog(LOG_WARNING,
-				     "Couldn't decode frame %u "
-				     "of '%s'",
-				     i, path);
-		}
+	gif = bzalloc(sizeof(*gif));
+	gif->stream = stream;
 
-		gif_decode_frame(&image->gif, 0);
+	/* the first frame is needed to create the texture, the rest are
+	 * decoded on the gif decode thread as they're needed */
+	gif->frame = gif_stream_decode_frame(stream, 0);
+	gif->frame_idx = 0;
+	gif_stream_prefetch(stream, 1);
 
-		image->cx = (uint32_t)image->gif.width;
-		image->cy = (uint32_t)image->gif.height;
-		image->format = GS_RGBA;
+	image->gif_stream = gif;
+	image->is_animated_gif = true;
+	image->cx = gif_stream_get_width(stream);
+	image->cy = gif_stream_get_height(stream);
+	image->format = GS_RGBA;
 
-		if (mem_usage) {
-			*mem_usage += image->cx * image->cy * 4;
-			*mem_usage += size;
-		}
-	} else {
-		gif_finalise(&image->gif);
-		bfree(image->gif_data);
-		image->gif_data = NULL;
-		is_animated_gif = false;
-		goto not_animated;
+	/* decoded frames are shared and limited by the gif frame cache, so
+	 * only count the frame that's held and the texture */
+	if (mem_usage) {
+		*mem_usage += image->cx * image->cy * 4 * 2;
+		*mem_usage += gif_stream_get_file_size(stream);
 	}
 
 	image->loaded = true;
-
-fail:
-	if (!image->loaded)
-		gs_image_file_free(image);
-not_animated:
-	if (file)
-		fclose(file);
-
-	return is_animated_gif;
+	return true;
 }
 
 static void gs_image_file_init_internal(gs_image_file_t *image,
-					const char *file, uint64_t *mem_usage)
+					const char *file, uint64_t *mem_usage,
+					uint32_t max_cx, uint32_t max_cy)
 {
 	size_t len;
 
@@ -199,8 +85,8 @@ static void gs_image_file_init_internal(gs_image_file_t *image,
 			return;
 	}
 
-	image->texture_data = gs_create_texture_file_data(
-		file, &image->format, &image->cx, &image->cy);
+	image->texture_data = gs_create_texture_file_data_scaled(
+		file, &image->format, &image->cx, &image->cy, max_cx, max_cy);
 
 	if (mem_usage) {
 		*mem_usage += image->cx * image->cy *
@@ -216,7 +102,7 @@ static void gs_image_file_init_internal(gs_image_file_t *image,
 
 void gs_image_file_init(gs_image_file_t *image, const char *file)
 {
-	gs_image_file_init_internal(image, file, NULL);
+	gs_image_file_init_internal(image, file, NULL, 0, 0);
 }
 
 void gs_image_file_free(gs_image_file_t *image)
@@ -226,22 +112,31 @@ void gs_image_file_free(gs_image_file_t *image)
 
 	if (image->loaded) {
 		if (image->is_animated_gif) {
-			gif_finalise(&image->gif);
-			bfree(image->animation_frame_cache);
-			bfree(image->animation_frame_data);
+			gif_stream_frame_release(image->gif_stream->frame);
+			gif_stream_close(image->gif_stream->stream);
+			bfree(image->gif_stream);
 		}
 
-		gs_texture_destroy(image->texture);
+		/* images that were never uploaded can be freed outside of
+		 * the graphics context */
+		if (image->texture)
+			gs_texture_destroy(image->texture);
 	}
 
 	bfree(image->texture_data);
-	bfree(image->gif_data);
 	memset(image, 0, sizeof(*image));
 }
 
 void gs_image_file2_init(gs_image_file2_t *if2, const char *file)
 {
-	gs_image_file_init_internal(&if2->image, file, &if2->mem_usage);
+	gs_image_file_init_internal(&if2->image, file, &if2->mem_usage, 0, 0);
+}
+
+void gs_image_file2_init_scaled(gs_image_file2_t *if2, const char *file,
+				uint32_t max_cx, uint32_t max_cy)
+{
+	gs_image_file_init_internal(&if2->image, file, &if2->mem_usage, max_cx,
+				    max_cy);
 }
 
 void gs_image_file_init_texture(gs_image_file_t *image)
@@ -250,9 +145,11 @@ void gs_image_file_init_texture(gs_image_file_t *image)
 		return;
 
 	if (image->is_animated_gif) {
-		image->texture = gs_texture_create(
-			image->cx, image->cy, image->format, 1,
-			(const uint8_t **)&image->gif.frame_image, GS_DYNAMIC);
+		const uint8_t *data = image->gif_stream->frame->data;
+
+		image->texture = gs_texture_create(image->cx, image->cy,
+						   image->format, 1, &data,
+						   GS_DYNAMIC);
 
 	} else {
 		image->texture = gs_texture_create(
@@ -265,15 +162,13 @@ void gs_image_file_init_texture(gs_image_file_t *image)
 
 static inline uint64_t get_time(gs_image_file_t *image, int i)
 {
-	uint64_t val = (uint64_t)image->gif.frames[i].frame_delay * 10000000ULL;
-	if (!val)
-		val = 100000000;
-	return val;
+	return gif_stream_get_frame_time(image->gif_stream->stream, i);
 }
 
 static inline int calculate_new_frame(gs_image_file_t *image,
 				      uint64_t elapsed_time_ns, int loops)
 {
+	int frame_count = gif_stream_get_frame_count(image->gif_stream->stream);
 	int new_frame = image->cur_frame;
 
 	image->cur_time += elapsed_time_ns;
@@ -283,7 +178,7 @@ static inline int calculate_new_frame(gs_image_file_t *image,
 			break;
 
 		image->cur_time -= t;
-		if ((unsigned int)++new_frame == image->gif.frame_count) {
+		if (++new_frame == frame_count) {
 			if (!loops || ++image->cur_loop < loops) {
 				new_frame = 0;
 			} else if (image->cur_loop == loops) {
@@ -296,38 +191,30 @@ static inline int calculate_new_frame(gs_image_file_t *image,
 	return new_frame;
 }
 
-static void decode_new_frame(gs_image_file_t *image, int new_frame)
+/* swaps the held frame for the current frame if it has been decoded, and
+ * makes sure the frame after it will be decoded by the time it's needed.
+ * never decodes on the calling thread. */
+static bool update_gif_frame(gs_image_file_t *image)
 {
-	if (!image->animation_frame_cache[new_frame]) {
-		int last_frame;
-
-		/* if looped, decode frame 0 */
-		last_frame = (new_frame < image->last_decoded_frame)
-				     ? 0
-				     : image->last_decoded_frame + 1;
-
-		/* decode missed frames */
-		for (int i = last_frame; i < new_frame; i++) {
-			if (gif_decode_frame(&image->gif, i) != GIF_OK)
-				return;
-		}
+	struct gs_image_file_gif *gif = image->gif_stream;
+	int next = image->cur_frame + 1;
+	struct gif_stream_frame *frame;
 
-		/* decode actual desired frame */
-		if (gif_decode_frame(&image->gif, new_frame) == GIF_OK) {
-			size_t pos = new_frame * image->gif.width *
-				     image->gif.height * 4;
-			image->animation_frame_cache[new_frame] =
-				image->animation_frame_data + pos;
+	if (next == gif_stream_get_frame_count(gif->stream))
+		next = 0;
 
-			memcpy(image->animation_frame_cache[new_frame],
-			       image->gif.frame_image,
-			       image->gif.width * image->gif.height * 4);
+	if (gif->frame_idx != image->cur_frame) {
+		frame = gif_stream_get_frame(gif->stream, image->cur_frame);
+		if (!frame)
+			return false;
 
-			image->last_decoded_frame = new_frame;
-		}
+		gif_stream_frame_release(gif->frame);
+		gif->frame = frame;
+		gif->frame_idx = image->cur_frame;
 	}
 
-	image->cur_frame = new_frame;
+	gif_stream_prefetch(gif->stream, next);
+	return true;
 }
 
 bool gs_image_file_tick(gs_image_file_t *image, uint64_t elapsed_time_ns)
@@ -337,21 +224,20 @@ bool gs_image_file_tick(gs_image_file_t *image, uint64_t elapsed_time_ns)
 	if (!image->is_animated_gif || !image->loaded)
 		return false;
 
-	loops = image->gif.loop_count;
+	loops = gif_stream_get_loop_count(image->gif_stream->stream);
 	if (loops >= 0xFFFF)
 		loops = 0;
 
-	if (!loops || image->cur_loop < loops) {
-		int new_frame =
+	if (!loops || image->cur_loop < loops)
+		image->cur_frame =
 			calculate_new_frame(image, elapsed_time_ns, loops);
 
-		if (new_frame != image->cur_frame) {
-			decode_new_frame(image, new_frame);
-			return true;
-		}
-	}
+	/* a frame that wasn't decoded in time is shown late rather than
+	 * stalling the tick */
+	if (image->cur_frame == image->gif_stream->frame_idx)
+		return false;
 
-	return false;
+	return update_gif_frame(image);
 }
 
 void gs_image_file_update_texture(gs_image_file_t *image)
@@ -359,10 +245,18 @@ void gs_image_file_update_texture(gs_image_file_t *image)
 	if (!image->is_animated_gif || !image->loaded)
 		return;
 
-	if (!image->animation_frame_cache[image->cur_frame])
-		decode_new_frame(image, image->cur_frame);
+	update_gif_frame(image);
+
+	gs_texture_set_image(image->texture, image->gif_stream->frame->data,
+			     image->cx * 4, false);
+}
 
-	gs_texture_set_image(image->texture,
-			     image->animation_frame_cache[image->cur_frame],
-			     image->gif.width * 4, false);
+void gs_image_file_set_gif_cache_size(uint32_t megabytes)
+{
+	gif_cache_set_limit((size_t)megabytes * 1024 * 1024);
+}
+
+uint64_t gs_image_file_get_gif_cache_usage(void)
+{
+	return (uint64_t)gif_cache_get_size();
 }
@@ -24,6 +24,8 @@
 extern "C" {
 #endif
 
+struct gs_image_file_gif;
+
 struct gs_image_file {
 	gs_texture_t *texture;
 	enum gs_color_format format;
@@ -33,10 +35,12 @@ struct gs_image_file {
 	bool frame_updated;
 	bool loaded;
 
+	/* no longer used, animated gifs are decoded through gif_stream */
 	gif_animation gif;
 	uint8_t *gif_data;
 	uint8_t **animation_frame_cache;
 	uint8_t *animation_frame_data;
+
 	uint64_t cur_time;
 	int cur_frame;
 	int cur_loop;
@@ -44,6 +48,10 @@ struct gs_image_file {
 
 	uint8_t *texture_data;
 	gif_bitmap_callback_vt bitmap_callbacks;
+
+	/* frames of animated gifs are decoded on a background thread, and
+	 * shared between image files that use the same file */
+	struct gs_image_file_gif *gif_stream;
 };
 
 struct gs_image_file2 {
@@ -62,7 +70,14 @@ EXPORT bool gs_image_file_tick(gs_image_file_t *image,
 			       uint64_t elapsed_time_ns);
 EXPORT void gs_image_file_update_texture(gs_image_file_t *image);
 
+/* limits the memory used by decoded animated gif frames (shared between all
+ * image files) */
+EXPORT void gs_image_file_set_gif_cache_size(uint32_t megabytes);
+EXPORT uint64_t gs_image_file_get_gif_cache_usage(void);
+
 EXPORT void gs_image_file2_init(gs_image_file2_t *if2, const char *file);
+EXPORT void gs_image_file2_init_scaled(gs_image_file2_t *if2, const char *file,
+				       uint32_t max_cx, uint32_t max_cy);
 
 static void gs_image_file2_free(gs_image_file2_t *if2)
 {
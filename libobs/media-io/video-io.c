@@ -41,19 +41,39 @@ struct cached_frame_info {
 
 struct video_input {
 	struct video_scale_info conversion;
+	struct video_scale_info source;
 	video_scaler_t *scaler;
 	struct video_frame frame[MAX_CONVERT_BUFFERS];
 	int cur_frame;
+	bool valid;
+
+	/* cascaded inputs are scaled from the output of their parent input
+	 * rather than from the full video output (e.g. an encoding ladder
+	 * where each rung is scaled from the rung above it) */
+	void (*parent_callback)(void *param, struct video_data *frame);
+	void *parent_param;
+	size_t parent_idx;
+
+	/* last frame sent to the callback, used as the source for the inputs
+	 * cascaded from this one */
+	struct video_data output;
+	bool output_valid;
 
 	void (*callback)(void *param, struct video_data *frame);
 	void *param;
 };
 
-static inline void video_input_free(struct video_input *input)
+static inline void video_input_free_scaler(struct video_input *input)
 {
 	for (size_t i = 0; i < MAX_CONVERT_BUFFERS; i++)
 		video_frame_free(&input->frame[i]);
 	video_scaler_destroy(input->scaler);
+	input->scaler = NULL;
+}
+
+static inline void video_input_free(struct video_input *input)
+{
+	video_input_free_scaler(input);
 }
 
 struct video_output {
@@ -137,8 +157,25 @@ static inline bool video_output_cur_frame(struct video_output *video)
 		struct video_input *input = video->inputs.array + i;
 		struct video_data frame = frame_info->frame;
 
-		if (scale_video_output(input, &frame))
+		input->output_valid = false;
+
+		if (!input->valid)
+			continue;
+
+		if (input->parent_idx != DARRAY_INVALID) {
+			struct video_input *parent =
+				video->inputs.array + input->parent_idx;
+			if (!parent->output_valid)
+				continue;
+
+			frame = parent->output;
+		}
+
+		if (scale_video_output(input, &frame)) {
+			input->output = frame;
+			input->output_valid = true;
 			input->callback(input->param, &frame);
+		}
 	}
 
 	pthread_mutex_unlock(&video->input_mutex);
@@ -296,21 +333,39 @@ static size_t video_get_input_idx(const video_t *video,
 	return DARRAY_INVALID;
 }
 
-static inline bool video_input_init(struct video_input *input,
-				    struct video_output *video)
+static inline bool scale_info_equal(const struct video_scale_info *a,
+				    const struct video_scale_info *b)
+{
+	return a->format == b->format && a->width == b->width &&
+	       a->height == b->height && a->range == b->range &&
+	       a->colorspace == b->colorspace;
+}
+
+static inline void get_output_scale_info(const struct video_output *video,
+					 struct video_scale_info *info)
 {
-	if (input->conversion.width != video->info.width ||
-	    input->conversion.height != video->info.height ||
-	    input->conversion.format != video->info.format) {
-		struct video_scale_info from = {.format = video->info.format,
-						.width = video->info.width,
-						.height = video->info.height,
-						.range = video->info.range,
-						.colorspace =
-							video->info.colorspace};
+	info->format = video->info.format;
+	info->width = video->info.width;
+	info->height = video->info.height;
+	info->range = video->info.range;
+	info->colorspace = video->info.colorspace;
+}
 
+static bool video_input_init(struct video_input *input,
+			     const struct video_scale_info *from)
+{
+	if (input->valid && scale_info_equal(&input->source, from))
+		return true;
+
+	video_input_free_scaler(input);
+	input->source = *from;
+	input->valid = false;
+
+	if (input->conversion.width != from->width ||
+	    input->conversion.height != from->height ||
+	    input->conversion.format != from->format) {
 		int ret = video_scaler_create(&input->scaler,
-					      &input->conversion, &from,
+					      &input->conversion, from,
 					      VIDEO_SCALE_FAST_BILINEAR);
 		if (ret != VIDEO_SCALER_SUCCESS) {
 			if (ret == VIDEO_SCALER_BAD_CONVERSION)
@@ -330,9 +385,58 @@ static inline bool video_input_init(struct video_input *input,
 					 input->conversion.height);
 	}
 
+	input->valid = true;
 	return true;
 }
 
+/* a cascaded input can only be scaled from its parent if the parent is
+ * processed before it and is not smaller than it, otherwise it falls back to
+ * being scaled from the full video output */
+static size_t get_cascade_parent(const struct video_output *video, size_t idx)
+{
+	const struct video_input *input = video->inputs.array + idx;
+	const struct video_input *parent;
+	size_t parent_idx;
+
+	if (!input->parent_callback)
+		return DARRAY_INVALID;
+
+	parent_idx = video_get_input_idx(video, input->parent_callback,
+					 input->parent_param);
+	if (parent_idx == DARRAY_INVALID || parent_idx >= idx)
+		return DARRAY_INVALID;
+
+	parent = video->inputs.array + parent_idx;
+	if (!parent->valid ||
+	    parent->conversion.width < input->conversion.width ||
+	    parent->conversion.height < input->conversion.height)
+		return DARRAY_INVALID;
+
+	return parent_idx;
+}
+
+/* resolves the source of every input after inputs are added or removed */
+static void video_output_update_cascade(struct video_output *video)
+{
+	for (size_t i = 0; i < video->inputs.num; i++) {
+		struct video_input *input = video->inputs.array + i;
+		struct video_scale_info from;
+		size_t parent_idx = get_cascade_parent(video, i);
+
+		if (parent_idx != DARRAY_INVALID) {
+			from = video->inputs.array[parent_idx].conversion;
+			if (video_input_init(input, &from)) {
+				input->parent_idx = parent_idx;
+				continue;
+			}
+		}
+
+		input->parent_idx = DARRAY_INVALID;
+		get_output_scale_info(video, &from);
+		video_input_init(input, &from);
+	}
+}
+
 static inline void reset_frames(video_t *video)
 {
 	os_atomic_set_long(&video->skipped_frames, 0);
@@ -342,6 +446,16 @@ static inline void reset_frames(video_t *video)
 bool video_output_connect(
 	video_t *video, const struct video_scale_info *conversion,
 	void (*callback)(void *param, struct video_data *frame), void *param)
+{
+	return video_output_connect_cascaded(video, conversion, NULL, NULL,
+					     callback, param);
+}
+
+bool video_output_connect_cascaded(
+	video_t *video, const struct video_scale_info *conversion,
+	void (*parent_callback)(void *param, struct video_data *frame),
+	void *parent_param,
+	void (*callback)(void *param, struct video_data *frame), void *param)
 {
 	bool success = false;
 
@@ -356,6 +470,9 @@ bool video_output_connect(
 
 		input.callback = callback;
 		input.param = param;
+		input.parent_callback = parent_callback;
+		input.parent_param = parent_param;
+		input.parent_idx = DARRAY_INVALID;
 
 		if (conversion) {
 			input.conversion = *conversion;
@@ -370,15 +487,20 @@ bool video_output_connect(
 		if (input.conversion.height == 0)
 			input.conversion.height = video->info.height;
 
-		success = video_input_init(&input, video);
+		size_t idx = da_push_back(video->inputs, &input);
+		video_output_update_cascade(video);
+
+		success = video->inputs.array[idx].valid;
 		if (success) {
-			if (video->inputs.num == 0) {
+			if (video->inputs.num == 1) {
 				if (!os_atomic_load_long(&video->gpu_refs)) {
 					reset_frames(video);
 				}
 				os_atomic_set_bool(&video->raw_active, true);
 			}
-			da_push_back(video->inputs, &input);
+		} else {
+			video_input_free(video->inputs.array + idx);
+			da_erase(video->inputs, idx);
 		}
 	}
 
@@ -418,6 +540,7 @@ void video_output_disconnect(video_t *video,
 	if (idx != DARRAY_INVALID) {
 		video_input_free(video->inputs.array + idx);
 		da_erase(video->inputs, idx);
+		video_output_update_cascade(video);
 
 		if (video->inputs.num == 0) {
 			os_atomic_set_bool(&video->raw_active, false);
@@ -236,6 +236,21 @@ EXPORT bool
 video_output_connect(video_t *video, const struct video_scale_info *conversion,
 		     void (*callback)(void *param, struct video_data *frame),
 		     void *param);
+
+/**
+ * Connects an input that is scaled from the output of another input (the
+ * parent, identified by its callback and param) instead of the full video
+ * output.  This allows building a chain of renditions where each one is
+ * scaled from the next larger one.  The parent must be connected first and
+ * must not be smaller than the conversion; otherwise, or if the parent is
+ * disconnected, the input is scaled from the full video output as usual.
+ * Every input receives the same timestamp for a given frame.
+ */
+EXPORT bool video_output_connect_cascaded(
+	video_t *video, const struct video_scale_info *conversion,
+	void (*parent_callback)(void *param, struct video_data *frame),
+	void *parent_param,
+	void (*callback)(void *param, struct video_data *frame), void *param);
 EXPORT void video_output_disconnect(video_t *video,
 				    void (*callback)(void *param,
 						     struct video_data *frame),
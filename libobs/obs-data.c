@@ -26,7 +26,9 @@
 #include "graphics/quat.h"
 #include "obs-data.h"
 
-#include <jansson.h>
+#include <locale.h>
+#include <errno.h>
+#include <math.h>
 
 struct obs_data_item {
 	volatile long ref;
@@ -44,15 +46,35 @@ struct obs_data_item {
 
 struct obs_data {
 	volatile long ref;
+	volatile long change_serial;
 	char *json;
 	struct obs_data_item *first_item;
 };
 
 struct obs_data_array {
 	volatile long ref;
+	volatile long change_serial;
 	DARRAY(obs_data_t *) objects;
 };
 
+/* every change to any data or array takes a new serial from here, so the
+ * latest serial of some data only ever increases */
+static volatile long change_serial_counter = 0;
+
+static inline void data_changed(struct obs_data *data)
+{
+	if (data)
+		os_atomic_set_long(&data->change_serial,
+				   os_atomic_inc_long(&change_serial_counter));
+}
+
+static inline void array_changed(struct obs_data_array *array)
+{
+	if (array)
+		os_atomic_set_long(&array->change_serial,
+				   os_atomic_inc_long(&change_serial_counter));
+}
+
 struct obs_data_number {
 	enum obs_data_number_type type;
 	union {
@@ -330,6 +352,7 @@ static inline void obs_data_item_detach(struct obs_data_item *item)
 	if (prev_next) {
 		*prev_next = item->next;
 		item->next = NULL;
+		data_changed(item->parent);
 	}
 }
 
@@ -411,6 +434,7 @@ static inline void obs_data_item_setdata(struct obs_data_item **p_item,
 	}
 
 	*p_item = item;
+	data_changed(item->parent);
 }
 
 static inline void obs_data_item_set_default_data(struct obs_data_item **p_item,
@@ -440,6 +464,7 @@ static inline void obs_data_item_set_default_data(struct obs_data_item **p_item,
 	}
 
 	*p_item = item;
+	data_changed(item->parent);
 }
 
 static inline void
@@ -466,158 +491,795 @@ obs_data_item_set_autoselect_data(struct obs_data_item **p_item,
 	}
 
 	*p_item = item;
+	data_changed(item->parent);
 }
 
+static struct obs_data_item *get_item(struct obs_data *data,
+				      const char *name);
+
 /* ------------------------------------------------------------------------- */
+/* JSON
+ *
+ * obs_data is written to and read from JSON directly, without building an
+ * intermediate JSON tree.  The output is byte-for-byte what jansson's
+ * json_dumps(JSON_PRESERVE_ORDER | JSON_INDENT(4)) produced, and the reader
+ * accepts and rejects the same documents that json_loads did with
+ * JSON_REJECT_DUPLICATES. */
+
+#define JSON_INDENT_SIZE 4
+#define JSON_MAX_DEPTH 2048
+#define JSON_FLUSH_SIZE (64 * 1024)
+
+static const char json_whitespace[] = "                                ";
+
+/* returns the length of the UTF-8 sequence at str, or 0 if invalid */
+static size_t json_utf8_seq(const uint8_t *str, size_t max_len)
+{
+	uint8_t c = str[0];
+	uint32_t value;
+	size_t len;
+
+	if (c < 0x80)
+		return 1;
+	else if (c >= 0xC2 && c <= 0xDF)
+		len = 2, value = c & 0x1F;
+	else if (c >= 0xE0 && c <= 0xEF)
+		len = 3, value = c & 0x0F;
+	else if (c >= 0xF0 && c <= 0xF4)
+		len = 4, value = c & 0x07;
+	else
+		return 0;
 
-static void obs_data_add_json_item(obs_data_t *data, const char *key,
-				   json_t *json);
+	if (len > max_len)
+		return 0;
 
-static inline void obs_data_add_json_object_data(obs_data_t *data, json_t *jobj)
+	for (size_t i = 1; i < len; i++) {
+		if ((str[i] & 0xC0) != 0x80)
+			return 0;
+		value = (value << 6) | (str[i] & 0x3F);
+	}
+
+	/* overlong encodings, surrogates, and out of range code points */
+	if ((len == 3 && value < 0x800) || (len == 4 && value < 0x10000) ||
+	    (value >= 0xD800 && value <= 0xDFFF) || value > 0x10FFFF)
+		return 0;
+
+	return len;
+}
+
+static bool json_utf8_valid(const char *str)
 {
-	const char *item_key;
-	json_t *jitem;
+	const uint8_t *pos = (const uint8_t *)str;
+	size_t len = strlen(str);
+
+	while (len) {
+		size_t seq = json_utf8_seq(pos, len);
+		if (!seq)
+			return false;
+		pos += seq;
+		len -= seq;
+	}
+
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+
+struct json_writer {
+	struct dstr out;
+	FILE *file;
+	bool error;
+};
 
-	json_object_foreach (jobj, item_key, jitem) {
-		obs_data_add_json_item(data, item_key, jitem);
+static void json_flush(struct json_writer *w)
+{
+	if (w->file && w->out.len && !w->error) {
+		if (fwrite(w->out.array, w->out.len, 1, w->file) != 1)
+			w->error = true;
+		w->out.len = 0;
 	}
 }
 
-static inline void obs_data_add_json_object(obs_data_t *data, const char *key,
-					    json_t *jobj)
+static inline void json_write(struct json_writer *w, const char *str,
+			      size_t len)
 {
-	obs_data_t *sub_obj = obs_data_create();
+	dstr_ncat(&w->out, str, len);
+	if (w->file && w->out.len >= JSON_FLUSH_SIZE)
+		json_flush(w);
+}
 
-	obs_data_add_json_object_data(sub_obj, jobj);
-	obs_data_set_obj(data, key, sub_obj);
-	obs_data_release(sub_obj);
+static void json_write_indent(struct json_writer *w, int depth)
+{
+	size_t spaces = (size_t)depth * JSON_INDENT_SIZE;
+
+	json_write(w, "\n", 1);
+
+	while (spaces) {
+		size_t count = spaces < sizeof(json_whitespace) - 1
+				       ? spaces
+				       : sizeof(json_whitespace) - 1;
+		json_write(w, json_whitespace, count);
+		spaces -= count;
+	}
 }
 
-static void obs_data_add_json_array(obs_data_t *data, const char *key,
-				    json_t *jarray)
+/* expects valid UTF-8 */
+static void json_write_string(struct json_writer *w, const char *str)
 {
-	obs_data_array_t *array = obs_data_array_create();
-	size_t idx;
-	json_t *jitem;
+	const char *start = str;
+	char seq[8];
 
-	json_array_foreach (jarray, idx, jitem) {
-		obs_data_t *item;
+	json_write(w, "\"", 1);
 
-		if (!json_is_object(jitem))
+	for (; *str; str++) {
+		const char *text;
+		uint8_t c = (uint8_t)*str;
+
+		if (c >= 0x20 && c != '"' && c != '\\')
 			continue;
 
-		item = obs_data_create();
-		obs_data_add_json_object_data(item, jitem);
-		obs_data_array_push_back(array, item);
-		obs_data_release(item);
+		if (str != start)
+			json_write(w, start, str - start);
+		start = str + 1;
+
+		switch (c) {
+		case '\\':
+			text = "\\\\";
+			break;
+		case '"':
+			text = "\\\"";
+			break;
+		case '\b':
+			text = "\\b";
+			break;
+		case '\f':
+			text = "\\f";
+			break;
+		case '\n':
+			text = "\\n";
+			break;
+		case '\r':
+			text = "\\r";
+			break;
+		case '\t':
+			text = "\\t";
+			break;
+		default:
+			snprintf(seq, sizeof(seq), "\\u%04X", (unsigned int)c);
+			text = seq;
+		}
+
+		json_write(w, text, strlen(text));
 	}
 
-	obs_data_set_array(data, key, array);
-	obs_data_array_release(array);
+	if (str != start)
+		json_write(w, start, str - start);
+	json_write(w, "\"", 1);
 }
 
-static void obs_data_add_json_item(obs_data_t *data, const char *key,
-				   json_t *json)
+static void json_write_obj(struct json_writer *w, obs_data_t *data,
+			   int depth);
+
+static void json_write_array(struct json_writer *w, obs_data_array_t *array,
+			     int depth)
 {
-	if (json_is_object(json))
-		obs_data_add_json_object(data, key, json);
-	else if (json_is_array(json))
-		obs_data_add_json_array(data, key, json);
-	else if (json_is_string(json))
-		obs_data_set_string(data, key, json_string_value(json));
-	else if (json_is_integer(json))
-		obs_data_set_int(data, key, json_integer_value(json));
-	else if (json_is_real(json))
-		obs_data_set_double(data, key, json_real_value(json));
-	else if (json_is_true(json))
-		obs_data_set_bool(data, key, true);
-	else if (json_is_false(json))
-		obs_data_set_bool(data, key, false);
+	size_t count = obs_data_array_count(array);
+
+	json_write(w, "[", 1);
+	if (!count) {
+		json_write(w, "]", 1);
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (i)
+			json_write(w, ",", 1);
+		json_write_indent(w, depth + 1);
+		json_write_obj(w, array->objects.array[i], depth + 1);
+	}
+
+	json_write_indent(w, depth);
+	json_write(w, "]", 1);
+}
+
+/* items that jansson would have refused to add to the object (invalid
+ * UTF-8, non-finite numbers) are left out, same as before */
+static bool json_item_valid(struct obs_data_item *item)
+{
+	void *ptr = get_data_ptr(item);
+
+	if (!item->data_size || !json_utf8_valid(get_item_name(item)))
+		return false;
+
+	if (item->type == OBS_DATA_STRING) {
+		return json_utf8_valid(ptr);
+
+	} else if (item->type == OBS_DATA_NUMBER) {
+		struct obs_data_number *num = ptr;
+		return num->type == OBS_DATA_NUM_INT ||
+		       isfinite(num->double_val);
+	}
+
+	return item->type == OBS_DATA_BOOLEAN ||
+	       item->type == OBS_DATA_OBJECT || item->type == OBS_DATA_ARRAY;
+}
+
+static void json_write_item(struct json_writer *w, struct obs_data_item *item,
+			    int depth)
+{
+	void *ptr = get_data_ptr(item);
+	char buf[64];
+	int len;
+
+	json_write_string(w, get_item_name(item));
+	json_write(w, ": ", 2);
+
+	if (item->type == OBS_DATA_STRING) {
+		json_write_string(w, ptr);
+
+	} else if (item->type == OBS_DATA_NUMBER) {
+		struct obs_data_number *num = ptr;
+
+		if (num->type == OBS_DATA_NUM_INT)
+			len = snprintf(buf, sizeof(buf), "%lld", num->int_val);
+		else
+			len = os_dtostr(num->double_val, buf, sizeof(buf));
+		if (len > 0)
+			json_write(w, buf, len);
+
+	} else if (item->type == OBS_DATA_BOOLEAN) {
+		bool val = *(bool *)ptr;
+		json_write(w, val ? "true" : "false", val ? 4 : 5);
+
+	} else if (item->type == OBS_DATA_OBJECT) {
+		json_write_obj(w, *(obs_data_t **)ptr, depth);
+
+	} else if (item->type == OBS_DATA_ARRAY) {
+		json_write_array(w, *(obs_data_array_t **)ptr, depth);
+	}
+}
+
+static void json_write_obj(struct json_writer *w, obs_data_t *data, int depth)
+{
+	struct obs_data_item *item = data ? data->first_item : NULL;
+	bool first = true;
+
+	json_write(w, "{", 1);
+
+	for (; item; item = item->next) {
+		if (!json_item_valid(item))
+			continue;
+
+		if (!first)
+			json_write(w, ",", 1);
+		json_write_indent(w, depth + 1);
+		json_write_item(w, item, depth + 1);
+		first = false;
+	}
+
+	if (!first)
+		json_write_indent(w, depth);
+	json_write(w, "}", 1);
 }
 
 /* ------------------------------------------------------------------------- */
 
-static inline void set_json_string(json_t *json, const char *name,
-				   obs_data_item_t *item)
+struct json_reader {
+	const char *start;
+	const char *pos;
+	int depth;
+	struct dstr error;
+	struct dstr str;
+};
+
+static void json_set_error(struct json_reader *r, const char *format, ...)
+{
+	va_list args;
+
+	if (!dstr_is_empty(&r->error))
+		return;
+
+	va_start(args, format);
+	dstr_vprintf(&r->error, format, args);
+	va_end(args);
+}
+
+static int json_get_line(const struct json_reader *r)
 {
-	const char *val = obs_data_item_get_string(item);
-	json_object_set_new(json, name, json_string(val));
+	int line = 1;
+	for (const char *p = r->start; p < r->pos; p++) {
+		if (*p == '\n')
+			line++;
+	}
+	return line;
 }
 
-static inline void set_json_number(json_t *json, const char *name,
-				   obs_data_item_t *item)
+static inline void json_skip_whitespace(struct json_reader *r)
 {
-	enum obs_data_number_type type = obs_data_item_numtype(item);
+	while (*r->pos == ' ' || *r->pos == '\t' || *r->pos == '\n' ||
+	       *r->pos == '\r')
+		r->pos++;
+}
+
+static int json_hex_digit(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+static bool json_read_hex4(struct json_reader *r, uint32_t *out)
+{
+	uint32_t value = 0;
+
+	for (int i = 0; i < 4; i++) {
+		int digit = json_hex_digit(r->pos[i]);
+		if (digit < 0) {
+			json_set_error(r, "invalid escape");
+			return false;
+		}
+		value = (value << 4) | (uint32_t)digit;
+	}
 
-	if (type == OBS_DATA_NUM_INT) {
-		long long val = obs_data_item_get_int(item);
-		json_object_set_new(json, name, json_integer(val));
+	r->pos += 4;
+	*out = value;
+	return true;
+}
+
+static void json_append_utf8(struct dstr *str, uint32_t cp)
+{
+	char buf[4];
+	size_t len;
+
+	if (cp < 0x80) {
+		buf[0] = (char)cp;
+		len = 1;
+	} else if (cp < 0x800) {
+		buf[0] = (char)(0xC0 | (cp >> 6));
+		buf[1] = (char)(0x80 | (cp & 0x3F));
+		len = 2;
+	} else if (cp < 0x10000) {
+		buf[0] = (char)(0xE0 | (cp >> 12));
+		buf[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		buf[2] = (char)(0x80 | (cp & 0x3F));
+		len = 3;
 	} else {
-		double val = obs_data_item_get_double(item);
-		json_object_set_new(json, name, json_real(val));
+		buf[0] = (char)(0xF0 | (cp >> 18));
+		buf[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+		buf[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		buf[3] = (char)(0x80 | (cp & 0x3F));
+		len = 4;
 	}
+
+	dstr_ncat(str, buf, len);
 }
 
-static inline void set_json_bool(json_t *json, const char *name,
-				 obs_data_item_t *item)
+static bool json_read_escape(struct json_reader *r, struct dstr *str)
 {
-	bool val = obs_data_item_get_bool(item);
-	json_object_set_new(json, name, val ? json_true() : json_false());
+	char c = *r->pos++;
+	uint32_t cp, low;
+
+	switch (c) {
+	case '"':
+	case '\\':
+	case '/':
+		dstr_ncat(str, &c, 1);
+		return true;
+	case 'b':
+		dstr_ncat(str, "\b", 1);
+		return true;
+	case 'f':
+		dstr_ncat(str, "\f", 1);
+		return true;
+	case 'n':
+		dstr_ncat(str, "\n", 1);
+		return true;
+	case 'r':
+		dstr_ncat(str, "\r", 1);
+		return true;
+	case 't':
+		dstr_ncat(str, "\t", 1);
+		return true;
+	case 'u':
+		break;
+	default:
+		json_set_error(r, "invalid escape");
+		return false;
+	}
+
+	if (!json_read_hex4(r, &cp))
+		return false;
+
+	if (cp == 0) {
+		json_set_error(r, "\\u0000 is not allowed");
+		return false;
+	}
+
+	if (cp >= 0xD800 && cp <= 0xDBFF) {
+		if (r->pos[0] != '\\' || r->pos[1] != 'u') {
+			json_set_error(r, "invalid Unicode '\\u%04X'", cp);
+			return false;
+		}
+
+		r->pos += 2;
+		if (!json_read_hex4(r, &low))
+			return false;
+
+		if (low < 0xDC00 || low > 0xDFFF) {
+			json_set_error(r, "invalid Unicode '\\u%04X\\u%04X'",
+				       cp, low);
+			return false;
+		}
+
+		cp = 0x10000 + (((cp & 0x3FF) << 10) | (low & 0x3FF));
+
+	} else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+		json_set_error(r, "invalid Unicode '\\u%04X'", cp);
+		return false;
+	}
+
+	json_append_utf8(str, cp);
+	return true;
 }
 
-static json_t *obs_data_to_json(obs_data_t *data);
+/* reads a string (starting after the quote) into str */
+static bool json_read_string(struct json_reader *r, struct dstr *str)
+{
+	dstr_resize(str, 0);
+
+	for (;;) {
+		const char *start = r->pos;
+		uint8_t c;
+
+		/* copy runs of plain characters at once */
+		while ((c = (uint8_t)*r->pos) >= 0x20 && c != '"' &&
+		       c != '\\') {
+			if (c < 0x80) {
+				r->pos++;
+				continue;
+			}
+
+			size_t seq = json_utf8_seq((const uint8_t *)r->pos,
+						   strnlen(r->pos, 4));
+			if (!seq) {
+				json_set_error(r, "unable to decode byte 0x%x",
+					       c);
+				return false;
+			}
+			r->pos += seq;
+		}
+
+		if (r->pos != start)
+			dstr_ncat(str, start, r->pos - start);
 
-static inline void set_json_obj(json_t *json, const char *name,
-				obs_data_item_t *item)
+		if (c == '"') {
+			r->pos++;
+			break;
+
+		} else if (c == '\\') {
+			r->pos++;
+			if (!json_read_escape(r, str))
+				return false;
+
+		} else if (c == 0) {
+			json_set_error(r, "premature end of input");
+			return false;
+
+		} else {
+			json_set_error(r, "control character 0x%x", c);
+			return false;
+		}
+	}
+
+	/* empty strings still need a valid (terminated) buffer */
+	if (!str->array)
+		dstr_copy(str, "");
+	return true;
+}
+
+static inline bool json_is_digit(char c)
 {
-	obs_data_t *obj = obs_data_item_get_obj(item);
-	json_object_set_new(json, name, obs_data_to_json(obj));
-	obs_data_release(obj);
+	return c >= '0' && c <= '9';
 }
 
-static inline void set_json_array(json_t *json, const char *name,
-				  obs_data_item_t *item)
+static bool json_read_number(struct json_reader *r, obs_data_t *data,
+			     const char *key)
 {
-	json_t *jarray = json_array();
-	obs_data_array_t *array = obs_data_item_get_array(item);
-	size_t count = obs_data_array_count(array);
+	const char *start = r->pos;
+	bool real = false;
+
+	if (*r->pos == '-')
+		r->pos++;
+
+	if (*r->pos == '0') {
+		r->pos++;
+		if (json_is_digit(*r->pos))
+			goto invalid;
+	} else if (json_is_digit(*r->pos)) {
+		while (json_is_digit(*r->pos))
+			r->pos++;
+	} else {
+		goto invalid;
+	}
+
+	if (*r->pos == '.') {
+		r->pos++;
+		if (!json_is_digit(*r->pos))
+			goto invalid;
+		while (json_is_digit(*r->pos))
+			r->pos++;
+		real = true;
+	}
 
-	for (size_t idx = 0; idx < count; idx++) {
-		obs_data_t *sub_item = obs_data_array_item(array, idx);
-		json_t *jitem = obs_data_to_json(sub_item);
-		json_array_append_new(jarray, jitem);
-		obs_data_release(sub_item);
+	if (*r->pos == 'e' || *r->pos == 'E') {
+		r->pos++;
+		if (*r->pos == '+' || *r->pos == '-')
+			r->pos++;
+		if (!json_is_digit(*r->pos))
+			goto invalid;
+		while (json_is_digit(*r->pos))
+			r->pos++;
+		real = true;
 	}
 
-	json_object_set_new(json, name, jarray);
+	dstr_ncopy(&r->str, start, r->pos - start);
+	errno = 0;
+
+	if (!real) {
+		long long val = strtoll(r->str.array, NULL, 10);
+		if (errno == ERANGE) {
+			json_set_error(r, val < 0 ? "too big negative integer"
+						  : "too big integer");
+			return false;
+		}
+		if (data)
+			obs_data_set_int(data, key, val);
+
+	} else {
+		const char *point = localeconv()->decimal_point;
+		double val;
+
+		if (*point != '.')
+			dstr_replace(&r->str, ".", point);
+
+		val = strtod(r->str.array, NULL);
+		if ((val == HUGE_VAL || val == -HUGE_VAL) && errno == ERANGE) {
+			json_set_error(r, "real number overflow");
+			return false;
+		}
+		if (data)
+			obs_data_set_double(data, key, val);
+	}
+
+	return true;
+
+invalid:
+	json_set_error(r, "invalid token");
+	return false;
+}
+
+static obs_data_t *json_read_obj(struct json_reader *r);
+static obs_data_array_t *json_read_array(struct json_reader *r);
+
+static inline bool json_read_literal(struct json_reader *r, const char *text,
+				     size_t len)
+{
+	if (strncmp(r->pos, text, len) != 0) {
+		json_set_error(r, "invalid token");
+		return false;
+	}
+
+	r->pos += len;
+	return true;
+}
+
+/* reads a value and sets it on data (if not NULL) */
+static bool json_read_value(struct json_reader *r, obs_data_t *data,
+			    const char *key)
+{
+	bool success = true;
+
+	if (++r->depth > JSON_MAX_DEPTH) {
+		json_set_error(r, "maximum parsing depth reached");
+		return false;
+	}
+
+	switch (*r->pos) {
+	case '{': {
+		obs_data_t *obj = json_read_obj(r);
+		if (obj && data)
+			obs_data_set_obj(data, key, obj);
+		success = !!obj;
+		obs_data_release(obj);
+		break;
+	}
+	case '[': {
+		obs_data_array_t *array = json_read_array(r);
+		if (array && data)
+			obs_data_set_array(data, key, array);
+		success = !!array;
+		obs_data_array_release(array);
+		break;
+	}
+	case '"':
+		r->pos++;
+		success = json_read_string(r, &r->str);
+		if (success && data)
+			obs_data_set_string(data, key, r->str.array);
+		break;
+	case 't':
+		success = json_read_literal(r, "true", 4);
+		if (success && data)
+			obs_data_set_bool(data, key, true);
+		break;
+	case 'f':
+		success = json_read_literal(r, "false", 5);
+		if (success && data)
+			obs_data_set_bool(data, key, false);
+		break;
+	case 'n':
+		success = json_read_literal(r, "null", 4);
+		break;
+	default:
+		success = json_read_number(r, data, key);
+	}
+
+	r->depth--;
+	return success;
+}
+
+static obs_data_t *json_read_obj(struct json_reader *r)
+{
+	obs_data_t *data = obs_data_create();
+	struct dstr key = {0};
+
+	r->pos++;
+	json_skip_whitespace(r);
+
+	if (*r->pos == '}') {
+		r->pos++;
+		return data;
+	}
+
+	for (;;) {
+		if (*r->pos != '"') {
+			json_set_error(r, "string or '}' expected");
+			goto fail;
+		}
+
+		r->pos++;
+		if (!json_read_string(r, &key))
+			goto fail;
+
+		if (get_item(data, key.array)) {
+			json_set_error(r, "duplicate object key");
+			goto fail;
+		}
+
+		json_skip_whitespace(r);
+		if (*r->pos != ':') {
+			json_set_error(r, "':' expected");
+			goto fail;
+		}
+
+		r->pos++;
+		json_skip_whitespace(r);
+		if (!json_read_value(r, data, key.array))
+			goto fail;
+
+		json_skip_whitespace(r);
+		if (*r->pos == '}') {
+			r->pos++;
+			break;
+		} else if (*r->pos != ',') {
+			json_set_error(r, "'}' expected");
+			goto fail;
+		}
+
+		r->pos++;
+		json_skip_whitespace(r);
+	}
+
+	dstr_free(&key);
+	return data;
+
+fail:
+	dstr_free(&key);
+	obs_data_release(data);
+	return NULL;
+}
+
+/* only object elements are kept, same as before */
+static obs_data_array_t *json_read_array(struct json_reader *r)
+{
+	obs_data_array_t *array = obs_data_array_create();
+
+	r->pos++;
+	json_skip_whitespace(r);
+
+	if (*r->pos == ']') {
+		r->pos++;
+		return array;
+	}
+
+	for (;;) {
+		if (*r->pos == '{') {
+			obs_data_t *obj;
+
+			if (++r->depth > JSON_MAX_DEPTH) {
+				json_set_error(r,
+					       "maximum parsing depth reached");
+				goto fail;
+			}
+
+			obj = json_read_obj(r);
+			r->depth--;
+			if (!obj)
+				goto fail;
+
+			obs_data_array_push_back(array, obj);
+			obs_data_release(obj);
+
+		} else if (!json_read_value(r, NULL, NULL)) {
+			goto fail;
+		}
+
+		json_skip_whitespace(r);
+		if (*r->pos == ']') {
+			r->pos++;
+			break;
+		} else if (*r->pos != ',') {
+			json_set_error(r, "']' expected");
+			goto fail;
+		}
+
+		r->pos++;
+		json_skip_whitespace(r);
+	}
+
+	return array;
+
+fail:
 	obs_data_array_release(array);
+	return NULL;
 }
 
-static json_t *obs_data_to_json(obs_data_t *data)
+static obs_data_t *json_read_root(struct json_reader *r)
 {
-	json_t *json = json_object();
-	obs_data_item_t *item = NULL;
+	obs_data_t *data = NULL;
 
-	for (item = obs_data_first(data); item; obs_data_item_next(&item)) {
-		enum obs_data_type type = obs_data_item_gettype(item);
-		const char *name = get_item_name(item);
+	json_skip_whitespace(r);
+	r->depth = 1;
 
-		if (!obs_data_item_has_user_value(item))
-			continue;
+	if (*r->pos == '{') {
+		data = json_read_obj(r);
 
-		if (type == OBS_DATA_STRING)
-			set_json_string(json, name, item);
-		else if (type == OBS_DATA_NUMBER)
-			set_json_number(json, name, item);
-		else if (type == OBS_DATA_BOOLEAN)
-			set_json_bool(json, name, item);
-		else if (type == OBS_DATA_OBJECT)
-			set_json_obj(json, name, item);
-		else if (type == OBS_DATA_ARRAY)
-			set_json_array(json, name, item);
+	} else if (*r->pos == '[') {
+		/* a root array is valid json, but has no object data */
+		obs_data_array_t *array = json_read_array(r);
+		if (array)
+			data = obs_data_create();
+		obs_data_array_release(array);
+
+	} else {
+		json_set_error(r, "'[' or '{' expected");
+		return NULL;
 	}
 
-	return json;
+	if (data) {
+		json_skip_whitespace(r);
+		if (*r->pos) {
+			json_set_error(r, "end of file expected");
+			obs_data_release(data);
+			data = NULL;
+		}
+	}
+
+	return data;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -626,29 +1288,35 @@ obs_data_t *obs_data_create()
 {
 	struct obs_data *data = bzalloc(sizeof(struct obs_data));
 	data->ref = 1;
+	data_changed(data);
 
 	return data;
 }
 
 obs_data_t *obs_data_create_from_json(const char *json_string)
 {
-	obs_data_t *data = obs_data_create();
+	struct json_reader reader = {0};
+	obs_data_t *data;
 
-	json_error_t error;
-	json_t *root = json_loads(json_string, JSON_REJECT_DUPLICATES, &error);
+	if (!json_string) {
+		blog(LOG_ERROR, "obs-data.c: [obs_data_create_from_json] "
+				"Failed reading json string: wrong arguments");
+		return NULL;
+	}
 
-	if (root) {
-		obs_data_add_json_object_data(data, root);
-		json_decref(root);
-	} else {
+	reader.start = json_string;
+	reader.pos = json_string;
+
+	data = json_read_root(&reader);
+	if (!data) {
 		blog(LOG_ERROR,
 		     "obs-data.c: [obs_data_create_from_json] "
 		     "Failed reading json string (%d): %s",
-		     error.line, error.text);
-		obs_data_release(data);
-		data = NULL;
+		     json_get_line(&reader), reader.error.array);
 	}
 
+	dstr_free(&reader.error);
+	dstr_free(&reader.str);
 	return data;
 }
 
@@ -712,8 +1380,7 @@ static inline void obs_data_destroy(struct obs_data *data)
 		item = next;
 	}
 
-	/* NOTE: don't use bfree for json text, allocated by json */
-	free(data->json);
+	bfree(data->json);
 	bfree(data);
 }
 
@@ -728,43 +1395,139 @@ void obs_data_release(obs_data_t *data)
 
 const char *obs_data_get_json(obs_data_t *data)
 {
+	struct json_writer writer = {0};
+
 	if (!data)
 		return NULL;
 
-	/* NOTE: don't use libobs bfree for json text */
-	free(data->json);
-	data->json = NULL;
+	json_write_obj(&writer, data, 0);
 
-	json_t *root = obs_data_to_json(data);
-	data->json = json_dumps(root, JSON_PRESERVE_ORDER | JSON_INDENT(4));
-	json_decref(root);
+	bfree(data->json);
+	data->json = writer.out.array;
 
 	return data->json;
 }
 
-bool obs_data_save_json(obs_data_t *data, const char *file)
+static long array_get_change_serial(obs_data_array_t *array);
+
+long obs_data_get_change_serial(obs_data_t *data)
 {
-	const char *json = obs_data_get_json(data);
+	struct obs_data_item *item;
+	long serial;
+
+	if (!data)
+		return 0;
+
+	serial = os_atomic_load_long(&data->change_serial);
 
-	if (json && *json) {
-		return os_quick_write_utf8_file(file, json, strlen(json),
-						false);
+	for (item = data->first_item; item; item = item->next) {
+		long item_serial = 0;
+
+		if (item->type == OBS_DATA_OBJECT)
+			item_serial =
+				obs_data_get_change_serial(get_item_obj(item));
+		else if (item->type == OBS_DATA_ARRAY)
+			item_serial =
+				array_get_change_serial(get_item_array(item));
+
+		if (item_serial > serial)
+			serial = item_serial;
 	}
 
-	return false;
+	return serial;
+}
+
+static long array_get_change_serial(obs_data_array_t *array)
+{
+	long serial;
+
+	if (!array)
+		return 0;
+
+	serial = os_atomic_load_long(&array->change_serial);
+
+	for (size_t i = 0; i < array->objects.num; i++) {
+		long obj_serial =
+			obs_data_get_change_serial(array->objects.array[i]);
+		if (obj_serial > serial)
+			serial = obj_serial;
+	}
+
+	return serial;
+}
+
+static bool write_json_file(obs_data_t *data, const char *file)
+{
+	struct json_writer writer = {0};
+
+	writer.file = os_fopen(file, "wb");
+	if (!writer.file)
+		return false;
+
+	dstr_reserve(&writer.out, JSON_FLUSH_SIZE + 4096);
+
+	json_write_obj(&writer, data, 0);
+	json_flush(&writer);
+
+	if (fflush(writer.file) != 0)
+		writer.error = true;
+	fclose(writer.file);
+
+	dstr_free(&writer.out);
+	return !writer.error;
+}
+
+bool obs_data_save_json(obs_data_t *data, const char *file)
+{
+	if (!data)
+		return false;
+
+	return write_json_file(data, file);
 }
 
 bool obs_data_save_json_safe(obs_data_t *data, const char *file,
 			     const char *temp_ext, const char *backup_ext)
 {
-	const char *json = obs_data_get_json(data);
+	struct dstr backup_path = {0};
+	struct dstr temp_path = {0};
+	bool success = false;
 
-	if (json && *json) {
-		return os_quick_write_utf8_file_safe(
-			file, json, strlen(json), false, temp_ext, backup_ext);
+	if (!data)
+		return false;
+
+	if (!temp_ext || !*temp_ext) {
+		blog(LOG_ERROR, "obs_data_save_json_safe: invalid "
+				"temporary extension specified");
+		return false;
 	}
 
-	return false;
+	dstr_copy(&temp_path, file);
+	if (*temp_ext != '.')
+		dstr_cat(&temp_path, ".");
+	dstr_cat(&temp_path, temp_ext);
+
+	if (!write_json_file(data, temp_path.array)) {
+		blog(LOG_ERROR,
+		     "obs_data_save_json_safe: failed to "
+		     "write to %s",
+		     temp_path.array);
+		goto cleanup;
+	}
+
+	if (backup_ext && *backup_ext) {
+		dstr_copy(&backup_path, file);
+		if (*backup_ext != '.')
+			dstr_cat(&backup_path, ".");
+		dstr_cat(&backup_path, backup_ext);
+	}
+
+	if (os_safe_replace(file, temp_path.array, backup_path.array) == 0)
+		success = true;
+
+cleanup:
+	dstr_free(&backup_path);
+	dstr_free(&temp_path);
+	return success;
 }
 
 static struct obs_data_item *get_item(struct obs_data *data, const char *name)
@@ -820,6 +1583,8 @@ static void set_item_data(struct obs_data *data, struct obs_data_item **item,
 		obs_data_item_release(&prev);
 		obs_data_item_release(&next);
 
+		data_changed(data);
+
 	} else if (default_data) {
 		obs_data_item_set_default_data(item, ptr, size, type);
 	} else if (autoselect_data) {
@@ -1009,6 +1774,8 @@ void obs_data_clear(obs_data_t *target)
 		clear_item(item);
 		item = item->next;
 	}
+
+	data_changed(target);
 }
 
 typedef void (*set_item_t)(obs_data_t *, obs_data_item_t **, const char *,
@@ -1264,6 +2031,7 @@ obs_data_array_t *obs_data_array_create()
 {
 	struct obs_data_array *array = bzalloc(sizeof(struct obs_data_array));
 	array->ref = 1;
+	array_changed(array);
 
 	return array;
 }
@@ -1318,6 +2086,7 @@ size_t obs_data_array_push_back(obs_data_array_t *array, obs_data_t *obj)
 		return 0;
 
 	os_atomic_inc_long(&obj->ref);
+	array_changed(array);
 	return da_push_back(array->objects, &obj);
 }
 
@@ -1328,6 +2097,7 @@ void obs_data_array_insert(obs_data_array_t *array, size_t idx, obs_data_t *obj)
 
 	os_atomic_inc_long(&obj->ref);
 	da_insert(array->objects, idx, &obj);
+	array_changed(array);
 }
 
 void obs_data_array_push_back_array(obs_data_array_t *array,
@@ -1341,6 +2111,7 @@ void obs_data_array_push_back_array(obs_data_array_t *array,
 		obs_data_addref(obj);
 	}
 	da_push_back_da(array->objects, array2->objects);
+	array_changed(array);
 }
 
 void obs_data_array_erase(obs_data_array_t *array, size_t idx)
@@ -1348,6 +2119,7 @@ void obs_data_array_erase(obs_data_array_t *array, size_t idx)
 	if (array) {
 		obs_data_release(array->objects.array[idx]);
 		da_erase(array->objects, idx);
+		array_changed(array);
 	}
 }
 
@@ -1417,6 +2189,8 @@ void obs_data_item_unset_user_value(obs_data_item_t *item)
 		move_data(item, old_non_user_data, item,
 			  get_default_data_ptr(item),
 			  item->default_len + item->autoselect_size);
+
+	data_changed(item->parent);
 }
 
 void obs_data_item_unset_default_value(obs_data_item_t *item)
@@ -1433,6 +2207,8 @@ void obs_data_item_unset_default_value(obs_data_item_t *item)
 	if (item->autoselect_size)
 		move_data(item, old_autoselect_data, item,
 			  get_autoselect_data_ptr(item), item->autoselect_size);
+
+	data_changed(item->parent);
 }
 
 void obs_data_item_unset_autoselect_value(obs_data_item_t *item)
@@ -1442,6 +2218,7 @@ void obs_data_item_unset_autoselect_value(obs_data_item_t *item)
 
 	item_autoselect_data_release(item);
 	item->autoselect_size = 0;
+	data_changed(item->parent);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -47,6 +47,9 @@ bool obs_display_init(struct obs_display *display,
 	}
 
 	display->enabled = true;
+	display->visible = true;
+	display->redraw_requested = true;
+	display->profile_name = "obs_display";
 	return true;
 }
 
@@ -119,6 +122,8 @@ void obs_display_resize(obs_display_t *display, uint32_t cx, uint32_t cy)
 	display->size_changed = true;
 
 	pthread_mutex_unlock(&display->draw_info_mutex);
+
+	obs_display_request_redraw(display);
 }
 
 void obs_display_add_draw_callback(obs_display_t *display,
@@ -134,6 +139,8 @@ void obs_display_add_draw_callback(obs_display_t *display,
 	pthread_mutex_lock(&display->draw_callbacks_mutex);
 	da_push_back(display->draw_callbacks, &data);
 	pthread_mutex_unlock(&display->draw_callbacks_mutex);
+
+	obs_display_request_redraw(display);
 }
 
 void obs_display_remove_draw_callback(obs_display_t *display,
@@ -149,6 +156,8 @@ void obs_display_remove_draw_callback(obs_display_t *display,
 	pthread_mutex_lock(&display->draw_callbacks_mutex);
 	da_erase_item(display->draw_callbacks, &data);
 	pthread_mutex_unlock(&display->draw_callbacks_mutex);
+
+	obs_display_request_redraw(display);
 }
 
 static inline void render_display_begin(struct obs_display *display,
@@ -183,14 +192,48 @@ static inline void render_display_end()
 	gs_end_scene();
 }
 
-void render_display(struct obs_display *display)
+static bool display_render_due(struct obs_display *display,
+			       uint64_t frame_time)
 {
+	uint64_t interval = 0;
+
+	if (!display->enabled || !display->visible)
+		return false;
+
+	if (display->max_fps) {
+		interval = 1000000000ULL / display->max_fps;
+
+		/* allow a bit of slack so that a display limited to the
+		 * output framerate doesn't drop frames due to jitter */
+		if (frame_time + interval / 4 < display->next_render_ts)
+			return false;
+	}
+
+	if (display->redraw_on_demand &&
+	    !os_atomic_set_bool(&display->redraw_requested, false))
+		return false;
+
+	if (interval) {
+		display->next_render_ts += interval;
+		if (display->next_render_ts <= frame_time)
+			display->next_render_ts = frame_time + interval;
+	}
+
+	return true;
+}
+
+void render_display(struct obs_display *display, uint64_t frame_time)
+{
+	const char *profile_name;
 	uint32_t cx, cy;
 	bool size_changed;
 
-	if (!display || !display->enabled)
+	if (!display || !display_render_due(display, frame_time))
 		return;
 
+	profile_name = display->profile_name;
+	profile_start(profile_name);
+
 	GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_DISPLAY, "obs_display");
 
 	/* -------------------------------------------- */
@@ -226,12 +269,16 @@ void render_display(struct obs_display *display)
 	GS_DEBUG_MARKER_END();
 
 	gs_present();
+
+	profile_end(profile_name);
 }
 
 void obs_display_set_enabled(obs_display_t *display, bool enable)
 {
-	if (display)
+	if (display) {
 		display->enabled = enable;
+		obs_display_request_redraw(display);
+	}
 }
 
 bool obs_display_enabled(obs_display_t *display)
@@ -241,8 +288,10 @@ bool obs_display_enabled(obs_display_t *display)
 
 void obs_display_set_background_color(obs_display_t *display, uint32_t color)
 {
-	if (display)
+	if (display) {
 		display->background_color = color;
+		obs_display_request_redraw(display);
+	}
 }
 
 void obs_display_size(obs_display_t *display, uint32_t *width, uint32_t *height)
@@ -259,3 +308,63 @@ void obs_display_size(obs_display_t *display, uint32_t *width, uint32_t *height)
 		pthread_mutex_unlock(&display->draw_info_mutex);
 	}
 }
+
+void obs_display_set_name(obs_display_t *display, const char *name)
+{
+	if (!display || !name || !*name)
+		return;
+
+	/* profiler entries reference names for the lifetime of the profiler,
+	 * so store them in the profiler's name store */
+	display->profile_name = profile_store_name(
+		obs_get_profiler_name_store(), "obs_display(%s)", name);
+}
+
+void obs_display_set_max_fps(obs_display_t *display, uint32_t fps)
+{
+	if (!display)
+		return;
+
+	display->max_fps = fps;
+	display->next_render_ts = 0;
+}
+
+uint32_t obs_display_get_max_fps(obs_display_t *display)
+{
+	return display ? display->max_fps : 0;
+}
+
+void obs_display_set_redraw_on_demand(obs_display_t *display, bool on_demand)
+{
+	if (!display)
+		return;
+
+	display->redraw_on_demand = on_demand;
+	obs_display_request_redraw(display);
+}
+
+bool obs_display_redraw_on_demand(obs_display_t *display)
+{
+	return display ? display->redraw_on_demand : false;
+}
+
+void obs_display_request_redraw(obs_display_t *display)
+{
+	if (display)
+		os_atomic_set_bool(&display->redraw_requested, true);
+}
+
+void obs_display_set_visible(obs_display_t *display, bool visible)
+{
+	if (!display)
+		return;
+
+	display->visible = visible;
+	if (visible)
+		obs_display_request_redraw(display);
+}
+
+bool obs_display_visible(obs_display_t *display)
+{
+	return display ? display->visible : false;
+}
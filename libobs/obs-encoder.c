@@ -15,6 +15,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
+#include <inttypes.h>
 #include "obs.h"
 #include "obs-internal.h"
 
@@ -66,6 +67,8 @@ static bool init_encoder(struct obs_encoder *encoder, const char *name,
 	if (pthread_mutex_init(&encoder->pause.mutex, NULL) != 0)
 		return false;
 
+	encoder->packet_pool = encoder_packet_pool_create();
+
 	if (encoder->orig_info.get_defaults) {
 		encoder->orig_info.get_defaults(encoder->context.settings);
 	}
@@ -195,6 +198,31 @@ static inline bool gpu_encode_available(const struct obs_encoder *encoder)
 	       obs->video.using_nv12_tex;
 }
 
+/* returns a reference to the ladder parent if it's currently active on the
+ * same video output, otherwise the encoder just runs on its own */
+static struct obs_encoder *get_active_ladder_parent(struct obs_encoder *encoder)
+{
+	struct obs_encoder *parent;
+
+	if (!encoder->ladder_parent)
+		return NULL;
+
+	parent = obs_weak_encoder_get_encoder(encoder->ladder_parent);
+	if (!parent)
+		return NULL;
+
+	if (parent->media != encoder->media || !encoder_active(parent)) {
+		blog(LOG_WARNING,
+		     "encoder '%s': Ladder parent '%s' is not active, "
+		     "scaling from the full video output",
+		     encoder->context.name, parent->context.name);
+		obs_encoder_release(parent);
+		return NULL;
+	}
+
+	return parent;
+}
+
 static void add_connection(struct obs_encoder *encoder)
 {
 	if (encoder->info.type == OBS_ENCODER_AUDIO) {
@@ -207,8 +235,16 @@ static void add_connection(struct obs_encoder *encoder)
 		struct video_scale_info info = {0};
 		get_video_info(encoder, &info);
 
+		encoder->active_ladder_parent =
+			get_active_ladder_parent(encoder);
+
 		if (gpu_encode_available(encoder)) {
 			start_gpu_encode(encoder);
+		} else if (encoder->active_ladder_parent) {
+			start_raw_video_cascaded(encoder->media, &info,
+						 receive_video,
+						 encoder->active_ladder_parent,
+						 receive_video, encoder);
 		} else {
 			start_raw_video(encoder->media, &info, receive_video,
 					encoder);
@@ -229,6 +265,9 @@ static void remove_connection(struct obs_encoder *encoder, bool shutdown)
 		} else {
 			stop_raw_video(encoder->media, receive_video, encoder);
 		}
+
+		obs_encoder_release(encoder->active_ladder_parent);
+		encoder->active_ladder_parent = NULL;
 	}
 
 	/* obs_encoder_shutdown locks init_mutex, so don't call it on encode
@@ -265,6 +304,7 @@ static void obs_encoder_actually_destroy(obs_encoder_t *encoder)
 		     encoder->context.name);
 
 		free_audio_buffers(encoder);
+		obs_weak_encoder_release(encoder->ladder_parent);
 
 		if (encoder->context.data)
 			encoder->info.destroy(encoder->context.data);
@@ -273,6 +313,7 @@ static void obs_encoder_actually_destroy(obs_encoder_t *encoder)
 		pthread_mutex_destroy(&encoder->callbacks_mutex);
 		pthread_mutex_destroy(&encoder->outputs_mutex);
 		pthread_mutex_destroy(&encoder->pause.mutex);
+		encoder_packet_pool_release(encoder->packet_pool);
 		obs_context_data_free(&encoder->context);
 		if (encoder->owns_info_id)
 			bfree((void *)encoder->info.id);
@@ -459,11 +500,13 @@ static inline bool obs_encoder_initialize_internal(obs_encoder_t *encoder)
 	obs_encoder_shutdown(encoder);
 
 	if (encoder->orig_info.create) {
+		const char *prev_tag = bmem_set_tag(encoder->orig_info.id);
 		can_reroute = true;
 		encoder->info = encoder->orig_info;
 		encoder->context.data = encoder->orig_info.create(
 			encoder->context.settings, encoder);
 		can_reroute = false;
+		bmem_set_tag(prev_tag);
 	}
 	if (!encoder->context.data)
 		return false;
@@ -512,10 +555,27 @@ bool obs_encoder_initialize(obs_encoder_t *encoder)
 	return success;
 }
 
+static void log_packet_pool_stats(const struct obs_encoder *encoder)
+{
+	struct obs_encoder_packet_pool_stats stats;
+
+	if (!obs_encoder_get_packet_pool_stats(encoder, &stats) ||
+	    !stats.allocs)
+		return;
+
+	blog(LOG_INFO,
+	     "encoder '%s' packet pool: %" PRIu64 " allocations, "
+	     "%.1f%% reused, %" PRIu64 " zero-copy",
+	     encoder->context.name, stats.allocs,
+	     (double)stats.hits / (double)stats.allocs * 100.0,
+	     stats.handoffs);
+}
+
 void obs_encoder_shutdown(obs_encoder_t *encoder)
 {
 	pthread_mutex_lock(&encoder->init_mutex);
 	if (encoder->context.data) {
+		log_packet_pool_stats(encoder);
 		encoder->info.destroy(encoder->context.data);
 		encoder->context.data = NULL;
 		encoder->paired_encoder = NULL;
@@ -697,6 +757,58 @@ void obs_encoder_set_scaled_size(obs_encoder_t *encoder, uint32_t width,
 	encoder->scaled_height = height;
 }
 
+static bool ladder_has_encoder(obs_encoder_t *parent, obs_encoder_t *encoder)
+{
+	obs_encoder_t *next;
+
+	parent = obs_encoder_get_ref(parent);
+
+	while (parent) {
+		if (parent == encoder) {
+			obs_encoder_release(parent);
+			return true;
+		}
+
+		next = obs_weak_encoder_get_encoder(parent->ladder_parent);
+		obs_encoder_release(parent);
+		parent = next;
+	}
+
+	return false;
+}
+
+void obs_encoder_set_ladder_parent(obs_encoder_t *encoder,
+				   obs_encoder_t *parent)
+{
+	if (!obs_encoder_valid(encoder, "obs_encoder_set_ladder_parent"))
+		return;
+	if (encoder->info.type != OBS_ENCODER_VIDEO ||
+	    (parent && parent->info.type != OBS_ENCODER_VIDEO)) {
+		blog(LOG_WARNING, "obs_encoder_set_ladder_parent: "
+				  "encoders must be video encoders");
+		return;
+	}
+	if (encoder_active(encoder)) {
+		blog(LOG_WARNING,
+		     "encoder '%s': Cannot set the ladder parent "
+		     "while the encoder is active",
+		     obs_encoder_get_name(encoder));
+		return;
+	}
+	if (parent && ladder_has_encoder(parent, encoder)) {
+		blog(LOG_WARNING,
+		     "encoder '%s': Cannot set '%s' as the ladder parent, "
+		     "it would create a loop",
+		     obs_encoder_get_name(encoder),
+		     obs_encoder_get_name(parent));
+		return;
+	}
+
+	obs_weak_encoder_release(encoder->ladder_parent);
+	encoder->ladder_parent =
+		parent ? obs_encoder_get_weak_encoder(parent) : NULL;
+}
+
 bool obs_encoder_scaling_enabled(const obs_encoder_t *encoder)
 {
 	if (!obs_encoder_valid(encoder, "obs_encoder_scaling_enabled"))
@@ -918,12 +1030,22 @@ void full_stop(struct obs_encoder *encoder)
 	}
 }
 
+static inline void release_handoff_data(struct obs_encoder *encoder)
+{
+	if (encoder->handoff_data) {
+		struct encoder_packet pkt = {.data = encoder->handoff_data};
+		obs_encoder_packet_release(&pkt);
+		encoder->handoff_data = NULL;
+	}
+}
+
 void send_off_encoder_packet(obs_encoder_t *encoder, bool success,
 			     bool received, struct encoder_packet *pkt)
 {
 	if (!success) {
 		blog(LOG_ERROR, "Error encoding with encoder '%s'",
 		     encoder->context.name);
+		release_handoff_data(encoder);
 		full_stop(encoder);
 		return;
 	}
@@ -954,6 +1076,8 @@ void send_off_encoder_packet(obs_encoder_t *encoder, bool success,
 
 		pthread_mutex_unlock(&encoder->callbacks_mutex);
 	}
+
+	release_handoff_data(encoder);
 }
 
 static const char *do_encode_name = "do_encode";
@@ -966,6 +1090,7 @@ bool do_encode(struct obs_encoder *encoder, struct encoder_frame *frame)
 					   "encode(%s)", encoder->context.name);
 
 	struct encoder_packet pkt = {0};
+	const char *prev_tag;
 	bool received = false;
 	bool success;
 
@@ -974,8 +1099,10 @@ bool do_encode(struct obs_encoder *encoder, struct encoder_frame *frame)
 	pkt.encoder = encoder;
 
 	profile_start(encoder->profile_encoder_encode_name);
+	prev_tag = bmem_set_tag(encoder->info.id);
 	success = encoder->info.encode(encoder->context.data, frame, &pkt,
 				       &received);
+	bmem_set_tag(prev_tag);
 	profile_end(encoder->profile_encoder_encode_name);
 	send_off_encoder_packet(encoder, success, received, &pkt);
 
@@ -1014,6 +1141,25 @@ bool video_pause_check(struct pause_data *pause, uint64_t timestamp)
 	return ignore_frame;
 }
 
+/* renditions of a ladder start on the same frame as their parent so that
+ * their timestamps and (given the same keyframe interval) keyframes line up */
+static bool ladder_start_check(struct obs_encoder *encoder, uint64_t ts)
+{
+	uint64_t parent_start_ts = encoder->active_ladder_parent->start_ts;
+
+	if (!parent_start_ts || ts < parent_start_ts)
+		return false;
+
+	if (ts > parent_start_ts)
+		blog(LOG_WARNING,
+		     "encoder '%s': Started %" PRIu64 " ms after its ladder "
+		     "parent '%s', keyframes will not be aligned",
+		     encoder->context.name, (ts - parent_start_ts) / 1000000,
+		     encoder->active_ladder_parent->context.name);
+
+	return true;
+}
+
 static const char *receive_video_name = "receive_video";
 static void receive_video(void *param, struct video_data *frame)
 {
@@ -1030,6 +1176,11 @@ static void receive_video(void *param, struct video_data *frame)
 		}
 	}
 
+	if (!encoder->start_ts && encoder->active_ladder_parent) {
+		if (!ladder_start_check(encoder, frame->timestamp))
+			goto wait_for_audio;
+	}
+
 	if (video_pause_check(&encoder->pause, frame->timestamp))
 		goto wait_for_audio;
 
@@ -1308,15 +1459,271 @@ void obs_encoder_remove_output(struct obs_encoder *encoder,
 	pthread_mutex_unlock(&encoder->outputs_mutex);
 }
 
+/* ------------------------------------------------------------------------- */
+/* packet pool */
+
+/* Packet payloads are allocated from size classes owned by the encoder that
+ * produced them.  Released blocks go back on the free list of their class
+ * instead of being freed, so steady-state encoding (and fan-out to several
+ * outputs) does not hit the allocator for every packet.
+ *
+ * Each power of two is split into quarter steps (512, 640, 768, 896, 1024,
+ * ...), which keeps the memory wasted by rounding up to at most 20% of a
+ * block (rounding up to the next power of two could waste almost half).  This
+ * matters for long-lived packets such as the ones held by the replay buffer,
+ * which only counts the packet size against its limit. */
+
+#define PACKET_POOL_MIN_SHIFT 9  /* 512 bytes */
+#define PACKET_POOL_MAX_SHIFT 23 /* 8 megabytes */
+#define PACKET_POOL_STEPS 4      /* size classes per power of two */
+#define PACKET_POOL_OCTAVES (PACKET_POOL_MAX_SHIFT - PACKET_POOL_MIN_SHIFT)
+#define PACKET_POOL_CLASSES (PACKET_POOL_OCTAVES * PACKET_POOL_STEPS + 1)
+#define PACKET_POOL_CLASS_CACHE_SIZE (8 * 1024 * 1024)
+#define PACKET_POOL_CLASS_MIN_CACHED 4
+#define PACKET_POOL_MAX_CACHED (32 * 1024 * 1024)
+
+struct packet_header {
+	struct encoder_packet_pool *pool;
+	struct packet_header *next;
+	int size_class;
+	volatile long refs;
+};
+
+struct packet_pool_class {
+	pthread_mutex_t mutex;
+	struct packet_header *free_list;
+	size_t num_free;
+	size_t max_free;
+};
+
+struct encoder_packet_pool {
+	volatile long refs;
+	volatile long allocs;
+	volatile long hits;
+	volatile long handoffs;
+	volatile long cached_bytes;
+	struct packet_pool_class classes[PACKET_POOL_CLASSES];
+};
+
+static inline size_t packet_pool_class_size(int size_class)
+{
+	int shift = size_class / PACKET_POOL_STEPS + PACKET_POOL_MIN_SHIFT;
+	int step = size_class % PACKET_POOL_STEPS;
+	size_t base = (size_t)1 << shift;
+
+	return base + base / PACKET_POOL_STEPS * step;
+}
+
+static inline int packet_pool_get_class(size_t size)
+{
+	size_t base = (size_t)1 << PACKET_POOL_MIN_SHIFT;
+	size_t step_size;
+	int octave = 0;
+
+	if (size <= base)
+		return 0;
+	if (size > packet_pool_class_size(PACKET_POOL_CLASSES - 1))
+		return -1;
+
+	while ((base << 1) < size) {
+		base <<= 1;
+		octave++;
+	}
+
+	/* base < size <= base * 2, round up to the next step */
+	step_size = base / PACKET_POOL_STEPS;
+	return octave * PACKET_POOL_STEPS +
+	       (int)((size - base + step_size - 1) / step_size);
+}
+
+/* total bytes cached by the pool are capped across all classes.  returns
+ * false if adding delta would exceed the cap */
+static bool packet_pool_adjust_cached(struct encoder_packet_pool *pool,
+				      long delta)
+{
+	long cur;
+
+	do {
+		cur = os_atomic_load_long(&pool->cached_bytes);
+		if (delta > 0 && cur + delta > PACKET_POOL_MAX_CACHED)
+			return false;
+	} while (!os_atomic_compare_swap_long(&pool->cached_bytes, cur,
+					      cur + delta));
+
+	return true;
+}
+
+struct encoder_packet_pool *encoder_packet_pool_create(void)
+{
+	struct encoder_packet_pool *pool = bzalloc(sizeof(*pool));
+	pool->refs = 1;
+
+	for (int i = 0; i < PACKET_POOL_CLASSES; i++) {
+		struct packet_pool_class *pc = &pool->classes[i];
+		size_t max = PACKET_POOL_CLASS_CACHE_SIZE /
+			     packet_pool_class_size(i);
+
+		pthread_mutex_init_value(&pc->mutex);
+		pthread_mutex_init(&pc->mutex, NULL);
+		pc->max_free = max > PACKET_POOL_CLASS_MIN_CACHED
+				       ? max
+				       : PACKET_POOL_CLASS_MIN_CACHED;
+	}
+
+	return pool;
+}
+
+void encoder_packet_pool_release(struct encoder_packet_pool *pool)
+{
+	if (!pool || os_atomic_dec_long(&pool->refs) != 0)
+		return;
+
+	for (int i = 0; i < PACKET_POOL_CLASSES; i++) {
+		struct packet_pool_class *pc = &pool->classes[i];
+		struct packet_header *block = pc->free_list;
+
+		while (block) {
+			struct packet_header *next = block->next;
+			bfree(block);
+			block = next;
+		}
+
+		pthread_mutex_destroy(&pc->mutex);
+	}
+
+	bfree(pool);
+}
+
+static uint8_t *packet_pool_alloc(struct encoder_packet_pool *pool, size_t size)
+{
+	struct packet_header *block = NULL;
+	int size_class = pool ? packet_pool_get_class(size) : -1;
+
+	if (size_class != -1) {
+		struct packet_pool_class *pc = &pool->classes[size_class];
+
+		pthread_mutex_lock(&pc->mutex);
+		block = pc->free_list;
+		if (block) {
+			pc->free_list = block->next;
+			pc->num_free--;
+		}
+		pthread_mutex_unlock(&pc->mutex);
+
+		os_atomic_inc_long(&pool->refs);
+		os_atomic_inc_long(&pool->allocs);
+
+		if (block) {
+			long size = (long)packet_pool_class_size(size_class);
+			packet_pool_adjust_cached(pool, -size);
+			os_atomic_inc_long(&pool->hits);
+		} else
+			block = bmalloc(sizeof(*block) +
+					packet_pool_class_size(size_class));
+	} else {
+		block = bmalloc(sizeof(*block) + size);
+		pool = NULL;
+	}
+
+	block->pool = pool;
+	block->next = NULL;
+	block->size_class = size_class;
+	block->refs = 1;
+	return (uint8_t *)(block + 1);
+}
+
+static void packet_pool_free(struct packet_header *block)
+{
+	struct encoder_packet_pool *pool = block->pool;
+	struct packet_pool_class *pc;
+	bool cached = false;
+
+	if (!pool) {
+		bfree(block);
+		return;
+	}
+
+	pc = &pool->classes[block->size_class];
+
+	pthread_mutex_lock(&pc->mutex);
+	if (pc->num_free < pc->max_free &&
+	    packet_pool_adjust_cached(
+		    pool, (long)packet_pool_class_size(block->size_class))) {
+		block->next = pc->free_list;
+		pc->free_list = block;
+		pc->num_free++;
+		cached = true;
+	}
+	pthread_mutex_unlock(&pc->mutex);
+
+	if (!cached)
+		bfree(block);
+
+	encoder_packet_pool_release(pool);
+}
+
+/* packet data built outside of an encoder still needs a header in front of
+ * it so that obs_encoder_packet_ref/release work on it */
+uint8_t *encoder_packet_alloc_unpooled(size_t size)
+{
+	return packet_pool_alloc(NULL, size);
+}
+
+static inline struct packet_header *get_packet_header(uint8_t *data)
+{
+	return ((struct packet_header *)data) - 1;
+}
+
+uint8_t *obs_encoder_packet_alloc(obs_encoder_t *encoder, size_t size)
+{
+	if (!obs_encoder_valid(encoder, "obs_encoder_packet_alloc"))
+		return NULL;
+
+	if (encoder->handoff_data)
+		packet_pool_free(get_packet_header(encoder->handoff_data));
+
+	encoder->handoff_data = packet_pool_alloc(encoder->packet_pool, size);
+	return encoder->handoff_data;
+}
+
+bool obs_encoder_get_packet_pool_stats(
+	const obs_encoder_t *encoder,
+	struct obs_encoder_packet_pool_stats *stats)
+{
+	struct encoder_packet_pool *pool;
+
+	if (!obs_encoder_valid(encoder, "obs_encoder_get_packet_pool_stats"))
+		return false;
+	if (!obs_ptr_valid(stats, "obs_encoder_get_packet_pool_stats"))
+		return false;
+
+	pool = encoder->packet_pool;
+	stats->allocs = (uint64_t)os_atomic_load_long(&pool->allocs);
+	stats->hits = (uint64_t)os_atomic_load_long(&pool->hits);
+	stats->handoffs = (uint64_t)os_atomic_load_long(&pool->handoffs);
+	stats->cached_bytes =
+		(size_t)os_atomic_load_long(&pool->cached_bytes);
+	return true;
+}
+
 void obs_encoder_packet_create_instance(struct encoder_packet *dst,
 					const struct encoder_packet *src)
 {
-	long *p_refs;
+	struct obs_encoder *encoder = src->encoder;
+
+	/* the encoder wrote this packet directly into pooled memory, so it
+	 * only needs another reference rather than a copy */
+	if (encoder && src->data && src->data == encoder->handoff_data) {
+		long *p_refs = (long *)&get_packet_header(src->data)->refs;
+		os_atomic_inc_long(p_refs);
+		os_atomic_inc_long(&encoder->packet_pool->handoffs);
+		*dst = *src;
+		return;
+	}
 
 	*dst = *src;
-	p_refs = bmalloc(src->size + sizeof(long));
-	dst->data = (void *)(p_refs + 1);
-	*p_refs = 1;
+	dst->data = packet_pool_alloc(encoder ? encoder->packet_pool : NULL,
+				      src->size);
 	memcpy(dst->data, src->data, src->size);
 }
 
@@ -1340,8 +1747,8 @@ void obs_encoder_packet_ref(struct encoder_packet *dst,
 		return;
 
 	if (src->data) {
-		long *p_refs = ((long *)src->data) - 1;
-		os_atomic_inc_long(p_refs);
+		struct packet_header *block = get_packet_header(src->data);
+		os_atomic_inc_long(&block->refs);
 	}
 
 	*dst = *src;
@@ -1353,9 +1760,9 @@ void obs_encoder_packet_release(struct encoder_packet *pkt)
 		return;
 
 	if (pkt->data) {
-		long *p_refs = ((long *)pkt->data) - 1;
-		if (os_atomic_dec_long(p_refs) == 0)
-			bfree(p_refs);
+		struct packet_header *block = get_packet_header(pkt->data);
+		if (os_atomic_dec_long(&block->refs) == 0)
+			packet_pool_free(block);
 	}
 
 	memset(pkt, 0, sizeof(struct encoder_packet));
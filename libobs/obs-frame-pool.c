@@ -0,0 +1,258 @@
+/******************************************************************************
+    Copyright (C) 2013 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <inttypes.h>
+#include "obs-internal.h"
+
+/*
+ * Async frames that sources no longer need (resolution changes, cache
+ * overflow, frames that have gone unused, destroyed sources) are returned to
+ * a global pool instead of being freed, and are handed back out to any
+ * source that needs a frame of the same format and size.  Idle frames are
+ * freed when they exceed the budget (oldest first) or after they have been
+ * idle for a while.
+ */
+
+#define DEFAULT_BUDGET (256ULL * 1024ULL * 1024ULL)
+#define MAX_IDLE_TIME 10000000000ULL
+#define TRIM_INTERVAL 1000000000ULL
+
+static size_t get_frame_size(const struct obs_source_frame *frame)
+{
+	uint32_t height = frame->height;
+	uint32_t half_height = (height + 1) / 2;
+
+	switch (frame->format) {
+	case VIDEO_FORMAT_NONE:
+		return 0;
+
+	case VIDEO_FORMAT_I420:
+		return frame->linesize[0] * height +
+		       frame->linesize[1] * half_height +
+		       frame->linesize[2] * half_height;
+
+	case VIDEO_FORMAT_I40A:
+		return (frame->linesize[0] + frame->linesize[3]) * height +
+		       frame->linesize[1] * half_height +
+		       frame->linesize[2] * half_height;
+
+	case VIDEO_FORMAT_NV12:
+		return frame->linesize[0] * height +
+		       frame->linesize[1] * half_height;
+
+	default:;
+	}
+
+	size_t size = 0;
+	for (size_t i = 0; i < MAX_AV_PLANES; i++)
+		size += frame->linesize[i] * height;
+	return size;
+}
+
+static inline bool frame_matches(const struct obs_source_frame *frame,
+				 enum video_format format, uint32_t width,
+				 uint32_t height)
+{
+	return frame->format == format && frame->width == width &&
+	       frame->height == height;
+}
+
+static inline void evict_frame(struct obs_frame_pool *pool, size_t idx)
+{
+	struct pooled_frame *pf = &pool->frames.array[idx];
+
+	pool->idle_bytes -= pf->size;
+	obs_source_frame_destroy(pf->frame);
+	da_erase(pool->frames, idx);
+}
+
+static void enforce_budget(struct obs_frame_pool *pool)
+{
+	while (pool->frames.num && pool->idle_bytes > pool->budget) {
+		evict_frame(pool, 0);
+		pool->evictions++;
+	}
+}
+
+bool obs_frame_pool_init(struct obs_frame_pool *pool)
+{
+	memset(pool, 0, sizeof(*pool));
+	pool->budget = DEFAULT_BUDGET;
+
+	if (pthread_mutex_init(&pool->mutex, NULL) != 0)
+		return false;
+
+	pool->initialized = true;
+	return true;
+}
+
+void obs_frame_pool_free(struct obs_frame_pool *pool)
+{
+	if (!pool->initialized)
+		return;
+
+	blog(LOG_INFO,
+	     "Async frame pool: %" PRIu64 " reused, %" PRIu64 " allocated, "
+	     "%" PRIu64 " evicted",
+	     pool->hits, pool->misses, pool->evictions);
+
+	pool->initialized = false;
+
+	for (size_t i = 0; i < pool->frames.num; i++)
+		obs_source_frame_destroy(pool->frames.array[i].frame);
+	da_free(pool->frames);
+
+	pthread_mutex_destroy(&pool->mutex);
+}
+
+struct obs_source_frame *obs_frame_pool_get(struct obs_frame_pool *pool,
+					    enum video_format format,
+					    uint32_t width, uint32_t height)
+{
+	struct obs_source_frame *frame = NULL;
+	const char *prev_tag;
+
+	if (pool->initialized) {
+		pthread_mutex_lock(&pool->mutex);
+
+		/* most recently returned first, it's most likely to still be
+		 * in cache */
+		for (size_t i = pool->frames.num; i > 0; i--) {
+			struct pooled_frame *pf = &pool->frames.array[i - 1];
+
+			if (frame_matches(pf->frame, format, width, height)) {
+				frame = pf->frame;
+				pool->idle_bytes -= pf->size;
+				da_erase(pool->frames, i - 1);
+				break;
+			}
+		}
+
+		if (frame)
+			pool->hits++;
+		else
+			pool->misses++;
+
+		pthread_mutex_unlock(&pool->mutex);
+	}
+
+	if (frame) {
+		frame->prev_frame = false;
+		frame->refs = 0;
+		return frame;
+	}
+
+	prev_tag = bmem_set_tag("async frame pool");
+	frame = obs_source_frame_create(format, width, height);
+	bmem_set_tag(prev_tag);
+	return frame;
+}
+
+void obs_frame_pool_put(struct obs_frame_pool *pool,
+			struct obs_source_frame *frame)
+{
+	struct pooled_frame pf;
+
+	if (!frame)
+		return;
+
+	if (!pool->initialized || frame->format == VIDEO_FORMAT_NONE) {
+		obs_source_frame_destroy(frame);
+		return;
+	}
+
+	pf.frame = frame;
+	pf.size = get_frame_size(frame);
+	pf.idle_since = os_gettime_ns();
+
+	pthread_mutex_lock(&pool->mutex);
+
+	if (pf.size > pool->budget) {
+		obs_source_frame_destroy(frame);
+		pool->evictions++;
+	} else {
+		da_push_back(pool->frames, &pf);
+		pool->idle_bytes += pf.size;
+		enforce_budget(pool);
+	}
+
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+void obs_frame_pool_trim(struct obs_frame_pool *pool, uint64_t cur_time)
+{
+	if (!pool->initialized || cur_time - pool->last_trim < TRIM_INTERVAL)
+		return;
+
+	pool->last_trim = cur_time;
+
+	pthread_mutex_lock(&pool->mutex);
+
+	/* frames are kept in the order they were returned */
+	while (pool->frames.num &&
+	       cur_time - pool->frames.array[0].idle_since > MAX_IDLE_TIME) {
+		evict_frame(pool, 0);
+		pool->evictions++;
+	}
+
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void obs_set_frame_pool_budget(uint64_t bytes)
+{
+	struct obs_frame_pool *pool;
+
+	if (!obs)
+		return;
+
+	pool = &obs->data.frame_pool;
+	if (!pool->initialized)
+		return;
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->budget = (size_t)bytes;
+	enforce_budget(pool);
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+void obs_get_frame_pool_stats(struct obs_frame_pool_stats *stats)
+{
+	struct obs_frame_pool *pool;
+
+	if (!stats)
+		return;
+
+	memset(stats, 0, sizeof(*stats));
+
+	if (!obs)
+		return;
+
+	pool = &obs->data.frame_pool;
+	if (!pool->initialized)
+		return;
+
+	pthread_mutex_lock(&pool->mutex);
+	stats->budget = pool->budget;
+	stats->idle_bytes = pool->idle_bytes;
+	stats->idle_frames = (uint32_t)pool->frames.num;
+	stats->reused = pool->hits;
+	stats->allocated = pool->misses;
+	stats->evicted = pool->evictions;
+	pthread_mutex_unlock(&pool->mutex);
+}
@@ -680,6 +680,21 @@ static inline void load_bindings(obs_hotkey_t *hotkey, obs_data_array_t *data)
 
 static inline void remove_bindings(obs_hotkey_id id);
 
+/* source hotkeys are saved with the source */
+static inline void mark_registerer_dirty(obs_hotkey_t *hotkey)
+{
+	obs_source_t *source;
+
+	if (hotkey->registerer_type != OBS_HOTKEY_REGISTERER_SOURCE)
+		return;
+
+	source = obs_weak_source_get_source(hotkey->registerer);
+	if (source) {
+		obs_source_mark_dirty(source);
+		obs_source_release(source);
+	}
+}
+
 void obs_hotkey_load_bindings(obs_hotkey_id id,
 			      obs_key_combination_t *combinations, size_t num)
 {
@@ -694,6 +709,7 @@ void obs_hotkey_load_bindings(obs_hotkey_id id,
 		for (size_t i = 0; i < num; i++)
 			create_binding(hotkey, combinations[i]);
 
+		mark_registerer_dirty(hotkey);
 		hotkey_signal("hotkey_bindings_changed", hotkey);
 	}
 	unlock();
@@ -36,7 +36,9 @@
 
 #include "obs.h"
 
-#define NUM_TEXTURES 2
+/* maximum number of frames that can be waiting to be read back from the GPU */
+#define NUM_TEXTURES 4
+#define DEFAULT_READBACK_DEPTH 2
 #define NUM_CHANNELS 3
 #define MICROSECOND_DEN 1000000
 #define NUM_ENCODE_TEXTURES 3
@@ -201,6 +203,12 @@ extern void obs_view_free(struct obs_view *view);
 struct obs_display {
 	bool size_changed;
 	bool enabled;
+	bool visible;
+	bool redraw_on_demand;
+	volatile bool redraw_requested;
+	uint32_t max_fps;
+	uint64_t next_render_ts;
+	const char *profile_name;
 	uint32_t cx, cy;
 	uint32_t background_color;
 	gs_swapchain_t *swap;
@@ -265,6 +273,11 @@ struct obs_core_video {
 	gs_samplerstate_t *point_sampler;
 	gs_stagesurf_t *mapped_surfaces[NUM_CHANNELS];
 	int cur_texture;
+	uint32_t readback_depth;
+	uint32_t requested_readback_depth;
+	volatile long readback_frames;
+	volatile long readback_deferred;
+	volatile long readback_stalls;
 	long raw_active;
 	long gpu_encoder_active;
 	pthread_mutex_t gpu_encoder_mutex;
@@ -285,6 +298,20 @@ struct obs_core_video {
 	pthread_t video_thread;
 	uint32_t total_frames;
 	uint32_t lagged_frames;
+	uint32_t draw_calls;
+
+	/* graphics thread only */
+	uint64_t render_frame;
+	uint32_t filter_passes;
+	uint32_t last_filter_passes;
+
+	/* per-frame source render cache, graphics thread only */
+	uint32_t render_cache_hits;
+	uint32_t render_cache_renders;
+	uint32_t render_cache_last_hits;
+	uint32_t render_cache_last_renders;
+	uint64_t render_cache_total_hits;
+	uint64_t render_cache_total_renders;
 	bool thread_initialized;
 
 	bool gpu_conversion;
@@ -317,6 +344,7 @@ struct obs_core_video {
 };
 
 struct audio_monitor;
+struct monitoring_bus;
 
 struct obs_core_audio {
 	audio_t *audio;
@@ -335,6 +363,55 @@ struct obs_core_audio {
 	DARRAY(struct audio_monitor *) monitors;
 	char *monitoring_device_name;
 	char *monitoring_device_id;
+	struct monitoring_bus *monitoring_bus;
+	uint32_t monitoring_latency_ms;
+};
+
+/* ------------------------------------------------------------------------- */
+/* async frame pool */
+
+struct pooled_frame {
+	struct obs_source_frame *frame;
+	size_t size;
+	uint64_t idle_since;
+};
+
+struct obs_frame_pool {
+	pthread_mutex_t mutex;
+
+	/* idle frames, in the order they were returned */
+	DARRAY(struct pooled_frame) frames;
+	size_t idle_bytes;
+	size_t budget;
+	uint64_t last_trim;
+
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+
+	bool initialized;
+};
+
+extern bool obs_frame_pool_init(struct obs_frame_pool *pool);
+extern void obs_frame_pool_free(struct obs_frame_pool *pool);
+extern struct obs_source_frame *obs_frame_pool_get(struct obs_frame_pool *pool,
+						   enum video_format format,
+						   uint32_t width,
+						   uint32_t height);
+extern void obs_frame_pool_put(struct obs_frame_pool *pool,
+			       struct obs_source_frame *frame);
+extern void obs_frame_pool_trim(struct obs_frame_pool *pool, uint64_t cur_time);
+
+/* name -> context lookup of the non-private sources, outputs, encoders or
+ * services, so that lookups by name neither walk the whole list nor
+ * serialize on the list's mutex */
+struct obs_context_index {
+	pthread_rwlock_t rwlock;
+	struct obs_context_data **buckets;
+	size_t num_buckets;
+	size_t num;
+	uint64_t next_order;
+	bool initialized;
 };
 
 /* user sources, output channels, and displays */
@@ -353,13 +430,28 @@ struct obs_core_data {
 	pthread_mutex_t services_mutex;
 	pthread_mutex_t audio_sources_mutex;
 	pthread_mutex_t draw_callbacks_mutex;
+	struct obs_context_index sources_index;
+	struct obs_context_index outputs_index;
+	struct obs_context_index encoders_index;
+	struct obs_context_index services_index;
 	DARRAY(struct draw_callback) draw_callbacks;
 	DARRAY(struct tick_callback) tick_callbacks;
 
+	/* sources that need obs_source_video_tick this frame; idle sources
+	 * are dropped from the list and re-added when they change state */
+	pthread_mutex_t tick_sources_mutex;
+	DARRAY(struct obs_source *) tick_sources;
+	DARRAY(struct obs_source *) tick_sources_cur;
+
 	struct obs_view main_view;
 
 	long long unnamed_index;
 
+	/* source save serials are taken from this so that they never repeat */
+	volatile long save_serial;
+
+	struct obs_frame_pool frame_pool;
+
 	obs_data_t *private_data;
 
 	volatile bool valid;
@@ -446,6 +538,11 @@ extern void
 start_raw_video(video_t *video, const struct video_scale_info *conversion,
 		void (*callback)(void *param, struct video_data *frame),
 		void *param);
+extern void start_raw_video_cascaded(
+	video_t *video, const struct video_scale_info *conversion,
+	void (*parent_callback)(void *param, struct video_data *frame),
+	void *parent_param,
+	void (*callback)(void *param, struct video_data *frame), void *param);
 extern void stop_raw_video(video_t *video,
 			   void (*callback)(void *param,
 					    struct video_data *frame),
@@ -473,6 +570,12 @@ struct obs_context_data {
 	struct obs_context_data *next;
 	struct obs_context_data **prev_next;
 
+	/* name index, write locked to change name */
+	struct obs_context_index *index;
+	struct obs_context_data *index_next;
+	uint64_t index_order;
+	uint32_t name_hash;
+
 	bool private;
 };
 
@@ -535,6 +638,7 @@ static inline bool obs_weak_ref_get_ref(struct obs_weak_ref *ref)
 
 struct async_frame {
 	struct obs_source_frame *frame;
+	uint64_t received_time;
 	long unused_count;
 	bool used;
 };
@@ -565,6 +669,8 @@ struct audio_cb_info {
 	void *param;
 };
 
+struct async_convert;
+
 struct obs_source {
 	struct obs_context_data context;
 	struct obs_source_info info;
@@ -581,6 +687,9 @@ struct obs_source {
 	/* signals to call the source update in the video thread */
 	bool defer_update;
 
+	/* whether the source is in the tick list (tick_sources_mutex) */
+	bool in_tick_list;
+
 	/* ensures show/hide are only called once */
 	volatile long show_refs;
 
@@ -644,6 +753,8 @@ struct obs_source {
 	gs_texture_t *async_textures[MAX_AV_PLANES];
 	gs_texrender_t *async_texrender;
 	struct obs_source_frame *cur_async_frame;
+	const struct async_convert *async_convert;
+	gs_technique_t *async_convert_tech;
 	bool async_gpu_conversion;
 	enum video_format async_format;
 	bool async_full_range;
@@ -661,6 +772,15 @@ struct obs_source {
 	DARRAY(struct async_frame) async_cache;
 	DARRAY(struct obs_source_frame *) async_frames;
 	pthread_mutex_t async_mutex;
+	enum obs_async_frame_policy async_policy;
+	uint64_t async_target_latency;
+
+	/* async frame stats, protected by async_mutex */
+	uint64_t async_frames_received;
+	uint64_t async_frames_rendered;
+	uint64_t async_frames_dropped;
+	uint64_t async_frames_duplicated;
+	uint64_t async_total_age;
 	uint32_t async_width;
 	uint32_t async_height;
 	uint32_t async_cache_width;
@@ -688,6 +808,27 @@ struct obs_source {
 	gs_texrender_t *filter_texrender;
 	enum obs_allow_direct_render allow_direct;
 	bool rendering_filter;
+	uint64_t filter_pass_frame;
+	uint32_t filter_passes;
+	uint32_t last_filter_passes;
+
+	/* fused filter stages, graphics thread only */
+	DARRAY(obs_source_t *) fused_stages;
+	DARRAY(const char *) fused_code;
+	gs_effect_t *fused_effect;
+	gs_effect_t *fused_params_effect;
+	size_t fused_stage_idx;
+
+	/* per-frame render cache */
+	bool render_cache;
+	bool render_cache_rendering;
+	uint64_t render_cache_frame;
+	gs_texrender_t *render_cache_texrender;
+
+	/* cached properties (OBS_SOURCE_CACHE_PROPERTIES) */
+	pthread_mutex_t props_mutex;
+	obs_properties_t *props_cache;
+	char *props_settings;
 
 	/* sources specific hotkeys */
 	obs_hotkey_pair_id mute_unmute_key;
@@ -733,6 +874,10 @@ struct obs_source {
 	enum obs_monitoring_type monitoring_type;
 
 	obs_data_t *private_settings;
+
+	/* changes whenever something stored by obs_save_source changes */
+	volatile long save_serial;
+	volatile long settings_change_serial;
 };
 
 extern struct obs_source_info *get_source_info(const char *id);
@@ -754,6 +899,8 @@ extern void obs_transition_load(obs_source_t *source, obs_data_t *data);
 struct audio_monitor *audio_monitor_create(obs_source_t *source);
 void audio_monitor_reset(struct audio_monitor *monitor);
 extern void audio_monitor_destroy(struct audio_monitor *monitor);
+extern void audio_monitoring_bus_reset(void);
+extern uint64_t audio_monitoring_bus_get_latency(void);
 
 extern obs_source_t *obs_source_create_set_last_ver(const char *id,
 						    const char *name,
@@ -761,6 +908,14 @@ extern obs_source_t *obs_source_create_set_last_ver(const char *id,
 						    obs_data_t *hotkey_data,
 						    uint32_t last_obs_ver);
 extern void obs_source_destroy(struct obs_source *source);
+extern void obs_source_mark_dirty(obs_source_t *source);
+
+/* in obs-scene.c */
+extern long obs_scene_get_items_change_serial(obs_source_t *source);
+
+/* in obs-properties.c */
+extern void obs_properties_addref(obs_properties_t *props);
+extern obs_properties_t *obs_properties_duplicate(obs_properties_t *props);
 
 enum view_type {
 	MAIN_VIEW,
@@ -814,6 +969,9 @@ convert_video_format(enum video_format format)
 extern void obs_source_activate(obs_source_t *source, enum view_type type);
 extern void obs_source_deactivate(obs_source_t *source, enum view_type type);
 extern void obs_source_video_tick(obs_source_t *source, float seconds);
+extern void obs_source_tick_list_add(obs_source_t *source);
+extern void obs_source_tick_list_remove(obs_source_t *source);
+extern bool obs_source_needs_tick(obs_source_t *source);
 extern float obs_source_get_target_volume(obs_source_t *source,
 					  obs_source_t *target);
 
@@ -1062,6 +1220,11 @@ struct obs_encoder {
 	uint64_t first_raw_ts;
 	uint64_t start_ts;
 
+	/* encoding ladder: the next larger rendition this encoder is scaled
+	 * from, and the reference to it held while this encoder is active */
+	struct obs_weak_encoder *ladder_parent;
+	struct obs_encoder *active_ladder_parent;
+
 	pthread_mutex_t outputs_mutex;
 	DARRAY(obs_output_t *) outputs;
 
@@ -1077,10 +1240,19 @@ struct obs_encoder {
 
 	const char *profile_encoder_encode_name;
 	char *last_error_message;
+
+	/* packet payload allocator, and the pooled buffer the encoder is
+	 * currently writing into (if it uses obs_encoder_packet_alloc) */
+	struct encoder_packet_pool *packet_pool;
+	uint8_t *handoff_data;
 };
 
 extern struct obs_encoder_info *find_encoder(const char *id);
 
+extern struct encoder_packet_pool *encoder_packet_pool_create(void);
+extern void encoder_packet_pool_release(struct encoder_packet_pool *pool);
+extern uint8_t *encoder_packet_alloc_unpooled(size_t size);
+
 extern bool obs_encoder_initialize(obs_encoder_t *encoder);
 extern void obs_encoder_shutdown(obs_encoder_t *encoder);
 
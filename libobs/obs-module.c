@@ -142,7 +142,9 @@ bool obs_init_module(obs_module_t *module)
 				   "obs_init_module(%s)", module->file);
 	profile_start(profile_name);
 
+	const char *prev_tag = bmem_set_tag(module->mod_name);
 	module->loaded = module->load();
+	bmem_set_tag(prev_tag);
 	if (!module->loaded)
 		blog(LOG_WARNING, "Failed to initialize module '%s'",
 		     module->file);
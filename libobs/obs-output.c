@@ -152,9 +152,12 @@ obs_output_t *obs_output_create(const char *id, const char *name,
 	obs_context_data_insert(&output->context, &obs->data.outputs_mutex,
 				&obs->data.first_output);
 
-	if (info)
+	if (info) {
+		const char *prev_tag = bmem_set_tag(info->id);
 		output->context.data =
 			info->create(output->context.settings, output);
+		bmem_set_tag(prev_tag);
+	}
 	if (!output->context.data)
 		blog(LOG_ERROR, "Failed to create output '%s'!", name);
 
@@ -252,8 +255,11 @@ bool obs_output_actual_start(obs_output_t *output)
 		output->last_error_message = NULL;
 	}
 
-	if (output->context.data)
+	if (output->context.data) {
+		const char *prev_tag = bmem_set_tag(output->info.id);
 		success = output->info.start(output->context.data);
+		bmem_set_tag(prev_tag);
+	}
 
 	if (success && output->video) {
 		output->starting_frame_count =
@@ -1212,20 +1218,14 @@ static bool add_caption(struct obs_output *output, struct encoder_packet *out)
 	caption_frame_t cf;
 	sei_t sei;
 	uint8_t *data;
+	uint8_t *out_data;
 	size_t size;
-	long ref = 1;
-
-	DARRAY(uint8_t) out_data;
 
 	if (out->priority > 1)
 		return false;
 
 	sei_init(&sei, 0.0);
 
-	da_init(out_data);
-	da_push_back_array(out_data, &ref, sizeof(ref));
-	da_push_back_array(out_data, out->data, out->size);
-
 	caption_frame_init(&cf);
 	caption_frame_from_text(&cf, &output->caption_head->text[0]);
 
@@ -1233,16 +1233,19 @@ static bool add_caption(struct obs_output *output, struct encoder_packet *out)
 
 	data = malloc(sei_render_size(&sei));
 	size = sei_render(&sei, data);
+
 	/* TODO SEI should come after AUD/SPS/PPS, but before any VCL */
-	da_push_back_array(out_data, nal_start, 4);
-	da_push_back_array(out_data, data, size);
+	out_data = encoder_packet_alloc_unpooled(out->size + 4 + size);
+	memcpy(out_data, out->data, out->size);
+	memcpy(out_data + out->size, nal_start, 4);
+	memcpy(out_data + out->size + 4, data, size);
 	free(data);
 
 	obs_encoder_packet_release(out);
 
 	*out = backup;
-	out->data = (uint8_t *)out_data.array + sizeof(ref);
-	out->size = out_data.num - sizeof(ref);
+	out->data = out_data;
+	out->size += 4 + size;
 
 	sei_free(&sei);
 
@@ -1256,6 +1259,7 @@ static bool add_caption(struct obs_output *output, struct encoder_packet *out)
 static inline void send_interleaved(struct obs_output *output)
 {
 	struct encoder_packet out = output->interleaved_packets.array[0];
+	const char *prev_tag;
 
 	/* do not send an interleaved packet if there's no packet of the
 	 * opposing type of a higher timestamp in the interleave buffer.
@@ -1292,7 +1296,9 @@ static inline void send_interleaved(struct obs_output *output)
 #endif
 	}
 
+	prev_tag = bmem_set_tag(output->info.id);
 	output->info.encoded_packet(output->context.data, &out);
+	bmem_set_tag(prev_tag);
 	obs_encoder_packet_release(&out);
 }
 
@@ -1692,7 +1698,9 @@ static void default_encoded_callback(void *param, struct encoder_packet *packet)
 		if (packet->type == OBS_ENCODER_AUDIO)
 			packet->track_idx = get_track_index(output, packet);
 
+		const char *prev_tag = bmem_set_tag(output->info.id);
 		output->info.encoded_packet(output->context.data, packet);
+		bmem_set_tag(prev_tag);
 
 		if (packet->type == OBS_ENCODER_VIDEO)
 			output->total_frames++;
@@ -1709,8 +1717,11 @@ static void default_raw_video_callback(void *param, struct video_data *frame)
 	if (video_pause_check(&output->pause, frame->timestamp))
 		return;
 
-	if (data_active(output))
+	if (data_active(output)) {
+		const char *prev_tag = bmem_set_tag(output->info.id);
 		output->info.raw_video(output->context.data, frame);
+		bmem_set_tag(prev_tag);
+	}
 	output->total_frames++;
 }
 
@@ -1800,11 +1811,13 @@ static void default_raw_audio_callback(void *param, size_t mix_idx,
 
 		output->total_audio_frames += AUDIO_OUTPUT_FRAMES;
 
+		const char *prev_tag = bmem_set_tag(output->info.id);
 		if (output->info.raw_audio2)
 			output->info.raw_audio2(output->context.data, mix_idx,
 						&out);
 		else
 			output->info.raw_audio(output->context.data, &out);
+		bmem_set_tag(prev_tag);
 	}
 }
 
@@ -21,6 +21,9 @@
 #include "obs-properties.h"
 
 static inline void *get_property_data(struct obs_property *prop);
+static inline size_t get_property_size(enum obs_property_type type);
+static inline void propertes_add(struct obs_properties *props,
+				 struct obs_property *p);
 
 /* ------------------------------------------------------------------------- */
 
@@ -185,6 +188,7 @@ struct obs_property {
 };
 
 struct obs_properties {
+	volatile long refs;
 	void *param;
 	void (*destroy)(void *param);
 	uint32_t flags;
@@ -192,12 +196,17 @@ struct obs_properties {
 	struct obs_property *first_property;
 	struct obs_property **last;
 	struct obs_property *parent;
+
+	/* duplicates share the param of the properties they were made from,
+	 * and keep them alive for as long as the param is in use */
+	struct obs_properties *origin;
 };
 
 obs_properties_t *obs_properties_create(void)
 {
 	struct obs_properties *props;
 	props = bzalloc(sizeof(struct obs_properties));
+	props->refs = 1;
 	props->last = &props->first_property;
 	return props;
 }
@@ -262,9 +271,15 @@ static void obs_property_destroy(struct obs_property *property)
 	bfree(property);
 }
 
+void obs_properties_addref(obs_properties_t *props)
+{
+	if (props)
+		os_atomic_inc_long(&props->refs);
+}
+
 void obs_properties_destroy(obs_properties_t *props)
 {
-	if (props) {
+	if (props && os_atomic_dec_long(&props->refs) == 0) {
 		struct obs_property *p = props->first_property;
 
 		if (props->destroy && props->param)
@@ -276,10 +291,120 @@ void obs_properties_destroy(obs_properties_t *props)
 			p = next;
 		}
 
+		obs_properties_destroy(props->origin);
 		bfree(props);
 	}
 }
 
+static inline char *bstrdup_or_null(const char *str)
+{
+	return str ? bstrdup(str) : NULL;
+}
+
+static void list_data_copy(struct list_data *dst, const struct list_data *src)
+{
+	da_init(dst->items);
+	da_copy(dst->items, src->items);
+
+	for (size_t i = 0; i < dst->items.num; i++) {
+		struct list_item *item = dst->items.array + i;
+		item->name = bstrdup_or_null(item->name);
+		if (dst->format == OBS_COMBO_FORMAT_STRING)
+			item->str = bstrdup_or_null(item->str);
+	}
+}
+
+static void frame_rate_data_copy(struct frame_rate_data *dst,
+				 const struct frame_rate_data *src)
+{
+	da_init(dst->extra_options);
+	da_init(dst->ranges);
+	da_copy(dst->extra_options, src->extra_options);
+	da_copy(dst->ranges, src->ranges);
+
+	for (size_t i = 0; i < dst->extra_options.num; i++) {
+		struct frame_rate_option *opt = &dst->extra_options.array[i];
+		opt->name = bstrdup_or_null(opt->name);
+		opt->description = bstrdup_or_null(opt->description);
+	}
+}
+
+static struct obs_property *obs_property_duplicate(struct obs_properties *props,
+						   struct obs_property *src)
+{
+	size_t data_size = get_property_size(src->type);
+	struct obs_property *p;
+	void *data;
+
+	p = bmalloc(sizeof(struct obs_property) + data_size);
+	memcpy(p, src, sizeof(struct obs_property) + data_size);
+	p->name = bstrdup_or_null(src->name);
+	p->desc = bstrdup_or_null(src->desc);
+	p->long_desc = bstrdup_or_null(src->long_desc);
+	p->parent = props;
+	p->next = NULL;
+
+	data = get_property_data(p);
+
+	if (p->type == OBS_PROPERTY_LIST) {
+		list_data_copy(data, get_property_data(src));
+
+	} else if (p->type == OBS_PROPERTY_PATH) {
+		struct path_data *path = data;
+		path->default_path = bstrdup_or_null(path->default_path);
+		if (path->type == OBS_PATH_FILE)
+			path->filter = bstrdup_or_null(path->filter);
+
+	} else if (p->type == OBS_PROPERTY_EDITABLE_LIST) {
+		struct editable_list_data *list = data;
+		list->filter = bstrdup_or_null(list->filter);
+		list->default_path = bstrdup_or_null(list->default_path);
+
+	} else if (p->type == OBS_PROPERTY_FRAME_RATE) {
+		frame_rate_data_copy(data, get_property_data(src));
+
+	} else if (p->type == OBS_PROPERTY_GROUP) {
+		struct group_data *group = data;
+		group->content = obs_properties_duplicate(group->content);
+		if (group->content)
+			group->content->parent = p;
+
+	} else if (p->type == OBS_PROPERTY_INT) {
+		struct int_data *num = data;
+		num->suffix = bstrdup_or_null(num->suffix);
+
+	} else if (p->type == OBS_PROPERTY_FLOAT) {
+		struct float_data *num = data;
+		num->suffix = bstrdup_or_null(num->suffix);
+	}
+
+	propertes_add(props, p);
+	return p;
+}
+
+obs_properties_t *obs_properties_duplicate(obs_properties_t *src)
+{
+	struct obs_properties *props;
+	struct obs_property *p;
+
+	if (!src)
+		return NULL;
+
+	props = obs_properties_create();
+	props->flags = src->flags;
+
+	if (src->param) {
+		props->param = src->param;
+		props->origin = src->origin ? src->origin : src;
+		obs_properties_addref(props->origin);
+	}
+
+	for (p = src->first_property; p; p = p->next)
+		obs_property_duplicate(props, p);
+
+	return props;
+}
+
 obs_property_t *obs_properties_first(obs_properties_t *props)
 {
 	return (props != NULL) ? props->first_property : NULL;
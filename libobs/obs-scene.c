@@ -225,6 +225,8 @@ static void scene_enum_all_sources(void *data,
 
 static inline void detach_sceneitem(struct obs_scene_item *item)
 {
+	obs_source_mark_dirty(item->parent->source);
+
 	if (item->prev)
 		item->prev->next = item->next;
 	else
@@ -243,6 +245,8 @@ static inline void attach_sceneitem(struct obs_scene *parent,
 	item->prev = prev;
 	item->parent = parent;
 
+	obs_source_mark_dirty(parent->source);
+
 	if (prev) {
 		item->next = prev->next;
 		if (prev->next)
@@ -461,67 +465,89 @@ static inline bool item_texture_enabled(const struct obs_scene_item *item)
 	       (item_is_scene(item) && !item->is_group);
 }
 
-static void render_item_texture(struct obs_scene_item *item)
+static gs_effect_t *get_item_effect(const struct obs_scene_item *item,
+				    const char **tech)
 {
-	gs_texture_t *tex = gs_texrender_get_texture(item->item_render);
-	if (!tex) {
-		return;
+	enum obs_scale_type type = item->scale_filter;
+
+	*tech = "Draw";
+
+	if (type == OBS_SCALE_DISABLE || type == OBS_SCALE_POINT)
+		return obs->video.default_effect;
+	if (close_float(item->output_scale.x, 1.0f, EPSILON) &&
+	    close_float(item->output_scale.y, 1.0f, EPSILON))
+		return obs->video.default_effect;
+
+	if (item->output_scale.x < 0.5f || item->output_scale.y < 0.5f) {
+		return obs->video.bilinear_lowres_effect;
+	} else if (type == OBS_SCALE_BICUBIC) {
+		return obs->video.bicubic_effect;
+	} else if (type == OBS_SCALE_LANCZOS) {
+		return obs->video.lanczos_effect;
+	} else if (type == OBS_SCALE_AREA) {
+		if ((item->output_scale.x >= 1.0f) &&
+		    (item->output_scale.y >= 1.0f))
+			*tech = "DrawUpscale";
+		return obs->video.area_effect;
 	}
 
-	GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_ITEM_TEXTURE,
-			      "render_item_texture");
+	return obs->video.default_effect;
+}
 
-	gs_effect_t *effect = obs->video.default_effect;
-	enum obs_scale_type type = item->scale_filter;
+static void set_item_effect_params(const struct obs_scene_item *item,
+				   gs_effect_t *effect, gs_texture_t *tex)
+{
 	uint32_t cx = gs_texture_get_width(tex);
 	uint32_t cy = gs_texture_get_height(tex);
-	const char *tech = "Draw";
-
-	if (type != OBS_SCALE_DISABLE) {
-		if (type == OBS_SCALE_POINT) {
-			gs_eparam_t *image =
-				gs_effect_get_param_by_name(effect, "image");
-			gs_effect_set_next_sampler(image,
-						   obs->video.point_sampler);
-
-		} else if (!close_float(item->output_scale.x, 1.0f, EPSILON) ||
-			   !close_float(item->output_scale.y, 1.0f, EPSILON)) {
-			gs_eparam_t *scale_param;
-			gs_eparam_t *scale_i_param;
-
-			if (item->output_scale.x < 0.5f ||
-			    item->output_scale.y < 0.5f) {
-				effect = obs->video.bilinear_lowres_effect;
-			} else if (type == OBS_SCALE_BICUBIC) {
-				effect = obs->video.bicubic_effect;
-			} else if (type == OBS_SCALE_LANCZOS) {
-				effect = obs->video.lanczos_effect;
-			} else if (type == OBS_SCALE_AREA) {
-				effect = obs->video.area_effect;
-				if ((item->output_scale.x >= 1.0f) &&
-				    (item->output_scale.y >= 1.0f))
-					tech = "DrawUpscale";
-			}
+	gs_eparam_t *scale_param;
+	gs_eparam_t *scale_i_param;
 
-			scale_param = gs_effect_get_param_by_name(
-				effect, "base_dimension");
-			if (scale_param) {
-				struct vec2 base_res = {(float)cx, (float)cy};
+	if (item->scale_filter == OBS_SCALE_POINT) {
+		gs_eparam_t *image =
+			gs_effect_get_param_by_name(effect, "image");
+		gs_effect_set_next_sampler(image, obs->video.point_sampler);
+		return;
+	}
 
-				gs_effect_set_vec2(scale_param, &base_res);
-			}
+	if (effect == obs->video.default_effect)
+		return;
 
-			scale_i_param = gs_effect_get_param_by_name(
-				effect, "base_dimension_i");
-			if (scale_i_param) {
-				struct vec2 base_res_i = {1.0f / (float)cx,
-							  1.0f / (float)cy};
+	scale_param = gs_effect_get_param_by_name(effect, "base_dimension");
+	if (scale_param) {
+		struct vec2 base_res = {(float)cx, (float)cy};
 
-				gs_effect_set_vec2(scale_i_param, &base_res_i);
-			}
-		}
+		gs_effect_set_vec2(scale_param, &base_res);
 	}
 
+	scale_i_param = gs_effect_get_param_by_name(effect, "base_dimension_i");
+	if (scale_i_param) {
+		struct vec2 base_res_i = {1.0f / (float)cx, 1.0f / (float)cy};
+
+		gs_effect_set_vec2(scale_i_param, &base_res_i);
+	}
+}
+
+static inline gs_texture_t *get_item_texture(struct obs_scene_item *item)
+{
+	struct obs_scene_item *render_item =
+		item->shared_render ? item->shared_render : item;
+	return gs_texrender_get_texture(render_item->item_render);
+}
+
+static void render_item_texture(struct obs_scene_item *item)
+{
+	gs_texture_t *tex = get_item_texture(item);
+	if (!tex) {
+		return;
+	}
+
+	GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_ITEM_TEXTURE,
+			      "render_item_texture");
+
+	const char *tech;
+	gs_effect_t *effect = get_item_effect(item, &tech);
+	set_item_effect_params(item, effect, tex);
+
 	gs_blend_state_push();
 	gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
 
@@ -533,42 +559,96 @@ static void render_item_texture(struct obs_scene_item *item)
 	GS_DEBUG_MARKER_END();
 }
 
-static inline void render_item(struct obs_scene_item *item)
+/* two items showing the same source with the same crop and size can share
+ * one texture render */
+static inline bool same_item_render(const struct obs_scene_item *a,
+				    const struct obs_scene_item *b,
+				    uint32_t cx, uint32_t cy)
 {
-	GS_DEBUG_MARKER_BEGIN_FORMAT(GS_DEBUG_COLOR_ITEM, "Item: %s",
-				     obs_source_get_name(item->source));
+	return a->source == b->source && a->item_render && !a->shared_render &&
+	       a->last_render_cx == cx && a->last_render_cy == cy &&
+	       memcmp(&a->crop, &b->crop, sizeof(a->crop)) == 0;
+}
 
-	if (item->item_render) {
-		uint32_t width = obs_source_get_width(item->source);
-		uint32_t height = obs_source_get_height(item->source);
+static struct obs_scene_item *find_shared_render(struct obs_scene *scene,
+						 struct obs_scene_item *item,
+						 uint32_t cx, uint32_t cy)
+{
+	struct obs_scene_item *prev = scene->first_item;
 
-		if (!width || !height) {
-			goto cleanup;
-		}
+	for (; prev && prev != item; prev = prev->next) {
+		if (prev->user_visible && same_item_render(prev, item, cx, cy))
+			return prev;
+	}
+
+	return NULL;
+}
 
-		uint32_t cx = calc_cx(item, width);
-		uint32_t cy = calc_cy(item, height);
+static void render_item_texrender(struct obs_scene *scene,
+				  struct obs_scene_item *item)
+{
+	uint32_t width = obs_source_get_width(item->source);
+	uint32_t height = obs_source_get_height(item->source);
+	uint32_t cx, cy;
+
+	item->shared_render = NULL;
+	item->last_render_cx = 0;
+	item->last_render_cy = 0;
+
+	if (!width || !height)
+		return;
+
+	cx = calc_cx(item, width);
+	cy = calc_cy(item, height);
+	if (!cx || !cy)
+		return;
+
+	item->shared_render = find_shared_render(scene, item, cx, cy);
+	if (item->shared_render)
+		return;
 
-		if (cx && cy && gs_texrender_begin(item->item_render, cx, cy)) {
-			float cx_scale = (float)width / (float)cx;
-			float cy_scale = (float)height / (float)cy;
-			struct vec4 clear_color;
+	item->last_render_cx = cx;
+	item->last_render_cy = cy;
 
-			vec4_zero(&clear_color);
-			gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
-			gs_ortho(0.0f, (float)width, 0.0f, (float)height,
-				 -100.0f, 100.0f);
+	GS_DEBUG_MARKER_BEGIN_FORMAT(GS_DEBUG_COLOR_ITEM, "Item texture: %s",
+				     obs_source_get_name(item->source));
 
-			gs_matrix_scale3f(cx_scale, cy_scale, 1.0f);
-			gs_matrix_translate3f(-(float)item->crop.left,
-					      -(float)item->crop.top, 0.0f);
+	if (gs_texrender_begin(item->item_render, cx, cy)) {
+		float cx_scale = (float)width / (float)cx;
+		float cy_scale = (float)height / (float)cy;
+		struct vec4 clear_color;
 
-			obs_source_video_render(item->source);
+		vec4_zero(&clear_color);
+		gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+		gs_ortho(0.0f, (float)width, 0.0f, (float)height, -100.0f,
+			 100.0f);
 
-			gs_texrender_end(item->item_render);
-		}
+		gs_matrix_scale3f(cx_scale, cy_scale, 1.0f);
+		gs_matrix_translate3f(-(float)item->crop.left,
+				      -(float)item->crop.top, 0.0f);
+
+		obs_source_video_render(item->source);
+
+		gs_texrender_end(item->item_render);
 	}
 
+	GS_DEBUG_MARKER_END();
+}
+
+static inline bool item_has_texture(const struct obs_scene_item *item)
+{
+	return item->item_render &&
+	       (item->last_render_cx || item->shared_render);
+}
+
+static inline void render_item(struct obs_scene_item *item)
+{
+	GS_DEBUG_MARKER_BEGIN_FORMAT(GS_DEBUG_COLOR_ITEM, "Item: %s",
+				     obs_source_get_name(item->source));
+
+	if (item->item_render && !item_has_texture(item))
+		goto cleanup;
+
 	gs_matrix_push();
 	gs_matrix_mul(&item->draw_transform);
 	if (item->item_render) {
@@ -582,6 +662,72 @@ cleanup:
 	GS_DEBUG_MARKER_END();
 }
 
+/* items drawn from the same texture with the same effect state can be drawn
+ * together as one sprite batch */
+static inline bool can_batch_items(struct obs_scene_item *a,
+				   struct obs_scene_item *b, gs_texture_t *tex)
+{
+	const char *tech_a, *tech_b;
+
+	if (!b->user_visible || !item_has_texture(b))
+		return false;
+	if (get_item_texture(b) != tex)
+		return false;
+	if (a->scale_filter != b->scale_filter)
+		return false;
+
+	return get_item_effect(a, &tech_a) == get_item_effect(b, &tech_b) &&
+	       strcmp(tech_a, tech_b) == 0;
+}
+
+static struct obs_scene_item *
+render_item_batch(struct obs_scene_item *item,
+		  struct darray *transforms_da)
+{
+	DARRAY(struct matrix4) transforms;
+	struct obs_scene_item *next = item->next;
+	gs_texture_t *tex = get_item_texture(item);
+
+	transforms.da = *transforms_da;
+	da_resize(transforms, 0);
+	da_push_back(transforms, &item->draw_transform);
+
+	for (; next && can_batch_items(item, next, tex); next = next->next)
+		da_push_back(transforms, &next->draw_transform);
+
+	if (transforms.num == 1) {
+		*transforms_da = transforms.da;
+		render_item(item);
+		return item->next;
+	}
+
+	GS_DEBUG_MARKER_BEGIN_FORMAT(GS_DEBUG_COLOR_ITEM,
+				     "Items: %s (%d batched)",
+				     obs_source_get_name(item->source),
+				     (int)transforms.num);
+
+	const char *tech;
+	gs_effect_t *effect = get_item_effect(item, &tech);
+	set_item_effect_params(item, effect, tex);
+
+	gs_blend_state_push();
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+
+	while (gs_effect_loop(effect, tech)) {
+		gs_effect_set_texture(
+			gs_effect_get_param_by_name(effect, "image"), tex);
+		gs_draw_sprite_batch(tex, 0, 0, 0, transforms.array,
+				     transforms.num);
+	}
+
+	gs_blend_state_pop();
+
+	GS_DEBUG_MARKER_END();
+
+	*transforms_da = transforms.da;
+	return next;
+}
+
 static void scene_video_tick(void *data, float seconds)
 {
 	struct obs_scene *scene = data;
@@ -648,10 +794,12 @@ update_transforms_and_prune_sources(obs_scene_t *scene,
 static void scene_video_render(void *data, gs_effect_t *effect)
 {
 	DARRAY(struct obs_scene_item *) remove_items;
+	DARRAY(struct matrix4) transforms;
 	struct obs_scene *scene = data;
 	struct obs_scene_item *item;
 
 	da_init(remove_items);
+	da_init(transforms);
 
 	video_lock(scene);
 
@@ -663,14 +811,28 @@ static void scene_video_render(void *data, gs_effect_t *effect)
 	gs_blend_state_push();
 	gs_reset_blend_state();
 
+	/* render all item textures first so that items sharing a texture
+	 * can then be drawn together */
 	item = scene->first_item;
 	while (item) {
-		if (item->user_visible)
-			render_item(item);
+		if (item->user_visible && item->item_render)
+			render_item_texrender(scene, item);
 
 		item = item->next;
 	}
 
+	item = scene->first_item;
+	while (item) {
+		if (!item->user_visible) {
+			item = item->next;
+		} else if (item_has_texture(item)) {
+			item = render_item_batch(item, &transforms.da);
+		} else {
+			render_item(item);
+			item = item->next;
+		}
+	}
+
 	gs_blend_state_pop();
 
 	video_unlock(scene);
@@ -678,6 +840,7 @@ static void scene_video_render(void *data, gs_effect_t *effect)
 	for (size_t i = 0; i < remove_items.num; i++)
 		obs_sceneitem_release(remove_items.array[i]);
 	da_free(remove_items);
+	da_free(transforms);
 
 	UNUSED_PARAMETER(effect);
 }
@@ -1424,6 +1587,32 @@ obs_scene_t *obs_group_from_source(const obs_source_t *source)
 	return source->context.data;
 }
 
+/* latest change serial of the private settings of the items of a scene or
+ * group, which are saved with it */
+long obs_scene_get_items_change_serial(obs_source_t *source)
+{
+	obs_scene_t *scene = obs_scene_from_source(source);
+	struct obs_scene_item *item;
+	long serial = 0;
+
+	if (!scene)
+		scene = obs_group_from_source(source);
+	if (!scene)
+		return 0;
+
+	video_lock(scene);
+
+	for (item = scene->first_item; item; item = item->next) {
+		long item_serial =
+			obs_data_get_change_serial(item->private_settings);
+		if (item_serial > serial)
+			serial = item_serial;
+	}
+
+	video_unlock(scene);
+	return serial;
+}
+
 obs_sceneitem_t *obs_scene_find_source(obs_scene_t *scene, const char *name)
 {
 	struct obs_scene_item *item;
@@ -1736,6 +1925,7 @@ static obs_sceneitem_t *obs_scene_add_internal(obs_scene_t *scene,
 		}
 	}
 
+	obs_source_mark_dirty(scene->source);
 	full_unlock(scene);
 
 	if (!scene->source->context.private)
@@ -1845,6 +2035,8 @@ obs_source_t *obs_sceneitem_get_source(const obs_sceneitem_t *item)
 static void signal_parent(obs_scene_t *parent, const char *command,
 			  calldata_t *params)
 {
+	obs_source_mark_dirty(parent->source);
+
 	calldata_set_ptr(params, "scene", parent);
 	signal_handler_signal(parent->source->context.signals, command, params);
 }
@@ -2281,6 +2473,7 @@ void obs_scene_atomic_update(obs_scene_t *scene,
 	obs_scene_addref(scene);
 	full_lock(scene);
 	func(data, scene);
+	obs_source_mark_dirty(scene->source);
 	full_unlock(scene);
 	obs_scene_release(scene);
 }
@@ -2629,6 +2822,7 @@ obs_sceneitem_t *obs_scene_insert_group(obs_scene_t *scene, const char *name,
 	}
 	items[0]->prev = NULL;
 	resize_group(item);
+	obs_source_mark_dirty(sub_scene->source);
 	full_unlock(sub_scene);
 	full_unlock(scene);
 
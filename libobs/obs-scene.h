@@ -51,6 +51,12 @@ struct obs_scene_item {
 	gs_texrender_t *item_render;
 	struct obs_sceneitem_crop crop;
 
+	/* set while rendering: item showing the same texture as this one,
+	 * and the size this item's texture was last rendered at */
+	struct obs_scene_item *shared_render;
+	uint32_t last_render_cx;
+	uint32_t last_render_cy;
+
 	struct vec2 pos;
 	struct vec2 scale;
 	float rot;
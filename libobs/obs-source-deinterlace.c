@@ -442,6 +442,7 @@ void obs_source_set_deinterlace_mode(obs_source_t *source,
 		source->deinterlace_effect = get_effect(mode);
 		obs_leave_graphics();
 	}
+	obs_source_mark_dirty(source);
 }
 
 enum obs_deinterlace_mode
@@ -460,6 +461,7 @@ void obs_source_set_deinterlace_field_order(
 
 	source->deinterlace_top_first = field_order ==
 					OBS_DEINTERLACE_FIELD_ORDER_TOP;
+	obs_source_mark_dirty(source);
 }
 
 enum obs_deinterlace_field_order
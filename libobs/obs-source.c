@@ -101,6 +101,7 @@ static const char *source_signals[] = {
 	"void media_previous(ptr source)",
 	"void media_started(ptr source)",
 	"void media_ended(ptr source)",
+	"void async_frame_policy(ptr source, int policy, int target_ms)",
 	NULL,
 };
 
@@ -176,11 +177,13 @@ static bool obs_source_init(struct obs_source *source)
 	source->sync_offset = 0;
 	source->balance = 0.5f;
 	source->audio_active = true;
+	source->save_serial = os_atomic_inc_long(&obs->data.save_serial);
 	pthread_mutex_init_value(&source->filter_mutex);
 	pthread_mutex_init_value(&source->async_mutex);
 	pthread_mutex_init_value(&source->audio_mutex);
 	pthread_mutex_init_value(&source->audio_buf_mutex);
 	pthread_mutex_init_value(&source->audio_cb_mutex);
+	pthread_mutex_init_value(&source->props_mutex);
 
 	if (pthread_mutexattr_init(&attr) != 0)
 		return false;
@@ -198,6 +201,8 @@ static bool obs_source_init(struct obs_source *source)
 		return false;
 	if (pthread_mutex_init(&source->async_mutex, NULL) != 0)
 		return false;
+	if (pthread_mutex_init(&source->props_mutex, NULL) != 0)
+		return false;
 
 	if (is_audio_source(source) || is_composite_source(source))
 		allocate_audio_output_buffer(source);
@@ -235,6 +240,7 @@ static void obs_source_init_finalize(struct obs_source *source)
 
 	obs_context_data_insert(&source->context, &obs->data.sources_mutex,
 				&obs->data.first_source);
+	obs_source_tick_list_add(source);
 }
 
 static bool obs_source_hotkey_mute(void *data, obs_hotkey_pair_id id,
@@ -328,6 +334,48 @@ static void obs_source_init_audio_hotkeys(struct obs_source *source)
 		obs_source_hotkey_push_to_talk, source);
 }
 
+#define DEFAULT_ASYNC_TARGET_LATENCY 100000000ULL
+
+static void get_async_frame_stats_proc(void *data, calldata_t *cd)
+{
+	struct obs_source_async_stats stats;
+	obs_source_get_async_stats(data, &stats);
+
+	calldata_set_int(cd, "queue_depth", stats.queue_depth);
+	calldata_set_int(cd, "received", (long long)stats.frames_received);
+	calldata_set_int(cd, "rendered", (long long)stats.frames_rendered);
+	calldata_set_int(cd, "dropped", (long long)stats.frames_dropped);
+	calldata_set_int(cd, "duplicated", (long long)stats.frames_duplicated);
+	calldata_set_int(cd, "average_age_ms",
+			 (long long)(stats.average_age_ns / 1000000));
+}
+
+static void set_async_frame_policy_proc(void *data, calldata_t *cd)
+{
+	long long policy = calldata_int(cd, "policy");
+	long long target_ms = calldata_int(cd, "target_ms");
+
+	obs_source_set_async_frame_policy(data,
+					  (enum obs_async_frame_policy)policy,
+					  (uint32_t)target_ms);
+}
+
+static inline void obs_source_add_async_procs(obs_source_t *source)
+{
+	proc_handler_t *ph = source->context.procs;
+
+	proc_handler_add(ph,
+			 "void get_async_frame_stats(out int queue_depth, "
+			 "out int received, out int rendered, "
+			 "out int dropped, out int duplicated, "
+			 "out int average_age_ms)",
+			 get_async_frame_stats_proc, source);
+	proc_handler_add(ph,
+			 "void set_async_frame_policy(int policy, "
+			 "int target_ms)",
+			 set_async_frame_policy_proc, source);
+}
+
 static obs_source_t *
 obs_source_create_internal(const char *id, const char *name,
 			   obs_data_t *settings, obs_data_t *hotkey_data,
@@ -358,6 +406,7 @@ obs_source_create_internal(const char *id, const char *name,
 	source->push_to_mute_key = OBS_INVALID_HOTKEY_ID;
 	source->push_to_talk_key = OBS_INVALID_HOTKEY_ID;
 	source->last_obs_ver = last_obs_ver;
+	source->async_target_latency = DEFAULT_ASYNC_TARGET_LATENCY;
 
 	if (!obs_source_init_context(source, settings, name, hotkey_data,
 				     private))
@@ -381,12 +430,18 @@ obs_source_create_internal(const char *id, const char *name,
 
 	/* allow the source to be created even if creation fails so that the
 	 * user's data doesn't become lost */
-	if (info && info->create)
+	if (info && info->create) {
+		const char *prev_tag = bmem_set_tag(info->id);
 		source->context.data =
 			info->create(source->context.settings, source);
+		bmem_set_tag(prev_tag);
+	}
 	if ((!info || info->create) && !source->context.data)
 		blog(LOG_ERROR, "Failed to create source '%s'!", name);
 
+	if ((source->info.output_flags & OBS_SOURCE_ASYNC) != 0)
+		obs_source_add_async_procs(source);
+
 	blog(LOG_DEBUG, "%ssource '%s' (%s) created", private ? "private " : "",
 	     name, id);
 
@@ -574,7 +629,7 @@ void obs_source_frame_init(struct obs_source_frame *frame,
 static inline void obs_source_frame_decref(struct obs_source_frame *frame)
 {
 	if (os_atomic_dec_long(&frame->refs) == 0)
-		obs_source_frame_destroy(frame);
+		obs_frame_pool_put(&obs->data.frame_pool, frame);
 }
 
 static bool obs_source_filter_remove_refless(obs_source_t *source,
@@ -612,11 +667,19 @@ void obs_source_destroy(struct obs_source *source)
 
 	obs_source_dosignal(source, "source_destroy", "destroy");
 
+	obs_properties_destroy(source->props_cache);
+	source->props_cache = NULL;
+	bfree(source->props_settings);
+
 	if (source->context.data) {
 		source->info.destroy(source->context.data);
 		source->context.data = NULL;
 	}
 
+	/* async capture threads may still output frames (and re-add the
+	 * source) until the destroy callback has stopped them */
+	obs_source_tick_list_remove(source);
+
 	audio_monitor_destroy(source->monitor);
 
 	obs_hotkey_unregister(source->push_to_talk_key);
@@ -637,6 +700,9 @@ void obs_source_destroy(struct obs_source *source)
 	}
 	if (source->filter_texrender)
 		gs_texrender_destroy(source->filter_texrender);
+	if (source->render_cache_texrender)
+		gs_texrender_destroy(source->render_cache_texrender);
+	gs_effect_destroy(source->fused_effect);
 	gs_leave_context();
 
 	for (i = 0; i < MAX_AV_PLANES; i++)
@@ -657,12 +723,15 @@ void obs_source_destroy(struct obs_source *source)
 	da_free(source->async_cache);
 	da_free(source->async_frames);
 	da_free(source->filters);
+	da_free(source->fused_stages);
+	da_free(source->fused_code);
 	pthread_mutex_destroy(&source->filter_mutex);
 	pthread_mutex_destroy(&source->audio_actions_mutex);
 	pthread_mutex_destroy(&source->audio_buf_mutex);
 	pthread_mutex_destroy(&source->audio_cb_mutex);
 	pthread_mutex_destroy(&source->audio_mutex);
 	pthread_mutex_destroy(&source->async_mutex);
+	pthread_mutex_destroy(&source->props_mutex);
 	obs_data_release(source->private_settings);
 	obs_context_data_free(&source->context);
 
@@ -822,26 +891,78 @@ bool obs_source_configurable(const obs_source_t *source)
 	       (source->info.get_properties || source->info.get_properties2);
 }
 
-obs_properties_t *obs_source_properties(const obs_source_t *source)
+static inline obs_properties_t *
+create_source_properties(const obs_source_t *source)
 {
-	if (!data_valid(source, "obs_source_properties"))
-		return NULL;
+	if (source->info.get_properties2)
+		return source->info.get_properties2(source->context.data,
+						    source->info.type_data);
+	return source->info.get_properties(source->context.data);
+}
 
-	if (source->info.get_properties2) {
-		obs_properties_t *props;
-		props = source->info.get_properties2(source->context.data,
-						     source->info.type_data);
-		obs_properties_apply_settings(props, source->context.settings);
-		return props;
+/* properties of sources with OBS_SOURCE_CACHE_PROPERTIES are only created
+ * once, and settings are only re-applied (which runs every modified callback)
+ * when they have changed since the cached properties were made.  The cached
+ * properties are never modified once stored, every caller gets its own copy
+ * of them. */
+static obs_properties_t *get_cached_properties(struct obs_source *source)
+{
+	obs_properties_t *cache;
+	obs_properties_t *props;
+	obs_properties_t *copy;
+	char *json;
+	bool applied;
 
-	} else if (source->info.get_properties) {
-		obs_properties_t *props;
-		props = source->info.get_properties(source->context.data);
-		obs_properties_apply_settings(props, source->context.settings);
+	pthread_mutex_lock(&source->props_mutex);
+	json = bstrdup(obs_data_get_json(source->context.settings));
+	cache = source->props_cache;
+	applied = cache && source->props_settings &&
+		  strcmp(source->props_settings, json) == 0;
+	props = obs_properties_duplicate(cache);
+	pthread_mutex_unlock(&source->props_mutex);
+
+	if (applied) {
+		bfree(json);
 		return props;
 	}
 
-	return NULL;
+	/* created and applied outside of the lock in case the source
+	 * invalidates its properties from within its callbacks */
+	if (!props)
+		props = create_source_properties(source);
+	obs_properties_apply_settings(props, source->context.settings);
+	copy = obs_properties_duplicate(props);
+
+	pthread_mutex_lock(&source->props_mutex);
+	if (source->props_cache == cache) {
+		source->props_cache = props;
+		bfree(source->props_settings);
+		source->props_settings = json;
+		props = cache;
+		json = NULL;
+	}
+	pthread_mutex_unlock(&source->props_mutex);
+
+	obs_properties_destroy(props);
+	bfree(json);
+	return copy;
+}
+
+obs_properties_t *obs_source_properties(const obs_source_t *source)
+{
+	obs_properties_t *props;
+
+	if (!data_valid(source, "obs_source_properties"))
+		return NULL;
+	if (!source->info.get_properties && !source->info.get_properties2)
+		return NULL;
+
+	if ((source->info.output_flags & OBS_SOURCE_CACHE_PROPERTIES) != 0)
+		return get_cached_properties((struct obs_source *)source);
+
+	props = create_source_properties(source);
+	obs_properties_apply_settings(props, source->context.settings);
+	return props;
 }
 
 uint32_t obs_source_get_output_flags(const obs_source_t *source)
@@ -859,9 +980,12 @@ uint32_t obs_get_source_output_flags(const char *id)
 
 static void obs_source_deferred_update(obs_source_t *source)
 {
-	if (source->context.data && source->info.update)
+	if (source->context.data && source->info.update) {
+		const char *prev_tag = bmem_set_tag(source->info.id);
 		source->info.update(source->context.data,
 				    source->context.settings);
+		bmem_set_tag(prev_tag);
+	}
 
 	source->defer_update = false;
 }
@@ -874,19 +998,35 @@ void obs_source_update(obs_source_t *source, obs_data_t *settings)
 	if (settings)
 		obs_data_apply(source->context.settings, settings);
 
+	obs_source_mark_dirty(source);
+
 	if (source->info.output_flags & OBS_SOURCE_VIDEO) {
 		source->defer_update = true;
+		obs_source_tick_list_add(source);
 	} else if (source->context.data && source->info.update) {
+		const char *prev_tag = bmem_set_tag(source->info.id);
 		source->info.update(source->context.data,
 				    source->context.settings);
+		bmem_set_tag(prev_tag);
 	}
 }
 
 void obs_source_update_properties(obs_source_t *source)
 {
+	obs_properties_t *props;
+
 	if (!obs_source_valid(source, "obs_source_update_properties"))
 		return;
 
+	pthread_mutex_lock(&source->props_mutex);
+	props = source->props_cache;
+	source->props_cache = NULL;
+	bfree(source->props_settings);
+	source->props_settings = NULL;
+	pthread_mutex_unlock(&source->props_mutex);
+
+	obs_properties_destroy(props);
+
 	obs_source_dosignal(source, NULL, "update_properties");
 }
 
@@ -994,6 +1134,7 @@ static void activate_tree(obs_source_t *parent, obs_source_t *child,
 			  void *param)
 {
 	os_atomic_inc_long(&child->activate_refs);
+	obs_source_tick_list_add(child);
 
 	UNUSED_PARAMETER(parent);
 	UNUSED_PARAMETER(param);
@@ -1011,6 +1152,7 @@ static void deactivate_tree(obs_source_t *parent, obs_source_t *child,
 static void show_tree(obs_source_t *parent, obs_source_t *child, void *param)
 {
 	os_atomic_inc_long(&child->show_refs);
+	obs_source_tick_list_add(child);
 
 	UNUSED_PARAMETER(parent);
 	UNUSED_PARAMETER(param);
@@ -1030,6 +1172,7 @@ void obs_source_activate(obs_source_t *source, enum view_type type)
 		return;
 
 	os_atomic_inc_long(&source->show_refs);
+	obs_source_tick_list_add(source);
 	obs_source_enum_active_tree(source, show_tree, NULL);
 
 	if (type == MAIN_VIEW) {
@@ -1059,6 +1202,8 @@ void obs_source_deactivate(obs_source_t *source, enum view_type type)
 
 static inline struct obs_source_frame *get_closest_frame(obs_source_t *source,
 							 uint64_t sys_time);
+static void count_rendered_frame(obs_source_t *source,
+				 const struct obs_source_frame *frame);
 bool set_async_texture_size(struct obs_source *source,
 			    const struct obs_source_frame *frame);
 
@@ -1077,6 +1222,13 @@ static void async_tick(obs_source_t *source)
 		}
 
 		source->cur_async_frame = get_closest_frame(source, sys_time);
+
+		/* with no new frame, the texture of the last one is shown
+		 * again, however many ticks in a row that happens */
+		if (source->cur_async_frame)
+			count_rendered_frame(source, source->cur_async_frame);
+		else if (source->async_active && source->async_textures[0])
+			source->async_frames_duplicated++;
 	}
 
 	source->last_sys_timestamp = sys_time;
@@ -1087,6 +1239,65 @@ static void async_tick(obs_source_t *source)
 			set_async_texture_size(source, source->cur_async_frame);
 }
 
+void obs_source_tick_list_add(obs_source_t *source)
+{
+	struct obs_core_data *data = &obs->data;
+
+	pthread_mutex_lock(&data->tick_sources_mutex);
+
+	/* skip sources whose last reference is gone, they are being
+	 * destroyed */
+	if (!source->in_tick_list &&
+	    os_atomic_load_long(&source->control->ref.refs) >= 0) {
+		da_push_back(data->tick_sources, &source);
+		source->in_tick_list = true;
+	}
+	pthread_mutex_unlock(&data->tick_sources_mutex);
+}
+
+void obs_source_tick_list_remove(obs_source_t *source)
+{
+	struct obs_core_data *data = &obs->data;
+
+	pthread_mutex_lock(&data->tick_sources_mutex);
+	if (source->in_tick_list) {
+		da_erase_item(data->tick_sources, &source);
+		source->in_tick_list = false;
+	}
+	pthread_mutex_unlock(&data->tick_sources_mutex);
+}
+
+/* Whether the source still has to be ticked.  Sources for which this returns
+ * false are dropped from the tick list until something re-adds them (being
+ * shown or activated, receiving an async frame, or a deferred update). */
+bool obs_source_needs_tick(obs_source_t *source)
+{
+	bool frames_pending;
+
+	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION ||
+	    source->info.type == OBS_SOURCE_TYPE_FILTER)
+		return true;
+
+	if (source->defer_update || source->showing || source->active)
+		return true;
+	if (os_atomic_load_long(&source->show_refs) ||
+	    os_atomic_load_long(&source->activate_refs))
+		return true;
+
+	if (source->info.video_tick &&
+	    (source->info.output_flags & OBS_SOURCE_SKIP_HIDDEN_TICK) == 0)
+		return true;
+
+	if ((source->info.output_flags & OBS_SOURCE_ASYNC) == 0)
+		return false;
+
+	pthread_mutex_lock(&source->async_mutex);
+	frames_pending = source->async_frames.num || source->cur_async_frame;
+	pthread_mutex_unlock(&source->async_mutex);
+
+	return frames_pending;
+}
+
 void obs_source_video_tick(obs_source_t *source, float seconds)
 {
 	bool now_showing, now_active;
@@ -1155,8 +1366,11 @@ void obs_source_video_tick(obs_source_t *source, float seconds)
 		source->active = now_active;
 	}
 
-	if (source->context.data && source->info.video_tick)
+	if (source->context.data && source->info.video_tick) {
+		const char *prev_tag = bmem_set_tag(source->info.id);
 		source->info.video_tick(source->context.data, seconds);
+		bmem_set_tag(prev_tag);
+	}
 
 	source->async_rendered = false;
 	source->deinterlace_rendered = false;
@@ -1410,68 +1624,6 @@ static void source_output_audio_data(obs_source_t *source,
 	source_signal_audio_data(source, data, source_muted(source, os_time));
 }
 
-enum convert_type {
-	CONVERT_NONE,
-	CONVERT_NV12,
-	CONVERT_420,
-	CONVERT_420_A,
-	CONVERT_422,
-	CONVERT_422_A,
-	CONVERT_422_PACK,
-	CONVERT_444,
-	CONVERT_444_A,
-	CONVERT_444_A_PACK,
-	CONVERT_800,
-	CONVERT_RGB_LIMITED,
-	CONVERT_BGR3,
-};
-
-static inline enum convert_type get_convert_type(enum video_format format,
-						 bool full_range)
-{
-	switch (format) {
-	case VIDEO_FORMAT_I420:
-		return CONVERT_420;
-	case VIDEO_FORMAT_NV12:
-		return CONVERT_NV12;
-	case VIDEO_FORMAT_I444:
-		return CONVERT_444;
-	case VIDEO_FORMAT_I422:
-		return CONVERT_422;
-
-	case VIDEO_FORMAT_YVYU:
-	case VIDEO_FORMAT_YUY2:
-	case VIDEO_FORMAT_UYVY:
-		return CONVERT_422_PACK;
-
-	case VIDEO_FORMAT_Y800:
-		return CONVERT_800;
-
-	case VIDEO_FORMAT_NONE:
-	case VIDEO_FORMAT_RGBA:
-	case VIDEO_FORMAT_BGRA:
-	case VIDEO_FORMAT_BGRX:
-		return full_range ? CONVERT_NONE : CONVERT_RGB_LIMITED;
-
-	case VIDEO_FORMAT_BGR3:
-		return CONVERT_BGR3;
-
-	case VIDEO_FORMAT_I40A:
-		return CONVERT_420_A;
-
-	case VIDEO_FORMAT_I42A:
-		return CONVERT_422_A;
-
-	case VIDEO_FORMAT_YUVA:
-		return CONVERT_444_A;
-
-	case VIDEO_FORMAT_AYUV:
-		return CONVERT_444_A_PACK;
-	}
-
-	return CONVERT_NONE;
-}
-
 static inline bool set_packed422_sizes(struct obs_source *source,
 				       const struct obs_source_frame *frame)
 {
@@ -1644,58 +1796,169 @@ static inline bool set_bgr3_sizes(struct obs_source *source,
 	return true;
 }
 
-static inline bool init_gpu_conversion(struct obs_source *source,
-				       const struct obs_source_frame *frame)
-{
-	switch (get_convert_type(frame->format, frame->full_range)) {
-	case CONVERT_422_PACK:
-		return set_packed422_sizes(source, frame);
+/* Per-format upload/convert handlers.  The handler is picked once when the
+ * async textures are (re)created, so the per-frame path does not have to
+ * work out the conversion from the frame format again.  Handlers without an
+ * init function are sampled directly from the uploaded texture. */
+struct async_convert {
+	bool (*init)(struct obs_source *source,
+		     const struct obs_source_frame *frame);
+	const char *tech_full;
+	const char *tech_limited;
+	const char *profile_name;
+};
 
-	case CONVERT_420:
-		return set_planar420_sizes(source, frame);
+static const struct async_convert convert_rgb = {
+	NULL,
+	NULL,
+	NULL,
+	"async_upload(RGB)",
+};
 
-	case CONVERT_422:
-		return set_planar422_sizes(source, frame);
+static const struct async_convert convert_rgb_limited = {
+	set_rgb_limited_sizes,
+	NULL,
+	"RGB_Limited",
+	"async_convert(RGB_Limited)",
+};
 
-	case CONVERT_NV12:
-		return set_nv12_sizes(source, frame);
+static const struct async_convert convert_i420 = {
+	set_planar420_sizes,
+	"I420_Reverse",
+	"I420_Reverse",
+	"async_convert(I420)",
+};
 
-	case CONVERT_444:
-		return set_planar444_sizes(source, frame);
+static const struct async_convert convert_nv12 = {
+	set_nv12_sizes,
+	"NV12_Reverse",
+	"NV12_Reverse",
+	"async_convert(NV12)",
+};
 
-	case CONVERT_800:
-		return set_y800_sizes(source, frame);
+static const struct async_convert convert_yvyu = {
+	set_packed422_sizes,
+	"YVYU_Reverse",
+	"YVYU_Reverse",
+	"async_convert(YVYU)",
+};
 
-	case CONVERT_RGB_LIMITED:
-		return set_rgb_limited_sizes(source, frame);
+static const struct async_convert convert_yuy2 = {
+	set_packed422_sizes,
+	"YUY2_Reverse",
+	"YUY2_Reverse",
+	"async_convert(YUY2)",
+};
 
-	case CONVERT_BGR3:
-		return set_bgr3_sizes(source, frame);
+static const struct async_convert convert_uyvy = {
+	set_packed422_sizes,
+	"UYVY_Reverse",
+	"UYVY_Reverse",
+	"async_convert(UYVY)",
+};
 
-	case CONVERT_420_A:
-		return set_planar420_alpha_sizes(source, frame);
+static const struct async_convert convert_y800 = {
+	set_y800_sizes,
+	"Y800_Full",
+	"Y800_Limited",
+	"async_convert(Y800)",
+};
 
-	case CONVERT_422_A:
-		return set_planar422_alpha_sizes(source, frame);
+static const struct async_convert convert_i444 = {
+	set_planar444_sizes,
+	"I444_Reverse",
+	"I444_Reverse",
+	"async_convert(I444)",
+};
 
-	case CONVERT_444_A:
-		return set_planar444_alpha_sizes(source, frame);
+static const struct async_convert convert_bgr3 = {
+	set_bgr3_sizes,
+	"BGR3_Full",
+	"BGR3_Limited",
+	"async_convert(BGR3)",
+};
+
+static const struct async_convert convert_i422 = {
+	set_planar422_sizes,
+	"I422_Reverse",
+	"I422_Reverse",
+	"async_convert(I422)",
+};
+
+static const struct async_convert convert_i40a = {
+	set_planar420_alpha_sizes,
+	"I40A_Reverse",
+	"I40A_Reverse",
+	"async_convert(I40A)",
+};
+
+static const struct async_convert convert_i42a = {
+	set_planar422_alpha_sizes,
+	"I42A_Reverse",
+	"I42A_Reverse",
+	"async_convert(I42A)",
+};
+
+static const struct async_convert convert_yuva = {
+	set_planar444_alpha_sizes,
+	"YUVA_Reverse",
+	"YUVA_Reverse",
+	"async_convert(YUVA)",
+};
+
+static const struct async_convert convert_ayuv = {
+	set_packed444_alpha_sizes,
+	"AYUV_Reverse",
+	"AYUV_Reverse",
+	"async_convert(AYUV)",
+};
 
-	case CONVERT_444_A_PACK:
-		return set_packed444_alpha_sizes(source, frame);
+static const struct async_convert *get_async_convert(enum video_format format,
+						     bool full_range)
+{
+	switch (format) {
+	case VIDEO_FORMAT_I420:
+		return &convert_i420;
+	case VIDEO_FORMAT_NV12:
+		return &convert_nv12;
+	case VIDEO_FORMAT_YVYU:
+		return &convert_yvyu;
+	case VIDEO_FORMAT_YUY2:
+		return &convert_yuy2;
+	case VIDEO_FORMAT_UYVY:
+		return &convert_uyvy;
+	case VIDEO_FORMAT_Y800:
+		return &convert_y800;
+	case VIDEO_FORMAT_I444:
+		return &convert_i444;
+	case VIDEO_FORMAT_BGR3:
+		return &convert_bgr3;
+	case VIDEO_FORMAT_I422:
+		return &convert_i422;
+	case VIDEO_FORMAT_I40A:
+		return &convert_i40a;
+	case VIDEO_FORMAT_I42A:
+		return &convert_i42a;
+	case VIDEO_FORMAT_YUVA:
+		return &convert_yuva;
+	case VIDEO_FORMAT_AYUV:
+		return &convert_ayuv;
 
-	case CONVERT_NONE:
-		assert(false && "No conversion requested");
+	case VIDEO_FORMAT_NONE:
+	case VIDEO_FORMAT_RGBA:
+	case VIDEO_FORMAT_BGRA:
+	case VIDEO_FORMAT_BGRX:
 		break;
 	}
-	return false;
+
+	return full_range ? &convert_rgb : &convert_rgb_limited;
 }
 
 bool set_async_texture_size(struct obs_source *source,
 			    const struct obs_source_frame *frame)
 {
-	enum convert_type cur =
-		get_convert_type(frame->format, frame->full_range);
+	const struct async_convert *convert =
+		get_async_convert(frame->format, frame->full_range);
 
 	if (source->async_width == frame->width &&
 	    source->async_height == frame->height &&
@@ -1723,10 +1986,18 @@ bool set_async_texture_size(struct obs_source *source,
 	source->async_prev_texrender = NULL;
 
 	const enum gs_color_format format = convert_video_format(frame->format);
-	const bool async_gpu_conversion = (cur != CONVERT_NONE) &&
-					  init_gpu_conversion(source, frame);
+	const bool async_gpu_conversion = convert->init &&
+					  convert->init(source, frame);
+	source->async_convert = convert;
 	source->async_gpu_conversion = async_gpu_conversion;
+	source->async_convert_tech = NULL;
 	if (async_gpu_conversion) {
+		const char *tech_name = frame->full_range
+						? convert->tech_full
+						: convert->tech_limited;
+		source->async_convert_tech = gs_effect_get_technique(
+			obs->video.conversion_effect, tech_name);
+
 		source->async_texrender =
 			gs_texrender_create(format, GS_ZS_NONE);
 
@@ -1750,91 +2021,17 @@ bool set_async_texture_size(struct obs_source *source,
 	return source->async_textures[0] != NULL;
 }
 
-static void upload_raw_frame(gs_texture_t *tex[MAX_AV_PLANES],
-			     const struct obs_source_frame *frame)
+static inline void upload_raw_frame(struct obs_source *source,
+				    gs_texture_t *tex[MAX_AV_PLANES],
+				    const struct obs_source_frame *frame)
 {
-	switch (get_convert_type(frame->format, frame->full_range)) {
-	case CONVERT_422_PACK:
-	case CONVERT_800:
-	case CONVERT_RGB_LIMITED:
-	case CONVERT_BGR3:
-	case CONVERT_420:
-	case CONVERT_422:
-	case CONVERT_NV12:
-	case CONVERT_444:
-	case CONVERT_420_A:
-	case CONVERT_422_A:
-	case CONVERT_444_A:
-	case CONVERT_444_A_PACK:
-		for (size_t c = 0; c < MAX_AV_PLANES; c++) {
-			if (tex[c])
-				gs_texture_set_image(tex[c], frame->data[c],
-						     frame->linesize[c], false);
-		}
-		break;
-
-	case CONVERT_NONE:
-		assert(false && "No conversion requested");
-		break;
+	for (int c = 0; c < source->async_channel_count; c++) {
+		if (tex[c])
+			gs_texture_set_image(tex[c], frame->data[c],
+					     frame->linesize[c], false);
 	}
 }
 
-static const char *select_conversion_technique(enum video_format format,
-					       bool full_range)
-{
-	switch (format) {
-	case VIDEO_FORMAT_UYVY:
-		return "UYVY_Reverse";
-
-	case VIDEO_FORMAT_YUY2:
-		return "YUY2_Reverse";
-
-	case VIDEO_FORMAT_YVYU:
-		return "YVYU_Reverse";
-
-	case VIDEO_FORMAT_I420:
-		return "I420_Reverse";
-
-	case VIDEO_FORMAT_NV12:
-		return "NV12_Reverse";
-
-	case VIDEO_FORMAT_I444:
-		return "I444_Reverse";
-
-	case VIDEO_FORMAT_Y800:
-		return full_range ? "Y800_Full" : "Y800_Limited";
-
-	case VIDEO_FORMAT_BGR3:
-		return full_range ? "BGR3_Full" : "BGR3_Limited";
-
-	case VIDEO_FORMAT_I422:
-		return "I422_Reverse";
-
-	case VIDEO_FORMAT_I40A:
-		return "I40A_Reverse";
-
-	case VIDEO_FORMAT_I42A:
-		return "I42A_Reverse";
-
-	case VIDEO_FORMAT_YUVA:
-		return "YUVA_Reverse";
-
-	case VIDEO_FORMAT_AYUV:
-		return "AYUV_Reverse";
-
-	case VIDEO_FORMAT_BGRA:
-	case VIDEO_FORMAT_BGRX:
-	case VIDEO_FORMAT_RGBA:
-	case VIDEO_FORMAT_NONE:
-		if (full_range)
-			assert(false && "No conversion requested");
-		else
-			return "RGB_Limited";
-		break;
-	}
-	return NULL;
-}
-
 static inline void set_eparam(gs_effect_t *effect, const char *name, float val)
 {
 	gs_eparam_t *param = gs_effect_get_param_by_name(effect, name);
@@ -1856,15 +2053,13 @@ static bool update_async_texrender(struct obs_source *source,
 
 	gs_texrender_reset(texrender);
 
-	upload_raw_frame(tex, frame);
+	upload_raw_frame(source, tex, frame);
 
 	uint32_t cx = source->async_width;
 	uint32_t cy = source->async_height;
 
 	gs_effect_t *conv = obs->video.conversion_effect;
-	const char *tech_name =
-		select_conversion_technique(frame->format, frame->full_range);
-	gs_technique_t *tech = gs_effect_get_technique(conv, tech_name);
+	gs_technique_t *tech = source->async_convert_tech;
 
 	const bool success = gs_texrender_begin(texrender, cx, cy);
 
@@ -1948,21 +2143,27 @@ bool update_async_textures(struct obs_source *source,
 			   gs_texture_t *tex[MAX_AV_PLANES],
 			   gs_texrender_t *texrender)
 {
-	enum convert_type type;
+	const struct async_convert *convert = source->async_convert;
+	bool success = false;
 
 	source->async_flip = frame->flip;
 
-	if (source->async_gpu_conversion && texrender)
-		return update_async_texrender(source, frame, tex, texrender);
+	if (!convert)
+		return false;
+
+	profile_start(convert->profile_name);
 
-	type = get_convert_type(frame->format, frame->full_range);
-	if (type == CONVERT_NONE) {
+	if (source->async_gpu_conversion && texrender) {
+		success = update_async_texrender(source, frame, tex, texrender);
+
+	} else if (!convert->init) {
 		gs_texture_set_image(tex[0], frame->data[0], frame->linesize[0],
 				     false);
-		return true;
+		success = true;
 	}
 
-	return false;
+	profile_end(convert->profile_name);
+	return success;
 }
 
 static inline void obs_source_draw_texture(struct obs_source *source,
@@ -2129,12 +2330,15 @@ static inline void obs_source_main_render(obs_source_t *source)
 	bool custom_draw = (flags & OBS_SOURCE_CUSTOM_DRAW) != 0;
 	bool default_effect = !source->filter_parent &&
 			      source->filters.num == 0 && !custom_draw;
+	const char *prev_tag = bmem_set_tag(source->info.id);
 
 	if (default_effect)
 		obs_source_default_render(source);
 	else if (source->context.data)
 		source->info.video_render(source->context.data,
 					  custom_draw ? NULL : gs_get_effect());
+
+	bmem_set_tag(prev_tag);
 }
 
 static bool ready_async_frame(obs_source_t *source, uint64_t sys_time);
@@ -2157,6 +2361,9 @@ static const char *get_type_format(enum obs_source_type type)
 }
 #endif
 
+static bool collect_fused_stages(obs_source_t *filter);
+static void render_fused_filters(obs_source_t *filter);
+
 static inline void render_video(obs_source_t *source)
 {
 	if (source->info.type != OBS_SOURCE_TYPE_FILTER &&
@@ -2187,6 +2394,9 @@ static inline void render_video(obs_source_t *source)
 	if (source->filters.num && !source->rendering_filter)
 		obs_source_render_filters(source);
 
+	else if (collect_fused_stages(source))
+		render_fused_filters(source);
+
 	else if (source->info.video_render)
 		obs_source_main_render(source);
 
@@ -2202,13 +2412,99 @@ static inline void render_video(obs_source_t *source)
 	GS_DEBUG_MARKER_END();
 }
 
+static inline void render_filter_tex(gs_texture_t *tex, gs_effect_t *effect,
+				     uint32_t width, uint32_t height,
+				     const char *tech_name);
+
+static inline bool use_render_cache(obs_source_t *source)
+{
+	/* filters render their parent as part of the parent's own render, and
+	 * the cached render itself must not be drawn from the cache */
+	return source->render_cache && !source->render_cache_rendering &&
+	       !source->rendering_filter && !source->filter_parent &&
+	       source->context.data && source->enabled &&
+	       (source->info.output_flags & OBS_SOURCE_VIDEO) != 0;
+}
+
+static void render_cache_update(obs_source_t *source, uint32_t cx,
+				uint32_t cy)
+{
+	struct obs_core_video *video = &obs->video;
+
+	if (!source->render_cache_texrender)
+		source->render_cache_texrender =
+			gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+
+	gs_texrender_reset(source->render_cache_texrender);
+
+	/* the cache holds premultiplied alpha, like scene item textures:
+	 * scenes already output premultiplied alpha, and blending any other
+	 * source onto the cleared texture like this premultiplies it */
+	gs_blend_state_push();
+	gs_blend_function_separate(GS_BLEND_SRCALPHA, GS_BLEND_INVSRCALPHA,
+				   GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+
+	if (gs_texrender_begin(source->render_cache_texrender, cx, cy)) {
+		struct vec4 clear_color;
+
+		vec4_zero(&clear_color);
+		gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+		gs_ortho(0.0f, (float)cx, 0.0f, (float)cy, -100.0f, 100.0f);
+
+		source->render_cache_rendering = true;
+		render_video(source);
+		source->render_cache_rendering = false;
+
+		gs_texrender_end(source->render_cache_texrender);
+	}
+
+	gs_blend_state_pop();
+
+	source->render_cache_frame = video->render_frame;
+	video->render_cache_renders++;
+	video->render_cache_total_renders++;
+}
+
+static void render_video_cached(obs_source_t *source)
+{
+	struct obs_core_video *video = &obs->video;
+	uint32_t cx = obs_source_get_width(source);
+	uint32_t cy = obs_source_get_height(source);
+	gs_texture_t *tex;
+
+	if (!cx || !cy) {
+		render_video(source);
+		return;
+	}
+
+	if (source->render_cache_frame != video->render_frame ||
+	    !source->render_cache_texrender) {
+		render_cache_update(source, cx, cy);
+	} else {
+		video->render_cache_hits++;
+		video->render_cache_total_hits++;
+	}
+
+	tex = gs_texrender_get_texture(source->render_cache_texrender);
+	if (!tex)
+		return;
+
+	gs_blend_state_push();
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+	render_filter_tex(tex, video->default_effect, cx, cy, "Draw");
+	gs_blend_state_pop();
+}
+
 void obs_source_video_render(obs_source_t *source)
 {
 	if (!obs_source_valid(source, "obs_source_video_render"))
 		return;
 
 	obs_source_addref(source);
-	render_video(source);
+	if (use_render_cache(source))
+		render_video_cached(source);
+	else
+		render_video(source);
 	obs_source_release(source);
 }
 
@@ -2387,6 +2683,8 @@ void obs_source_filter_add(obs_source_t *source, obs_source_t *filter)
 
 	pthread_mutex_unlock(&source->filter_mutex);
 
+	obs_source_mark_dirty(source);
+
 	calldata_init_fixed(&cd, stack, sizeof(stack));
 	calldata_set_ptr(&cd, "source", source);
 	calldata_set_ptr(&cd, "filter", filter);
@@ -2421,6 +2719,8 @@ static bool obs_source_filter_remove_refless(obs_source_t *source,
 
 	pthread_mutex_unlock(&source->filter_mutex);
 
+	obs_source_mark_dirty(source);
+
 	calldata_init_fixed(&cd, stack, sizeof(stack));
 	calldata_set_ptr(&cd, "source", source);
 	calldata_set_ptr(&cd, "filter", filter);
@@ -2548,8 +2848,10 @@ void obs_source_filter_set_order(obs_source_t *source, obs_source_t *filter,
 	success = move_filter_dir(source, filter, movement);
 	pthread_mutex_unlock(&source->filter_mutex);
 
-	if (success)
+	if (success) {
+		obs_source_mark_dirty(source);
 		obs_source_dosignal(source, NULL, "reorder_filters");
+	}
 }
 
 obs_data_t *obs_source_get_settings(const obs_source_t *source)
@@ -2575,8 +2877,10 @@ struct obs_source_frame *filter_async_video(obs_source_t *source,
 			continue;
 
 		if (filter->context.data && filter->info.filter_video) {
+			const char *prev_tag = bmem_set_tag(filter->info.id);
 			in = filter->info.filter_video(filter->context.data,
 						       in);
+			bmem_set_tag(prev_tag);
 			if (!in)
 				break;
 		}
@@ -2684,10 +2988,10 @@ void obs_source_frame_copy(struct obs_source_frame *dst,
 static inline bool async_texture_changed(struct obs_source *source,
 					 const struct obs_source_frame *frame)
 {
-	enum convert_type prev, cur;
-	prev = get_convert_type(source->async_cache_format,
-				source->async_cache_full_range);
-	cur = get_convert_type(frame->format, frame->full_range);
+	const struct async_convert *prev, *cur;
+	prev = get_async_convert(source->async_cache_format,
+				 source->async_cache_full_range);
+	cur = get_async_convert(frame->format, frame->full_range);
 
 	return source->async_cache_width != frame->width ||
 	       source->async_cache_height != frame->height || prev != cur;
@@ -2706,15 +3010,16 @@ static inline void free_async_cache(struct obs_source *source)
 
 #define MAX_UNUSED_FRAME_DURATION 5
 
-/* frees frame allocations if they haven't been used for a specific period
- * of time */
+/* returns frames to the frame pool if they haven't been used for a specific
+ * period of time */
 static void clean_cache(obs_source_t *source)
 {
 	for (size_t i = source->async_cache.num; i > 0; i--) {
 		struct async_frame *af = &source->async_cache.array[i - 1];
 		if (!af->used) {
 			if (++af->unused_count == MAX_UNUSED_FRAME_DURATION) {
-				obs_source_frame_destroy(af->frame);
+				obs_frame_pool_put(&obs->data.frame_pool,
+						   af->frame);
 				da_erase(source->async_cache, i - 1);
 			}
 		}
@@ -2722,6 +3027,16 @@ static void clean_cache(obs_source_t *source)
 }
 
 #define MAX_ASYNC_FRAMES 30
+
+static inline void drop_oldest_async_frame(obs_source_t *source)
+{
+	struct obs_source_frame *frame = source->async_frames.array[0];
+
+	da_erase(source->async_frames, 0);
+	remove_async_frame(source, frame);
+	source->async_frames_dropped++;
+}
+
 //if return value is not null then do (os_atomic_dec_long(&output->refs) == 0) && obs_source_frame_destroy(output)
 static inline struct obs_source_frame *
 cache_video(struct obs_source *source, const struct obs_source_frame *frame)
@@ -2730,11 +3045,21 @@ cache_video(struct obs_source *source, const struct obs_source_frame *frame)
 
 	pthread_mutex_lock(&source->async_mutex);
 
+	source->async_frames_received++;
+
 	if (source->async_frames.num >= MAX_ASYNC_FRAMES) {
-		free_async_cache(source);
-		source->last_frame_ts = 0;
-		pthread_mutex_unlock(&source->async_mutex);
-		return NULL;
+		if (source->async_policy == OBS_ASYNC_FRAME_POLICY_SMOOTH) {
+			source->async_frames_dropped +=
+				source->async_frames.num + 1;
+			free_async_cache(source);
+			source->last_frame_ts = 0;
+			pthread_mutex_unlock(&source->async_mutex);
+			return NULL;
+		}
+
+		/* the other policies favor latency, so rather than starting
+		 * over, only drop the oldest frame to make room */
+		drop_oldest_async_frame(source);
 	}
 
 	if (async_texture_changed(source, frame)) {
@@ -2752,6 +3077,7 @@ cache_video(struct obs_source *source, const struct obs_source_frame *frame)
 		if (!af->used) {
 			new_frame = af->frame;
 			new_frame->format = format;
+			af->received_time = os_gettime_ns();
 			af->used = true;
 			af->unused_count = 0;
 			break;
@@ -2763,9 +3089,10 @@ cache_video(struct obs_source *source, const struct obs_source_frame *frame)
 	if (!new_frame) {
 		struct async_frame new_af;
 
-		new_frame = obs_source_frame_create(format, frame->width,
-						    frame->height);
+		new_frame = obs_frame_pool_get(&obs->data.frame_pool, format,
+					       frame->width, frame->height);
 		new_af.frame = new_frame;
+		new_af.received_time = os_gettime_ns();
 		new_af.used = true;
 		new_af.unused_count = 0;
 		new_frame->refs = 1;
@@ -2801,7 +3128,7 @@ obs_source_output_video_internal(obs_source_t *source,
 	pthread_mutex_lock(&source->async_mutex);
 	if (output) {
 		if (os_atomic_dec_long(&output->refs) == 0) {
-			obs_source_frame_destroy(output);
+			obs_frame_pool_put(&obs->data.frame_pool, output);
 			output = NULL;
 		} else {
 			da_push_back(source->async_frames, &output);
@@ -2809,6 +3136,9 @@ obs_source_output_video_internal(obs_source_t *source,
 		}
 	}
 	pthread_mutex_unlock(&source->async_mutex);
+
+	if (output)
+		obs_source_tick_list_add(source);
 }
 
 void obs_source_output_video(obs_source_t *source,
@@ -2982,8 +3312,10 @@ filter_async_audio(obs_source_t *source, struct obs_audio_data *in)
 			continue;
 
 		if (filter->context.data && filter->info.filter_audio) {
+			const char *prev_tag = bmem_set_tag(filter->info.id);
 			in = filter->info.filter_audio(filter->context.data,
 						       in);
+			bmem_set_tag(prev_tag);
 			if (!in)
 				return NULL;
 		}
@@ -3204,10 +3536,10 @@ static bool ready_async_frame(obs_source_t *source, uint64_t sys_time)
 	uint64_t frame_time = next_frame->timestamp;
 	uint64_t frame_offset = 0;
 
-	if (source->async_unbuffered) {
+	if (source->async_unbuffered ||
+	    source->async_policy == OBS_ASYNC_FRAME_POLICY_LATEST) {
 		while (source->async_frames.num > 1) {
-			da_erase(source->async_frames, 0);
-			remove_async_frame(source, next_frame);
+			drop_oldest_async_frame(source);
 			next_frame = source->async_frames.array[0];
 		}
 
@@ -3246,8 +3578,10 @@ static bool ready_async_frame(obs_source_t *source, uint64_t sys_time)
 		if ((source->last_frame_ts - next_frame->timestamp) < 2000000)
 			break;
 
-		if (frame)
+		if (frame) {
 			da_erase(source->async_frames, 0);
+			source->async_frames_dropped++;
+		}
 
 #if DEBUG_ASYNC_FRAMES
 		blog(LOG_DEBUG,
@@ -3286,12 +3620,62 @@ static bool ready_async_frame(obs_source_t *source, uint64_t sys_time)
 	return frame != NULL;
 }
 
+static uint64_t get_received_time(obs_source_t *source,
+				  const struct obs_source_frame *frame)
+{
+	for (size_t i = 0; i < source->async_cache.num; i++) {
+		struct async_frame *af = &source->async_cache.array[i];
+		if (af->frame == frame)
+			return af->received_time;
+	}
+
+	return 0;
+}
+
+static void count_rendered_frame(obs_source_t *source,
+				 const struct obs_source_frame *frame)
+{
+	uint64_t received_time = get_received_time(source, frame);
+	uint64_t cur_time = os_gettime_ns();
+
+	source->async_frames_rendered++;
+	if (received_time && cur_time > received_time)
+		source->async_total_age += cur_time - received_time;
+}
+
+/* drops frames that have been waiting longer than the target latency, but
+ * always leaves the newest frame so there's something to render */
+static void drop_late_async_frames(obs_source_t *source)
+{
+	uint64_t cur_time = os_gettime_ns();
+	bool dropped = false;
+
+	while (source->async_frames.num > 1) {
+		struct obs_source_frame *frame = source->async_frames.array[0];
+		uint64_t received_time = get_received_time(source, frame);
+
+		if (!received_time ||
+		    cur_time - received_time <= source->async_target_latency)
+			break;
+
+		drop_oldest_async_frame(source);
+		dropped = true;
+	}
+
+	/* resync timing to the frame that's now first in line */
+	if (dropped)
+		source->last_frame_ts = 0;
+}
+
 static inline struct obs_source_frame *get_closest_frame(obs_source_t *source,
 							 uint64_t sys_time)
 {
 	if (!source->async_frames.num)
 		return NULL;
 
+	if (source->async_policy == OBS_ASYNC_FRAME_POLICY_BOUNDED)
+		drop_late_async_frames(source);
+
 	if (!source->last_frame_ts || ready_async_frame(source, sys_time)) {
 		struct obs_source_frame *frame = source->async_frames.array[0];
 		da_erase(source->async_frames, 0);
@@ -3344,7 +3728,7 @@ void obs_source_release_frame(obs_source_t *source,
 		pthread_mutex_lock(&source->async_mutex);
 
 		if (os_atomic_dec_long(&frame->refs) == 0)
-			obs_source_frame_destroy(frame);
+			obs_frame_pool_put(&obs->data.frame_pool, frame);
 		else
 			remove_async_frame(source, frame);
 
@@ -3369,6 +3753,7 @@ void obs_source_set_name(obs_source_t *source, const char *name)
 		struct calldata data;
 		char *prev_name = bstrdup(source->context.name);
 		obs_context_data_setname(&source->context, name);
+		obs_source_mark_dirty(source);
 
 		calldata_init(&data);
 		calldata_set_ptr(&data, "source", source);
@@ -3448,30 +3833,31 @@ static inline bool can_bypass(obs_source_t *target, obs_source_t *parent,
 	       ((parent_flags & OBS_SOURCE_ASYNC) == 0);
 }
 
-bool obs_source_process_filter_begin(obs_source_t *filter,
-				     enum gs_color_format format,
-				     enum obs_allow_direct_render allow_direct)
+static inline void count_filter_pass(obs_source_t *parent)
 {
-	obs_source_t *target, *parent;
-	uint32_t parent_flags;
-	int cx, cy;
+	struct obs_core_video *video = &obs->video;
+	uint64_t frame = video->render_frame;
 
-	if (!obs_ptr_valid(filter, "obs_source_process_filter_begin"))
-		return false;
+	if (parent->filter_pass_frame != frame) {
+		parent->last_filter_passes =
+			(parent->filter_pass_frame + 1 == frame)
+				? parent->filter_passes
+				: 0;
+		parent->filter_passes = 0;
+		parent->filter_pass_frame = frame;
+	}
 
-	target = obs_filter_get_target(filter);
-	parent = obs_filter_get_parent(filter);
+	parent->filter_passes++;
+	video->filter_passes++;
+}
 
-	if (!target) {
-		blog(LOG_INFO, "filter '%s' being processed with no target!",
-		     filter->context.name);
-		return false;
-	}
-	if (!parent) {
-		blog(LOG_INFO, "filter '%s' being processed with no parent!",
-		     filter->context.name);
-		return false;
-	}
+static bool process_filter_begin(obs_source_t *filter, obs_source_t *target,
+				 obs_source_t *parent,
+				 enum gs_color_format format,
+				 enum obs_allow_direct_render allow_direct)
+{
+	uint32_t parent_flags;
+	int cx, cy;
 
 	parent_flags = parent->info.output_flags;
 	cx = get_base_width(target);
@@ -3514,30 +3900,47 @@ bool obs_source_process_filter_begin(obs_source_t *filter,
 			obs_source_video_render(target);
 
 		gs_texrender_end(filter->filter_texrender);
+		count_filter_pass(parent);
 	}
 
 	gs_blend_state_pop();
 	return true;
 }
 
-void obs_source_process_filter_tech_end(obs_source_t *filter,
-					gs_effect_t *effect, uint32_t width,
-					uint32_t height, const char *tech_name)
+bool obs_source_process_filter_begin(obs_source_t *filter,
+				     enum gs_color_format format,
+				     enum obs_allow_direct_render allow_direct)
 {
 	obs_source_t *target, *parent;
-	gs_texture_t *texture;
-	uint32_t parent_flags;
 
-	if (!filter)
-		return;
+	if (!obs_ptr_valid(filter, "obs_source_process_filter_begin"))
+		return false;
 
 	target = obs_filter_get_target(filter);
 	parent = obs_filter_get_parent(filter);
 
-	if (!target || !parent)
-		return;
+	if (!target) {
+		blog(LOG_INFO, "filter '%s' being processed with no target!",
+		     filter->context.name);
+		return false;
+	}
+	if (!parent) {
+		blog(LOG_INFO, "filter '%s' being processed with no parent!",
+		     filter->context.name);
+		return false;
+	}
 
-	parent_flags = parent->info.output_flags;
+	return process_filter_begin(filter, target, parent, format,
+				    allow_direct);
+}
+
+static void process_filter_end(obs_source_t *filter, obs_source_t *target,
+			       obs_source_t *parent, gs_effect_t *effect,
+			       uint32_t width, uint32_t height,
+			       const char *tech_name)
+{
+	uint32_t parent_flags = parent->info.output_flags;
+	gs_texture_t *texture;
 
 	const char *tech = tech_name ? tech_name : "Draw";
 
@@ -3551,6 +3954,25 @@ void obs_source_process_filter_tech_end(obs_source_t *filter,
 	}
 }
 
+void obs_source_process_filter_tech_end(obs_source_t *filter,
+					gs_effect_t *effect, uint32_t width,
+					uint32_t height, const char *tech_name)
+{
+	obs_source_t *target, *parent;
+
+	if (!filter)
+		return;
+
+	target = obs_filter_get_target(filter);
+	parent = obs_filter_get_parent(filter);
+
+	if (!target || !parent)
+		return;
+
+	process_filter_end(filter, target, parent, effect, width, height,
+			   tech_name);
+}
+
 void obs_source_process_filter_end(obs_source_t *filter, gs_effect_t *effect,
 				   uint32_t width, uint32_t height)
 {
@@ -3561,6 +3983,243 @@ void obs_source_process_filter_end(obs_source_t *filter, gs_effect_t *effect,
 					   "Draw");
 }
 
+/* ------------------------------------------------------------------------- */
+/* fused filters                                                             */
+
+/*
+ * Consecutive filters that provide a per-pixel shader stage are combined into
+ * a single generated effect, so the whole run of filters takes one pass
+ * instead of one render to texture per filter.  Each stage's identifiers are
+ * prefixed with '$', which is replaced with a per-stage prefix.
+ */
+
+static const char *fused_effect_header =
+	"uniform float4x4 ViewProj;\n"
+	"uniform texture2d image;\n"
+	"\n"
+	"sampler_state fused_sampler {\n"
+	"\tFilter   = Linear;\n"
+	"\tAddressU = Clamp;\n"
+	"\tAddressV = Clamp;\n"
+	"};\n"
+	"\n"
+	"struct VertData {\n"
+	"\tfloat4 pos : POSITION;\n"
+	"\tfloat2 uv  : TEXCOORD0;\n"
+	"};\n"
+	"\n"
+	"VertData VSDefault(VertData v_in)\n"
+	"{\n"
+	"\tVertData vert_out;\n"
+	"\tvert_out.pos = mul(float4(v_in.pos.xyz, 1.0), ViewProj);\n"
+	"\tvert_out.uv  = v_in.uv;\n"
+	"\treturn vert_out;\n"
+	"}\n";
+
+static const char *fused_effect_footer =
+	"\treturn rgba;\n"
+	"}\n"
+	"\n"
+	"technique Draw\n"
+	"{\n"
+	"\tpass\n"
+	"\t{\n"
+	"\t\tvertex_shader = VSDefault(v_in);\n"
+	"\t\tpixel_shader  = PSFused(v_in);\n"
+	"\t}\n"
+	"}\n";
+
+static inline void get_stage_prefix(struct dstr *prefix, size_t idx)
+{
+	dstr_printf(prefix, "s%d_", (int)idx);
+}
+
+static char *generate_fused_effect(const obs_source_t *filter)
+{
+	struct dstr effect = {0};
+	struct dstr stage = {0};
+	struct dstr prefix = {0};
+	size_t num = filter->fused_code.num;
+
+	dstr_copy(&effect, fused_effect_header);
+
+	for (size_t i = 0; i < num; i++) {
+		get_stage_prefix(&prefix, i);
+		dstr_copy(&stage, filter->fused_code.array[i]);
+		dstr_replace(&stage, "$", prefix.array);
+
+		dstr_cat(&effect, "\n");
+		dstr_cat_dstr(&effect, &stage);
+	}
+
+	dstr_cat(&effect, "\nfloat4 PSFused(VertData v_in) : TARGET\n{\n"
+			  "\tfloat4 rgba = image.Sample(fused_sampler, "
+			  "v_in.uv);\n");
+
+	/* stages are stored from the last filter to the first, the first
+	 * filter (closest to the source) is applied first */
+	for (size_t i = num; i > 0; i--) {
+		get_stage_prefix(&prefix, i - 1);
+		dstr_catf(&effect, "\trgba = %sstage(rgba);\n", prefix.array);
+	}
+
+	dstr_cat(&effect, fused_effect_footer);
+
+	dstr_free(&stage);
+	dstr_free(&prefix);
+	return effect.array;
+}
+
+static inline const char *get_fused_stage(obs_source_t *filter)
+{
+	if (!filter->context.data || !filter->info.video_get_fused_stage ||
+	    !filter->info.video_set_fused_params)
+		return NULL;
+
+	return filter->info.video_get_fused_stage(filter->context.data);
+}
+
+static bool fused_code_changed(obs_source_t *filter, const char **code,
+			       size_t num)
+{
+	if (filter->fused_code.num != num)
+		return true;
+
+	return memcmp(filter->fused_code.array, code,
+		      num * sizeof(const char *)) != 0;
+}
+
+static void update_fused_effect(obs_source_t *filter, const char **code,
+				size_t num)
+{
+	char *effect_string;
+	char *errors = NULL;
+
+	gs_effect_destroy(filter->fused_effect);
+	da_copy_array(filter->fused_code, code, num);
+
+	effect_string = generate_fused_effect(filter);
+	filter->fused_effect =
+		gs_effect_create(effect_string, "fused_filters", &errors);
+
+	if (!filter->fused_effect)
+		blog(LOG_WARNING,
+		     "Failed to create fused effect for filter '%s', "
+		     "filters will be rendered separately: %s",
+		     filter->context.name, errors ? errors : "(null)");
+
+	bfree(effect_string);
+	bfree(errors);
+}
+
+/* finds the run of fusible filters starting at this filter, and makes sure
+ * the effect for that run is up to date.  the run must be at least two
+ * filters long, otherwise there's nothing to gain */
+static bool collect_fused_stages(obs_source_t *filter)
+{
+	DARRAY(const char *) code;
+	obs_source_t *parent = filter->filter_parent;
+	obs_source_t *cur = filter;
+	bool success;
+
+	if (!parent || !get_fused_stage(filter))
+		return false;
+
+	da_init(code);
+	da_resize(filter->fused_stages, 0);
+
+	while (cur && cur != parent) {
+		const char *stage;
+
+		/* disabled filters are skipped anyway */
+		if (!cur->enabled) {
+			cur = cur->filter_target;
+			continue;
+		}
+
+		stage = get_fused_stage(cur);
+		if (!stage)
+			break;
+
+		da_push_back(filter->fused_stages, &cur);
+		da_push_back(code, &stage);
+		cur = cur->filter_target;
+	}
+
+	if (filter->fused_stages.num < 2) {
+		da_free(code);
+		return false;
+	}
+
+	if (fused_code_changed(filter, code.array, code.num))
+		update_fused_effect(filter, code.array, code.num);
+
+	success = filter->fused_effect != NULL;
+	da_free(code);
+	return success;
+}
+
+static void render_fused_filters(obs_source_t *filter)
+{
+	obs_source_t *parent = filter->filter_parent;
+	size_t num = filter->fused_stages.num;
+	obs_source_t *last = filter->fused_stages.array[num - 1];
+	obs_source_t *target = last->filter_target;
+	gs_effect_t *effect = filter->fused_effect;
+
+	if (!process_filter_begin(filter, target, parent, GS_RGBA,
+				  OBS_ALLOW_DIRECT_RENDERING))
+		return;
+
+	for (size_t i = 0; i < num; i++) {
+		obs_source_t *stage = filter->fused_stages.array[i];
+
+		stage->fused_params_effect = effect;
+		stage->fused_stage_idx = i;
+		stage->info.video_set_fused_params(stage->context.data);
+		stage->fused_params_effect = NULL;
+	}
+
+	process_filter_end(filter, target, parent, effect, 0, 0, "Draw");
+}
+
+gs_eparam_t *obs_filter_get_fused_param(obs_source_t *filter,
+					const char *name)
+{
+	struct dstr param_name = {0};
+	gs_eparam_t *param;
+
+	if (!obs_ptr_valid(filter, "obs_filter_get_fused_param"))
+		return NULL;
+	if (!filter->fused_params_effect)
+		return NULL;
+
+	get_stage_prefix(&param_name, filter->fused_stage_idx);
+	dstr_cat(&param_name, name);
+	param = gs_effect_get_param_by_name(filter->fused_params_effect,
+					    param_name.array);
+	dstr_free(&param_name);
+	return param;
+}
+
+uint32_t obs_source_get_filter_passes(const obs_source_t *source)
+{
+	uint64_t frame;
+
+	if (!obs_source_valid(source, "obs_source_get_filter_passes"))
+		return 0;
+
+	/* the count is only valid if the source was rendered last frame */
+	frame = obs->video.render_frame;
+	if (source->filter_pass_frame + 1 == frame)
+		return source->filter_passes;
+	if (source->filter_pass_frame == frame)
+		return source->last_filter_passes;
+	return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
 void obs_source_skip_video_filter(obs_source_t *filter)
 {
 	obs_source_t *target, *parent;
@@ -3631,6 +4290,7 @@ void obs_source_set_volume(obs_source_t *source, float volume)
 		pthread_mutex_unlock(&source->audio_actions_mutex);
 
 		source->user_volume = volume;
+		obs_source_mark_dirty(source);
 	}
 }
 
@@ -3655,6 +4315,7 @@ void obs_source_set_sync_offset(obs_source_t *source, int64_t offset)
 				      &data);
 
 		source->sync_offset = calldata_int(&data, "offset");
+		obs_source_mark_dirty(source);
 	}
 }
 
@@ -3910,6 +4571,7 @@ void obs_source_set_flags(obs_source_t *source, uint32_t flags)
 
 	if (flags != source->flags) {
 		source->flags = flags;
+		obs_source_mark_dirty(source);
 		signal_flags_updated(source);
 	}
 }
@@ -3950,6 +4612,7 @@ void obs_source_set_audio_mixers(obs_source_t *source, uint32_t mixers)
 	mixers = (uint32_t)calldata_int(&data, "mixers");
 
 	source->audio_mixers = mixers;
+	obs_source_mark_dirty(source);
 }
 
 uint32_t obs_source_get_audio_mixers(const obs_source_t *source)
@@ -4112,6 +4775,7 @@ void obs_source_set_enabled(obs_source_t *source, bool enabled)
 		return;
 
 	source->enabled = enabled;
+	obs_source_mark_dirty(source);
 
 	calldata_init_fixed(&data, stack, sizeof(stack));
 	calldata_set_ptr(&data, "source", source);
@@ -4138,6 +4802,7 @@ void obs_source_set_muted(obs_source_t *source, bool muted)
 		return;
 
 	source->user_muted = muted;
+	obs_source_mark_dirty(source);
 
 	calldata_init_fixed(&data, stack, sizeof(stack));
 	calldata_set_ptr(&data, "source", source);
@@ -4202,6 +4867,7 @@ void obs_source_enable_push_to_mute(obs_source_t *source, bool enabled)
 		     enabled ? "enabled" : "disabled");
 
 	source->push_to_mute_enabled = enabled;
+	obs_source_mark_dirty(source);
 
 	if (changed)
 		source_signal_push_to_changed(source, "push_to_mute_changed",
@@ -4229,6 +4895,7 @@ void obs_source_set_push_to_mute_delay(obs_source_t *source, uint64_t delay)
 
 	pthread_mutex_lock(&source->audio_mutex);
 	source->push_to_mute_delay = delay;
+	obs_source_mark_dirty(source);
 
 	source_signal_push_to_delay(source, "push_to_mute_delay", delay);
 	pthread_mutex_unlock(&source->audio_mutex);
@@ -4260,6 +4927,7 @@ void obs_source_enable_push_to_talk(obs_source_t *source, bool enabled)
 		     enabled ? "enabled" : "disabled");
 
 	source->push_to_talk_enabled = enabled;
+	obs_source_mark_dirty(source);
 
 	if (changed)
 		source_signal_push_to_changed(source, "push_to_talk_changed",
@@ -4287,6 +4955,7 @@ void obs_source_set_push_to_talk_delay(obs_source_t *source, uint64_t delay)
 
 	pthread_mutex_lock(&source->audio_mutex);
 	source->push_to_talk_delay = delay;
+	obs_source_mark_dirty(source);
 
 	source_signal_push_to_delay(source, "push_to_talk_delay", delay);
 	pthread_mutex_unlock(&source->audio_mutex);
@@ -4464,6 +5133,7 @@ static void custom_audio_render(obs_source_t *source, uint32_t mixers,
 				size_t channels, size_t sample_rate)
 {
 	struct obs_source_audio_mix audio_data;
+	const char *prev_tag;
 	bool success;
 	uint64_t ts;
 
@@ -4479,9 +5149,11 @@ static void custom_audio_render(obs_source_t *source, uint32_t mixers,
 		}
 	}
 
+	prev_tag = bmem_set_tag(source->info.id);
 	success = source->info.audio_render(source->context.data, &ts,
 					    &audio_data, mixers, channels,
 					    sample_rate);
+	bmem_set_tag(prev_tag);
 	source->audio_ts = success ? ts : 0;
 	source->audio_pending = !success;
 
@@ -4705,6 +5377,7 @@ void obs_source_set_monitoring_type(obs_source_t *source,
 	}
 
 	source->monitoring_type = type;
+	obs_source_mark_dirty(source);
 }
 
 enum obs_monitoring_type
@@ -4723,6 +5396,21 @@ void obs_source_set_async_unbuffered(obs_source_t *source, bool unbuffered)
 	source->async_unbuffered = unbuffered;
 }
 
+void obs_source_set_render_cache(obs_source_t *source, bool enable)
+{
+	if (!obs_source_valid(source, "obs_source_set_render_cache"))
+		return;
+
+	source->render_cache = enable;
+}
+
+bool obs_source_render_cache_enabled(const obs_source_t *source)
+{
+	return obs_source_valid(source, "obs_source_render_cache_enabled")
+		       ? source->render_cache
+		       : false;
+}
+
 bool obs_source_async_unbuffered(const obs_source_t *source)
 {
 	return obs_source_valid(source, "obs_source_async_unbuffered")
@@ -4730,6 +5418,149 @@ bool obs_source_async_unbuffered(const obs_source_t *source)
 		       : false;
 }
 
+void obs_source_set_async_frame_policy(obs_source_t *source,
+				       enum obs_async_frame_policy policy,
+				       uint32_t target_ms)
+{
+	struct calldata data;
+	uint8_t stack[128];
+	bool changed;
+
+	if (!obs_source_valid(source, "obs_source_set_async_frame_policy"))
+		return;
+
+	if (policy != OBS_ASYNC_FRAME_POLICY_LATEST &&
+	    policy != OBS_ASYNC_FRAME_POLICY_BOUNDED)
+		policy = OBS_ASYNC_FRAME_POLICY_SMOOTH;
+
+	pthread_mutex_lock(&source->async_mutex);
+	changed = source->async_policy != policy ||
+		  source->async_target_latency != target_ms * 1000000ULL;
+	source->async_policy = policy;
+	source->async_target_latency = target_ms * 1000000ULL;
+	pthread_mutex_unlock(&source->async_mutex);
+
+	if (!changed)
+		return;
+
+	calldata_init_fixed(&data, stack, sizeof(stack));
+	calldata_set_ptr(&data, "source", source);
+	calldata_set_int(&data, "policy", policy);
+	calldata_set_int(&data, "target_ms", target_ms);
+	signal_handler_signal(source->context.signals, "async_frame_policy",
+			      &data);
+
+	obs_source_mark_dirty(source);
+}
+
+enum obs_async_frame_policy
+obs_source_get_async_frame_policy(const obs_source_t *source,
+				  uint32_t *target_ms)
+{
+	if (!obs_source_valid(source, "obs_source_get_async_frame_policy")) {
+		if (target_ms)
+			*target_ms = 0;
+		return OBS_ASYNC_FRAME_POLICY_SMOOTH;
+	}
+
+	if (target_ms)
+		*target_ms = (uint32_t)(source->async_target_latency / 1000000);
+	return source->async_policy;
+}
+
+void obs_source_get_async_stats(obs_source_t *source,
+				struct obs_source_async_stats *stats)
+{
+	if (!stats)
+		return;
+
+	memset(stats, 0, sizeof(*stats));
+
+	if (!obs_source_valid(source, "obs_source_get_async_stats"))
+		return;
+
+	pthread_mutex_lock(&source->async_mutex);
+	stats->queue_depth = (uint32_t)source->async_frames.num;
+	stats->frames_received = source->async_frames_received;
+	stats->frames_rendered = source->async_frames_rendered;
+	stats->frames_dropped = source->async_frames_dropped;
+	stats->frames_duplicated = source->async_frames_duplicated;
+	if (source->async_frames_rendered)
+		stats->average_age_ns = source->async_total_age /
+					source->async_frames_rendered;
+	pthread_mutex_unlock(&source->async_mutex);
+}
+
+void obs_source_reset_async_stats(obs_source_t *source)
+{
+	if (!obs_source_valid(source, "obs_source_reset_async_stats"))
+		return;
+
+	pthread_mutex_lock(&source->async_mutex);
+	source->async_frames_received = 0;
+	source->async_frames_rendered = 0;
+	source->async_frames_dropped = 0;
+	source->async_frames_duplicated = 0;
+	source->async_total_age = 0;
+	pthread_mutex_unlock(&source->async_mutex);
+}
+
+void obs_source_mark_dirty(obs_source_t *source)
+{
+	long serial = os_atomic_inc_long(&obs->data.save_serial);
+	os_atomic_set_long(&source->save_serial, serial);
+
+	/* filters are saved as part of their parent */
+	if (source->filter_parent)
+		obs_source_mark_dirty(source->filter_parent);
+}
+
+static inline long get_settings_change_serial(const obs_source_t *source)
+{
+	long serial = obs_data_get_change_serial(source->context.settings);
+	long private_serial =
+		obs_data_get_change_serial(source->private_settings);
+	return private_serial > serial ? private_serial : serial;
+}
+
+long obs_source_get_save_serial(const obs_source_t *source)
+{
+	obs_source_t *s = (obs_source_t *)source;
+	long serial, last;
+
+	if (!obs_source_valid(source, "obs_source_get_save_serial"))
+		return 0;
+
+	/* settings (of the source, and of its filters and scene items, which
+	 * are saved with it) can also be changed in place through the data
+	 * returned by the getters, so check whether they changed since the
+	 * last time */
+	serial = get_settings_change_serial(s);
+
+	if (s->info.type == OBS_SOURCE_TYPE_SCENE) {
+		long items_serial = obs_scene_get_items_change_serial(s);
+		if (items_serial > serial)
+			serial = items_serial;
+	}
+
+	pthread_mutex_lock(&s->filter_mutex);
+	for (size_t i = 0; i < s->filters.num; i++) {
+		long filter_serial =
+			get_settings_change_serial(s->filters.array[i]);
+		if (filter_serial > serial)
+			serial = filter_serial;
+	}
+	pthread_mutex_unlock(&s->filter_mutex);
+
+	last = os_atomic_load_long(&s->settings_change_serial);
+	if (serial != last &&
+	    os_atomic_compare_swap_long(&s->settings_change_serial, last,
+					serial))
+		obs_source_mark_dirty(s);
+
+	return os_atomic_load_long(&s->save_serial);
+}
+
 obs_data_t *obs_source_get_private_settings(obs_source_t *source)
 {
 	if (!obs_ptr_valid(source, "obs_source_get_private_settings"))
@@ -4787,6 +5618,7 @@ void obs_source_set_balance_value(obs_source_t *source, float balance)
 		return;
 
 	source->balance = balance;
+	obs_source_mark_dirty(source);
 }
 
 float obs_source_get_balance_value(const obs_source_t *source)
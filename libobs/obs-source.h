@@ -186,6 +186,37 @@ enum obs_media_state {
  */
 #define OBS_SOURCE_CONTROLLABLE_MEDIA (1 << 13)
 
+/**
+ * Source only needs video_tick while it is showing or active
+ *
+ * By default every source with a video_tick callback is ticked each frame
+ * whether it is in use or not.  When this is used, the source is skipped
+ * while it is hidden and inactive, and only ticked again once it is shown.
+ */
+#define OBS_SOURCE_SKIP_HIDDEN_TICK (1 << 14)
+
+/**
+ * Source's properties only change when it calls obs_source_update_properties
+ *
+ * Properties of sources with this flag are created once and copied for every
+ * call to obs_source_properties until the source calls
+ * obs_source_update_properties (for example when a device is added or
+ * removed).  Use this for sources with expensive get_properties callbacks.
+ * Modified callbacks still run on each copy, and only when the settings have
+ * changed.  The properties param is shared by every copy.
+ */
+#define OBS_SOURCE_CACHE_PROPERTIES (1 << 15)
+
+/**
+ * Source's video only changes when its settings do, or occasionally (for
+ * example when a file it displays is modified)
+ *
+ * Lets previews of the source redraw only when its settings change and
+ * otherwise at a low rate, instead of every frame.  Do not use this for
+ * sources with animated or captured video.
+ */
+#define OBS_SOURCE_STATIC_VIDEO (1 << 16)
+
 /** @} */
 
 typedef void (*obs_source_enum_proc_t)(obs_source_t *parent,
@@ -527,6 +558,29 @@ struct obs_source_info {
 	/* version-related stuff */
 	uint32_t version; /* increment if needed to specify a new version */
 	const char *unversioned_id; /* set internally, don't set manually */
+
+	/**
+	 * Returns a shader stage for a per-pixel video filter, so that it can
+	 * be combined with other consecutive fusible filters into a single
+	 * pass.  Return NULL if the filter currently can't be fused.
+	 *
+	 * The stage must define a "float4 $stage(float4 rgba)" function,
+	 * which returns the filtered color.  Every global identifier of the
+	 * stage (uniforms, functions, samplers) must start with '$'.  The
+	 * string must stay valid and unchanged for as long as it's returned.
+	 *
+	 * @param  data  Filter data
+	 * @return       Shader stage, or NULL
+	 */
+	const char *(*video_get_fused_stage)(void *data);
+
+	/**
+	 * Sets the parameters of the filter's fused stage.  Get the
+	 * parameters with obs_filter_get_fused_param, without the '$'.
+	 *
+	 * @param  data  Filter data
+	 */
+	void (*video_set_fused_params)(void *data);
 };
 
 EXPORT void obs_register_source_s(const struct obs_source_info *info,
@@ -59,29 +59,46 @@ static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 	/* ------------------------------------- */
 	/* call the tick function of each source */
 
-	pthread_mutex_lock(&data->sources_mutex);
+	pthread_mutex_lock(&data->tick_sources_mutex);
 
-	source = data->first_source;
-	while (source) {
-		struct obs_source *cur_source = obs_source_get_ref(source);
-		source = (struct obs_source *)source->context.next;
+	da_resize(data->tick_sources_cur, 0);
+	for (size_t i = 0; i < data->tick_sources.num; i++) {
+		source = obs_source_get_ref(data->tick_sources.array[i]);
+		if (source)
+			da_push_back(data->tick_sources_cur, &source);
+	}
 
-		if (cur_source) {
-			obs_source_video_tick(cur_source, seconds);
-			obs_source_release(cur_source);
-		}
+	pthread_mutex_unlock(&data->tick_sources_mutex);
+
+	for (size_t i = 0; i < data->tick_sources_cur.num; i++)
+		obs_source_video_tick(data->tick_sources_cur.array[i], seconds);
+
+	/* drop sources that have gone idle, they are re-added to the tick
+	 * list when they are shown, activated or receive a new frame */
+	pthread_mutex_lock(&data->tick_sources_mutex);
+
+	for (size_t i = 0; i < data->tick_sources_cur.num; i++) {
+		source = data->tick_sources_cur.array[i];
+		if (!obs_source_needs_tick(source))
+			obs_source_tick_list_remove(source);
 	}
 
-	pthread_mutex_unlock(&data->sources_mutex);
+	pthread_mutex_unlock(&data->tick_sources_mutex);
+
+	for (size_t i = 0; i < data->tick_sources_cur.num; i++)
+		obs_source_release(data->tick_sources_cur.array[i]);
+
+	obs_frame_pool_trim(&data->frame_pool, cur_time);
 
 	return cur_time;
 }
 
 /* in obs-display.c */
-extern void render_display(struct obs_display *display);
+extern void render_display(struct obs_display *display, uint64_t frame_time);
 
 static inline void render_displays(void)
 {
+	uint64_t frame_time = obs->video.video_time;
 	struct obs_display *display;
 
 	if (!obs->data.valid)
@@ -94,7 +111,7 @@ static inline void render_displays(void)
 
 	display = obs->data.first_display;
 	while (display) {
-		render_display(display);
+		render_display(display, frame_time);
 		display = display->next;
 	}
 
@@ -513,15 +530,25 @@ static inline void render_video(struct obs_core_video *video, bool raw_active,
 	gs_end_scene();
 }
 
-static inline bool download_frame(struct obs_core_video *video,
-				  int prev_texture, struct video_data *frame)
+static inline bool readback_ready(struct obs_core_video *video, int texture)
 {
-	if (!video->textures_copied[prev_texture])
-		return false;
+	for (int channel = 0; channel < NUM_CHANNELS; ++channel) {
+		gs_stagesurf_t *surface =
+			video->copy_surfaces[texture][channel];
+		if (surface && !gs_stagesurface_ready(surface))
+			return false;
+	}
+	return true;
+}
+
+static bool map_frame(struct obs_core_video *video, int texture,
+		      struct video_data *frame)
+{
+	video->textures_copied[texture] = false;
 
 	for (int channel = 0; channel < NUM_CHANNELS; ++channel) {
 		gs_stagesurf_t *surface =
-			video->copy_surfaces[prev_texture][channel];
+			video->copy_surfaces[texture][channel];
 		if (surface) {
 			if (!gs_stagesurface_map(surface, &frame->data[channel],
 						 &frame->linesize[channel]))
@@ -530,9 +557,44 @@ static inline bool download_frame(struct obs_core_video *video,
 			video->mapped_surfaces[channel] = surface;
 		}
 	}
+
+	os_atomic_inc_long(&video->readback_frames);
 	return true;
 }
 
+/* the oldest staged frame, not counting the one that was just staged */
+static inline int get_oldest_copied_texture(struct obs_core_video *video,
+					    int cur_texture)
+{
+	int depth = (int)video->readback_depth;
+
+	for (int i = 1; i < depth; i++) {
+		int texture = (cur_texture + i) % depth;
+		if (video->textures_copied[texture])
+			return texture;
+	}
+
+	return -1;
+}
+
+/* only maps frames whose copies have completed, so the graphics thread
+ * doesn't have to wait on the GPU.  a frame that isn't ready yet is read
+ * back on a later frame */
+static inline bool download_frame(struct obs_core_video *video,
+				  int cur_texture, struct video_data *frame)
+{
+	int texture = get_oldest_copied_texture(video, cur_texture);
+	if (texture == -1)
+		return false;
+
+	if (!readback_ready(video, texture)) {
+		os_atomic_inc_long(&video->readback_deferred);
+		return false;
+	}
+
+	return map_frame(video, texture, frame);
+}
+
 static const uint8_t *set_gpu_converted_plane(uint32_t width, uint32_t height,
 					      uint32_t linesize_input,
 					      uint32_t linesize_output,
@@ -741,12 +803,45 @@ static const char *output_frame_render_video_name = "render_video";
 static const char *output_frame_download_frame_name = "download_frame";
 static const char *output_frame_gs_flush_name = "gs_flush";
 static const char *output_frame_output_video_data_name = "output_video_data";
+static inline void output_downloaded_frame(struct obs_core_video *video,
+					   struct video_data *frame)
+{
+	struct obs_vframe_info vframe_info;
+	circlebuf_pop_front(&video->vframe_info_buffer, &vframe_info,
+			    sizeof(vframe_info));
+
+	frame->timestamp = vframe_info.timestamp;
+	profile_start(output_frame_output_video_data_name);
+	output_video_data(video, frame, vframe_info.count);
+	profile_end(output_frame_output_video_data_name);
+}
+
+/* if every surface is waiting to be read back, the oldest frame has to be
+ * read back before its surface can be staged to again, even if that means
+ * waiting for the GPU */
+static void flush_oldest_frame(struct obs_core_video *video, int cur_texture)
+{
+	struct video_data frame;
+	bool success;
+
+	memset(&frame, 0, sizeof(struct video_data));
+
+	if (!readback_ready(video, cur_texture))
+		os_atomic_inc_long(&video->readback_stalls);
+
+	unmap_last_surface(video);
+	success = map_frame(video, cur_texture, &frame);
+
+	if (success)
+		output_downloaded_frame(video, &frame);
+
+	unmap_last_surface(video);
+}
+
 static inline void output_frame(bool raw_active, const bool gpu_active)
 {
 	struct obs_core_video *video = &obs->video;
 	int cur_texture = video->cur_texture;
-	int prev_texture = cur_texture == 0 ? NUM_TEXTURES - 1
-					    : cur_texture - 1;
 	struct video_data frame;
 	bool frame_ready = 0;
 
@@ -755,6 +850,12 @@ static inline void output_frame(bool raw_active, const bool gpu_active)
 	profile_start(output_frame_gs_context_name);
 	gs_enter_context(video->graphics);
 
+	if (raw_active && video->textures_copied[cur_texture]) {
+		profile_start(output_frame_download_frame_name);
+		flush_oldest_frame(video, cur_texture);
+		profile_end(output_frame_download_frame_name);
+	}
+
 	profile_start(output_frame_render_video_name);
 	GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_RENDER_VIDEO,
 			      output_frame_render_video_name);
@@ -764,7 +865,7 @@ static inline void output_frame(bool raw_active, const bool gpu_active)
 
 	if (raw_active) {
 		profile_start(output_frame_download_frame_name);
-		frame_ready = download_frame(video, prev_texture, &frame);
+		frame_ready = download_frame(video, cur_texture, &frame);
 		profile_end(output_frame_download_frame_name);
 	}
 
@@ -775,18 +876,10 @@ static inline void output_frame(bool raw_active, const bool gpu_active)
 	gs_leave_context();
 	profile_end(output_frame_gs_context_name);
 
-	if (raw_active && frame_ready) {
-		struct obs_vframe_info vframe_info;
-		circlebuf_pop_front(&video->vframe_info_buffer, &vframe_info,
-				    sizeof(vframe_info));
+	if (raw_active && frame_ready)
+		output_downloaded_frame(video, &frame);
 
-		frame.timestamp = vframe_info.timestamp;
-		profile_start(output_frame_output_video_data_name);
-		output_video_data(video, &frame, vframe_info.count);
-		profile_end(output_frame_output_video_data_name);
-	}
-
-	if (++video->cur_texture == NUM_TEXTURES)
+	if (++video->cur_texture == (int)video->readback_depth)
 		video->cur_texture = 0;
 }
 
@@ -845,6 +938,7 @@ void *obs_graphics_thread(void *param)
 	uint64_t frame_time_total_ns = 0;
 	uint64_t fps_total_ns = 0;
 	uint32_t fps_total_frames = 0;
+	uint64_t last_draw_calls = 0;
 #ifdef _WIN32
 	bool gpu_was_active = false;
 #endif
@@ -898,8 +992,26 @@ void *obs_graphics_thread(void *param)
 
 		gs_enter_context(obs->video.graphics);
 		gs_begin_frame();
+		uint64_t draw_calls = gs_get_draw_call_count();
 		gs_leave_context();
 
+		obs->video.draw_calls =
+			(uint32_t)(draw_calls - last_draw_calls);
+		last_draw_calls = draw_calls;
+
+		/* everything rendered from here on is part of a new frame
+		 * as far as the per-frame render stats and source render
+		 * cache are concerned */
+		obs->video.last_filter_passes = obs->video.filter_passes;
+		obs->video.filter_passes = 0;
+		obs->video.render_cache_last_hits =
+			obs->video.render_cache_hits;
+		obs->video.render_cache_last_renders =
+			obs->video.render_cache_renders;
+		obs->video.render_cache_hits = 0;
+		obs->video.render_cache_renders = 0;
+		obs->video.render_frame++;
+
 		profile_start(tick_sources_name);
 		last_time = tick_sources(obs->video.video_time, last_time);
 		profile_end(tick_sources_name);
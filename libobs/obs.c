@@ -203,7 +203,11 @@ static bool obs_init_textures(struct obs_video_info *ovi)
 {
 	struct obs_core_video *video = &obs->video;
 
-	for (size_t i = 0; i < NUM_TEXTURES; i++) {
+	video->readback_depth = video->requested_readback_depth
+					? video->requested_readback_depth
+					: DEFAULT_READBACK_DEPTH;
+
+	for (size_t i = 0; i < video->readback_depth; i++) {
 #ifdef _WIN32
 		if (video->using_nv12_tex) {
 			video->copy_surfaces[i][0] =
@@ -282,6 +286,14 @@ static int obs_init_graphics(struct obs_video_info *ovi)
 
 	gs_enter_context(video->graphics);
 
+	if (obs->module_config_path) {
+		struct dstr cache_path = {0};
+		dstr_printf(&cache_path, "%s/libobs/shader-cache",
+			    obs->module_config_path);
+		gs_set_shader_cache_path(cache_path.array);
+		dstr_free(&cache_path);
+	}
+
 	char *filename = obs_find_data_file("default.effect");
 	video->default_effect = gs_effect_create_from_file(filename, NULL);
 	bfree(filename);
@@ -464,6 +476,18 @@ static void obs_free_video(void)
 		if (!video->graphics)
 			return;
 
+		if (os_atomic_load_long(&video->readback_frames))
+			blog(LOG_INFO,
+			     "Video readback: %ld frames, %ld deferred until "
+			     "ready, %ld stalls",
+			     os_atomic_load_long(&video->readback_frames),
+			     os_atomic_load_long(&video->readback_deferred),
+			     os_atomic_load_long(&video->readback_stalls));
+
+		os_atomic_set_long(&video->readback_frames, 0);
+		os_atomic_set_long(&video->readback_deferred, 0);
+		os_atomic_set_long(&video->readback_stalls, 0);
+
 		gs_enter_context(video->graphics);
 
 		for (size_t c = 0; c < NUM_CHANNELS; c++) {
@@ -580,6 +604,7 @@ static bool obs_init_audio(struct audio_output_info *ai)
 
 	audio->monitoring_device_name = bstrdup("Default");
 	audio->monitoring_device_id = bstrdup("default");
+	audio->monitoring_latency_ms = 25;
 
 	errorcode = audio_output_open(&audio->audio, ai);
 	if (errorcode == AUDIO_OUTPUT_SUCCESS)
@@ -610,6 +635,139 @@ static void obs_free_audio(void)
 	memset(audio, 0, sizeof(struct obs_core_audio));
 }
 
+#define INDEX_MIN_BUCKETS 64
+
+static bool obs_context_index_init(struct obs_context_index *index)
+{
+	memset(index, 0, sizeof(*index));
+
+	if (pthread_rwlock_init(&index->rwlock, NULL) != 0)
+		return false;
+
+	index->initialized = true;
+	return true;
+}
+
+static void obs_context_index_free(struct obs_context_index *index)
+{
+	if (!index->initialized)
+		return;
+
+	pthread_rwlock_destroy(&index->rwlock);
+	bfree(index->buckets);
+	memset(index, 0, sizeof(*index));
+}
+
+static inline struct obs_context_index *
+get_context_index(enum obs_obj_type type)
+{
+	switch (type) {
+	case OBS_OBJ_TYPE_SOURCE:
+		return &obs->data.sources_index;
+	case OBS_OBJ_TYPE_OUTPUT:
+		return &obs->data.outputs_index;
+	case OBS_OBJ_TYPE_ENCODER:
+		return &obs->data.encoders_index;
+	case OBS_OBJ_TYPE_SERVICE:
+		return &obs->data.services_index;
+	default:
+		return NULL;
+	}
+}
+
+/* FNV-1a */
+static inline uint32_t hash_context_name(const char *name)
+{
+	uint32_t hash = 2166136261U;
+
+	while (*name) {
+		hash ^= (uint8_t)*(name++);
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static inline struct obs_context_data **
+get_index_bucket(struct obs_context_index *index, uint32_t hash)
+{
+	return &index->buckets[hash & (index->num_buckets - 1)];
+}
+
+static void index_grow(struct obs_context_index *index)
+{
+	struct obs_context_data **old_buckets = index->buckets;
+	size_t old_num = index->num_buckets;
+
+	index->num_buckets = old_num ? old_num * 2 : INDEX_MIN_BUCKETS;
+	index->buckets =
+		bzalloc(index->num_buckets * sizeof(*index->buckets));
+
+	/* keep the order of each chain, so that when several contexts share
+	 * the same name, the most recently added one is still found first */
+	for (size_t i = 0; i < old_num; i++) {
+		struct obs_context_data *context = old_buckets[i];
+
+		while (context) {
+			struct obs_context_data *next = context->index_next;
+			struct obs_context_data **tail =
+				get_index_bucket(index, context->name_hash);
+
+			while (*tail)
+				tail = &(*tail)->index_next;
+
+			context->index_next = NULL;
+			*tail = context;
+			context = next;
+		}
+	}
+
+	bfree(old_buckets);
+}
+
+/* index must be write locked.  chains are kept newest first by the order in
+ * which contexts were added, so a renamed context goes back to where it was
+ * relative to the others rather than ahead of them */
+static void index_insert(struct obs_context_index *index,
+			 struct obs_context_data *context)
+{
+	struct obs_context_data **bucket;
+
+	if (index->num >= index->num_buckets)
+		index_grow(index);
+
+	context->name_hash = hash_context_name(context->name);
+
+	bucket = get_index_bucket(index, context->name_hash);
+	while (*bucket && (*bucket)->index_order > context->index_order)
+		bucket = &(*bucket)->index_next;
+
+	context->index_next = *bucket;
+	*bucket = context;
+	index->num++;
+}
+
+/* index must be write locked */
+static void index_remove(struct obs_context_index *index,
+			 struct obs_context_data *context)
+{
+	struct obs_context_data **cur;
+
+	if (!index->num_buckets)
+		return;
+
+	cur = get_index_bucket(index, context->name_hash);
+	while (*cur) {
+		if (*cur == context) {
+			*cur = context->index_next;
+			context->index_next = NULL;
+			index->num--;
+			break;
+		}
+		cur = &(*cur)->index_next;
+	}
+}
+
 static bool obs_init_data(void)
 {
 	struct obs_core_data *data = &obs->data;
@@ -619,6 +777,7 @@ static bool obs_init_data(void)
 
 	pthread_mutex_init_value(&obs->data.displays_mutex);
 	pthread_mutex_init_value(&obs->data.draw_callbacks_mutex);
+	pthread_mutex_init_value(&obs->data.tick_sources_mutex);
 
 	if (pthread_mutexattr_init(&attr) != 0)
 		return false;
@@ -638,8 +797,20 @@ static bool obs_init_data(void)
 		goto fail;
 	if (pthread_mutex_init(&obs->data.draw_callbacks_mutex, &attr) != 0)
 		goto fail;
+	if (pthread_mutex_init(&data->tick_sources_mutex, &attr) != 0)
+		goto fail;
 	if (!obs_view_init(&data->main_view))
 		goto fail;
+	if (!obs_frame_pool_init(&data->frame_pool))
+		goto fail;
+	if (!obs_context_index_init(&data->sources_index))
+		goto fail;
+	if (!obs_context_index_init(&data->outputs_index))
+		goto fail;
+	if (!obs_context_index_init(&data->encoders_index))
+		goto fail;
+	if (!obs_context_index_init(&data->services_index))
+		goto fail;
 
 	data->private_data = obs_data_create();
 	data->valid = true;
@@ -689,6 +860,13 @@ static void obs_free_data(void)
 	FREE_OBS_LINKED_LIST(display);
 	FREE_OBS_LINKED_LIST(service);
 
+	obs_frame_pool_free(&data->frame_pool);
+
+	obs_context_index_free(&data->sources_index);
+	obs_context_index_free(&data->outputs_index);
+	obs_context_index_free(&data->encoders_index);
+	obs_context_index_free(&data->services_index);
+
 	pthread_mutex_destroy(&data->sources_mutex);
 	pthread_mutex_destroy(&data->audio_sources_mutex);
 	pthread_mutex_destroy(&data->displays_mutex);
@@ -696,8 +874,11 @@ static void obs_free_data(void)
 	pthread_mutex_destroy(&data->encoders_mutex);
 	pthread_mutex_destroy(&data->services_mutex);
 	pthread_mutex_destroy(&data->draw_callbacks_mutex);
+	pthread_mutex_destroy(&data->tick_sources_mutex);
 	da_free(data->draw_callbacks);
 	da_free(data->tick_callbacks);
+	da_free(data->tick_sources);
+	da_free(data->tick_sources_cur);
 	obs_data_release(data->private_data);
 }
 
@@ -1595,25 +1776,32 @@ void obs_enum_services(bool (*enum_proc)(void *, obs_service_t *), void *param)
 		 param);
 }
 
-static inline void *get_context_by_name(void *vfirst, const char *name,
-					pthread_mutex_t *mutex,
+static inline void *get_context_by_name(struct obs_context_index *index,
+					const char *name,
 					void *(*addref)(void *))
 {
-	struct obs_context_data **first = vfirst;
-	struct obs_context_data *context;
+	struct obs_context_data *context = NULL;
+	uint32_t hash;
 
-	pthread_mutex_lock(mutex);
+	if (!index->initialized || !name)
+		return NULL;
+
+	hash = hash_context_name(name);
+
+	pthread_rwlock_rdlock(&index->rwlock);
 
-	context = *first;
+	if (index->num_buckets)
+		context = *get_index_bucket(index, hash);
 	while (context) {
-		if (!context->private && strcmp(context->name, name) == 0) {
+		if (context->name_hash == hash &&
+		    strcmp(context->name, name) == 0) {
 			context = addref(context);
 			break;
 		}
-		context = context->next;
+		context = context->index_next;
 	}
 
-	pthread_mutex_unlock(mutex);
+	pthread_rwlock_unlock(&index->rwlock);
 	return context;
 }
 
@@ -1646,8 +1834,7 @@ obs_source_t *obs_get_source_by_name(const char *name)
 {
 	if (!obs)
 		return NULL;
-	return get_context_by_name(&obs->data.first_source, name,
-				   &obs->data.sources_mutex,
+	return get_context_by_name(&obs->data.sources_index, name,
 				   obs_source_addref_safe_);
 }
 
@@ -1655,8 +1842,7 @@ obs_output_t *obs_get_output_by_name(const char *name)
 {
 	if (!obs)
 		return NULL;
-	return get_context_by_name(&obs->data.first_output, name,
-				   &obs->data.outputs_mutex,
+	return get_context_by_name(&obs->data.outputs_index, name,
 				   obs_output_addref_safe_);
 }
 
@@ -1664,8 +1850,7 @@ obs_encoder_t *obs_get_encoder_by_name(const char *name)
 {
 	if (!obs)
 		return NULL;
-	return get_context_by_name(&obs->data.first_encoder, name,
-				   &obs->data.encoders_mutex,
+	return get_context_by_name(&obs->data.encoders_index, name,
 				   obs_encoder_addref_safe_);
 }
 
@@ -1673,8 +1858,7 @@ obs_service_t *obs_get_service_by_name(const char *name)
 {
 	if (!obs)
 		return NULL;
-	return get_context_by_name(&obs->data.first_service, name,
-				   &obs->data.services_mutex,
+	return get_context_by_name(&obs->data.services_index, name,
 				   obs_service_addref_safe_);
 }
 
@@ -1833,6 +2017,8 @@ static obs_source_t *obs_load_source_type(obs_data_t *source_data)
 	uint32_t flags;
 	uint32_t mixers;
 	int di_order;
+	int async_policy;
+	int async_target;
 	int di_mode;
 	int monitoring_type;
 
@@ -1903,6 +2089,14 @@ static obs_source_t *obs_load_source_type(obs_data_t *source_data)
 	obs_source_set_deinterlace_field_order(
 		source, (enum obs_deinterlace_field_order)di_order);
 
+	obs_data_set_default_int(source_data, "async_frame_target_ms", 100);
+	async_policy = (int)obs_data_get_int(source_data, "async_frame_policy");
+	async_target = (int)obs_data_get_int(source_data,
+					     "async_frame_target_ms");
+	obs_source_set_async_frame_policy(
+		source, (enum obs_async_frame_policy)async_policy,
+		(uint32_t)async_target);
+
 	monitoring_type = (int)obs_data_get_int(source_data, "monitoring_type");
 	if (prev_ver < MAKE_SEMANTIC_VERSION(23, 2, 2)) {
 		if ((caps & OBS_SOURCE_MONITOR_BY_DEFAULT) != 0) {
@@ -2010,7 +2204,7 @@ obs_data_t *obs_save_source(obs_source_t *source)
 {
 	obs_data_array_t *filters = obs_data_array_create();
 	obs_data_t *source_data = obs_data_create();
-	obs_data_t *settings = obs_source_get_settings(source);
+	obs_data_t *settings = source->context.settings;
 	obs_data_t *hotkey_data = source->context.hotkey_data;
 	obs_data_t *hotkeys;
 	float volume = obs_source_get_volume(source);
@@ -2030,6 +2224,9 @@ obs_data_t *obs_save_source(obs_source_t *source)
 	int m_type = (int)obs_source_get_monitoring_type(source);
 	int di_mode = (int)obs_source_get_deinterlace_mode(source);
 	int di_order = (int)obs_source_get_deinterlace_field_order(source);
+	uint32_t async_target;
+	int async_policy =
+		(int)obs_source_get_async_frame_policy(source, &async_target);
 
 	obs_source_save(source);
 	hotkeys = obs_hotkeys_save_source(source);
@@ -2060,6 +2257,8 @@ obs_data_t *obs_save_source(obs_source_t *source)
 	obs_data_set_obj(source_data, "hotkeys", hotkey_data);
 	obs_data_set_int(source_data, "deinterlace_mode", di_mode);
 	obs_data_set_int(source_data, "deinterlace_field_order", di_order);
+	obs_data_set_int(source_data, "async_frame_policy", async_policy);
+	obs_data_set_int(source_data, "async_frame_target_ms", async_target);
 	obs_data_set_int(source_data, "monitoring_type", m_type);
 
 	obs_data_set_obj(source_data, "private_settings",
@@ -2083,7 +2282,6 @@ obs_data_t *obs_save_source(obs_source_t *source)
 
 	pthread_mutex_unlock(&source->filter_mutex);
 
-	obs_data_release(settings);
 	obs_data_array_release(filters);
 
 	return source_data;
@@ -2231,10 +2429,32 @@ void obs_context_data_insert(struct obs_context_data *context,
 	if (context->next)
 		context->next->prev_next = &context->next;
 	pthread_mutex_unlock(mutex);
+
+	if (!context->private && context->name) {
+		struct obs_context_index *index;
+		index = get_context_index(context->type);
+
+		if (index && index->initialized) {
+			pthread_rwlock_wrlock(&index->rwlock);
+			context->index = index;
+			context->index_order = ++index->next_order;
+			index_insert(index, context);
+			pthread_rwlock_unlock(&index->rwlock);
+		}
+	}
 }
 
 void obs_context_data_remove(struct obs_context_data *context)
 {
+	if (context && context->index) {
+		struct obs_context_index *index = context->index;
+
+		pthread_rwlock_wrlock(&index->rwlock);
+		index_remove(index, context);
+		context->index = NULL;
+		pthread_rwlock_unlock(&index->rwlock);
+	}
+
 	if (context && context->mutex) {
 		pthread_mutex_lock(context->mutex);
 		if (context->prev_next)
@@ -2250,6 +2470,13 @@ void obs_context_data_remove(struct obs_context_data *context)
 void obs_context_data_setname(struct obs_context_data *context,
 			      const char *name)
 {
+	struct obs_context_index *index = context->index;
+
+	if (index) {
+		pthread_rwlock_wrlock(&index->rwlock);
+		index_remove(index, context);
+	}
+
 	pthread_mutex_lock(&context->rename_cache_mutex);
 
 	if (context->name)
@@ -2257,6 +2484,11 @@ void obs_context_data_setname(struct obs_context_data *context,
 	context->name = dup_name(name, context->private);
 
 	pthread_mutex_unlock(&context->rename_cache_mutex);
+
+	if (index) {
+		index_insert(index, context);
+		pthread_rwlock_unlock(&index->rwlock);
+	}
 }
 
 profiler_name_store_t *obs_get_profiler_name_store(void)
@@ -2376,6 +2608,31 @@ void obs_get_audio_monitoring_device(const char **name, const char **id)
 		*id = obs->audio.monitoring_device_id;
 }
 
+void obs_set_audio_monitoring_latency(uint32_t latency_ms)
+{
+	if (!obs)
+		return;
+
+	pthread_mutex_lock(&obs->audio.monitoring_mutex);
+	obs->audio.monitoring_latency_ms = latency_ms;
+#if HAVE_PULSEAUDIO
+	audio_monitoring_bus_reset();
+#endif
+	pthread_mutex_unlock(&obs->audio.monitoring_mutex);
+}
+
+uint32_t obs_get_audio_monitoring_latency(void)
+{
+	if (!obs)
+		return 0;
+
+#if HAVE_PULSEAUDIO
+	return (uint32_t)(audio_monitoring_bus_get_latency() / 1000000);
+#else
+	return 0;
+#endif
+}
+
 void obs_add_tick_callback(void (*tick)(void *param, float seconds),
 			   void *param)
 {
@@ -2440,13 +2697,78 @@ uint32_t obs_get_lagged_frames(void)
 	return obs ? obs->video.lagged_frames : 0;
 }
 
+uint32_t obs_get_draw_call_count(void)
+{
+	return obs ? obs->video.draw_calls : 0;
+}
+
+uint32_t obs_get_filter_pass_count(void)
+{
+	return obs ? obs->video.last_filter_passes : 0;
+}
+
+void obs_set_video_readback_depth(uint32_t depth)
+{
+	if (!obs)
+		return;
+
+	if (depth < 2)
+		depth = 2;
+	else if (depth > NUM_TEXTURES)
+		depth = NUM_TEXTURES;
+
+	obs->video.requested_readback_depth = depth;
+}
+
+void obs_get_video_readback_stats(struct obs_video_readback_stats *stats)
+{
+	if (!stats)
+		return;
+
+	memset(stats, 0, sizeof(*stats));
+
+	if (!obs)
+		return;
+
+	stats->depth = obs->video.readback_depth;
+	stats->frames = os_atomic_load_long(&obs->video.readback_frames);
+	stats->deferred = os_atomic_load_long(&obs->video.readback_deferred);
+	stats->stalls = os_atomic_load_long(&obs->video.readback_stalls);
+}
+
+void obs_get_render_cache_stats(struct obs_render_cache_stats *stats)
+{
+	if (!stats)
+		return;
+
+	memset(stats, 0, sizeof(*stats));
+
+	if (!obs)
+		return;
+
+	stats->hits = obs->video.render_cache_last_hits;
+	stats->renders = obs->video.render_cache_last_renders;
+	stats->total_hits = obs->video.render_cache_total_hits;
+	stats->total_renders = obs->video.render_cache_total_renders;
+}
+
 void start_raw_video(video_t *v, const struct video_scale_info *conversion,
 		     void (*callback)(void *param, struct video_data *frame),
 		     void *param)
+{
+	start_raw_video_cascaded(v, conversion, NULL, NULL, callback, param);
+}
+
+void start_raw_video_cascaded(
+	video_t *v, const struct video_scale_info *conversion,
+	void (*parent_callback)(void *param, struct video_data *frame),
+	void *parent_param,
+	void (*callback)(void *param, struct video_data *frame), void *param)
 {
 	struct obs_core_video *video = &obs->video;
 	os_atomic_inc_long(&video->raw_active);
-	video_output_connect(v, conversion, callback, param);
+	video_output_connect_cascaded(v, conversion, parent_callback,
+				      parent_param, callback, param);
 }
 
 void stop_raw_video(video_t *v,
@@ -713,6 +713,15 @@ EXPORT void obs_enum_audio_monitoring_devices(obs_enum_audio_device_cb cb,
 EXPORT bool obs_set_audio_monitoring_device(const char *name, const char *id);
 EXPORT void obs_get_audio_monitoring_device(const char **name, const char **id);
 
+/**
+ * Sets the target latency of the audio monitoring device stream.  Only used
+ * on platforms that mix monitored sources into a single stream (PulseAudio).
+ */
+EXPORT void obs_set_audio_monitoring_latency(uint32_t latency_ms);
+
+/** Returns the measured latency of audio monitoring, or 0 if unknown */
+EXPORT uint32_t obs_get_audio_monitoring_latency(void);
+
 EXPORT void obs_add_tick_callback(void (*tick)(void *param, float seconds),
 				  void *param);
 EXPORT void obs_remove_tick_callback(void (*tick)(void *param, float seconds),
@@ -739,6 +748,60 @@ EXPORT uint64_t obs_get_frame_interval_ns(void);
 EXPORT uint32_t obs_get_total_frames(void);
 EXPORT uint32_t obs_get_lagged_frames(void);
 
+/** Number of draw calls issued by the graphics thread in the last frame */
+EXPORT uint32_t obs_get_draw_call_count(void);
+
+/** Number of filter render to texture passes in the last frame */
+EXPORT uint32_t obs_get_filter_pass_count(void);
+
+/**
+ * Sets the maximum number of frames that can be waiting to be read back from
+ * the GPU for raw video outputs (2 to 4, 2 by default).  A deeper pipeline
+ * gives the GPU more time to finish copies before they're needed, at the
+ * cost of latency.  Takes effect the next time video is reset.
+ */
+EXPORT void obs_set_video_readback_depth(uint32_t depth);
+
+struct obs_video_readback_stats {
+	uint32_t depth;
+	/** Frames read back */
+	uint64_t frames;
+	/** Times a frame wasn't read back yet to avoid waiting for the GPU */
+	uint64_t deferred;
+	/** Times the graphics thread had to wait for the GPU */
+	uint64_t stalls;
+};
+
+EXPORT void
+obs_get_video_readback_stats(struct obs_video_readback_stats *stats);
+
+struct obs_render_cache_stats {
+	/** Cached sources drawn from their cache in the last frame */
+	uint32_t hits;
+	/** Cached sources rendered to their cache in the last frame */
+	uint32_t renders;
+	uint64_t total_hits;
+	uint64_t total_renders;
+};
+
+EXPORT void obs_get_render_cache_stats(struct obs_render_cache_stats *stats);
+
+struct obs_frame_pool_stats {
+	uint64_t budget;
+	uint64_t idle_bytes;
+	uint32_t idle_frames;
+	uint64_t reused;
+	uint64_t allocated;
+	uint64_t evicted;
+};
+
+/**
+ * Sets the maximum amount of memory the async frame pool keeps in idle
+ * frames for reuse.  Frames that are in use by sources are not counted.
+ */
+EXPORT void obs_set_frame_pool_budget(uint64_t bytes);
+EXPORT void obs_get_frame_pool_stats(struct obs_frame_pool_stats *stats);
+
 EXPORT bool obs_nv12_tex_active(void);
 
 EXPORT void obs_apply_private_data(obs_data_t *settings);
@@ -830,6 +893,36 @@ EXPORT void obs_display_set_background_color(obs_display_t *display,
 EXPORT void obs_display_size(obs_display_t *display, uint32_t *width,
 			     uint32_t *height);
 
+/**
+ * Sets the name the display's render time is reported under in the profiler.
+ */
+EXPORT void obs_display_set_name(obs_display_t *display, const char *name);
+
+/**
+ * Limits how often the display is redrawn.  A value of 0 (the default)
+ * redraws the display every frame.
+ */
+EXPORT void obs_display_set_max_fps(obs_display_t *display, uint32_t fps);
+EXPORT uint32_t obs_display_get_max_fps(obs_display_t *display);
+
+/**
+ * When enabled, the display is only redrawn when it's resized, when its draw
+ * callbacks or background color change, or when a redraw is requested with
+ * obs_display_request_redraw.  Meant for displays that show static content.
+ */
+EXPORT void obs_display_set_redraw_on_demand(obs_display_t *display,
+					     bool on_demand);
+EXPORT bool obs_display_redraw_on_demand(obs_display_t *display);
+EXPORT void obs_display_request_redraw(obs_display_t *display);
+
+/**
+ * Marks whether the display's window is currently visible.  Displays that are
+ * hidden, minimized or fully occluded should be marked as not visible so that
+ * they're not rendered.
+ */
+EXPORT void obs_display_set_visible(obs_display_t *display, bool visible);
+EXPORT bool obs_display_visible(obs_display_t *display);
+
 /* ------------------------------------------------------------------------- */
 /* Sources */
 
@@ -1145,6 +1238,14 @@ obs_source_get_monitoring_type(const obs_source_t *source);
  * automatically.  Returns an incremented reference. */
 EXPORT obs_data_t *obs_source_get_private_settings(obs_source_t *item);
 
+/**
+ * Returns a value that changes whenever data stored by obs_save_source for
+ * the source changes (settings, filters, audio state, scene items, etc).
+ * Values are never reused between sources, so front-ends can use it to skip
+ * re-saving sources that have not changed.
+ */
+EXPORT long obs_source_get_save_serial(const obs_source_t *source);
+
 /* ------------------------------------------------------------------------- */
 /* Functions used by sources */
 
@@ -1266,6 +1367,19 @@ EXPORT void obs_source_process_filter_tech_end(obs_source_t *filter,
 /** Skips the filter if the filter is invalid and cannot be rendered */
 EXPORT void obs_source_skip_video_filter(obs_source_t *filter);
 
+/**
+ * Gets a parameter of the filter's stage in a fused filter effect.  Only
+ * valid in the video_set_fused_params callback of the filter.
+ */
+EXPORT gs_eparam_t *obs_filter_get_fused_param(obs_source_t *filter,
+					       const char *name);
+
+/**
+ * Number of times the filters of the source were rendered to texture in the
+ * last frame
+ */
+EXPORT uint32_t obs_source_get_filter_passes(const obs_source_t *source);
+
 /**
  * Adds an active child source.  Must be called by parent sources on child
  * sources when the child is added and active.  This ensures that the source is
@@ -1332,6 +1446,52 @@ EXPORT bool obs_source_async_unbuffered(const obs_source_t *source);
 EXPORT void obs_source_set_async_decoupled(obs_source_t *source, bool decouple);
 EXPORT bool obs_source_async_decoupled(const obs_source_t *source);
 
+/**
+ * Renders the source to a texture the first time it's rendered in a frame,
+ * and draws that texture for every other time it's rendered in the same
+ * frame.  Useful for sources that are rendered in several places, such as
+ * scenes nested in multiple scenes or shown in the multiview.
+ */
+EXPORT void obs_source_set_render_cache(obs_source_t *source, bool enable);
+EXPORT bool obs_source_render_cache_enabled(const obs_source_t *source);
+
+enum obs_async_frame_policy {
+	/** Plays frames according to their timestamps (default) */
+	OBS_ASYNC_FRAME_POLICY_SMOOTH,
+
+	/** Always displays the newest frame, dropping any older frames */
+	OBS_ASYNC_FRAME_POLICY_LATEST,
+
+	/** Like smooth, but drops frames that have been queued for longer than
+	 * the target latency */
+	OBS_ASYNC_FRAME_POLICY_BOUNDED,
+};
+
+struct obs_source_async_stats {
+	uint32_t queue_depth;
+	uint64_t frames_received;
+	uint64_t frames_rendered;
+	uint64_t frames_dropped;
+	uint64_t frames_duplicated;
+
+	/** Average time between a frame being output and rendered */
+	uint64_t average_age_ns;
+};
+
+/** Sets how queued async video frames are scheduled.  target_ms is only
+ * used by OBS_ASYNC_FRAME_POLICY_BOUNDED. */
+EXPORT void
+obs_source_set_async_frame_policy(obs_source_t *source,
+				  enum obs_async_frame_policy policy,
+				  uint32_t target_ms);
+EXPORT enum obs_async_frame_policy
+obs_source_get_async_frame_policy(const obs_source_t *source,
+				  uint32_t *target_ms);
+
+EXPORT void obs_source_get_async_stats(obs_source_t *source,
+				       struct obs_source_async_stats *stats);
+EXPORT void obs_source_reset_async_stats(obs_source_t *source);
+
 EXPORT void obs_source_set_audio_active(obs_source_t *source, bool show);
 EXPORT bool obs_source_audio_active(const obs_source_t *source);
 
@@ -2003,6 +2163,20 @@ EXPORT enum obs_encoder_type obs_encoder_get_type(const obs_encoder_t *encoder);
 EXPORT void obs_encoder_set_scaled_size(obs_encoder_t *encoder, uint32_t width,
 					uint32_t height);
 
+/**
+ * Makes a video encoder a rendition of an encoding ladder, below the next
+ * larger rendition (parent) on the same video output.  While the parent is
+ * active, the encoder's frames are scaled from the parent's scaled frames
+ * rather than from the full output, and the encoder starts on the same frame
+ * as its parent so their timestamps (and keyframes, if they use the same
+ * keyframe interval) line up.  The parent must be started before the
+ * encoder.  Set parent to NULL to remove the encoder from its ladder.  If
+ * the encoder is active, this function will trigger a warning, and do
+ * nothing.
+ */
+EXPORT void obs_encoder_set_ladder_parent(obs_encoder_t *encoder,
+					  obs_encoder_t *parent);
+
 /** For video encoders, returns true if pre-encode scaling is enabled */
 EXPORT bool obs_encoder_scaling_enabled(const obs_encoder_t *encoder);
 
@@ -2096,6 +2270,26 @@ EXPORT void obs_encoder_packet_ref(struct encoder_packet *dst,
 				   struct encoder_packet *src);
 EXPORT void obs_encoder_packet_release(struct encoder_packet *packet);
 
+/**
+ * Allocates packet data from the encoder's packet pool.  An encoder that
+ * writes its output directly into this buffer and sets it as the packet data
+ * lets outputs take a reference to it instead of copying it.  The buffer is
+ * only valid until the encode callback returns.
+ */
+EXPORT uint8_t *obs_encoder_packet_alloc(obs_encoder_t *encoder, size_t size);
+
+struct obs_encoder_packet_pool_stats {
+	uint64_t allocs;
+	uint64_t hits;
+	uint64_t handoffs;
+	size_t cached_bytes;
+};
+
+/** Gets allocation statistics of the encoder's packet pool */
+EXPORT bool
+obs_encoder_get_packet_pool_stats(const obs_encoder_t *encoder,
+				  struct obs_encoder_packet_pool_stats *stats);
+
 EXPORT void *obs_encoder_create_rerouted(obs_encoder_t *encoder,
 					 const char *reroute_id);
 
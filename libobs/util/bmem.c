@@ -90,6 +90,279 @@ static void a_free(void *ptr)
 static struct base_allocator alloc = {a_malloc, a_realloc, a_free};
 static long num_allocs = 0;
 
+/* ------------------------------------------------------------------------- */
+/* Allocation tracking
+ *
+ * Tracked allocations are kept in a separate table keyed by pointer rather
+ * than in a header in front of each allocation, so allocations don't change
+ * when tracking is toggled, and custom allocators still work. */
+
+#define MAX_TAGS 256
+#define UNTAGGED 0
+#define MIN_TABLE_SIZE 4096
+
+struct tracked_alloc {
+	void *ptr;
+	size_t size;
+	uint32_t tag;
+};
+
+struct tag_info {
+	const char *name;
+	struct bmem_tag_stats stats;
+};
+
+static pthread_mutex_t track_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile bool tracking_enabled = false;
+
+/* stays set while tracked allocations remain, even if tracking has been
+ * disabled, so that frees are still accounted for */
+static volatile bool tracking_active = false;
+
+static struct tracked_alloc *table = NULL;
+static size_t table_size = 0;
+static size_t table_count = 0;
+
+static struct tag_info tags[MAX_TAGS] = {{"untagged"}};
+static size_t num_tags = 1;
+
+static THREAD_LOCAL const char *cur_tag = NULL;
+static THREAD_LOCAL int cur_tag_idx = -1;
+
+static inline size_t hash_ptr(const void *ptr)
+{
+	uint64_t val = (uint64_t)(uintptr_t)ptr >> 4;
+	return (size_t)((val * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+static void table_insert(struct tracked_alloc *entry);
+
+static void table_grow(void)
+{
+	struct tracked_alloc *old_table = table;
+	size_t old_size = table_size;
+
+	table_size = old_size ? old_size * 2 : MIN_TABLE_SIZE;
+	table = alloc.malloc(table_size * sizeof(struct tracked_alloc));
+	if (!table) {
+		os_breakpoint();
+		bcrash("Out of memory while trying to track allocations");
+	}
+
+	memset(table, 0, table_size * sizeof(struct tracked_alloc));
+	table_count = 0;
+
+	for (size_t i = 0; i < old_size; i++) {
+		if (old_table[i].ptr)
+			table_insert(&old_table[i]);
+	}
+
+	alloc.free(old_table);
+}
+
+static void table_insert(struct tracked_alloc *entry)
+{
+	size_t mask;
+	size_t idx;
+
+	if ((table_count + 1) * 2 > table_size)
+		table_grow();
+
+	mask = table_size - 1;
+	idx = hash_ptr(entry->ptr) & mask;
+
+	while (table[idx].ptr)
+		idx = (idx + 1) & mask;
+
+	table[idx] = *entry;
+	table_count++;
+}
+
+static bool table_remove(void *ptr, struct tracked_alloc *entry)
+{
+	size_t mask = table_size - 1;
+	size_t i, j;
+
+	if (!table_count)
+		return false;
+
+	i = hash_ptr(ptr) & mask;
+	while (table[i].ptr != ptr) {
+		if (!table[i].ptr)
+			return false;
+		i = (i + 1) & mask;
+	}
+
+	*entry = table[i];
+
+	/* shift back any following entries that would no longer be
+	 * reachable from their home slot */
+	for (j = (i + 1) & mask; table[j].ptr; j = (j + 1) & mask) {
+		size_t home = hash_ptr(table[j].ptr) & mask;
+		bool between = i <= j ? (i < home && home <= j)
+				      : (i < home || home <= j);
+		if (!between) {
+			table[i] = table[j];
+			i = j;
+		}
+	}
+
+	table[i].ptr = NULL;
+	table_count--;
+	return true;
+}
+
+static inline size_t size_bucket(size_t size)
+{
+	size_t bucket = 0;
+	while (bucket < BMEM_SIZE_BUCKETS - 1 && size > ((size_t)64 << bucket))
+		bucket++;
+	return bucket;
+}
+
+static uint32_t get_tag_idx(const char *name)
+{
+	size_t len;
+	char *copy;
+
+	if (!name)
+		return UNTAGGED;
+
+	for (size_t i = 1; i < num_tags; i++) {
+		if (strcmp(tags[i].name, name) == 0)
+			return (uint32_t)i;
+	}
+
+	if (num_tags == MAX_TAGS)
+		return UNTAGGED;
+
+	/* tag strings may belong to modules that get unloaded */
+	len = strlen(name);
+	copy = alloc.malloc(len + 1);
+	if (!copy)
+		return UNTAGGED;
+	memcpy(copy, name, len + 1);
+
+	tags[num_tags].name = copy;
+	return (uint32_t)num_tags++;
+}
+
+static void track_alloc(void *ptr, size_t size, int tag, bool new_alloc)
+{
+	struct tracked_alloc entry = {ptr, size, 0};
+	struct bmem_tag_stats *stats;
+
+	pthread_mutex_lock(&track_mutex);
+
+	if (tag < 0) {
+		if (cur_tag_idx < 0)
+			cur_tag_idx = (int)get_tag_idx(cur_tag);
+		tag = cur_tag_idx;
+	}
+
+	entry.tag = (uint32_t)tag;
+	table_insert(&entry);
+	tracking_active = true;
+
+	stats = &tags[tag].stats;
+	stats->bytes += size;
+	stats->allocs++;
+	stats->size_buckets[size_bucket(size)]++;
+	if (stats->bytes > stats->peak_bytes)
+		stats->peak_bytes = stats->bytes;
+	if (new_alloc)
+		stats->total_allocs++;
+
+	pthread_mutex_unlock(&track_mutex);
+}
+
+/* returns the tag of the allocation, or -1 if it wasn't tracked */
+static int untrack_alloc(void *ptr)
+{
+	struct tracked_alloc entry;
+	struct bmem_tag_stats *stats;
+	int tag = -1;
+
+	pthread_mutex_lock(&track_mutex);
+
+	if (table_remove(ptr, &entry)) {
+		stats = &tags[entry.tag].stats;
+		stats->bytes -= entry.size;
+		stats->allocs--;
+		stats->size_buckets[size_bucket(entry.size)]--;
+		tag = (int)entry.tag;
+
+		if (!table_count && !tracking_enabled)
+			tracking_active = false;
+	}
+
+	pthread_mutex_unlock(&track_mutex);
+	return tag;
+}
+
+void bmem_enable_tracking(bool enable)
+{
+	pthread_mutex_lock(&track_mutex);
+	tracking_enabled = enable;
+	tracking_active = enable || table_count > 0;
+	pthread_mutex_unlock(&track_mutex);
+}
+
+bool bmem_tracking_enabled(void)
+{
+	return tracking_enabled;
+}
+
+const char *bmem_set_tag(const char *tag)
+{
+	const char *prev = cur_tag;
+	if (tag != prev) {
+		cur_tag = tag;
+		cur_tag_idx = -1;
+	}
+	return prev;
+}
+
+void bmem_enum_tags(bmem_enum_tags_cb cb, void *param)
+{
+	struct bmem_tag_stats *list;
+	size_t count = 0;
+
+	list = alloc.malloc(MAX_TAGS * sizeof(struct bmem_tag_stats));
+	if (!list)
+		return;
+
+	/* callbacks are made without the lock held, as they will most
+	 * likely allocate */
+	pthread_mutex_lock(&track_mutex);
+	for (size_t i = 0; i < num_tags; i++) {
+		if (!tags[i].stats.total_allocs)
+			continue;
+
+		list[count] = tags[i].stats;
+		list[count].tag = tags[i].name;
+		count++;
+	}
+	pthread_mutex_unlock(&track_mutex);
+
+	for (size_t i = 0; i < count; i++) {
+		if (!cb(param, &list[i]))
+			break;
+	}
+
+	alloc.free(list);
+}
+
+void bmem_reset_peaks(void)
+{
+	pthread_mutex_lock(&track_mutex);
+	for (size_t i = 0; i < num_tags; i++)
+		tags[i].stats.peak_bytes = tags[i].stats.bytes;
+	pthread_mutex_unlock(&track_mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+
 void base_set_allocator(struct base_allocator *defs)
 {
 	memcpy(&alloc, defs, sizeof(struct base_allocator));
@@ -107,13 +380,21 @@ void *bmalloc(size_t size)
 	}
 
 	os_atomic_inc_long(&num_allocs);
+
+	if (tracking_enabled)
+		track_alloc(ptr, size, -1, true);
 	return ptr;
 }
 
 void *brealloc(void *ptr, size_t size)
 {
+	bool new_alloc = !ptr;
+	int tag = -1;
+
 	if (!ptr)
 		os_atomic_inc_long(&num_allocs);
+	else if (tracking_active)
+		tag = untrack_alloc(ptr);
 
 	ptr = alloc.realloc(ptr, size);
 	if (!ptr && !size)
@@ -124,13 +405,19 @@ void *brealloc(void *ptr, size_t size)
 		       (unsigned long)size);
 	}
 
+	/* reallocated blocks keep the tag they were first allocated with */
+	if (tag >= 0 || (new_alloc && tracking_enabled))
+		track_alloc(ptr, size, tag, new_alloc);
 	return ptr;
 }
 
 void bfree(void *ptr)
 {
-	if (ptr)
+	if (ptr) {
 		os_atomic_dec_long(&num_allocs);
+		if (tracking_active)
+			untrack_alloc(ptr);
+	}
 	alloc.free(ptr);
 }
 
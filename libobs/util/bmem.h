@@ -43,6 +43,44 @@ EXPORT long bnum_allocs(void);
 
 EXPORT void *bmemdup(const void *ptr, size_t size);
 
+/* ------------------------------------------------------------------------- */
+/* Tagged allocation tracking
+ *
+ * When enabled, every allocation is attributed to the tag that is current
+ * on the allocating thread, so memory usage can be broken down per module,
+ * source type, etc.  Allocations made while tracking is disabled are not
+ * accounted for.  When disabled, the only cost is checking a flag. */
+
+#define BMEM_SIZE_BUCKETS 16
+
+struct bmem_tag_stats {
+	const char *tag;
+
+	/* currently allocated, and the high-water mark */
+	uint64_t bytes;
+	uint64_t peak_bytes;
+
+	uint64_t allocs;
+	uint64_t total_allocs;
+
+	/* current allocations by size: bucket n holds allocations of up to
+	 * (64 << n) bytes, the last bucket holds everything larger */
+	uint64_t size_buckets[BMEM_SIZE_BUCKETS];
+};
+
+typedef bool (*bmem_enum_tags_cb)(void *param,
+				  const struct bmem_tag_stats *stats);
+
+EXPORT void bmem_enable_tracking(bool enable);
+EXPORT bool bmem_tracking_enabled(void);
+
+/* sets the tag for allocations made by the calling thread, and returns the
+ * previous tag so it can be restored.  NULL means untagged. */
+EXPORT const char *bmem_set_tag(const char *tag);
+
+EXPORT void bmem_enum_tags(bmem_enum_tags_cb cb, void *param);
+EXPORT void bmem_reset_peaks(void);
+
 static inline void *bzalloc(size_t size)
 {
 	void *mem = bmalloc(size);
@@ -40,11 +40,20 @@
 #define _mm_andnot_ps simde_mm_andnot_ps
 #define _mm_storeu_ps simde_mm_storeu_ps
 #define _mm_loadu_ps simde_mm_loadu_ps
+#define _mm_cmplt_ps simde_mm_cmplt_ps
+#define _mm_cmpgt_ps simde_mm_cmpgt_ps
+#define _mm_and_ps simde_mm_and_ps
+#define _mm_or_ps simde_mm_or_ps
+#define _mm_castps_si128 simde_mm_castps_si128
+#define _mm_castsi128_ps simde_mm_castsi128_ps
+#define _mm_cvttps_epi32 simde_mm_cvttps_epi32
+#define _mm_cvtepi32_ps simde_mm_cvtepi32_ps
 
 #define __m128i simde__m128i
 #define _mm_set1_epi32 simde_mm_set1_epi32
 #define _mm_set1_epi16 simde_mm_set1_epi16
 #define _mm_load_si128 simde_mm_load_si128
+#define _mm_loadu_si128 simde_mm_loadu_si128
 #define _mm_packs_epi32 simde_mm_packs_epi32
 #define _mm_srli_si128 simde_mm_srli_si128
 #define _mm_and_si128 simde_mm_and_si128
@@ -54,6 +63,14 @@
 #define _mm_srai_epi16 simde_mm_srai_epi16
 #define _mm_shufflelo_epi16 simde_mm_shufflelo_epi16
 #define _mm_storeu_si128 simde_mm_storeu_si128
+#define _mm_or_si128 simde_mm_or_si128
+#define _mm_add_epi32 simde_mm_add_epi32
+#define _mm_sub_epi32 simde_mm_sub_epi32
+#define _mm_slli_epi32 simde_mm_slli_epi32
+#define _mm_srli_epi32 simde_mm_srli_epi32
+#define _mm_srai_epi32 simde_mm_srai_epi32
+#define _mm_unpacklo_epi16 simde_mm_unpacklo_epi16
+#define _mm_unpackhi_epi16 simde_mm_unpackhi_epi16
 
 #define _MM_SHUFFLE SIMDE_MM_SHUFFLE
 #define _MM_TRANSPOSE4_PS SIMDE_MM_TRANSPOSE4_PS
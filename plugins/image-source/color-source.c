@@ -117,7 +117,7 @@ struct obs_source_info color_source_info_v1 = {
 	.id = "color_source",
 	.type = OBS_SOURCE_TYPE_INPUT,
 	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_CUSTOM_DRAW |
-			OBS_SOURCE_CAP_OBSOLETE,
+			OBS_SOURCE_STATIC_VIDEO | OBS_SOURCE_CAP_OBSOLETE,
 	.create = color_source_create,
 	.destroy = color_source_destroy,
 	.update = color_source_update,
@@ -134,7 +134,8 @@ struct obs_source_info color_source_info_v2 = {
 	.id = "color_source",
 	.version = 2,
 	.type = OBS_SOURCE_TYPE_INPUT,
-	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_CUSTOM_DRAW,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_CUSTOM_DRAW |
+			OBS_SOURCE_STATIC_VIDEO,
 	.create = color_source_create,
 	.destroy = color_source_destroy,
 	.update = color_source_update,
@@ -0,0 +1,234 @@
+#include <obs-module.h>
+#include <util/threading.h>
+#include <util/platform.h>
+#include <util/darray.h>
+
+#include "image-loader.h"
+
+struct load_request {
+	void *owner;
+	char *file;
+	uint32_t max_cx;
+	uint32_t max_cy;
+	enum image_load_priority priority;
+	image_loaded_t callback;
+	uint64_t id;
+};
+
+static pthread_mutex_t mutex;
+static pthread_mutex_t busy_mutex;
+static os_sem_t *load_sem = NULL;
+static pthread_t load_thread;
+static bool initialized = false;
+static bool stopping = false;
+
+static DARRAY(struct load_request) requests;
+static void *cur_owner = NULL;
+static uint64_t next_id = 0;
+
+/* must be called with the mutex held */
+static inline size_t find_request(void *owner)
+{
+	for (size_t i = 0; i < requests.num; i++) {
+		if (requests.array[i].owner == owner)
+			return i;
+	}
+
+	return DARRAY_INVALID;
+}
+
+/* must be called with the mutex held */
+static inline void remove_request(void *owner)
+{
+	size_t idx = find_request(owner);
+
+	if (idx != DARRAY_INVALID) {
+		bfree(requests.array[idx].file);
+		da_erase(requests, idx);
+	}
+}
+
+/* must be called with the mutex held.  visible images first, then the ones
+ * that will be visible soon, oldest first within the same priority. */
+static inline size_t next_request(void)
+{
+	size_t best = 0;
+
+	for (size_t i = 1; i < requests.num; i++) {
+		if (requests.array[i].priority < requests.array[best].priority)
+			best = i;
+	}
+
+	return best;
+}
+
+static void *load_thread_func(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+
+	os_set_thread_name("image source: loader thread");
+
+	while (os_sem_wait(load_sem) == 0) {
+		struct load_request req;
+		gs_image_file2_t *if2;
+		size_t idx;
+
+		/* held while decoding so image_loader_remove can wait for
+		 * the owner's callback to return */
+		pthread_mutex_lock(&busy_mutex);
+
+		pthread_mutex_lock(&mutex);
+		if (stopping || !requests.num) {
+			pthread_mutex_unlock(&mutex);
+			pthread_mutex_unlock(&busy_mutex);
+
+			if (stopping)
+				break;
+			continue;
+		}
+
+		idx = next_request();
+		req = requests.array[idx];
+		da_erase(requests, idx);
+		cur_owner = req.owner;
+		pthread_mutex_unlock(&mutex);
+
+		if2 = bzalloc(sizeof(*if2));
+		gs_image_file2_init_scaled(if2, req.file, req.max_cx,
+					   req.max_cy);
+		req.callback(req.owner, req.id, if2);
+		bfree(req.file);
+
+		pthread_mutex_lock(&mutex);
+		cur_owner = NULL;
+		pthread_mutex_unlock(&mutex);
+
+		pthread_mutex_unlock(&busy_mutex);
+	}
+
+	return NULL;
+}
+
+bool image_loader_init(void)
+{
+	if (pthread_mutex_init(&mutex, NULL) != 0)
+		return false;
+	if (pthread_mutex_init(&busy_mutex, NULL) != 0)
+		goto fail_busy_mutex;
+	if (os_sem_init(&load_sem, 0) != 0)
+		goto fail_sem;
+	if (pthread_create(&load_thread, NULL, load_thread_func, NULL) != 0)
+		goto fail_thread;
+
+	initialized = true;
+	return true;
+
+fail_thread:
+	os_sem_destroy(load_sem);
+fail_sem:
+	pthread_mutex_destroy(&busy_mutex);
+fail_busy_mutex:
+	pthread_mutex_destroy(&mutex);
+	blog(LOG_ERROR, "Failed to create the image loader thread");
+	return false;
+}
+
+void image_loader_free(void)
+{
+	if (!initialized)
+		return;
+
+	pthread_mutex_lock(&mutex);
+	stopping = true;
+	pthread_mutex_unlock(&mutex);
+
+	os_sem_post(load_sem);
+	pthread_join(load_thread, NULL);
+
+	for (size_t i = 0; i < requests.num; i++)
+		bfree(requests.array[i].file);
+	da_free(requests);
+
+	os_sem_destroy(load_sem);
+	pthread_mutex_destroy(&busy_mutex);
+	pthread_mutex_destroy(&mutex);
+	initialized = false;
+}
+
+uint64_t image_loader_queue(void *owner, const char *file, uint32_t max_cx,
+			    uint32_t max_cy, enum image_load_priority priority,
+			    image_loaded_t callback)
+{
+	struct load_request *req;
+	uint64_t id;
+	size_t idx;
+
+	if (!initialized)
+		return 0;
+
+	pthread_mutex_lock(&mutex);
+
+	idx = find_request(owner);
+	if (idx != DARRAY_INVALID) {
+		req = &requests.array[idx];
+		bfree(req->file);
+	} else {
+		req = da_push_back_new(requests);
+		os_sem_post(load_sem);
+	}
+
+	req->owner = owner;
+	req->file = bstrdup(file);
+	req->max_cx = max_cx;
+	req->max_cy = max_cy;
+	req->priority = priority;
+	req->callback = callback;
+	req->id = id = ++next_id;
+
+	pthread_mutex_unlock(&mutex);
+	return id;
+}
+
+void image_loader_raise_priority(void *owner, enum image_load_priority priority)
+{
+	size_t idx;
+
+	if (!initialized)
+		return;
+
+	pthread_mutex_lock(&mutex);
+
+	idx = find_request(owner);
+	if (idx != DARRAY_INVALID && priority < requests.array[idx].priority)
+		requests.array[idx].priority = priority;
+
+	pthread_mutex_unlock(&mutex);
+}
+
+void image_loader_cancel(void *owner)
+{
+	if (!initialized)
+		return;
+
+	pthread_mutex_lock(&mutex);
+	remove_request(owner);
+	pthread_mutex_unlock(&mutex);
+}
+
+void image_loader_remove(void *owner)
+{
+	bool busy;
+
+	if (!initialized)
+		return;
+
+	pthread_mutex_lock(&mutex);
+	remove_request(owner);
+	busy = cur_owner == owner;
+	pthread_mutex_unlock(&mutex);
+
+	if (busy) {
+		pthread_mutex_lock(&busy_mutex);
+		pthread_mutex_unlock(&busy_mutex);
+	}
+}
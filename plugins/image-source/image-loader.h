@@ -0,0 +1,38 @@
+#pragma once
+
+#include <graphics/image-file.h>
+
+/* Images are decoded on a separate thread so that loading an image never
+ * stalls the thread that requested it.  Textures are still created by the
+ * owner, from within the graphics context. */
+
+enum image_load_priority {
+	IMAGE_LOAD_VISIBLE,
+	IMAGE_LOAD_PREFETCH,
+	IMAGE_LOAD_BACKGROUND,
+};
+
+/* called from the loader thread, takes ownership of the image */
+typedef void (*image_loaded_t)(void *owner, uint64_t id,
+			       gs_image_file2_t *if2);
+
+extern bool image_loader_init(void);
+extern void image_loader_free(void);
+
+/* queues an image to be decoded, replacing any image the owner already has
+ * queued.  returns the id that will be passed to the callback. */
+extern uint64_t image_loader_queue(void *owner, const char *file,
+				   uint32_t max_cx, uint32_t max_cy,
+				   enum image_load_priority priority,
+				   image_loaded_t callback);
+
+/* raises the priority of the owner's queued image, if any */
+extern void image_loader_raise_priority(void *owner,
+					enum image_load_priority priority);
+
+/* removes the owner's queued image, if any */
+extern void image_loader_cancel(void *owner);
+
+/* removes the owner's queued image and waits for its callback to return if
+ * it is currently being decoded */
+extern void image_loader_remove(void *owner);
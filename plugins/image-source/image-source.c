@@ -1,9 +1,12 @@
 #include <obs-module.h>
 #include <graphics/image-file.h>
+#include <util/threading.h>
 #include <util/platform.h>
 #include <util/dstr.h>
 #include <sys/stat.h>
 
+#include "image-loader.h"
+
 #define blog(log_level, format, ...)                    \
 	blog(log_level, "[image_source: '%s'] " format, \
 	     obs_source_get_name(context->source), ##__VA_ARGS__)
@@ -17,11 +20,20 @@ struct image_source {
 
 	char *file;
 	bool persistent;
+	bool preloaded;
+	uint32_t max_cx;
+	uint32_t max_cy;
 	time_t file_timestamp;
 	float update_time_elapsed;
 	uint64_t last_time;
 	bool active;
 
+	/* images are decoded on the loader thread, and their textures are
+	 * created the next time the source is rendered */
+	pthread_mutex_t mutex;
+	uint64_t load_id;
+	gs_image_file2_t *pending;
+
 	gs_image_file2_t if2;
 };
 
@@ -39,34 +51,114 @@ static const char *image_source_get_name(void *unused)
 	return obs_module_text("ImageInput");
 }
 
-static void image_source_load(struct image_source *context)
+static void free_image(gs_image_file2_t *if2)
 {
-	char *file = context->file;
+	if (if2) {
+		gs_image_file2_free(if2);
+		bfree(if2);
+	}
+}
 
-	obs_enter_graphics();
-	gs_image_file2_free(&context->if2);
-	obs_leave_graphics();
+static void image_source_loaded(void *data, uint64_t id, gs_image_file2_t *if2)
+{
+	struct image_source *context = data;
+	gs_image_file2_t *old = NULL;
+
+	if (!if2->image.loaded)
+		warn("failed to load texture");
+
+	pthread_mutex_lock(&context->mutex);
+	if (id == context->load_id) {
+		old = context->pending;
+		context->pending = if2;
+		context->load_id = 0;
+		if2 = NULL;
+	}
+	pthread_mutex_unlock(&context->mutex);
+
+	/* neither has a texture yet */
+	free_image(old);
+	free_image(if2);
+}
+
+static inline enum image_load_priority
+get_priority(struct image_source *context)
+{
+	return obs_source_showing(context->source) ? IMAGE_LOAD_VISIBLE
+						   : IMAGE_LOAD_BACKGROUND;
+}
+
+static void image_source_load(struct image_source *context,
+			      enum image_load_priority priority)
+{
+	char *file = context->file;
 
 	if (file && *file) {
 		debug("loading texture '%s'", file);
 		context->file_timestamp = get_modified_timestamp(file);
-		gs_image_file2_init(&context->if2, file);
 		context->update_time_elapsed = 0;
 
-		obs_enter_graphics();
-		gs_image_file2_init_texture(&context->if2);
-		obs_leave_graphics();
-
-		if (!context->if2.image.loaded)
-			warn("failed to load texture '%s'", file);
+		/* the current image (if any) stays up until the new one has
+		 * been decoded */
+		pthread_mutex_lock(&context->mutex);
+		context->load_id = image_loader_queue(
+			context, file, context->max_cx, context->max_cy,
+			priority, image_source_loaded);
+		pthread_mutex_unlock(&context->mutex);
 	}
 }
 
 static void image_source_unload(struct image_source *context)
 {
+	gs_image_file2_t *pending;
+
+	image_loader_cancel(context);
+
+	pthread_mutex_lock(&context->mutex);
+	pending = context->pending;
+	context->pending = NULL;
+	context->load_id = 0;
+	pthread_mutex_unlock(&context->mutex);
+
 	obs_enter_graphics();
+	pthread_mutex_lock(&context->mutex);
 	gs_image_file2_free(&context->if2);
+	pthread_mutex_unlock(&context->mutex);
 	obs_leave_graphics();
+
+	free_image(pending);
+}
+
+/* must be called within the graphics context */
+static void upload_pending_image(struct image_source *context)
+{
+	gs_image_file2_t *pending;
+
+	pthread_mutex_lock(&context->mutex);
+	pending = context->pending;
+	if (pending) {
+		gs_image_file2_free(&context->if2);
+		context->if2 = *pending;
+		context->pending = NULL;
+	}
+	pthread_mutex_unlock(&context->mutex);
+
+	if (pending) {
+		gs_image_file2_init_texture(&context->if2);
+		bfree(pending);
+	}
+}
+
+static inline bool image_requested(struct image_source *context)
+{
+	bool requested;
+
+	pthread_mutex_lock(&context->mutex);
+	requested = context->if2.image.loaded || context->pending ||
+		    context->load_id;
+	pthread_mutex_unlock(&context->mutex);
+
+	return requested;
 }
 
 static void image_source_update(void *data, obs_data_t *settings)
@@ -81,10 +173,13 @@ static void image_source_update(void *data, obs_data_t *settings)
 	context->persistent = !unload;
 
 	/* Load the image if the source is persistent or showing */
-	if (context->persistent || obs_source_showing(context->source))
-		image_source_load(data);
+	if (!context->file || !*context->file)
+		image_source_unload(context);
+	else if (context->persistent || context->preloaded ||
+		 obs_source_showing(context->source))
+		image_source_load(context, get_priority(context));
 	else
-		image_source_unload(data);
+		image_source_unload(context);
 }
 
 static void image_source_defaults(obs_data_t *settings)
@@ -96,15 +191,17 @@ static void image_source_show(void *data)
 {
 	struct image_source *context = data;
 
-	if (!context->persistent)
-		image_source_load(context);
+	if (image_requested(context))
+		image_loader_raise_priority(context, IMAGE_LOAD_VISIBLE);
+	else
+		image_source_load(context, IMAGE_LOAD_VISIBLE);
 }
 
 static void image_source_hide(void *data)
 {
 	struct image_source *context = data;
 
-	if (!context->persistent)
+	if (!context->persistent && !context->preloaded)
 		image_source_unload(context);
 }
 
@@ -113,6 +210,12 @@ static void *image_source_create(obs_data_t *settings, obs_source_t *source)
 	struct image_source *context = bzalloc(sizeof(struct image_source));
 	context->source = source;
 
+	pthread_mutex_init_value(&context->mutex);
+	if (pthread_mutex_init(&context->mutex, NULL) != 0) {
+		bfree(context);
+		return NULL;
+	}
+
 	image_source_update(context, settings);
 	return context;
 }
@@ -121,29 +224,51 @@ static void image_source_destroy(void *data)
 {
 	struct image_source *context = data;
 
+	image_loader_remove(context);
 	image_source_unload(context);
+	pthread_mutex_destroy(&context->mutex);
 
 	if (context->file)
 		bfree(context->file);
 	bfree(context);
 }
 
+/* the size of a decoded image is reported before its texture is created so
+ * that it's already correct the first time it's rendered */
+static inline gs_image_file_t *get_size_image(struct image_source *context)
+{
+	return context->pending ? &context->pending->image
+				: &context->if2.image;
+}
+
 static uint32_t image_source_getwidth(void *data)
 {
 	struct image_source *context = data;
-	return context->if2.image.cx;
+	uint32_t cx;
+
+	pthread_mutex_lock(&context->mutex);
+	cx = get_size_image(context)->cx;
+	pthread_mutex_unlock(&context->mutex);
+	return cx;
 }
 
 static uint32_t image_source_getheight(void *data)
 {
 	struct image_source *context = data;
-	return context->if2.image.cy;
+	uint32_t cy;
+
+	pthread_mutex_lock(&context->mutex);
+	cy = get_size_image(context)->cy;
+	pthread_mutex_unlock(&context->mutex);
+	return cy;
 }
 
 static void image_source_render(void *data, gs_effect_t *effect)
 {
 	struct image_source *context = data;
 
+	upload_pending_image(context);
+
 	if (!context->if2.image.texture)
 		return;
 
@@ -165,7 +290,7 @@ static void image_source_tick(void *data, float seconds)
 		context->update_time_elapsed = 0.0f;
 
 		if (context->file_timestamp != t) {
-			image_source_load(context);
+			image_source_load(context, get_priority(context));
 		}
 	}
 
@@ -247,7 +372,56 @@ static obs_properties_t *image_source_properties(void *data)
 uint64_t image_source_get_memory_usage(void *data)
 {
 	struct image_source *s = data;
-	return s->if2.mem_usage;
+	uint64_t usage;
+
+	pthread_mutex_lock(&s->mutex);
+	usage = s->if2.mem_usage;
+	if (s->pending)
+		usage += s->pending->mem_usage;
+	pthread_mutex_unlock(&s->mutex);
+
+	return usage;
+}
+
+/* keeps the image loaded while hidden (until image_source_evict is called),
+ * loading it with the given priority if it isn't loaded already */
+void image_source_preload(void *data, enum image_load_priority priority)
+{
+	struct image_source *s = data;
+
+	s->preloaded = true;
+
+	if (image_requested(s))
+		image_loader_raise_priority(s, priority);
+	else
+		image_source_load(s, priority);
+}
+
+/* unloads the image if it was only loaded because it was preloaded */
+void image_source_evict(void *data)
+{
+	struct image_source *s = data;
+
+	s->preloaded = false;
+
+	if (!s->persistent && !obs_source_showing(s->source))
+		image_source_unload(s);
+}
+
+/* scales the image down while decoding it so that it fits within
+ * cx x cy (0 for no limit) */
+void image_source_set_max_size(void *data, uint32_t cx, uint32_t cy)
+{
+	struct image_source *s = data;
+
+	if (s->max_cx == cx && s->max_cy == cy)
+		return;
+
+	s->max_cx = cx;
+	s->max_cy = cy;
+
+	if (image_requested(s))
+		image_source_load(s, get_priority(s));
 }
 
 static struct obs_source_info image_source_info = {
@@ -282,9 +456,17 @@ extern struct obs_source_info color_source_info_v2;
 
 bool obs_module_load(void)
 {
+	if (!image_loader_init())
+		return false;
+
 	obs_register_source(&image_source_info);
 	obs_register_source(&color_source_info_v1);
 	obs_register_source(&color_source_info_v2);
 	obs_register_source(&slideshow_info);
 	return true;
 }
+
+void obs_module_unload(void)
+{
+	image_loader_free();
+}
@@ -4,6 +4,8 @@
 #include <util/darray.h>
 #include <util/dstr.h>
 
+#include "image-loader.h"
+
 #define do_log(level, format, ...)               \
 	blog(level, "[slideshow: '%s'] " format, \
 	     obs_source_get_name(ss->source), ##__VA_ARGS__)
@@ -62,6 +64,9 @@
 /* ------------------------------------------------------------------------- */
 
 extern uint64_t image_source_get_memory_usage(void *data);
+extern void image_source_preload(void *data, enum image_load_priority priority);
+extern void image_source_evict(void *data);
+extern void image_source_set_max_size(void *data, uint32_t cx, uint32_t cy);
 
 #define BYTES_TO_MBYTES (1024 * 1024)
 #define MAX_MEM_USAGE (400 * BYTES_TO_MBYTES)
@@ -69,6 +74,9 @@ extern uint64_t image_source_get_memory_usage(void *data);
 struct image_file_data {
 	char *path;
 	obs_source_t *source;
+	uint32_t cx;
+	uint32_t cy;
+	bool preloaded;
 };
 
 enum behavior {
@@ -97,6 +105,16 @@ struct slideshow {
 
 	float elapsed;
 	size_t cur_item;
+	size_t next_item;
+
+	bool use_auto;
+	bool aspect_only;
+	int cx_in;
+	int cy_in;
+
+	/* largest size of the images that have been loaded so far */
+	uint32_t base_cx;
+	uint32_t base_cy;
 
 	uint32_t cx;
 	uint32_t cy;
@@ -126,10 +144,10 @@ static obs_source_t *get_transition(struct slideshow *ss)
 	return tr;
 }
 
-static obs_source_t *get_source(struct darray *array, const char *path)
+static bool get_file(struct darray *array, const char *path,
+		     struct image_file_data *data)
 {
 	DARRAY(struct image_file_data) files;
-	obs_source_t *source = NULL;
 
 	files.da = *array;
 
@@ -137,13 +155,13 @@ static obs_source_t *get_source(struct darray *array, const char *path)
 		const char *cur_path = files.array[i].path;
 
 		if (strcmp(path, cur_path) == 0) {
-			source = files.array[i].source;
-			obs_source_addref(source);
-			break;
+			*data = files.array[i];
+			obs_source_addref(data->source);
+			return true;
 		}
 	}
 
-	return source;
+	return false;
 }
 
 static obs_source_t *create_source_from_file(const char *file)
@@ -151,8 +169,10 @@ static obs_source_t *create_source_from_file(const char *file)
 	obs_data_t *settings = obs_data_create();
 	obs_source_t *source;
 
+	/* images are only loaded while they're showing or preloaded by the
+	 * slideshow */
 	obs_data_set_string(settings, "file", file);
-	obs_data_set_bool(settings, "unload", false);
+	obs_data_set_bool(settings, "unload", true);
 	source = obs_source_create_private("image_source", NULL, settings);
 
 	obs_data_release(settings);
@@ -186,38 +206,36 @@ static const char *ss_getname(void *unused)
 }
 
 static void add_file(struct slideshow *ss, struct darray *array,
-		     const char *path, uint32_t *cx, uint32_t *cy)
+		     const char *path, uint32_t *cx, uint32_t *cy,
+		     uint32_t max_cx, uint32_t max_cy)
 {
 	DARRAY(struct image_file_data) new_files;
-	struct image_file_data data;
-	obs_source_t *new_source;
+	struct image_file_data data = {0};
+	bool found;
 
 	new_files.da = *array;
 
 	pthread_mutex_lock(&ss->mutex);
-	new_source = get_source(&ss->files.da, path);
+	found = get_file(&ss->files.da, path, &data);
 	pthread_mutex_unlock(&ss->mutex);
 
-	if (!new_source)
-		new_source = get_source(&new_files.da, path);
-	if (!new_source)
-		new_source = create_source_from_file(path);
+	if (!found)
+		found = get_file(&new_files.da, path, &data);
+	if (!found)
+		data.source = create_source_from_file(path);
+
+	if (data.source) {
+		void *source_data = obs_obj_get_data(data.source);
 
-	if (new_source) {
-		uint32_t new_cx = obs_source_get_width(new_source);
-		uint32_t new_cy = obs_source_get_height(new_source);
+		image_source_set_max_size(source_data, max_cx, max_cy);
 
 		data.path = bstrdup(path);
-		data.source = new_source;
 		da_push_back(new_files, &data);
 
-		if (new_cx > *cx)
-			*cx = new_cx;
-		if (new_cy > *cy)
-			*cy = new_cy;
-
-		void *source_data = obs_obj_get_data(new_source);
-		ss->mem_usage += image_source_get_memory_usage(source_data);
+		if (data.cx > *cx)
+			*cx = data.cx;
+		if (data.cy > *cy)
+			*cy = data.cy;
 	}
 
 	*array = new_files.da;
@@ -237,11 +255,185 @@ static inline bool item_valid(struct slideshow *ss)
 	return ss->files.num && ss->cur_item < ss->files.num;
 }
 
+static void update_size(struct slideshow *ss)
+{
+	uint32_t cx = ss->base_cx;
+	uint32_t cy = ss->base_cy;
+
+	if (!ss->use_auto) {
+		double cx_f = (double)cx;
+		double cy_f = (double)cy;
+
+		double old_aspect = cx_f / cy_f;
+		double new_aspect = (double)ss->cx_in / (double)ss->cy_in;
+
+		if (!ss->aspect_only) {
+			cx = (uint32_t)ss->cx_in;
+			cy = (uint32_t)ss->cy_in;
+
+		} else if (cx && cy &&
+			   fabs(old_aspect - new_aspect) > EPSILON) {
+			if (new_aspect > old_aspect)
+				cx = (uint32_t)(cy_f * new_aspect);
+			else
+				cy = (uint32_t)(cx_f / new_aspect);
+		}
+	}
+
+	if (cx != ss->cx || cy != ss->cy) {
+		ss->cx = cx;
+		ss->cy = cy;
+		obs_transition_set_size(ss->transition, cx, cy);
+	}
+}
+
+/* images are loaded in the background, so their size is only known once
+ * they've been loaded */
+static void update_file_size(struct slideshow *ss, size_t idx)
+{
+	struct image_file_data *file = &ss->files.array[idx];
+	uint32_t cx = obs_source_get_width(file->source);
+	uint32_t cy = obs_source_get_height(file->source);
+	bool grew = false;
+
+	if (!cx || !cy)
+		return;
+
+	file->cx = cx;
+	file->cy = cy;
+
+	if (cx > ss->base_cx) {
+		ss->base_cx = cx;
+		grew = true;
+	}
+	if (cy > ss->base_cy) {
+		ss->base_cy = cy;
+		grew = true;
+	}
+
+	if (grew)
+		update_size(ss);
+}
+
+static size_t get_next_item(struct slideshow *ss)
+{
+	size_t next = ss->cur_item;
+
+	if (ss->randomize) {
+		if (ss->files.num > 1) {
+			while (next == ss->cur_item)
+				next = random_file(ss);
+		}
+	} else if (++next >= ss->files.num) {
+		next = 0;
+	}
+
+	return next;
+}
+
+static inline size_t get_prev_item(struct slideshow *ss)
+{
+	return ss->cur_item ? ss->cur_item - 1 : ss->files.num - 1;
+}
+
+static inline size_t slide_distance(struct slideshow *ss, size_t idx)
+{
+	size_t num = ss->files.num;
+	size_t dist;
+
+	if (ss->randomize)
+		return num;
+
+	dist = idx > ss->cur_item ? idx - ss->cur_item : ss->cur_item - idx;
+	if (ss->loop && num - dist < dist)
+		dist = num - dist;
+	return dist;
+}
+
+static inline bool slide_needed(struct slideshow *ss, size_t idx)
+{
+	return idx == ss->cur_item || idx == ss->next_item ||
+	       (ss->manual && idx == get_prev_item(ss));
+}
+
+/* unloads the slides furthest away from the current one until the preloaded
+ * slides fit within the memory budget */
+static void enforce_memory_budget(struct slideshow *ss)
+{
+	uint64_t usage = 0;
+
+	for (size_t i = 0; i < ss->files.num; i++) {
+		struct image_file_data *file = &ss->files.array[i];
+		void *source_data = obs_obj_get_data(file->source);
+
+		if (file->preloaded)
+			usage += image_source_get_memory_usage(source_data);
+	}
+
+	while (usage > MAX_MEM_USAGE) {
+		struct image_file_data *furthest = NULL;
+		size_t furthest_dist = 0;
+
+		for (size_t i = 0; i < ss->files.num; i++) {
+			struct image_file_data *file = &ss->files.array[i];
+			size_t dist = slide_distance(ss, i);
+
+			if (file->preloaded && !slide_needed(ss, i) &&
+			    (!furthest || dist > furthest_dist)) {
+				furthest = file;
+				furthest_dist = dist;
+			}
+		}
+
+		if (!furthest)
+			break;
+
+		void *source_data = obs_obj_get_data(furthest->source);
+		usage -= image_source_get_memory_usage(source_data);
+		image_source_evict(source_data);
+		furthest->preloaded = false;
+	}
+
+	ss->mem_usage = usage;
+}
+
+static void preload_slide(struct slideshow *ss, size_t idx,
+			  enum image_load_priority priority)
+{
+	struct image_file_data *file = &ss->files.array[idx];
+
+	image_source_preload(obs_obj_get_data(file->source), priority);
+	file->preloaded = true;
+}
+
+/* makes sure the current slide and the slide(s) that can be switched to
+ * next are loaded (or being loaded), and unloads far away slides */
+static void preload_slides(struct slideshow *ss)
+{
+	if (!item_valid(ss))
+		return;
+
+	ss->next_item = get_next_item(ss);
+
+	/* the current slide is raised to visible once it's shown */
+	preload_slide(ss, ss->cur_item, IMAGE_LOAD_PREFETCH);
+
+	if (ss->loop || ss->randomize || ss->next_item > ss->cur_item)
+		preload_slide(ss, ss->next_item, IMAGE_LOAD_PREFETCH);
+	if (ss->manual)
+		preload_slide(ss, get_prev_item(ss), IMAGE_LOAD_PREFETCH);
+
+	enforce_memory_budget(ss);
+}
+
 static void do_transition(void *data, bool to_null)
 {
 	struct slideshow *ss = data;
 	bool valid = item_valid(ss);
 
+	if (valid && !to_null)
+		preload_slides(ss);
+
 	if (valid && ss->use_cut)
 		obs_transition_set(ss->transition,
 				   ss->files.array[ss->cur_item].source);
@@ -269,9 +461,12 @@ static void ss_update(void *data, obs_data_t *settings)
 	uint32_t new_speed;
 	uint32_t cx = 0;
 	uint32_t cy = 0;
+	uint32_t max_cx = 0;
+	uint32_t max_cy = 0;
 	size_t count;
 	const char *behavior;
 	const char *mode;
+	const char *res_str;
 
 	/* ------------------------------------- */
 	/* get settings data */
@@ -314,11 +509,39 @@ static void ss_update(void *data, obs_data_t *settings)
 	array = obs_data_get_array(settings, S_FILES);
 	count = obs_data_array_count(array);
 
+	res_str = obs_data_get_string(settings, S_CUSTOM_SIZE);
+	ss->aspect_only = false;
+	ss->use_auto = true;
+	ss->cx_in = 0;
+	ss->cy_in = 0;
+
+	if (strcmp(res_str, T_CUSTOM_SIZE_AUTO) != 0) {
+		int ret = sscanf(res_str, "%dx%d", &ss->cx_in, &ss->cy_in);
+		if (ret == 2) {
+			ss->aspect_only = false;
+			ss->use_auto = false;
+		} else {
+			ret = sscanf(res_str, "%d:%d", &ss->cx_in, &ss->cy_in);
+			if (ret == 2) {
+				ss->aspect_only = true;
+				ss->use_auto = false;
+			}
+		}
+	}
+
+	/* with a fixed size, images never need to be any larger than the
+	 * slideshow, so they're scaled down while they're decoded */
+	if (!ss->use_auto && !ss->aspect_only && ss->cx_in > 0 &&
+	    ss->cy_in > 0) {
+		max_cx = (uint32_t)ss->cx_in;
+		max_cy = (uint32_t)ss->cy_in;
+	}
+
 	/* ------------------------------------- */
 	/* create new list of sources */
 
-	ss->mem_usage = 0;
-
+	/* images aren't loaded here, so all files can be added; the memory
+	 * budget is enforced as slides are preloaded */
 	for (size_t i = 0; i < count; i++) {
 		obs_data_t *item = obs_data_array_item(array, i);
 		const char *path = obs_data_get_string(item, "value");
@@ -345,22 +568,17 @@ static void ss_update(void *data, obs_data_t *settings)
 				dstr_cat_ch(&dir_path, '/');
 				dstr_cat(&dir_path, ent->d_name);
 				add_file(ss, &new_files.da, dir_path.array, &cx,
-					 &cy);
-
-				if (ss->mem_usage >= MAX_MEM_USAGE)
-					break;
+					 &cy, max_cx, max_cy);
 			}
 
 			dstr_free(&dir_path);
 			os_closedir(dir);
 		} else {
-			add_file(ss, &new_files.da, path, &cx, &cy);
+			add_file(ss, &new_files.da, path, &cx, &cy, max_cx,
+				 max_cy);
 		}
 
 		obs_data_release(item);
-
-		if (ss->mem_usage >= MAX_MEM_USAGE)
-			break;
 	}
 
 	/* ------------------------------------- */
@@ -400,51 +618,13 @@ static void ss_update(void *data, obs_data_t *settings)
 
 	/* ------------------------- */
 
-	const char *res_str = obs_data_get_string(settings, S_CUSTOM_SIZE);
-	bool aspect_only = false, use_auto = true;
-	int cx_in = 0, cy_in = 0;
-
-	if (strcmp(res_str, T_CUSTOM_SIZE_AUTO) != 0) {
-		int ret = sscanf(res_str, "%dx%d", &cx_in, &cy_in);
-		if (ret == 2) {
-			aspect_only = false;
-			use_auto = false;
-		} else {
-			ret = sscanf(res_str, "%d:%d", &cx_in, &cy_in);
-			if (ret == 2) {
-				aspect_only = true;
-				use_auto = false;
-			}
-		}
-	}
-
-	if (!use_auto) {
-		double cx_f = (double)cx;
-		double cy_f = (double)cy;
+	ss->base_cx = cx;
+	ss->base_cy = cy;
+	update_size(ss);
 
-		double old_aspect = cx_f / cy_f;
-		double new_aspect = (double)cx_in / (double)cy_in;
-
-		if (aspect_only) {
-			if (fabs(old_aspect - new_aspect) > EPSILON) {
-				if (new_aspect > old_aspect)
-					cx = (uint32_t)(cy_f * new_aspect);
-				else
-					cy = (uint32_t)(cx_f / new_aspect);
-			}
-		} else {
-			cx = (uint32_t)cx_in;
-			cy = (uint32_t)cy_in;
-		}
-	}
-
-	/* ------------------------- */
-
-	ss->cx = cx;
-	ss->cy = cy;
 	ss->cur_item = 0;
 	ss->elapsed = 0.0f;
-	obs_transition_set_size(ss->transition, cx, cy);
+	obs_transition_set_size(ss->transition, ss->cx, ss->cy);
 	obs_transition_set_alignment(ss->transition, OBS_ALIGN_CENTER);
 	obs_transition_set_scale_type(ss->transition,
 				      OBS_TRANSITION_SCALE_ASPECT);
@@ -474,6 +654,7 @@ static void ss_restart(void *data)
 	ss->elapsed = 0.0f;
 	ss->cur_item = 0;
 
+	preload_slides(ss);
 	obs_transition_set(ss->transition,
 			   ss->files.array[ss->cur_item].source);
 
@@ -662,6 +843,12 @@ static void ss_video_tick(void *data, float seconds)
 	if (!ss->transition || !ss->slide_time)
 		return;
 
+	if (item_valid(ss)) {
+		update_file_size(ss, ss->cur_item);
+		if (ss->next_item < ss->files.num)
+			update_file_size(ss, ss->next_item);
+	}
+
 	if (ss->restart_on_activate && !ss->randomize && ss->use_cut) {
 		ss->elapsed = 0.0f;
 		ss->cur_item = 0;
@@ -703,13 +890,13 @@ static void ss_video_tick(void *data, float seconds)
 			return;
 		}
 
+		/* the next random slide was picked (and preloaded) when
+		 * the current one was shown */
 		if (ss->randomize) {
-			size_t next = ss->cur_item;
-			if (ss->files.num > 1) {
-				while (next == ss->cur_item)
-					next = random_file(ss);
-			}
-			ss->cur_item = next;
+			if (ss->next_item < ss->files.num)
+				ss->cur_item = ss->next_item;
+			else
+				ss->cur_item = get_next_item(ss);
 
 		} else if (++ss->cur_item >= ss->files.num) {
 			ss->cur_item = 0;
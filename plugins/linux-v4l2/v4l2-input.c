@@ -997,10 +997,19 @@ static void *v4l2_create(obs_data_t *settings, obs_source_t *source)
 	return data;
 }
 
+/* device enumeration is expensive, and with udev we're told when the device
+ * list changes, so the properties only need to be created again then */
+#if HAVE_UDEV
+#define V4L2_PROPERTIES_FLAGS OBS_SOURCE_CACHE_PROPERTIES
+#else
+#define V4L2_PROPERTIES_FLAGS 0
+#endif
+
 struct obs_source_info v4l2_input = {
 	.id = "v4l2_input",
 	.type = OBS_SOURCE_TYPE_INPUT,
-	.output_flags = OBS_SOURCE_ASYNC_VIDEO | OBS_SOURCE_DO_NOT_DUPLICATE,
+	.output_flags = OBS_SOURCE_ASYNC_VIDEO | OBS_SOURCE_DO_NOT_DUPLICATE |
+			V4L2_PROPERTIES_FLAGS,
 	.get_name = v4l2_getname,
 	.create = v4l2_create,
 	.destroy = v4l2_destroy,
@@ -50,6 +50,22 @@ struct ffmpeg_muxer {
 	volatile bool stopping;
 	volatile bool capturing;
 
+	/* segmented recording */
+	struct dstr base_path;
+	int64_t segment_max_size;
+	int64_t segment_max_time;
+	int64_t segment_size;
+	int64_t segment_start;
+	int segment_idx;
+	bool segment_offsets_set;
+	bool segment_found_audio[MAX_AUDIO_MIXES];
+	int64_t segment_video_offset;
+	int64_t segment_audio_offsets[MAX_AUDIO_MIXES];
+	os_process_pipe_t *finalize_pipe;
+	struct dstr finalize_path;
+	pthread_t finalize_thread;
+	bool finalize_thread_joinable;
+
 	/* replay buffer */
 	struct circlebuf packets;
 	int64_t cur_size;
@@ -89,6 +105,14 @@ static inline void replay_buffer_clear(struct ffmpeg_muxer *stream)
 	stream->keyframes = 0;
 }
 
+static inline void join_finalize_thread(struct ffmpeg_muxer *stream)
+{
+	if (stream->finalize_thread_joinable) {
+		pthread_join(stream->finalize_thread, NULL);
+		stream->finalize_thread_joinable = false;
+	}
+}
+
 static void ffmpeg_mux_destroy(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
@@ -98,8 +122,12 @@ static void ffmpeg_mux_destroy(void *data)
 		pthread_join(stream->mux_thread, NULL);
 	da_free(stream->mux_packets);
 
+	join_finalize_thread(stream);
+
 	os_process_pipe_destroy(stream->pipe);
 	dstr_free(&stream->path);
+	dstr_free(&stream->base_path);
+	dstr_free(&stream->finalize_path);
 	bfree(stream);
 }
 
@@ -108,6 +136,9 @@ static void *ffmpeg_mux_create(obs_data_t *settings, obs_output_t *output)
 	struct ffmpeg_muxer *stream = bzalloc(sizeof(*stream));
 	stream->output = output;
 
+	signal_handler_t *sh = obs_output_get_signal_handler(output);
+	signal_handler_add(sh, "void file_changed(ptr output, string path)");
+
 	UNUSED_PARAMETER(settings);
 	return stream;
 }
@@ -264,6 +295,39 @@ static inline void start_pipe(struct ffmpeg_muxer *stream, const char *path)
 	dstr_free(&cmd);
 }
 
+static inline bool segmenting(struct ffmpeg_muxer *stream)
+{
+	return stream->segment_max_time > 0 || stream->segment_max_size > 0;
+}
+
+static inline void reset_segment(struct ffmpeg_muxer *stream)
+{
+	stream->segment_size = 0;
+	stream->segment_start = 0;
+	stream->segment_offsets_set = false;
+	stream->segment_video_offset = 0;
+	memset(stream->segment_found_audio, 0,
+	       sizeof(stream->segment_found_audio));
+	memset(stream->segment_audio_offsets, 0,
+	       sizeof(stream->segment_audio_offsets));
+}
+
+/* Segment paths are derived from the configured recording path: the first
+ * segment uses the path as-is, subsequent segments are named
+ * "<name>_<index>.<ext>" next to it. */
+static void generate_segment_path(struct ffmpeg_muxer *stream,
+				  struct dstr *dst)
+{
+	const char *base = stream->base_path.array;
+	const char *ext = os_get_path_extension(base);
+	size_t stem_len = ext ? (size_t)(ext - base) : stream->base_path.len;
+
+	dstr_ncopy(dst, base, stem_len);
+	dstr_catf(dst, "_%03d", stream->segment_idx + 1);
+	if (ext)
+		dstr_cat(dst, ext);
+}
+
 static bool ffmpeg_mux_start(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
@@ -305,6 +369,17 @@ static bool ffmpeg_mux_start(void *data)
 	fclose(test_file);
 	os_unlink(path);
 
+	/* a previous recording may still be finalizing its last segment */
+	join_finalize_thread(stream);
+
+	stream->segment_max_time =
+		obs_data_get_int(settings, "segment_time_sec") * 1000000LL;
+	stream->segment_max_size =
+		obs_data_get_int(settings, "segment_size_mb") * (1024 * 1024);
+	stream->segment_idx = 0;
+	reset_segment(stream);
+	dstr_copy(&stream->base_path, path);
+
 	start_pipe(stream, path);
 	obs_data_release(settings);
 
@@ -466,6 +541,132 @@ static bool send_headers(struct ffmpeg_muxer *stream)
 	return true;
 }
 
+static void *finalize_segment_thread(void *data)
+{
+	struct ffmpeg_muxer *stream = data;
+	uint64_t start = os_gettime_ns();
+	int ret;
+
+	/* closing the pipe makes the helper write the trailer (the MP4 moov
+	 * atom) and exit, which is what takes time on large segments */
+	ret = os_process_pipe_destroy(stream->finalize_pipe);
+	stream->finalize_pipe = NULL;
+
+	if (ret != FFM_SUCCESS)
+		warn("Failed to finalize segment '%s' (%d)",
+		     stream->finalize_path.array, ret);
+	else
+		info("Finalized segment '%s' in %d ms",
+		     stream->finalize_path.array,
+		     (int)((os_gettime_ns() - start) / 1000000ULL));
+
+	return NULL;
+}
+
+static void signal_file_changed(struct ffmpeg_muxer *stream)
+{
+	signal_handler_t *sh = obs_output_get_signal_handler(stream->output);
+	calldata_t cd = {0};
+
+	calldata_set_ptr(&cd, "output", stream->output);
+	calldata_set_string(&cd, "path", stream->path.array);
+	signal_handler_signal(sh, "file_changed", &cd);
+	calldata_free(&cd);
+}
+
+static bool split_segment(struct ffmpeg_muxer *stream)
+{
+	struct dstr path = {0};
+
+	/* only one segment is finalized at a time; if the previous one is
+	 * still being written out, wait for it here */
+	join_finalize_thread(stream);
+
+	stream->finalize_pipe = stream->pipe;
+	dstr_copy_dstr(&stream->finalize_path, &stream->path);
+	stream->pipe = NULL;
+
+	stream->finalize_thread_joinable =
+		pthread_create(&stream->finalize_thread, NULL,
+			       finalize_segment_thread, stream) == 0;
+	if (!stream->finalize_thread_joinable)
+		finalize_segment_thread(stream);
+
+	stream->segment_idx++;
+	generate_segment_path(stream, &path);
+	start_pipe(stream, path.array);
+	dstr_free(&path);
+
+	if (!stream->pipe) {
+		obs_output_set_last_error(
+			stream->output, obs_module_text("HelperProcessFailed"));
+		warn("Failed to create process pipe for next segment");
+		deactivate(stream, OBS_OUTPUT_ERROR);
+		return false;
+	}
+
+	reset_segment(stream);
+
+	if (!send_headers(stream))
+		return false;
+
+	info("Writing segment '%s'...", stream->path.array);
+	signal_file_changed(stream);
+	return true;
+}
+
+static inline bool should_split(struct ffmpeg_muxer *stream,
+				struct encoder_packet *packet)
+{
+	/* segments can only be cut at video keyframes */
+	if (packet->type != OBS_ENCODER_VIDEO || !packet->keyframe)
+		return false;
+	if (!stream->segment_size)
+		return false;
+
+	if (stream->segment_max_size &&
+	    stream->segment_size + (int64_t)packet->size >
+		    stream->segment_max_size)
+		return true;
+
+	return stream->segment_max_time &&
+	       packet->dts_usec - stream->segment_start >=
+		       stream->segment_max_time;
+}
+
+/* Every segment after the first is rebased so that its timestamps start at
+ * zero, the same way the replay buffer rebases the packets it saves. */
+static bool write_segment_packet(struct ffmpeg_muxer *stream,
+				 struct encoder_packet *packet)
+{
+	struct encoder_packet pkt = *packet;
+
+	if (!stream->segment_size)
+		stream->segment_start = packet->dts_usec;
+
+	if (stream->segment_idx > 0) {
+		if (pkt.type == OBS_ENCODER_VIDEO) {
+			if (!stream->segment_offsets_set) {
+				stream->segment_video_offset = pkt.dts;
+				stream->segment_offsets_set = true;
+			}
+			pkt.dts -= stream->segment_video_offset;
+			pkt.pts -= stream->segment_video_offset;
+		} else {
+			size_t idx = pkt.track_idx;
+			if (!stream->segment_found_audio[idx]) {
+				stream->segment_audio_offsets[idx] = pkt.dts;
+				stream->segment_found_audio[idx] = true;
+			}
+			pkt.dts -= stream->segment_audio_offsets[idx];
+			pkt.pts -= stream->segment_audio_offsets[idx];
+		}
+	}
+
+	stream->segment_size += (int64_t)packet->size;
+	return write_packet(stream, &pkt);
+}
+
 static void ffmpeg_mux_data(void *data, struct encoder_packet *packet)
 {
 	struct ffmpeg_muxer *stream = data;
@@ -493,6 +694,14 @@ static void ffmpeg_mux_data(void *data, struct encoder_packet *packet)
 		}
 	}
 
+	if (segmenting(stream)) {
+		if (should_split(stream, packet) && !split_segment(stream))
+			return;
+
+		write_segment_packet(stream, packet);
+		return;
+	}
+
 	write_packet(stream, packet);
 }
 
@@ -504,6 +713,10 @@ static obs_properties_t *ffmpeg_mux_properties(void *unused)
 
 	obs_properties_add_text(props, "path", obs_module_text("FilePath"),
 				OBS_TEXT_DEFAULT);
+	obs_properties_add_int(props, "segment_time_sec",
+			       obs_module_text("SegmentTime"), 0, 86400, 1);
+	obs_properties_add_int(props, "segment_size_mb",
+			       obs_module_text("SegmentSize"), 0, 1048576, 1);
 	return props;
 }
 
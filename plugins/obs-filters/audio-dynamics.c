@@ -0,0 +1,349 @@
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include <media-io/audio-io.h>
+#include <util/sse-intrin.h>
+
+#include "audio-dynamics.h"
+
+/* 20 * log10(2), converts between log2 and dB */
+#define DB_PER_LOG2 6.0205999132796239f
+
+/* log2(1 + t) for t in [0, 1), max error 1.7e-5 */
+#define LOG2_C1 1.4418799f
+#define LOG2_C2 -0.708865218f
+#define LOG2_C3 0.415245561f
+#define LOG2_C4 -0.193516525f
+#define LOG2_C5 0.0452682928f
+
+/* 2^f for f in [0, 1), max relative error 1.2e-7 */
+#define EXP2_C1 0.693152535f
+#define EXP2_C2 0.240152444f
+#define EXP2_C3 0.0558366008f
+#define EXP2_C4 0.00897289614f
+#define EXP2_C5 0.00188540505f
+
+#define EXPAND_MIN_GAIN_DB -60.0f
+
+/* -------------------------------------------------------- */
+/* scalar versions, used for the tails.  They perform the exact same
+ * operations as the vector versions so results don't depend on where a
+ * sample falls in the packet. */
+
+union float_bits {
+	float f;
+	uint32_t i;
+};
+
+/* 0 (and anything below FLT_MIN) maps to -126 rather than -inf */
+static inline float log2_approx(float x)
+{
+	union float_bits v;
+	float t, p;
+	int e;
+
+	v.f = fmaxf(x, FLT_MIN);
+	e = (int)(v.i >> 23) - 127;
+	v.i = (v.i & 0x007FFFFF) | 0x3F800000;
+	t = v.f - 1.0f;
+
+	p = LOG2_C5;
+	p = p * t + LOG2_C4;
+	p = p * t + LOG2_C3;
+	p = p * t + LOG2_C2;
+	p = p * t + LOG2_C1;
+	p = p * t;
+	return (float)e + p;
+}
+
+static inline float exp2_approx(float x)
+{
+	union float_bits v;
+	float fi, f, p;
+	int i;
+
+	x = fminf(fmaxf(x, -126.0f), 126.0f);
+	i = (int)x;
+	fi = (float)i;
+	if (fi > x) {
+		i--;
+		fi -= 1.0f;
+	}
+
+	f = x - fi;
+	p = EXP2_C5;
+	p = p * f + EXP2_C4;
+	p = p * f + EXP2_C3;
+	p = p * f + EXP2_C2;
+	p = p * f + EXP2_C1;
+	p = p * f + 1.0f;
+
+	v.i = (uint32_t)(i + 127) << 23;
+	return p * v.f;
+}
+
+static inline float envelope_step(float env, float in, float attack_gain,
+				  float release_gain)
+{
+	const float gain = env < in ? attack_gain : release_gain;
+	return in + gain * (env - in);
+}
+
+/* -------------------------------------------------------- */
+
+static inline __m128 log2_ps(__m128 x)
+{
+	const __m128i mantissa_mask = _mm_set1_epi32(0x007FFFFF);
+	const __m128i one_bits = _mm_set1_epi32(0x3F800000);
+	__m128i bits, e;
+	__m128 t, p;
+
+	bits = _mm_castps_si128(_mm_max_ps(x, _mm_set1_ps(FLT_MIN)));
+	e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+	bits = _mm_or_si128(_mm_and_si128(bits, mantissa_mask), one_bits);
+	t = _mm_sub_ps(_mm_castsi128_ps(bits), _mm_set1_ps(1.0f));
+
+	p = _mm_set1_ps(LOG2_C5);
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(LOG2_C4));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(LOG2_C3));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(LOG2_C2));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(LOG2_C1));
+	p = _mm_mul_ps(p, t);
+	return _mm_add_ps(_mm_cvtepi32_ps(e), p);
+}
+
+static inline __m128 exp2_ps(__m128 x)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	__m128i i, e;
+	__m128 fi, f, p, round_up;
+
+	x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.0f)),
+		       _mm_set1_ps(126.0f));
+
+	/* truncation rounds negative values up, turn it into floor */
+	i = _mm_cvttps_epi32(x);
+	fi = _mm_cvtepi32_ps(i);
+	round_up = _mm_cmpgt_ps(fi, x);
+	i = _mm_add_epi32(i, _mm_castps_si128(round_up));
+	fi = _mm_sub_ps(fi, _mm_and_ps(round_up, one));
+
+	f = _mm_sub_ps(x, fi);
+	p = _mm_set1_ps(EXP2_C5);
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(EXP2_C4));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(EXP2_C3));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(EXP2_C2));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(EXP2_C1));
+	p = _mm_add_ps(_mm_mul_ps(p, f), one);
+
+	e = _mm_slli_epi32(_mm_add_epi32(i, _mm_set1_epi32(127)), 23);
+	return _mm_mul_ps(p, _mm_castsi128_ps(e));
+}
+
+static inline __m128 abs_ps(__m128 v)
+{
+	return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+
+static inline __m128 envelope_step_ps(__m128 env, __m128 in, __m128 attack,
+				      __m128 release)
+{
+	const __m128 rising = _mm_cmplt_ps(env, in);
+	const __m128 gain = _mm_or_ps(_mm_and_ps(rising, attack),
+				      _mm_andnot_ps(rising, release));
+	return _mm_add_ps(in, _mm_mul_ps(gain, _mm_sub_ps(env, in)));
+}
+
+/* -------------------------------------------------------- */
+
+/* the envelope of each channel depends on its previous value, so instead of
+ * running over the samples of one channel, four channels are followed at
+ * once: blocks of 4x4 samples are transposed so that each vector holds one
+ * frame of all four channels */
+static void peak_envelope_4(float *env_buf, const float *const *src,
+			    uint32_t frames, float start, float attack_gain,
+			    float release_gain)
+{
+	const __m128 attack = _mm_set1_ps(attack_gain);
+	const __m128 release = _mm_set1_ps(release_gain);
+	__m128 env = _mm_set1_ps(start);
+	float lane_env[4];
+	uint32_t i = 0;
+
+	for (; i + 4 <= frames; i += 4) {
+		__m128 v0 = _mm_loadu_ps(src[0] + i);
+		__m128 v1 = _mm_loadu_ps(src[1] + i);
+		__m128 v2 = _mm_loadu_ps(src[2] + i);
+		__m128 v3 = _mm_loadu_ps(src[3] + i);
+		__m128 peak;
+
+		_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+		v0 = env = envelope_step_ps(env, abs_ps(v0), attack, release);
+		v1 = env = envelope_step_ps(env, abs_ps(v1), attack, release);
+		v2 = env = envelope_step_ps(env, abs_ps(v2), attack, release);
+		v3 = env = envelope_step_ps(env, abs_ps(v3), attack, release);
+		_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+
+		peak = _mm_max_ps(_mm_max_ps(v0, v1), _mm_max_ps(v2, v3));
+		peak = _mm_max_ps(peak, _mm_loadu_ps(env_buf + i));
+		_mm_storeu_ps(env_buf + i, peak);
+	}
+
+	if (i == frames)
+		return;
+
+	_mm_storeu_ps(lane_env, env);
+	for (size_t c = 0; c < 4; c++) {
+		float e = lane_env[c];
+
+		for (uint32_t j = i; j < frames; j++) {
+			e = envelope_step(e, fabsf(src[c][j]), attack_gain,
+					  release_gain);
+			env_buf[j] = fmaxf(env_buf[j], e);
+		}
+	}
+}
+
+void dyn_peak_envelope(float *env_buf, float *const *samples, size_t channels,
+		       uint32_t frames, float *envelope, float attack_gain,
+		       float release_gain)
+{
+	const float *src[MAX_AUDIO_CHANNELS];
+	size_t count = 0;
+
+	if (!frames)
+		return;
+
+	for (size_t c = 0; c < channels && c < MAX_AUDIO_CHANNELS; c++) {
+		if (samples[c])
+			src[count++] = samples[c];
+	}
+
+	memset(env_buf, 0, frames * sizeof(env_buf[0]));
+
+	for (size_t c = 0; c < count; c += 4) {
+		const float *lanes[4];
+
+		/* unused lanes repeat the first channel of the group, which
+		 * doesn't change the peak */
+		for (size_t j = 0; j < 4; j++)
+			lanes[j] = src[c + j < count ? c + j : c];
+
+		peak_envelope_4(env_buf, lanes, frames, *envelope, attack_gain,
+				release_gain);
+	}
+
+	*envelope = env_buf[frames - 1];
+}
+
+void dyn_channel_peak(float *dst, float *const *samples, size_t channels,
+		      uint32_t frames)
+{
+	memset(dst, 0, frames * sizeof(dst[0]));
+
+	for (size_t c = 0; c < channels; c++) {
+		const float *src = samples[c];
+		uint32_t i = 0;
+
+		if (!src)
+			continue;
+
+		for (; i + 4 <= frames; i += 4) {
+			__m128 v = abs_ps(_mm_loadu_ps(src + i));
+			v = _mm_max_ps(v, _mm_loadu_ps(dst + i));
+			_mm_storeu_ps(dst + i, v);
+		}
+		for (; i < frames; i++)
+			dst[i] = fmaxf(dst[i], fabsf(src[i]));
+	}
+}
+
+void dyn_compress_gain(float *gain, const float *env, uint32_t frames,
+		       float slope, float threshold_db, float output_gain)
+{
+	/* slope * (threshold - db) / DB_PER_LOG2 ==
+	 * slope * (threshold / DB_PER_LOG2 - log2(env)) */
+	const float threshold = threshold_db / DB_PER_LOG2;
+	const __m128 v_slope = _mm_set1_ps(slope);
+	const __m128 v_threshold = _mm_set1_ps(threshold);
+	const __m128 v_output = _mm_set1_ps(output_gain);
+	const __m128 zero = _mm_setzero_ps();
+	uint32_t i = 0;
+
+	for (; i + 4 <= frames; i += 4) {
+		__m128 g = log2_ps(_mm_loadu_ps(env + i));
+		g = _mm_mul_ps(v_slope, _mm_sub_ps(v_threshold, g));
+		g = exp2_ps(_mm_min_ps(g, zero));
+		_mm_storeu_ps(gain + i, _mm_mul_ps(g, v_output));
+	}
+	for (; i < frames; i++) {
+		float g = slope * (threshold - log2_approx(env[i]));
+		gain[i] = exp2_approx(fminf(g, 0.0f)) * output_gain;
+	}
+}
+
+void dyn_expand_gain_db(float *gain_db, const float *env, uint32_t frames,
+			float slope, float threshold_db)
+{
+	const __m128 v_db_per_log2 = _mm_set1_ps(DB_PER_LOG2);
+	const __m128 v_slope = _mm_set1_ps(slope);
+	const __m128 v_threshold = _mm_set1_ps(threshold_db);
+	const __m128 v_min_gain = _mm_set1_ps(EXPAND_MIN_GAIN_DB);
+	const __m128 zero = _mm_setzero_ps();
+	uint32_t i = 0;
+
+	for (; i + 4 <= frames; i += 4) {
+		__m128 db = log2_ps(_mm_loadu_ps(env + i));
+		__m128 below, g;
+
+		db = _mm_sub_ps(v_threshold, _mm_mul_ps(db, v_db_per_log2));
+		below = _mm_cmpgt_ps(db, zero);
+		g = _mm_max_ps(_mm_mul_ps(v_slope, db), v_min_gain);
+		_mm_storeu_ps(gain_db + i, _mm_and_ps(below, g));
+	}
+	for (; i < frames; i++) {
+		float db = threshold_db - log2_approx(env[i]) * DB_PER_LOG2;
+		gain_db[i] = db > 0.0f ? fmaxf(slope * db, EXPAND_MIN_GAIN_DB)
+				       : 0.0f;
+	}
+}
+
+void dyn_db_to_gain(float *gain, const float *gain_db, uint32_t frames,
+		    float output_gain)
+{
+	const __m128 v_scale = _mm_set1_ps(1.0f / DB_PER_LOG2);
+	const __m128 v_output = _mm_set1_ps(output_gain);
+	const __m128 zero = _mm_setzero_ps();
+	uint32_t i = 0;
+
+	for (; i + 4 <= frames; i += 4) {
+		__m128 g = _mm_min_ps(_mm_loadu_ps(gain_db + i), zero);
+		g = exp2_ps(_mm_mul_ps(g, v_scale));
+		_mm_storeu_ps(gain + i, _mm_mul_ps(g, v_output));
+	}
+	for (; i < frames; i++) {
+		float g = fminf(gain_db[i], 0.0f) * (1.0f / DB_PER_LOG2);
+		gain[i] = exp2_approx(g) * output_gain;
+	}
+}
+
+void dyn_apply_gain(float *const *samples, size_t channels, const float *gain,
+		    uint32_t frames)
+{
+	for (size_t c = 0; c < channels; c++) {
+		float *dst = samples[c];
+		uint32_t i = 0;
+
+		if (!dst)
+			continue;
+
+		for (; i + 4 <= frames; i += 4) {
+			__m128 v = _mm_loadu_ps(dst + i);
+			v = _mm_mul_ps(v, _mm_loadu_ps(gain + i));
+			_mm_storeu_ps(dst + i, v);
+		}
+		for (; i < frames; i++)
+			dst[i] *= gain[i];
+	}
+}
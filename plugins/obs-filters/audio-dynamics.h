@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Block based kernels shared by the dynamics filters (compressor, limiter,
+ * expander and noise gate).  Every kernel processes a whole packet at once,
+ * four samples at a time with scalar tails, and skips channels whose sample
+ * pointer is NULL.
+ *
+ * Levels are converted with polynomial log2/exp2 approximations instead of
+ * log10f/powf.  Levels are off by about 0.0001 dB at most, which is well
+ * below anything audible or visible on the meters.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* peak envelope follower: each channel starts at *envelope, env_buf receives
+ * the envelope of the loudest channel, and *envelope is set to the last value
+ * of env_buf */
+extern void dyn_peak_envelope(float *env_buf, float *const *samples,
+			      size_t channels, uint32_t frames, float *envelope,
+			      float attack_gain, float release_gain);
+
+/* dst[i] = max(|samples[c][i]|) across channels */
+extern void dyn_channel_peak(float *dst, float *const *samples,
+			     size_t channels, uint32_t frames);
+
+/* gain[i] = output_gain * db_to_mul(min(0, slope * (threshold - db(env[i]))))
+ * gain and env may be the same buffer */
+extern void dyn_compress_gain(float *gain, const float *env, uint32_t frames,
+			      float slope, float threshold_db,
+			      float output_gain);
+
+/* static expansion curve in dB, limited to -60 dB of attenuation:
+ * gain_db[i] = db(env[i]) < threshold ?
+ *              max(slope * (threshold - db(env[i])), -60) : 0
+ * gain_db and env may be the same buffer */
+extern void dyn_expand_gain_db(float *gain_db, const float *env,
+			       uint32_t frames, float slope,
+			       float threshold_db);
+
+/* gain[i] = output_gain * db_to_mul(min(0, gain_db[i]))
+ * gain and gain_db may be the same buffer */
+extern void dyn_db_to_gain(float *gain, const float *gain_db, uint32_t frames,
+			   float output_gain);
+
+/* samples[c][i] *= gain[i] */
+extern void dyn_apply_gain(float *const *samples, size_t channels,
+			   const float *gain, uint32_t frames);
+
+#ifdef __cplusplus
+}
+#endif
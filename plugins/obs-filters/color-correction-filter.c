@@ -356,6 +356,34 @@ static void color_correction_filter_render(void *data, gs_effect_t *effect)
 	UNUSED_PARAMETER(effect);
 }
 
+/* same as PSColorFilterRGBA, for when the filter is fused with others */
+static const char *fused_stage = "uniform float3 $gamma;\n"
+				 "uniform float4x4 $color_matrix;\n"
+				 "\n"
+				 "float4 $stage(float4 rgba)\n"
+				 "{\n"
+				 "\trgba.rgb = pow(rgba.rgb, $gamma);\n"
+				 "\treturn mul($color_matrix, rgba);\n"
+				 "}\n";
+
+static const char *color_correction_filter_fused_stage(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return fused_stage;
+}
+
+static void color_correction_filter_fused_params(void *data)
+{
+	struct color_correction_filter_data *filter = data;
+
+	gs_effect_set_vec3(obs_filter_get_fused_param(filter->context,
+						      SETTING_GAMMA),
+			   &filter->gamma);
+	gs_effect_set_matrix4(obs_filter_get_fused_param(filter->context,
+							 "color_matrix"),
+			      &filter->final_matrix);
+}
+
 /*
  * This function sets the interface. the types (add_*_Slider), the type of
  * data collected (int), the internal name, user-facing name, minimum,
@@ -422,6 +450,8 @@ struct obs_source_info color_filter = {
 	.create = color_correction_filter_create,
 	.destroy = color_correction_filter_destroy,
 	.video_render = color_correction_filter_render,
+	.video_get_fused_stage = color_correction_filter_fused_stage,
+	.video_set_fused_params = color_correction_filter_fused_params,
 	.update = color_correction_filter_update,
 	.get_properties = color_correction_filter_properties,
 	.get_defaults = color_correction_filter_defaults,
@@ -187,6 +187,56 @@ static void color_key_render(void *data, gs_effect_t *effect)
 	UNUSED_PARAMETER(effect);
 }
 
+/* same as PSColorKeyRGBA, for when the filter is fused with others */
+static const char *fused_stage =
+	"uniform float4 $color;\n"
+	"uniform float $contrast;\n"
+	"uniform float $brightness;\n"
+	"uniform float $gamma;\n"
+	"uniform float4 $key_color;\n"
+	"uniform float $similarity;\n"
+	"uniform float $smoothness;\n"
+	"\n"
+	"float4 $stage(float4 rgba)\n"
+	"{\n"
+	"\trgba *= $color;\n"
+	"\n"
+	"\tfloat colorDist = distance($key_color.rgb, rgba.rgb);\n"
+	"\trgba.a *= saturate(max(colorDist - $similarity, 0.0) /\n"
+	"\t\t\t    $smoothness);\n"
+	"\n"
+	"\tfloat3 gamma = float3($gamma, $gamma, $gamma);\n"
+	"\treturn float4(pow(rgba.rgb, gamma) * $contrast + $brightness,\n"
+	"\t\t      rgba.a);\n"
+	"}\n";
+
+static const char *color_key_fused_stage(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return fused_stage;
+}
+
+static void color_key_fused_params(void *data)
+{
+	struct color_key_filter_data *filter = data;
+	obs_source_t *context = filter->context;
+
+	gs_effect_set_vec4(obs_filter_get_fused_param(context, "color"),
+			   &filter->color);
+	gs_effect_set_float(obs_filter_get_fused_param(context, "contrast"),
+			    filter->contrast);
+	gs_effect_set_float(obs_filter_get_fused_param(context, "brightness"),
+			    filter->brightness);
+	gs_effect_set_float(obs_filter_get_fused_param(context, "gamma"),
+			    filter->gamma);
+	gs_effect_set_vec4(obs_filter_get_fused_param(context, "key_color"),
+			   &filter->key_color);
+	gs_effect_set_float(obs_filter_get_fused_param(context, "similarity"),
+			    filter->similarity);
+	gs_effect_set_float(obs_filter_get_fused_param(context, "smoothness"),
+			    filter->smoothness);
+}
+
 static bool key_type_changed(obs_properties_t *props, obs_property_t *p,
 			     obs_data_t *settings)
 {
@@ -256,6 +306,8 @@ struct obs_source_info color_key_filter = {
 	.create = color_key_create,
 	.destroy = color_key_destroy,
 	.video_render = color_key_render,
+	.video_get_fused_stage = color_key_fused_stage,
+	.video_set_fused_params = color_key_fused_params,
 	.update = color_key_update,
 	.get_properties = color_key_properties,
 	.get_defaults = color_key_defaults,
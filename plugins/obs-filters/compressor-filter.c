@@ -8,6 +8,8 @@
 #include <util/circlebuf.h>
 #include <util/threading.h>
 
+#include "audio-dynamics.h"
+
 /* -------------------------------------------------------- */
 
 #define do_log(level, format, ...)                \
@@ -317,27 +319,9 @@ static void analyze_envelope(struct compressor_data *cd, float **samples,
 		resize_env_buffer(cd, num_samples);
 	}
 
-	const float attack_gain = cd->attack_gain;
-	const float release_gain = cd->release_gain;
-
-	memset(cd->envelope_buf, 0, num_samples * sizeof(cd->envelope_buf[0]));
-	for (size_t chan = 0; chan < cd->num_channels; ++chan) {
-		if (!samples[chan])
-			continue;
-
-		float *envelope_buf = cd->envelope_buf;
-		float env = cd->envelope;
-		for (uint32_t i = 0; i < num_samples; ++i) {
-			const float env_in = fabsf(samples[chan][i]);
-			if (env < env_in) {
-				env = env_in + attack_gain * (env - env_in);
-			} else {
-				env = env_in + release_gain * (env - env_in);
-			}
-			envelope_buf[i] = fmaxf(envelope_buf[i], env);
-		}
-	}
-	cd->envelope = cd->envelope_buf[num_samples - 1];
+	dyn_peak_envelope(cd->envelope_buf, samples, cd->num_channels,
+			  num_samples, &cd->envelope, cd->attack_gain,
+			  cd->release_gain);
 }
 
 static void analyze_sidechain(struct compressor_data *cd,
@@ -349,45 +333,19 @@ static void analyze_sidechain(struct compressor_data *cd,
 
 	get_sidechain_data(cd, num_samples);
 
-	const float attack_gain = cd->attack_gain;
-	const float release_gain = cd->release_gain;
-	float **sidechain_buf = cd->sidechain_buf;
-
-	memset(cd->envelope_buf, 0, num_samples * sizeof(cd->envelope_buf[0]));
-	for (size_t chan = 0; chan < cd->num_channels; ++chan) {
-		if (!sidechain_buf[chan])
-			continue;
-
-		float *envelope_buf = cd->envelope_buf;
-		float env = cd->envelope;
-		for (uint32_t i = 0; i < num_samples; ++i) {
-			const float env_in = fabsf(sidechain_buf[chan][i]);
-
-			if (env < env_in) {
-				env = env_in + attack_gain * (env - env_in);
-			} else {
-				env = env_in + release_gain * (env - env_in);
-			}
-			envelope_buf[i] = fmaxf(envelope_buf[i], env);
-		}
-	}
-	cd->envelope = cd->envelope_buf[num_samples - 1];
+	dyn_peak_envelope(cd->envelope_buf, cd->sidechain_buf, cd->num_channels,
+			  num_samples, &cd->envelope, cd->attack_gain,
+			  cd->release_gain);
 }
 
 static inline void process_compression(const struct compressor_data *cd,
 				       float **samples, uint32_t num_samples)
 {
-	for (size_t i = 0; i < num_samples; ++i) {
-		const float env_db = mul_to_db(cd->envelope_buf[i]);
-		float gain = cd->slope * (cd->threshold - env_db);
-		gain = db_to_mul(fminf(0, gain));
-
-		for (size_t c = 0; c < cd->num_channels; ++c) {
-			if (samples[c]) {
-				samples[c][i] *= gain * cd->output_gain;
-			}
-		}
-	}
+	/* the envelope is turned into gain in place */
+	dyn_compress_gain(cd->envelope_buf, cd->envelope_buf, num_samples,
+			  cd->slope, cd->threshold, cd->output_gain);
+	dyn_apply_gain(samples, cd->num_channels, cd->envelope_buf,
+		       num_samples);
 }
 
 static void compressor_tick(void *data, float seconds)
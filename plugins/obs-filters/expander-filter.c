@@ -8,6 +8,8 @@
 #include <util/circlebuf.h>
 #include <util/threading.h>
 
+#include "audio-dynamics.h"
+
 /* -------------------------------------------------------- */
 
 #define do_log(level, format, ...)              \
@@ -280,18 +282,19 @@ static void analyze_envelope(struct expander_data *cd, float **samples,
 		if (cd->detector == RMS_DETECT) {
 			runave[0] =
 				rmscoef * cd->runave[chan] +
-				(1 - rmscoef) * powf(samples[chan][0], 2.0f);
+				(1 - rmscoef) * samples[chan][0] *
+					samples[chan][0];
 			env_in[0] = sqrtf(fmaxf(runave[0], 0));
 			for (uint32_t i = 1; i < num_samples; ++i) {
 				runave[i] =
 					rmscoef * runave[i - 1] +
-					(1 - rmscoef) *
-						powf(samples[chan][i], 2.0f);
+					(1 - rmscoef) * samples[chan][i] *
+						samples[chan][i];
 				env_in[i] = sqrtf(runave[i]);
 			}
 		} else if (cd->detector == PEAK_DETECT) {
 			for (uint32_t i = 0; i < num_samples; ++i) {
-				runave[i] = powf(samples[chan][i], 2);
+				runave[i] = samples[chan][i] * samples[chan][i];
 				env_in[i] = fabsf(samples[chan][i]);
 			}
 		}
@@ -312,50 +315,37 @@ static inline void process_expansion(struct expander_data *cd, float **samples,
 
 	if (cd->gaindB_len < num_samples)
 		resize_gaindB_buffer(cd, num_samples);
-	for (int i = 0; i < MAX_AUDIO_CHANNELS; i++)
-		memset(cd->gaindB[i], 0,
-		       num_samples * sizeof(cd->gaindB[i][0]));
 
 	for (size_t chan = 0; chan < cd->num_channels; chan++) {
-		for (size_t i = 0; i < num_samples; ++i) {
-			// gain stage of expansion
-			float env_db = mul_to_db(cd->envelope_buf[chan][i]);
-			float gain =
-				cd->threshold - env_db > 0.0f
-					? fmaxf(cd->slope * (cd->threshold -
-							     env_db),
-						-60.0f)
-					: 0.0f;
-			// ballistics (attack/release)
-			if (i > 0) {
-				if (gain > cd->gaindB[chan][i - 1])
-					cd->gaindB[chan][i] =
-						attack_gain *
-							cd->gaindB[chan][i - 1] +
-						(1.0f - attack_gain) * gain;
-				else
-					cd->gaindB[chan][i] =
-						release_gain *
-							cd->gaindB[chan][i - 1] +
-						(1.0f - release_gain) * gain;
-			} else {
-				if (gain > cd->gaindB_buf[chan])
-					cd->gaindB[chan][i] =
-						attack_gain *
-							cd->gaindB_buf[chan] +
-						(1.0f - attack_gain) * gain;
-				else
-					cd->gaindB[chan][i] =
-						release_gain *
-							cd->gaindB_buf[chan] +
-						(1.0f - release_gain) * gain;
-			}
+		float *gaindB = cd->gaindB[chan];
+		float prev = cd->gaindB_buf[chan];
+
+		// gain stage of expansion
+		dyn_expand_gain_db(gaindB, cd->envelope_buf[chan], num_samples,
+				   cd->slope, cd->threshold);
 
-			gain = db_to_mul(fminf(0, cd->gaindB[chan][i]));
-			if (samples[chan])
-				samples[chan][i] *= gain * cd->output_gain;
+		// ballistics (attack/release)
+		for (size_t i = 0; i < num_samples; ++i) {
+			const float gain = gaindB[i];
+
+			if (gain > prev)
+				prev = attack_gain * prev +
+				       (1.0f - attack_gain) * gain;
+			else
+				prev = release_gain * prev +
+				       (1.0f - release_gain) * gain;
+			gaindB[i] = prev;
 		}
-		cd->gaindB_buf[chan] = cd->gaindB[chan][num_samples - 1];
+		cd->gaindB_buf[chan] = prev;
+
+		if (!samples[chan])
+			continue;
+
+		/* the envelope isn't needed anymore, reuse it for the gain */
+		dyn_db_to_gain(cd->envelope_buf[chan], gaindB, num_samples,
+			       cd->output_gain);
+		dyn_apply_gain(&samples[chan], 1, cd->envelope_buf[chan],
+			       num_samples);
 	}
 }
 
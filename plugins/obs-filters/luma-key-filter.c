@@ -121,6 +121,49 @@ static void luma_key_render(void *data, gs_effect_t *effect)
 	UNUSED_PARAMETER(effect);
 }
 
+/* same as PSALumaKeyRGBA, for when the filter is fused with others */
+static const char *fused_stage =
+	"uniform float $lumaMax;\n"
+	"uniform float $lumaMin;\n"
+	"uniform float $lumaMaxSmooth;\n"
+	"uniform float $lumaMinSmooth;\n"
+	"\n"
+	"float4 $stage(float4 rgba)\n"
+	"{\n"
+	"\tfloat4 lumaCoef = float4(0.2989, 0.5870, 0.1140, 0.0);\n"
+	"\tfloat luminance = dot(rgba, lumaCoef);\n"
+	"\n"
+	"\tfloat clo = smoothstep($lumaMin, $lumaMin + $lumaMinSmooth,\n"
+	"\t\t\t       luminance);\n"
+	"\tfloat chi = 1. - smoothstep($lumaMax - $lumaMaxSmooth, $lumaMax,\n"
+	"\t\t\t\t    luminance);\n"
+	"\n"
+	"\treturn float4(rgba.rgb, clo * chi);\n"
+	"}\n";
+
+static const char *luma_key_fused_stage(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return fused_stage;
+}
+
+static void luma_key_fused_params(void *data)
+{
+	struct luma_key_filter_data *filter = data;
+	obs_source_t *context = filter->context;
+
+	gs_effect_set_float(obs_filter_get_fused_param(context, "lumaMax"),
+			    filter->luma_max);
+	gs_effect_set_float(obs_filter_get_fused_param(context, "lumaMin"),
+			    filter->luma_min);
+	gs_effect_set_float(obs_filter_get_fused_param(context,
+						       "lumaMaxSmooth"),
+			    filter->luma_max_smooth);
+	gs_effect_set_float(obs_filter_get_fused_param(context,
+						       "lumaMinSmooth"),
+			    filter->luma_min_smooth);
+}
+
 static obs_properties_t *luma_key_properties(void *data)
 {
 	obs_properties_t *props = obs_properties_create();
@@ -154,6 +197,8 @@ struct obs_source_info luma_key_filter = {
 	.create = luma_key_create,
 	.destroy = luma_key_destroy,
 	.video_render = luma_key_render,
+	.video_get_fused_stage = luma_key_fused_stage,
+	.video_set_fused_params = luma_key_fused_params,
 	.update = luma_key_update,
 	.get_properties = luma_key_properties,
 	.get_defaults = luma_key_defaults,
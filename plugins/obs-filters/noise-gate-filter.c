@@ -2,6 +2,8 @@
 #include <obs-module.h>
 #include <math.h>
 
+#include "audio-dynamics.h"
+
 #define do_log(level, format, ...)                \
 	blog(level, "[noise gate: '%s'] " format, \
 	     obs_source_get_name(ng->context), ##__VA_ARGS__)
@@ -43,6 +45,9 @@ struct noise_gate_data {
 	float attenuation;
 	float level;
 	float held_time;
+
+	float *level_buf;
+	size_t level_buf_len;
 };
 
 #define VOL_MIN -96.0
@@ -57,6 +62,7 @@ static const char *noise_gate_name(void *unused)
 static void noise_gate_destroy(void *data)
 {
 	struct noise_gate_data *ng = data;
+	bfree(ng->level_buf);
 	bfree(ng);
 }
 
@@ -122,12 +128,25 @@ noise_gate_filter_audio(void *data, struct obs_audio_data *audio)
 	const float decay_rate = ng->decay_rate;
 	const float hold_time = ng->hold_time;
 	const size_t channels = ng->channels;
+	const uint32_t frames = audio->frames;
+	float *level_buf;
 
-	for (size_t i = 0; i < audio->frames; i++) {
-		float cur_level = fabsf(adata[0][i]);
-		for (size_t j = 0; j < channels; j++) {
-			cur_level = fmaxf(cur_level, fabsf(adata[j][i]));
-		}
+	if (!frames)
+		return audio;
+
+	if (ng->level_buf_len < frames) {
+		ng->level_buf_len = frames;
+		ng->level_buf = brealloc(ng->level_buf, frames * sizeof(float));
+	}
+
+	level_buf = ng->level_buf;
+	dyn_channel_peak(level_buf, adata, channels, frames);
+
+	/* the gate state only depends on the peak level, its attenuation is
+	 * written back into the level buffer and applied to every channel at
+	 * once afterwards */
+	for (uint32_t i = 0; i < frames; i++) {
+		const float cur_level = level_buf[i];
 
 		if (cur_level > open_threshold && !ng->is_open) {
 			ng->is_open = true;
@@ -150,10 +169,10 @@ noise_gate_filter_audio(void *data, struct obs_audio_data *audio)
 			}
 		}
 
-		for (size_t c = 0; c < channels; c++)
-			adata[c][i] *= ng->attenuation;
+		level_buf[i] = ng->attenuation;
 	}
 
+	dyn_apply_gain(adata, channels, level_buf, frames);
 	return audio;
 }
 
@@ -2,6 +2,9 @@
 #include <inttypes.h>
 
 #include <util/circlebuf.h>
+#include <util/threading.h>
+#include <util/platform.h>
+#include <util/sse-intrin.h>
 #include <obs-module.h>
 #include <speex/speex_preprocess.h>
 
@@ -29,14 +32,37 @@
 
 #define MAX_PREPROC_CHANNELS 8
 
+/* packets are at most this many frames in practice, buffers are sized for
+ * it up front so they don't need to grow while processing */
+#define EXPECTED_PACKET_FRAMES AUDIO_OUTPUT_FRAMES
+#define EXPECTED_QUEUED_PACKETS 16
+
+/* channels are only processed in parallel once there are enough instances
+ * for speex to take a noticeable amount of time on the audio thread */
+#define PARALLEL_MIN_INSTANCES 3
+#define MAX_WORKERS 4
+#define MAX_PENDING_JOBS 64
+
 /* -------------------------------------------------------- */
 
+struct noise_suppress_data;
+
+/* the channels of one segment, handed out to the workers one at a time */
+struct ns_job {
+	struct noise_suppress_data *ng;
+	size_t next_channel;
+	volatile long remaining;
+	os_event_t *done;
+};
+
 struct noise_suppress_data {
 	obs_source_t *context;
 	int suppress_level;
+	int applied_level;
 
 	uint64_t last_timestamp;
 
+	uint32_t sample_rate;
 	size_t frames;
 	size_t channels;
 
@@ -54,6 +80,17 @@ struct noise_suppress_data {
 	/* output data */
 	struct obs_audio_data output_audio;
 	DARRAY(float) output_data;
+
+	struct ns_job job;
+
+	/* statistics, queried through the get_stats proc */
+	pthread_mutex_t stats_mutex;
+	uint64_t busy_ns;
+	uint64_t max_busy_ns;
+	uint64_t frames_in;
+	uint64_t segments;
+	uint32_t latency_frames;
+	uint32_t max_latency_frames;
 };
 
 /* -------------------------------------------------------- */
@@ -64,6 +101,269 @@ struct noise_suppress_data {
 static const float c_32_to_16 = (float)INT16_MAX;
 static const float c_16_to_32 = ((float)INT16_MAX + 1.0f);
 
+struct ng_audio_info {
+	uint32_t frames;
+	uint64_t timestamp;
+};
+
+/* -------------------------------------------------------- */
+
+static inline void convert_to_int16(spx_int16_t *dst, const float *src,
+				    size_t frames)
+{
+	const __m128 scale = _mm_set1_ps(c_32_to_16);
+	const __m128 min_val = _mm_set1_ps(-1.0f);
+	const __m128 max_val = _mm_set1_ps(1.0f);
+	size_t i = 0;
+
+	for (; i + 8 <= frames; i += 8) {
+		__m128 lo = _mm_loadu_ps(src + i);
+		__m128 hi = _mm_loadu_ps(src + i + 4);
+		__m128i v;
+
+		lo = _mm_mul_ps(_mm_min_ps(_mm_max_ps(lo, min_val), max_val),
+				scale);
+		hi = _mm_mul_ps(_mm_min_ps(_mm_max_ps(hi, min_val), max_val),
+				scale);
+		v = _mm_packs_epi32(_mm_cvttps_epi32(lo), _mm_cvttps_epi32(hi));
+		_mm_storeu_si128((__m128i *)(dst + i), v);
+	}
+
+	for (; i < frames; i++) {
+		float s = src[i];
+		if (s > 1.0f)
+			s = 1.0f;
+		else if (s < -1.0f)
+			s = -1.0f;
+		dst[i] = (spx_int16_t)(s * c_32_to_16);
+	}
+}
+
+static inline void convert_to_float(float *dst, const spx_int16_t *src,
+				    size_t frames)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / c_16_to_32);
+	size_t i = 0;
+
+	for (; i + 8 <= frames; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+
+		/* sign extend by placing each value in the upper half */
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+		_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+		_mm_storeu_ps(dst + i + 4,
+			      _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+	}
+
+	for (; i < frames; i++)
+		dst[i] = (float)src[i] / c_16_to_32;
+}
+
+static void process_channel(struct noise_suppress_data *ng, size_t channel)
+{
+	convert_to_int16(ng->segment_buffers[channel],
+			 ng->copy_buffers[channel], ng->frames);
+	speex_preprocess_run(ng->states[channel], ng->segment_buffers[channel]);
+	convert_to_float(ng->copy_buffers[channel],
+			 ng->segment_buffers[channel], ng->frames);
+}
+
+/* -------------------------------------------------------- */
+/* Worker threads shared by all instances.  The thread that submits a job
+ * processes channels of it as well, so a segment never waits on workers that
+ * are busy with another instance. */
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t jobs_mutex = PTHREAD_MUTEX_INITIALIZER;
+static os_sem_t *jobs_sem = NULL;
+static pthread_t workers[MAX_WORKERS];
+static size_t num_workers = 0;
+static volatile bool workers_running = false;
+static volatile long num_instances = 0;
+static bool stopping = false;
+
+static struct ns_job *jobs[MAX_PENDING_JOBS];
+static size_t num_jobs = 0;
+
+/* must be called with the jobs mutex held */
+static void remove_job(struct ns_job *job)
+{
+	for (size_t i = 0; i < num_jobs; i++) {
+		if (jobs[i] == job) {
+			memmove(&jobs[i], &jobs[i + 1],
+				(num_jobs - i - 1) * sizeof(jobs[0]));
+			num_jobs--;
+			break;
+		}
+	}
+}
+
+/* must be called with the jobs mutex held */
+static inline size_t claim_channel(struct ns_job *job)
+{
+	size_t channel = job->next_channel++;
+
+	if (job->next_channel == job->ng->channels)
+		remove_job(job);
+	return channel;
+}
+
+static void run_job_channel(struct ns_job *job, size_t channel)
+{
+	process_channel(job->ng, channel);
+
+	if (os_atomic_dec_long(&job->remaining) == 0)
+		os_event_signal(job->done);
+}
+
+static void *worker_thread(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+
+	os_set_thread_name("noise suppress: worker thread");
+
+	while (os_sem_wait(jobs_sem) == 0) {
+		struct ns_job *job = NULL;
+		size_t channel = 0;
+
+		pthread_mutex_lock(&jobs_mutex);
+		if (stopping) {
+			pthread_mutex_unlock(&jobs_mutex);
+			break;
+		}
+
+		/* the submitting thread may have taken every channel already */
+		if (num_jobs) {
+			job = jobs[0];
+			channel = claim_channel(job);
+		}
+		pthread_mutex_unlock(&jobs_mutex);
+
+		if (job)
+			run_job_channel(job, channel);
+	}
+
+	return NULL;
+}
+
+/* must be called with the pool mutex held */
+static void start_workers(void)
+{
+	int cores = os_get_logical_cores();
+	size_t count = cores > 1 ? (size_t)cores - 1 : 1;
+
+	if (count > MAX_WORKERS)
+		count = MAX_WORKERS;
+	if (os_sem_init(&jobs_sem, 0) != 0)
+		return;
+
+	stopping = false;
+
+	for (size_t i = 0; i < count; i++) {
+		if (pthread_create(&workers[num_workers], NULL, worker_thread,
+				   NULL) != 0)
+			break;
+		num_workers++;
+	}
+
+	if (!num_workers) {
+		blog(LOG_WARNING, "Failed to create noise suppression workers");
+		os_sem_destroy(jobs_sem);
+		jobs_sem = NULL;
+		return;
+	}
+
+	os_atomic_set_bool(&workers_running, true);
+}
+
+/* must be called with the pool mutex held */
+static void stop_workers(void)
+{
+	if (!num_workers)
+		return;
+
+	os_atomic_set_bool(&workers_running, false);
+
+	pthread_mutex_lock(&jobs_mutex);
+	stopping = true;
+	pthread_mutex_unlock(&jobs_mutex);
+
+	for (size_t i = 0; i < num_workers; i++)
+		os_sem_post(jobs_sem);
+	for (size_t i = 0; i < num_workers; i++)
+		pthread_join(workers[i], NULL);
+
+	os_sem_destroy(jobs_sem);
+	jobs_sem = NULL;
+	num_workers = 0;
+}
+
+static void add_instance(void)
+{
+	pthread_mutex_lock(&pool_mutex);
+	if (++num_instances >= PARALLEL_MIN_INSTANCES && !num_workers)
+		start_workers();
+	pthread_mutex_unlock(&pool_mutex);
+}
+
+static void remove_instance(void)
+{
+	pthread_mutex_lock(&pool_mutex);
+	if (--num_instances == 0)
+		stop_workers();
+	pthread_mutex_unlock(&pool_mutex);
+}
+
+static inline bool use_workers(const struct noise_suppress_data *ng)
+{
+	return ng->channels > 1 && ng->job.done &&
+	       os_atomic_load_long(&num_instances) >= PARALLEL_MIN_INSTANCES &&
+	       os_atomic_load_bool(&workers_running);
+}
+
+/* returns false if the job couldn't be queued, in which case nothing has
+ * been processed yet */
+static bool process_parallel(struct noise_suppress_data *ng)
+{
+	struct ns_job *job = &ng->job;
+	size_t channel = 0;
+	bool queued = false;
+
+	job->next_channel = 1;
+	job->remaining = (long)ng->channels;
+
+	pthread_mutex_lock(&jobs_mutex);
+	if (!stopping && num_jobs < MAX_PENDING_JOBS) {
+		jobs[num_jobs++] = job;
+		queued = true;
+	}
+	pthread_mutex_unlock(&jobs_mutex);
+
+	if (!queued)
+		return false;
+
+	for (size_t i = 1; i < ng->channels; i++)
+		os_sem_post(jobs_sem);
+
+	for (;;) {
+		run_job_channel(job, channel);
+
+		pthread_mutex_lock(&jobs_mutex);
+		queued = job->next_channel < ng->channels;
+		if (queued)
+			channel = claim_channel(job);
+		pthread_mutex_unlock(&jobs_mutex);
+
+		if (!queued)
+			break;
+	}
+
+	os_event_wait(job->done);
+	return true;
+}
+
 /* -------------------------------------------------------- */
 
 static const char *noise_suppress_name(void *unused)
@@ -76,6 +376,20 @@ static void noise_suppress_destroy(void *data)
 {
 	struct noise_suppress_data *ng = data;
 
+	if (ng->segments) {
+		const double audio_ns = (double)ng->frames_in * 1000000000.0 /
+					(double)ng->sample_rate;
+
+		info("%" PRIu64 " segments processed, %.2f%% of real time, "
+		     "longest packet %.3f ms, highest latency %.1f ms",
+		     ng->segments, (double)ng->busy_ns / audio_ns * 100.0,
+		     (double)ng->max_busy_ns / 1000000.0,
+		     (double)ng->max_latency_frames * 1000.0 /
+			     (double)ng->sample_rate);
+	}
+
+	remove_instance();
+
 	for (size_t i = 0; i < ng->channels; i++) {
 		speex_preprocess_state_destroy(ng->states[i]);
 		circlebuf_free(&ng->input_buffers[i]);
@@ -86,6 +400,8 @@ static void noise_suppress_destroy(void *data)
 	bfree(ng->copy_buffers[0]);
 	circlebuf_free(&ng->info_buffer);
 	da_free(ng->output_data);
+	os_event_destroy(ng->job.done);
+	pthread_mutex_destroy(&ng->stats_mutex);
 	bfree(ng);
 }
 
@@ -93,11 +409,16 @@ static inline void alloc_channel(struct noise_suppress_data *ng,
 				 uint32_t sample_rate, size_t channel,
 				 size_t frames)
 {
+	/* a packet can be pushed on top of almost a full segment, and
+	 * processing can add a segment on top of a packet of output */
+	const size_t capacity =
+		(frames + EXPECTED_PACKET_FRAMES) * 2 * sizeof(float);
+
 	ng->states[channel] =
 		speex_preprocess_state_init((int)frames, sample_rate);
 
-	circlebuf_reserve(&ng->input_buffers[channel], frames * sizeof(float));
-	circlebuf_reserve(&ng->output_buffers[channel], frames * sizeof(float));
+	circlebuf_reserve(&ng->input_buffers[channel], capacity);
+	circlebuf_reserve(&ng->output_buffers[channel], capacity);
 }
 
 static void noise_suppress_update(void *data, obs_data_t *s)
@@ -107,12 +428,14 @@ static void noise_suppress_update(void *data, obs_data_t *s)
 	uint32_t sample_rate = audio_output_get_sample_rate(obs_get_audio());
 	size_t channels = audio_output_get_channels(obs_get_audio());
 	size_t frames = (size_t)sample_rate / 100;
+	size_t info_size;
 
 	ng->suppress_level = (int)obs_data_get_int(s, S_SUPPRESS_LEVEL);
 
 	/* Process 10 millisecond segments to keep latency low */
 	ng->frames = frames;
 	ng->channels = channels;
+	ng->sample_rate = sample_rate;
 
 	/* Ignore if already allocated */
 	if (ng->states[0])
@@ -129,6 +452,31 @@ static void noise_suppress_update(void *data, obs_data_t *s)
 
 	for (size_t i = 0; i < channels; i++)
 		alloc_channel(ng, sample_rate, i, frames);
+
+	info_size = EXPECTED_QUEUED_PACKETS * sizeof(struct ng_audio_info);
+	circlebuf_reserve(&ng->info_buffer, info_size);
+	da_reserve(ng->output_data, EXPECTED_PACKET_FRAMES * channels);
+}
+
+static void get_stats_proc(void *data, calldata_t *cd)
+{
+	struct noise_suppress_data *ng = data;
+	double rate = (double)ng->sample_rate;
+	double latency_ms, max_latency_ms, cpu_usage, max_busy_ms;
+
+	pthread_mutex_lock(&ng->stats_mutex);
+	latency_ms = (double)ng->latency_frames * 1000.0 / rate;
+	max_latency_ms = (double)ng->max_latency_frames * 1000.0 / rate;
+	cpu_usage = ng->frames_in ? (double)ng->busy_ns * rate /
+					    ((double)ng->frames_in * 1e7)
+				  : 0.0;
+	max_busy_ms = (double)ng->max_busy_ns / 1000000.0;
+	pthread_mutex_unlock(&ng->stats_mutex);
+
+	calldata_set_float(cd, "latency_ms", latency_ms);
+	calldata_set_float(cd, "max_latency_ms", max_latency_ms);
+	calldata_set_float(cd, "cpu_usage", cpu_usage);
+	calldata_set_float(cd, "max_packet_time_ms", max_busy_ms);
 }
 
 static void *noise_suppress_create(obs_data_t *settings, obs_source_t *filter)
@@ -137,7 +485,22 @@ static void *noise_suppress_create(obs_data_t *settings, obs_source_t *filter)
 		bzalloc(sizeof(struct noise_suppress_data));
 
 	ng->context = filter;
+	ng->applied_level = SUP_MAX + 1;
+	pthread_mutex_init(&ng->stats_mutex, NULL);
+	ng->job.ng = ng;
+	if (os_event_init(&ng->job.done, OS_EVENT_TYPE_AUTO) != 0)
+		ng->job.done = NULL;
+
 	noise_suppress_update(ng, settings);
+
+	proc_handler_t *ph = obs_source_get_proc_handler(filter);
+	proc_handler_add(ph,
+			 "void get_stats(out float latency_ms, "
+			 "out float max_latency_ms, out float cpu_usage, "
+			 "out float max_packet_time_ms)",
+			 get_stats_proc, ng);
+
+	add_instance();
 	return ng;
 }
 
@@ -149,32 +512,21 @@ static inline void process(struct noise_suppress_data *ng)
 				    ng->frames * sizeof(float));
 
 	/* Set args */
-	for (size_t i = 0; i < ng->channels; i++)
-		speex_preprocess_ctl(ng->states[i],
-				     SPEEX_PREPROCESS_SET_NOISE_SUPPRESS,
-				     &ng->suppress_level);
-
-	/* Convert to 16bit */
-	for (size_t i = 0; i < ng->channels; i++)
-		for (size_t j = 0; j < ng->frames; j++) {
-			float s = ng->copy_buffers[i][j];
-			if (s > 1.0f)
-				s = 1.0f;
-			else if (s < -1.0f)
-				s = -1.0f;
-			ng->segment_buffers[i][j] =
-				(spx_int16_t)(s * c_32_to_16);
-		}
-
-	/* Execute */
-	for (size_t i = 0; i < ng->channels; i++)
-		speex_preprocess_run(ng->states[i], ng->segment_buffers[i]);
+	if (ng->applied_level != ng->suppress_level) {
+		ng->applied_level = ng->suppress_level;
+
+		for (size_t i = 0; i < ng->channels; i++)
+			speex_preprocess_ctl(
+				ng->states[i],
+				SPEEX_PREPROCESS_SET_NOISE_SUPPRESS,
+				&ng->applied_level);
+	}
 
-	/* Convert back to 32bit */
-	for (size_t i = 0; i < ng->channels; i++)
-		for (size_t j = 0; j < ng->frames; j++)
-			ng->copy_buffers[i][j] =
-				(float)ng->segment_buffers[i][j] / c_16_to_32;
+	/* Convert to 16bit, execute, convert back to 32bit */
+	if (!use_workers(ng) || !process_parallel(ng)) {
+		for (size_t i = 0; i < ng->channels; i++)
+			process_channel(ng, i);
+	}
 
 	/* Push to output circlebuf */
 	for (size_t i = 0; i < ng->channels; i++)
@@ -182,16 +534,33 @@ static inline void process(struct noise_suppress_data *ng)
 				    ng->frames * sizeof(float));
 }
 
-struct ng_audio_info {
-	uint32_t frames;
-	uint64_t timestamp;
-};
-
 static inline void clear_circlebuf(struct circlebuf *buf)
 {
 	circlebuf_pop_front(buf, NULL, buf->size);
 }
 
+/* latency is the audio held by the filter: everything that went in but
+ * hasn't been returned yet */
+static void update_stats(struct noise_suppress_data *ng, uint32_t frames,
+			 uint64_t segments, uint64_t start_time)
+{
+	uint64_t busy_ns = os_gettime_ns() - start_time;
+	uint32_t latency = (uint32_t)((ng->input_buffers[0].size +
+				       ng->output_buffers[0].size) /
+				      sizeof(float));
+
+	pthread_mutex_lock(&ng->stats_mutex);
+	ng->busy_ns += busy_ns;
+	ng->frames_in += frames;
+	ng->segments += segments;
+	ng->latency_frames = latency;
+	if (busy_ns > ng->max_busy_ns)
+		ng->max_busy_ns = busy_ns;
+	if (latency > ng->max_latency_frames)
+		ng->max_latency_frames = latency;
+	pthread_mutex_unlock(&ng->stats_mutex);
+}
+
 static void reset_data(struct noise_suppress_data *ng)
 {
 	for (size_t i = 0; i < ng->channels; i++) {
@@ -209,10 +578,14 @@ noise_suppress_filter_audio(void *data, struct obs_audio_data *audio)
 	struct ng_audio_info info;
 	size_t segment_size = ng->frames * sizeof(float);
 	size_t out_size;
+	uint64_t start_time;
+	uint64_t segments = 0;
 
 	if (!ng->states[0])
 		return audio;
 
+	start_time = os_gettime_ns();
+
 	/* -----------------------------------------------
 	 * if timestamp has dramatically changed, consider it a new stream of
 	 * audio data.  clear all circular buffers to prevent old audio data
@@ -241,8 +614,10 @@ noise_suppress_filter_audio(void *data, struct obs_audio_data *audio)
 
 	/* -----------------------------------------------
 	 * pop/process each 10ms segments, push back to output circlebuf */
-	while (ng->input_buffers[0].size >= segment_size)
+	while (ng->input_buffers[0].size >= segment_size) {
 		process(ng);
+		segments++;
+	}
 
 	/* -----------------------------------------------
 	 * peek front of info circlebuf, check to see if we have enough to
@@ -251,18 +626,20 @@ noise_suppress_filter_audio(void *data, struct obs_audio_data *audio)
 	circlebuf_peek_front(&ng->info_buffer, &info, sizeof(info));
 	out_size = info.frames * sizeof(float);
 
-	if (ng->output_buffers[0].size < out_size)
+	if (ng->output_buffers[0].size < out_size) {
+		update_stats(ng, audio->frames, segments, start_time);
 		return NULL;
+	}
 
 	/* -----------------------------------------------
 	 * if there's enough audio data buffered in the output circlebuf,
 	 * pop and return a packet */
 	circlebuf_pop_front(&ng->info_buffer, NULL, sizeof(info));
-	da_resize(ng->output_data, out_size * ng->channels);
+	da_resize(ng->output_data, info.frames * ng->channels);
 
 	for (size_t i = 0; i < ng->channels; i++) {
 		ng->output_audio.data[i] =
-			(uint8_t *)&ng->output_data.array[i * out_size];
+			(uint8_t *)&ng->output_data.array[i * info.frames];
 
 		circlebuf_pop_front(&ng->output_buffers[i],
 				    ng->output_audio.data[i], out_size);
@@ -270,6 +647,8 @@ noise_suppress_filter_audio(void *data, struct obs_audio_data *audio)
 
 	ng->output_audio.frames = info.frames;
 	ng->output_audio.timestamp = info.timestamp;
+
+	update_stats(ng, audio->frames, segments, start_time);
 	return &ng->output_audio;
 }
 
@@ -17,8 +17,10 @@
 
 #include <obs.h>
 #include <stdio.h>
+#include <inttypes.h>
 #include <util/dstr.h>
 #include <util/array-serializer.h>
+#include <util/threading.h>
 #include "flv-mux.h"
 #include "obs-output-ver.h"
 #include "rtmp-helpers.h"
@@ -264,3 +266,147 @@ void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset,
 	*output = data.bytes.array;
 	*size = data.bytes.num;
 }
+
+/* ------------------------------------------------------------------------- */
+/* Shared tag cache
+ *
+ * When several RTMP outputs stream from the same encoders, each of them would
+ * serialize identical FLV tags.  Recently muxed tags are kept in a small
+ * direct-mapped table keyed by the packet and dts offset, and handed out by
+ * reference until the other consumers have all taken them (or the slot gets
+ * reused).  Packets are identified by their encoder, track and system dts,
+ * which stays unique across encoder restarts. */
+
+#define TAG_CACHE_BITS 6
+#define TAG_CACHE_SIZE (1 << TAG_CACHE_BITS)
+
+struct tag_cache_entry {
+	const obs_encoder_t *encoder;
+	enum obs_encoder_type type;
+	size_t track_idx;
+	int64_t dts_usec;
+	int64_t dts;
+	size_t size;
+	int32_t dts_offset;
+
+	struct flv_tag *tag;
+	long remaining;
+};
+
+static struct tag_cache_entry tag_cache[TAG_CACHE_SIZE];
+static pthread_mutex_t tag_cache_mutex;
+static uint64_t tag_cache_hits;
+static uint64_t tag_cache_misses;
+
+void flv_tag_cache_init(void)
+{
+	pthread_mutex_init(&tag_cache_mutex, NULL);
+}
+
+void flv_tag_cache_free(void)
+{
+	for (size_t i = 0; i < TAG_CACHE_SIZE; i++) {
+		flv_tag_release(tag_cache[i].tag);
+		tag_cache[i].tag = NULL;
+	}
+
+	if (tag_cache_hits)
+		blog(LOG_INFO,
+		     "FLV tag cache: %" PRIu64 " hits, %" PRIu64 " misses",
+		     tag_cache_hits, tag_cache_misses);
+
+	pthread_mutex_destroy(&tag_cache_mutex);
+}
+
+static struct flv_tag *flv_tag_create(struct encoder_packet *packet,
+				      int32_t dts_offset)
+{
+	struct flv_tag *tag = bmalloc(sizeof(*tag));
+	tag->refs = 1;
+	flv_packet_mux(packet, dts_offset, &tag->data, &tag->size, false);
+	return tag;
+}
+
+void flv_tag_release(struct flv_tag *tag)
+{
+	if (tag && os_atomic_dec_long(&tag->refs) == 0) {
+		bfree(tag->data);
+		bfree(tag);
+	}
+}
+
+static inline size_t tag_cache_slot(const struct encoder_packet *packet,
+				    int32_t dts_offset)
+{
+	uint64_t hash = (uint64_t)packet->dts_usec ^
+			((uint64_t)(uintptr_t)packet->encoder >> 4) ^
+			((uint64_t)packet->track_idx << 32) ^
+			(uint64_t)(uint32_t)dts_offset;
+
+	hash ^= hash >> 17;
+	hash *= 0x9E3779B97F4A7C15ULL;
+	return (size_t)(hash >> (64 - TAG_CACHE_BITS));
+}
+
+static inline bool tag_cache_match(const struct tag_cache_entry *entry,
+				   const struct encoder_packet *packet,
+				   int32_t dts_offset)
+{
+	return entry->tag && entry->encoder == packet->encoder &&
+	       entry->type == packet->type &&
+	       entry->track_idx == packet->track_idx &&
+	       entry->dts_usec == packet->dts_usec &&
+	       entry->dts == packet->dts && entry->size == packet->size &&
+	       entry->dts_offset == dts_offset;
+}
+
+struct flv_tag *flv_packet_mux_shared(struct encoder_packet *packet,
+				      int32_t dts_offset, long consumers)
+{
+	struct tag_cache_entry *entry;
+	struct flv_tag *prev_tag;
+	struct flv_tag *tag = NULL;
+
+	if (consumers <= 1)
+		return flv_tag_create(packet, dts_offset);
+
+	entry = &tag_cache[tag_cache_slot(packet, dts_offset)];
+
+	pthread_mutex_lock(&tag_cache_mutex);
+	if (tag_cache_match(entry, packet, dts_offset)) {
+		tag = entry->tag;
+		os_atomic_inc_long(&tag->refs);
+
+		/* everyone else has it now, the cache's ref can go */
+		if (--entry->remaining <= 0) {
+			os_atomic_dec_long(&tag->refs);
+			entry->tag = NULL;
+		}
+
+		tag_cache_hits++;
+	}
+	pthread_mutex_unlock(&tag_cache_mutex);
+
+	if (tag)
+		return tag;
+
+	tag = flv_tag_create(packet, dts_offset);
+	os_atomic_inc_long(&tag->refs);
+
+	pthread_mutex_lock(&tag_cache_mutex);
+	prev_tag = entry->tag;
+	entry->encoder = packet->encoder;
+	entry->type = packet->type;
+	entry->track_idx = packet->track_idx;
+	entry->dts_usec = packet->dts_usec;
+	entry->dts = packet->dts;
+	entry->size = packet->size;
+	entry->dts_offset = dts_offset;
+	entry->tag = tag;
+	entry->remaining = consumers - 1;
+	tag_cache_misses++;
+	pthread_mutex_unlock(&tag_cache_mutex);
+
+	flv_tag_release(prev_tag);
+	return tag;
+}
@@ -32,3 +32,21 @@ extern bool flv_meta_data(obs_output_t *context, uint8_t **output, size_t *size,
 			  bool write_header, size_t audio_idx);
 extern void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset,
 			   uint8_t **output, size_t *size, bool is_header);
+
+/* refcounted muxed FLV tag, shared between outputs sending the same packet */
+struct flv_tag {
+	volatile long refs;
+	uint8_t *data;
+	size_t size;
+};
+
+extern void flv_tag_cache_init(void);
+extern void flv_tag_cache_free(void);
+
+/* muxes a (non-header) packet, or returns the tag already muxed for it with
+ * the same dts offset.  consumers is the number of outputs that are expected
+ * to send the packet; with one consumer nothing is cached. */
+extern struct flv_tag *flv_packet_mux_shared(struct encoder_packet *packet,
+					     int32_t dts_offset,
+					     long consumers);
+extern void flv_tag_release(struct flv_tag *tag);
@@ -1,6 +1,7 @@
 #include <obs-module.h>
 
 #include "obs-outputs-config.h"
+#include "flv-mux.h"
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -28,6 +29,8 @@ bool obs_module_load(void)
 	WSAStartup(MAKEWORD(2, 2), &wsad);
 #endif
 
+	flv_tag_cache_init();
+
 	obs_register_output(&rtmp_output_info);
 	obs_register_output(&null_output_info);
 	obs_register_output(&flv_output_info);
@@ -39,6 +42,8 @@ bool obs_module_load(void)
 
 void obs_module_unload(void)
 {
+	flv_tag_cache_free();
+
 #ifdef _WIN32
 	WSACleanup();
 #endif
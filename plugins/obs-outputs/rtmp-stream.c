@@ -50,6 +50,97 @@ static void log_rtmp(int level, const char *format, va_list args)
 }
 
 static inline size_t num_buffered_packets(struct rtmp_stream *stream);
+static int64_t get_backlog_usec(struct rtmp_stream *stream);
+
+/* number of sending streams per encoder, i.e. the number of consumers that
+ * may share the muxed tags of that encoder's packets */
+struct encoder_consumers {
+	const obs_encoder_t *encoder;
+	long streams;
+};
+
+static pthread_mutex_t consumers_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(struct encoder_consumers) consumers;
+
+/* must be called with the consumers mutex held */
+static inline size_t find_encoder_consumers(const obs_encoder_t *encoder)
+{
+	for (size_t i = 0; i < consumers.num; i++) {
+		if (consumers.array[i].encoder == encoder)
+			return i;
+	}
+
+	return DARRAY_INVALID;
+}
+
+static long get_encoder_consumers(const obs_encoder_t *encoder)
+{
+	long streams = 0;
+	size_t idx;
+
+	pthread_mutex_lock(&consumers_mutex);
+	idx = find_encoder_consumers(encoder);
+	if (idx != DARRAY_INVALID)
+		streams = consumers.array[idx].streams;
+	pthread_mutex_unlock(&consumers_mutex);
+
+	return streams;
+}
+
+static void add_consumer(struct rtmp_stream *stream)
+{
+	obs_output_t *context = stream->output;
+	obs_encoder_t *encoder;
+
+	stream->num_consumer_encoders = 0;
+
+	encoder = obs_output_get_video_encoder(context);
+	if (encoder)
+		stream->consumer_encoders[stream->num_consumer_encoders++] =
+			encoder;
+
+	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
+		encoder = obs_output_get_audio_encoder(context, i);
+		if (encoder)
+			stream->consumer_encoders
+				[stream->num_consumer_encoders++] = encoder;
+	}
+
+	pthread_mutex_lock(&consumers_mutex);
+	for (size_t i = 0; i < stream->num_consumer_encoders; i++) {
+		const obs_encoder_t *cur = stream->consumer_encoders[i];
+		size_t idx = find_encoder_consumers(cur);
+
+		if (idx == DARRAY_INVALID) {
+			struct encoder_consumers *item =
+				da_push_back_new(consumers);
+			item->encoder = cur;
+			idx = consumers.num - 1;
+		}
+
+		consumers.array[idx].streams++;
+	}
+	pthread_mutex_unlock(&consumers_mutex);
+}
+
+static void remove_consumer(struct rtmp_stream *stream)
+{
+	pthread_mutex_lock(&consumers_mutex);
+	for (size_t i = 0; i < stream->num_consumer_encoders; i++) {
+		size_t idx =
+			find_encoder_consumers(stream->consumer_encoders[i]);
+
+		if (idx != DARRAY_INVALID &&
+		    --consumers.array[idx].streams == 0)
+			da_erase(consumers, idx);
+	}
+
+	if (!consumers.num)
+		da_free(consumers);
+	pthread_mutex_unlock(&consumers_mutex);
+
+	stream->num_consumer_encoders = 0;
+}
 
 static inline void free_packets(struct rtmp_stream *stream)
 {
@@ -66,6 +157,7 @@ static inline void free_packets(struct rtmp_stream *stream)
 		circlebuf_pop_front(&stream->packets, &packet, sizeof(packet));
 		obs_encoder_packet_release(&packet);
 	}
+	stream->backlog_bytes = 0;
 	pthread_mutex_unlock(&stream->packets_mutex);
 }
 
@@ -139,6 +231,17 @@ static void rtmp_stream_destroy(void *data)
 	bfree(stream);
 }
 
+static void get_backlog_proc(void *data, calldata_t *cd)
+{
+	struct rtmp_stream *stream = data;
+
+	pthread_mutex_lock(&stream->packets_mutex);
+	calldata_set_int(cd, "packets", num_buffered_packets(stream));
+	calldata_set_int(cd, "bytes", stream->backlog_bytes);
+	calldata_set_int(cd, "duration_ms", get_backlog_usec(stream) / 1000);
+	pthread_mutex_unlock(&stream->packets_mutex);
+}
+
 static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 {
 	struct rtmp_stream *stream = bzalloc(sizeof(struct rtmp_stream));
@@ -185,6 +288,12 @@ static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 		goto fail;
 	}
 
+	proc_handler_t *ph = obs_output_get_proc_handler(output);
+	proc_handler_add(ph,
+			 "void get_backlog(out int packets, out int bytes, "
+			 "out int duration_ms)",
+			 get_backlog_proc, stream);
+
 	UNUSED_PARAMETER(settings);
 	return stream;
 
@@ -242,6 +351,7 @@ static inline bool get_next_packet(struct rtmp_stream *stream,
 	if (stream->packets.size) {
 		circlebuf_pop_front(&stream->packets, packet,
 				    sizeof(struct encoder_packet));
+		stream->backlog_bytes -= packet->size;
 		new_packet = true;
 	}
 	pthread_mutex_unlock(&stream->packets_mutex);
@@ -402,6 +512,7 @@ static int send_packet(struct rtmp_stream *stream,
 		       struct encoder_packet *packet, bool is_header,
 		       size_t idx)
 {
+	struct flv_tag *tag = NULL;
 	uint8_t *data;
 	size_t size;
 	int recv_size = 0;
@@ -423,15 +534,27 @@ static int send_packet(struct rtmp_stream *stream,
 		}
 	}
 
-	flv_packet_mux(packet, is_header ? 0 : stream->start_dts_offset, &data,
-		       &size, is_header);
+	if (is_header) {
+		flv_packet_mux(packet, 0, &data, &size, true);
+	} else {
+		long streams = get_encoder_consumers(packet->encoder);
+		tag = flv_packet_mux_shared(packet,
+					    (int32_t)stream->start_dts_offset,
+					    streams);
+		data = tag->data;
+		size = tag->size;
+	}
 
 #ifdef TEST_FRAMEDROPS
 	droptest_cap_data_rate(stream, size);
 #endif
 
 	ret = RTMP_Write(&stream->rtmp, (char *)data, (int)size, (int)idx);
-	bfree(data);
+
+	if (tag)
+		flv_tag_release(tag);
+	else
+		bfree(data);
 
 	if (is_header)
 		bfree(packet->data);
@@ -577,6 +700,9 @@ static void *send_thread(void *data)
 			break;
 		}
 
+		if (disconnected(stream))
+			break;
+
 		if (!get_next_packet(stream, &packet))
 			continue;
 
@@ -646,6 +772,7 @@ static void *send_thread(void *data)
 	free_packets(stream);
 	os_event_reset(stream->stop_event);
 	os_atomic_set_bool(&stream->active, false);
+	remove_consumer(stream);
 	stream->sent_headers = false;
 
 	/* reset bitrate on stop */
@@ -770,8 +897,13 @@ static int init_send(struct rtmp_stream *stream)
 
 	reset_semaphore(stream);
 
+	/* counted before the send thread starts, the send thread removes it
+	 * again when it exits */
+	add_consumer(stream);
+
 	ret = pthread_create(&stream->send_thread, NULL, send_thread, stream);
 	if (ret != 0) {
+		remove_consumer(stream);
 		RTMP_Close(&stream->rtmp);
 		warn("Failed to create send thread");
 		return OBS_OUTPUT_ERROR;
@@ -1052,6 +1184,8 @@ static bool init_connect(struct rtmp_stream *stream)
 	drop_p = (int64_t)obs_data_get_int(settings, OPT_PFRAME_DROP_THRESHOLD);
 	stream->max_shutdown_time_sec =
 		(int)obs_data_get_int(settings, OPT_MAX_SHUTDOWN_TIME_SEC);
+	stream->max_backlog_usec =
+		1000 * obs_data_get_int(settings, OPT_MAX_BACKLOG);
 
 	obs_encoder_t *venc = obs_output_get_video_encoder(stream->output);
 	obs_encoder_t *aenc = obs_output_get_audio_encoder(stream->output, 0);
@@ -1147,6 +1281,50 @@ static inline bool add_packet(struct rtmp_stream *stream,
 {
 	circlebuf_push_back(&stream->packets, packet,
 			    sizeof(struct encoder_packet));
+	stream->backlog_bytes += packet->size;
+	return true;
+}
+
+static int64_t get_backlog_usec(struct rtmp_stream *stream)
+{
+	struct encoder_packet *first;
+	struct encoder_packet *last;
+
+	if (!stream->packets.size)
+		return 0;
+
+	first = circlebuf_data(&stream->packets, 0);
+	last = circlebuf_data(&stream->packets,
+			      stream->packets.size - sizeof(*last));
+	return last->dts_usec - first->dts_usec;
+}
+
+#define BACKLOG_WARNING_INTERVAL (10 * SEC_TO_NSEC)
+
+/* drops this destination (and lets the output reconnect) if it has fallen
+ * too far behind, rather than letting its backlog grow indefinitely */
+static bool check_backlog(struct rtmp_stream *stream)
+{
+	int64_t backlog_usec;
+	uint64_t now;
+
+	if (!stream->max_backlog_usec || disconnected(stream))
+		return false;
+
+	backlog_usec = get_backlog_usec(stream);
+	if (backlog_usec <= stream->max_backlog_usec)
+		return false;
+
+	now = os_gettime_ns();
+	if (now - stream->last_backlog_warning >= BACKLOG_WARNING_INTERVAL) {
+		warn("Send backlog of %" PRId64 " ms (%zu bytes) exceeds the "
+		     "limit of %" PRId64 " ms, disconnecting",
+		     backlog_usec / 1000, stream->backlog_bytes,
+		     stream->max_backlog_usec / 1000);
+		stream->last_backlog_warning = now;
+	}
+
+	os_atomic_set_bool(&stream->disconnected, true);
 	return true;
 }
 
@@ -1182,6 +1360,7 @@ static void drop_frames(struct rtmp_stream *stream, const char *name,
 
 		} else {
 			num_frames_dropped++;
+			stream->backlog_bytes -= packet.size;
 			obs_encoder_packet_release(&packet);
 		}
 	}
@@ -1433,6 +1612,9 @@ static void rtmp_stream_data(void *data, struct encoder_packet *packet)
 		added_packet = (packet->type == OBS_ENCODER_VIDEO)
 				       ? add_video_packet(stream, &new_packet)
 				       : add_packet(stream, &new_packet);
+
+		if (check_backlog(stream))
+			os_sem_post(stream->send_sem);
 	}
 
 	pthread_mutex_unlock(&stream->packets_mutex);
@@ -1451,6 +1633,7 @@ static void rtmp_stream_defaults(obs_data_t *defaults)
 	obs_data_set_default_string(defaults, OPT_BIND_IP, "default");
 	obs_data_set_default_bool(defaults, OPT_NEWSOCKETLOOP_ENABLED, false);
 	obs_data_set_default_bool(defaults, OPT_LOWLATENCY_ENABLED, false);
+	obs_data_set_default_int(defaults, OPT_MAX_BACKLOG, 0);
 }
 
 static obs_properties_t *rtmp_stream_properties(void *unused)
@@ -1464,6 +1647,9 @@ static obs_properties_t *rtmp_stream_properties(void *unused)
 	obs_properties_add_int(props, OPT_DROP_THRESHOLD,
 			       obs_module_text("RTMPStream.DropThreshold"), 200,
 			       10000, 100);
+	obs_properties_add_int(props, OPT_MAX_BACKLOG,
+			       obs_module_text("RTMPStream.MaxBacklog"), 0,
+			       60000, 500);
 
 	p = obs_properties_add_list(props, OPT_BIND_IP,
 				    obs_module_text("RTMPStream.BindIP"),
@@ -31,6 +31,7 @@
 #define OPT_BIND_IP "bind_ip"
 #define OPT_NEWSOCKETLOOP_ENABLED "new_socket_loop_enabled"
 #define OPT_LOWLATENCY_ENABLED "low_latency_mode_enabled"
+#define OPT_MAX_BACKLOG "max_backlog_ms"
 
 //#define TEST_FRAMEDROPS
 //#define TEST_FRAMEDROPS_WITH_BITRATE_SHORTCUTS
@@ -90,6 +91,15 @@ struct rtmp_stream {
 
 	int64_t last_dts_usec;
 
+	/* data waiting to be sent to this destination */
+	size_t backlog_bytes;
+	int64_t max_backlog_usec;
+	uint64_t last_backlog_warning;
+
+	/* encoders this stream counts as a consumer of while sending */
+	const obs_encoder_t *consumer_encoders[MAX_AUDIO_MIXES + 1];
+	size_t num_consumer_encoders;
+
 	uint64_t total_bytes_sent;
 	int dropped_frames;
 
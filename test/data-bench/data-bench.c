@@ -0,0 +1,247 @@
+/*
+ * Compares obs_data's JSON reader/writer against the previous jansson based
+ * implementation: for each file given, both load and dump times are measured
+ * and the output of both writers is checked to be identical.
+ *
+ * usage: data-bench [-n iterations] file.json [file.json ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jansson.h>
+#include <util/platform.h>
+#include <util/bmem.h>
+#include <obs-data.h>
+
+/* ------------------------------------------------------------------------- */
+/* previous implementation, using jansson                                    */
+
+static void jansson_add_item(obs_data_t *data, const char *key, json_t *json);
+
+static void jansson_add_object_data(obs_data_t *data, json_t *jobj)
+{
+	const char *item_key;
+	json_t *jitem;
+
+	json_object_foreach (jobj, item_key, jitem) {
+		jansson_add_item(data, item_key, jitem);
+	}
+}
+
+static void jansson_add_item(obs_data_t *data, const char *key, json_t *json)
+{
+	if (json_is_object(json)) {
+		obs_data_t *sub_obj = obs_data_create();
+		jansson_add_object_data(sub_obj, json);
+		obs_data_set_obj(data, key, sub_obj);
+		obs_data_release(sub_obj);
+
+	} else if (json_is_array(json)) {
+		obs_data_array_t *array = obs_data_array_create();
+		size_t idx;
+		json_t *jitem;
+
+		json_array_foreach (json, idx, jitem) {
+			if (!json_is_object(jitem))
+				continue;
+
+			obs_data_t *item = obs_data_create();
+			jansson_add_object_data(item, jitem);
+			obs_data_array_push_back(array, item);
+			obs_data_release(item);
+		}
+
+		obs_data_set_array(data, key, array);
+		obs_data_array_release(array);
+
+	} else if (json_is_string(json)) {
+		obs_data_set_string(data, key, json_string_value(json));
+	} else if (json_is_integer(json)) {
+		obs_data_set_int(data, key, json_integer_value(json));
+	} else if (json_is_real(json)) {
+		obs_data_set_double(data, key, json_real_value(json));
+	} else if (json_is_true(json)) {
+		obs_data_set_bool(data, key, true);
+	} else if (json_is_false(json)) {
+		obs_data_set_bool(data, key, false);
+	}
+}
+
+static obs_data_t *jansson_load(const char *str)
+{
+	json_error_t error;
+	json_t *root = json_loads(str, JSON_REJECT_DUPLICATES, &error);
+	obs_data_t *data;
+
+	if (!root)
+		return NULL;
+
+	data = obs_data_create();
+	jansson_add_object_data(data, root);
+	json_decref(root);
+	return data;
+}
+
+static json_t *jansson_from_data(obs_data_t *data)
+{
+	json_t *json = json_object();
+	obs_data_item_t *item;
+
+	for (item = obs_data_first(data); item; obs_data_item_next(&item)) {
+		enum obs_data_type type = obs_data_item_gettype(item);
+		const char *name = obs_data_item_get_name(item);
+		json_t *val = NULL;
+
+		if (!obs_data_item_has_user_value(item))
+			continue;
+
+		if (type == OBS_DATA_STRING) {
+			val = json_string(obs_data_item_get_string(item));
+
+		} else if (type == OBS_DATA_NUMBER) {
+			if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT)
+				val = json_integer(obs_data_item_get_int(item));
+			else
+				val = json_real(obs_data_item_get_double(item));
+
+		} else if (type == OBS_DATA_BOOLEAN) {
+			val = obs_data_item_get_bool(item) ? json_true()
+							   : json_false();
+
+		} else if (type == OBS_DATA_OBJECT) {
+			obs_data_t *obj = obs_data_item_get_obj(item);
+			val = jansson_from_data(obj);
+			obs_data_release(obj);
+
+		} else if (type == OBS_DATA_ARRAY) {
+			obs_data_array_t *array = obs_data_item_get_array(item);
+			size_t count = obs_data_array_count(array);
+
+			val = json_array();
+			for (size_t i = 0; i < count; i++) {
+				obs_data_t *obj = obs_data_array_item(array, i);
+				json_t *jobj = jansson_from_data(obj);
+				json_array_append_new(val, jobj);
+				obs_data_release(obj);
+			}
+			obs_data_array_release(array);
+		}
+
+		json_object_set_new(json, name, val);
+	}
+
+	return json;
+}
+
+static char *jansson_dump(obs_data_t *data)
+{
+	json_t *root = jansson_from_data(data);
+	char *str = json_dumps(root, JSON_PRESERVE_ORDER | JSON_INDENT(4));
+	json_decref(root);
+	return str;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline double ms_since(uint64_t start, int iterations)
+{
+	return (double)(os_gettime_ns() - start) / 1000000.0 / iterations;
+}
+
+static bool bench_file(const char *file, int iterations)
+{
+	char *str = os_quick_read_utf8_file(file);
+	obs_data_t *old_data;
+	obs_data_t *new_data;
+	double old_load, new_load, old_dump, new_dump;
+	uint64_t start;
+	char *old_json;
+	bool success = true;
+
+	if (!str) {
+		printf("%s: could not read file\n", file);
+		return false;
+	}
+
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++)
+		obs_data_release(jansson_load(str));
+	old_load = ms_since(start, iterations);
+
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++)
+		obs_data_release(obs_data_create_from_json(str));
+	new_load = ms_since(start, iterations);
+
+	old_data = jansson_load(str);
+	new_data = obs_data_create_from_json(str);
+	bfree(str);
+
+	if (!old_data || !new_data) {
+		printf("%s: %s\n", file,
+		       !old_data && !new_data ? "invalid json (both rejected)"
+					      : "MISMATCH: only one rejected");
+		obs_data_release(old_data);
+		obs_data_release(new_data);
+		return !old_data && !new_data;
+	}
+
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++)
+		free(jansson_dump(old_data));
+	old_dump = ms_since(start, iterations);
+
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++)
+		obs_data_get_json(old_data);
+	new_dump = ms_since(start, iterations);
+
+	/* check both writers, and both readers */
+	old_json = jansson_dump(old_data);
+	if (strcmp(old_json, obs_data_get_json(old_data)) != 0) {
+		printf("%s: MISMATCH: written json differs\n", file);
+		success = false;
+	}
+	if (strcmp(old_json, obs_data_get_json(new_data)) != 0) {
+		printf("%s: MISMATCH: loaded data differs\n", file);
+		success = false;
+	}
+
+	printf("%s: load %.3f ms -> %.3f ms, dump %.3f ms -> %.3f ms "
+	       "(%zu bytes)\n",
+	       file, old_load, new_load, old_dump, new_dump, strlen(old_json));
+
+	free(old_json);
+	obs_data_release(old_data);
+	obs_data_release(new_data);
+	return success;
+}
+
+int main(int argc, char *argv[])
+{
+	int iterations = 100;
+	bool success = true;
+	int i = 1;
+
+	if (i + 1 < argc && strcmp(argv[i], "-n") == 0) {
+		iterations = atoi(argv[i + 1]);
+		if (iterations < 1)
+			iterations = 1;
+		i += 2;
+	}
+
+	if (i >= argc) {
+		printf("usage: %s [-n iterations] file.json [file.json ...]\n",
+		       argv[0]);
+		return 1;
+	}
+
+	for (; i < argc; i++) {
+		if (!bench_file(argv[i], iterations))
+			success = false;
+	}
+
+	printf("memory leaks: %ld\n", bnum_allocs());
+	return success ? 0 : 1;
+}
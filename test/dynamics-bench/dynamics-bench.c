@@ -0,0 +1,467 @@
+/*
+ * Compares the block kernels of the dynamics filters (audio-dynamics.c in
+ * obs-filters) against the previous per-sample implementation, which used
+ * log10f/powf through mul_to_db/db_to_mul: the accuracy of every kernel is
+ * checked over random signals and block lengths that exercise the scalar
+ * tails, then each kernel is timed against its scalar counterpart.
+ *
+ * usage: dynamics-bench [-n iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <util/platform.h>
+#include <media-io/audio-math.h>
+
+#include "audio-dynamics.h"
+
+#define CHANNELS 6
+#define MAX_FRAMES 1027
+#define BENCH_FRAMES 1024
+
+/* gains are compared in dB, 0.001 dB is far below anything audible.  the
+ * gain curves scale errors in the measured level by their slope, so those
+ * are divided by the slope to compare the level error itself */
+#define MAX_ERROR_DB 0.001
+
+/* ------------------------------------------------------------------------- */
+/* previous implementation, from the compressor, expander and noise gate    */
+
+static void ref_peak_envelope(float *env_buf, float *const *samples,
+			      size_t channels, uint32_t frames, float *envelope,
+			      float attack_gain, float release_gain)
+{
+	memset(env_buf, 0, frames * sizeof(float));
+
+	for (size_t c = 0; c < channels; c++) {
+		float env = *envelope;
+
+		if (!samples[c])
+			continue;
+
+		for (uint32_t i = 0; i < frames; i++) {
+			const float env_in = fabsf(samples[c][i]);
+			if (env < env_in)
+				env = env_in + attack_gain * (env - env_in);
+			else
+				env = env_in + release_gain * (env - env_in);
+			env_buf[i] = fmaxf(env_buf[i], env);
+		}
+	}
+
+	*envelope = env_buf[frames - 1];
+}
+
+static void ref_channel_peak(float *dst, float *const *samples,
+			     size_t channels, uint32_t frames)
+{
+	for (uint32_t i = 0; i < frames; i++) {
+		float level = 0.0f;
+
+		for (size_t c = 0; c < channels; c++) {
+			if (samples[c])
+				level = fmaxf(level, fabsf(samples[c][i]));
+		}
+
+		dst[i] = level;
+	}
+}
+
+static void ref_compress_gain(float *gain, const float *env, uint32_t frames,
+			      float slope, float threshold_db,
+			      float output_gain)
+{
+	for (uint32_t i = 0; i < frames; i++) {
+		const float env_db = mul_to_db(env[i]);
+		float g = slope * (threshold_db - env_db);
+		gain[i] = db_to_mul(fminf(0, g)) * output_gain;
+	}
+}
+
+static void ref_expand_gain_db(float *gain_db, const float *env,
+			       uint32_t frames, float slope,
+			       float threshold_db)
+{
+	for (uint32_t i = 0; i < frames; i++) {
+		float env_db = mul_to_db(env[i]);
+		gain_db[i] = threshold_db - env_db > 0.0f
+				     ? fmaxf(slope * (threshold_db - env_db),
+					     -60.0f)
+				     : 0.0f;
+	}
+}
+
+static void ref_db_to_gain(float *gain, const float *gain_db, uint32_t frames,
+			   float output_gain)
+{
+	for (uint32_t i = 0; i < frames; i++)
+		gain[i] = db_to_mul(fminf(0, gain_db[i])) * output_gain;
+}
+
+static void ref_apply_gain(float *const *samples, size_t channels,
+			   const float *gain, uint32_t frames)
+{
+	for (size_t c = 0; c < channels; c++) {
+		if (!samples[c])
+			continue;
+
+		for (uint32_t i = 0; i < frames; i++)
+			samples[c][i] *= gain[i];
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+
+static uint32_t rand_state = 0x12345678;
+
+static inline uint32_t rand_next(void)
+{
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 17;
+	rand_state ^= rand_state << 5;
+	return rand_state;
+}
+
+static inline float rand_unit(void)
+{
+	return (float)(rand_next() >> 8) / (float)(1 << 24);
+}
+
+/* random samples from -140 dBFS to +6 dBFS, with some silence */
+static void fill_samples(float *dst, uint32_t frames)
+{
+	for (uint32_t i = 0; i < frames; i++) {
+		float level = db_to_mul(-140.0f + 146.0f * rand_unit());
+		float sign = (rand_next() & 1) ? 1.0f : -1.0f;
+
+		dst[i] = (rand_next() % 61 == 0) ? 0.0f : sign * level;
+	}
+}
+
+static inline double gain_error_db(float a, float b)
+{
+	if (a == b)
+		return 0.0;
+	if (a <= 0.0f || b <= 0.0f)
+		return INFINITY;
+	return fabs((double)mul_to_db(a) - (double)mul_to_db(b));
+}
+
+static float *planes[CHANNELS];
+static float *ref_planes[CHANNELS];
+static float buf_a[MAX_FRAMES];
+static float buf_b[MAX_FRAMES];
+
+/* channel 2 is left out, like a muted or missing channel */
+static void fill_planes(uint32_t frames)
+{
+	for (size_t c = 0; c < CHANNELS; c++) {
+		if (!planes[c])
+			continue;
+
+		fill_samples(planes[c], frames);
+		memcpy(ref_planes[c], planes[c], frames * sizeof(float));
+	}
+}
+
+static bool check_envelope(void)
+{
+	size_t mismatches = 0;
+
+	for (uint32_t frames = 1; frames <= MAX_FRAMES; frames++) {
+		float env = 0.1f;
+		float ref_env = 0.1f;
+
+		fill_planes(frames);
+		dyn_peak_envelope(buf_a, planes, CHANNELS, frames, &env, 0.9f,
+				  0.999f);
+		ref_peak_envelope(buf_b, ref_planes, CHANNELS, frames,
+				  &ref_env, 0.9f, 0.999f);
+
+		if (memcmp(buf_a, buf_b, frames * sizeof(float)) != 0 ||
+		    env != ref_env)
+			mismatches++;
+	}
+
+	printf("peak envelope: %zu mismatching blocks\n", mismatches);
+	return mismatches == 0;
+}
+
+static bool check_channel_peak(void)
+{
+	size_t mismatches = 0;
+
+	for (uint32_t frames = 1; frames <= MAX_FRAMES; frames++) {
+		fill_planes(frames);
+		dyn_channel_peak(buf_a, planes, CHANNELS, frames);
+		ref_channel_peak(buf_b, ref_planes, CHANNELS, frames);
+
+		if (memcmp(buf_a, buf_b, frames * sizeof(float)) != 0)
+			mismatches++;
+	}
+
+	printf("channel peak: %zu mismatching blocks\n", mismatches);
+	return mismatches == 0;
+}
+
+static bool check_apply_gain(void)
+{
+	size_t mismatches = 0;
+
+	for (uint32_t frames = 1; frames <= MAX_FRAMES; frames++) {
+		fill_planes(frames);
+		for (uint32_t i = 0; i < frames; i++)
+			buf_a[i] = rand_unit();
+
+		dyn_apply_gain(planes, CHANNELS, buf_a, frames);
+		ref_apply_gain(ref_planes, CHANNELS, buf_a, frames);
+
+		for (size_t c = 0; c < CHANNELS; c++) {
+			if (planes[c] &&
+			    memcmp(planes[c], ref_planes[c],
+				   frames * sizeof(float)) != 0) {
+				mismatches++;
+				break;
+			}
+		}
+	}
+
+	printf("apply gain: %zu mismatching blocks\n", mismatches);
+	return mismatches == 0;
+}
+
+/* envelope levels from -160 dB to +20 dB, plus silence */
+static void fill_levels(float *dst, uint32_t frames)
+{
+	for (uint32_t i = 0; i < frames; i++)
+		dst[i] = db_to_mul(-160.0f + 180.0f * rand_unit());
+	dst[0] = 0.0f;
+}
+
+static bool check_compress_gain(void)
+{
+	static const float slopes[] = {0.5f, 0.75f, 0.95f, 1.0f};
+	static const float thresholds[] = {-60.0f, -30.0f, -6.0f, 0.0f};
+	static float levels[MAX_FRAMES];
+	double max_error = 0.0;
+
+	for (size_t s = 0; s < sizeof(slopes) / sizeof(slopes[0]); s++) {
+		for (size_t t = 0; t < 4; t++) {
+			uint32_t frames = MAX_FRAMES - (uint32_t)(s * 4 + t);
+
+			fill_levels(levels, frames);
+			dyn_compress_gain(buf_a, levels, frames, slopes[s],
+					  thresholds[t], 1.0f);
+			ref_compress_gain(buf_b, levels, frames, slopes[s],
+					  thresholds[t], 1.0f);
+
+			for (uint32_t i = 0; i < frames; i++) {
+				double e = gain_error_db(buf_a[i], buf_b[i]) /
+					   slopes[s];
+				if (e > max_error)
+					max_error = e;
+			}
+		}
+	}
+
+	printf("compress gain: max level error %g dB\n", max_error);
+	return max_error <= MAX_ERROR_DB;
+}
+
+static bool check_expand_gain_db(void)
+{
+	static const float slopes[] = {-1.0f, -3.0f, -9.0f};
+	static const float thresholds[] = {-60.0f, -40.0f, -20.0f, 0.0f};
+	static float levels[MAX_FRAMES];
+	double max_error = 0.0;
+
+	for (size_t s = 0; s < sizeof(slopes) / sizeof(slopes[0]); s++) {
+		for (size_t t = 0; t < 4; t++) {
+			uint32_t frames = MAX_FRAMES - (uint32_t)(s * 4 + t);
+
+			fill_levels(levels, frames);
+			dyn_expand_gain_db(buf_a, levels, frames, slopes[s],
+					   thresholds[t]);
+			ref_expand_gain_db(buf_b, levels, frames, slopes[s],
+					   thresholds[t]);
+
+			for (uint32_t i = 0; i < frames; i++) {
+				double e = fabs((double)buf_a[i] - buf_b[i]) /
+					   -slopes[s];
+				if (e > max_error)
+					max_error = e;
+			}
+		}
+	}
+
+	printf("expand gain: max level error %g dB\n", max_error);
+	return max_error <= MAX_ERROR_DB;
+}
+
+static bool check_db_to_gain(void)
+{
+	static float gain_db[MAX_FRAMES];
+	double max_error = 0.0;
+
+	/* the expander limits attenuation to 60 dB, sweep a bit past it and
+	 * include positive values, which must be clamped to unity */
+	for (uint32_t i = 0; i < MAX_FRAMES; i++)
+		gain_db[i] = -100.0f + 110.0f * i / (MAX_FRAMES - 1);
+
+	dyn_db_to_gain(buf_a, gain_db, MAX_FRAMES, 1.0f);
+	ref_db_to_gain(buf_b, gain_db, MAX_FRAMES, 1.0f);
+
+	for (uint32_t i = 0; i < MAX_FRAMES; i++) {
+		double e = gain_error_db(buf_a[i], buf_b[i]);
+		if (e > max_error)
+			max_error = e;
+	}
+
+	printf("dB to gain: max error %g dB\n", max_error);
+	return max_error <= MAX_ERROR_DB;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static volatile float sink;
+
+static inline double ns_per_frame(uint64_t start, int iterations)
+{
+	return (double)(os_gettime_ns() - start) / iterations / BENCH_FRAMES;
+}
+
+static void print_bench(const char *name, double scalar, double kernel)
+{
+	printf("%-14s %7.3f ns/frame -> %7.3f ns/frame (%.1fx)\n", name,
+	       scalar, kernel, scalar / kernel);
+}
+
+static void bench(int iterations)
+{
+	static float levels[BENCH_FRAMES];
+	float *stereo[2] = {planes[0], planes[1]};
+	float *ref_stereo[2] = {ref_planes[0], ref_planes[1]};
+	double scalar, kernel;
+	uint64_t start;
+	float env = 0.0f;
+
+	fill_planes(BENCH_FRAMES);
+	fill_levels(levels, BENCH_FRAMES);
+
+	printf("\n%d iterations of %d stereo frames\n", iterations,
+	       BENCH_FRAMES);
+
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++)
+		ref_peak_envelope(buf_b, ref_stereo, 2, BENCH_FRAMES, &env,
+				  0.9f, 0.999f);
+	scalar = ns_per_frame(start, iterations);
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++)
+		dyn_peak_envelope(buf_a, stereo, 2, BENCH_FRAMES, &env, 0.9f,
+				  0.999f);
+	kernel = ns_per_frame(start, iterations);
+	print_bench("peak envelope", scalar, kernel);
+
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++)
+		ref_channel_peak(buf_b, ref_stereo, 2, BENCH_FRAMES);
+	scalar = ns_per_frame(start, iterations);
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++)
+		dyn_channel_peak(buf_a, stereo, 2, BENCH_FRAMES);
+	kernel = ns_per_frame(start, iterations);
+	print_bench("channel peak", scalar, kernel);
+
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++)
+		ref_compress_gain(buf_b, levels, BENCH_FRAMES, 0.75f, -30.0f,
+				  1.0f);
+	scalar = ns_per_frame(start, iterations);
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++)
+		dyn_compress_gain(buf_a, levels, BENCH_FRAMES, 0.75f, -30.0f,
+				  1.0f);
+	kernel = ns_per_frame(start, iterations);
+	print_bench("compress gain", scalar, kernel);
+
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++)
+		ref_expand_gain_db(buf_b, levels, BENCH_FRAMES, -3.0f, -40.0f);
+	scalar = ns_per_frame(start, iterations);
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++)
+		dyn_expand_gain_db(buf_a, levels, BENCH_FRAMES, -3.0f, -40.0f);
+	kernel = ns_per_frame(start, iterations);
+	print_bench("expand gain", scalar, kernel);
+
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++)
+		ref_db_to_gain(buf_b, buf_b, BENCH_FRAMES, 1.0f);
+	scalar = ns_per_frame(start, iterations);
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++)
+		dyn_db_to_gain(buf_a, buf_a, BENCH_FRAMES, 1.0f);
+	kernel = ns_per_frame(start, iterations);
+	print_bench("dB to gain", scalar, kernel);
+
+	/* keep the gains close to unity so the samples don't run off to
+	 * zero or infinity over the iterations */
+	for (uint32_t i = 0; i < BENCH_FRAMES; i++)
+		buf_a[i] = (i & 1) ? 1.0001f : 0.9999f;
+
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++)
+		ref_apply_gain(ref_stereo, 2, buf_a, BENCH_FRAMES);
+	scalar = ns_per_frame(start, iterations);
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++)
+		dyn_apply_gain(stereo, 2, buf_a, BENCH_FRAMES);
+	kernel = ns_per_frame(start, iterations);
+	print_bench("apply gain", scalar, kernel);
+
+	sink = buf_a[0] + buf_b[0] + planes[0][0] + ref_planes[0][0] + env;
+}
+
+int main(int argc, char *argv[])
+{
+	int iterations = 10000;
+	bool success = true;
+
+	if (argc == 3 && strcmp(argv[1], "-n") == 0) {
+		iterations = atoi(argv[2]);
+		if (iterations < 1)
+			iterations = 1;
+	} else if (argc != 1) {
+		printf("usage: %s [-n iterations]\n", argv[0]);
+		return 1;
+	}
+
+	for (size_t c = 0; c < CHANNELS; c++) {
+		if (c == 2)
+			continue;
+		planes[c] = malloc(MAX_FRAMES * sizeof(float));
+		ref_planes[c] = malloc(MAX_FRAMES * sizeof(float));
+	}
+
+	success &= check_envelope();
+	success &= check_channel_peak();
+	success &= check_apply_gain();
+	success &= check_compress_gain();
+	success &= check_expand_gain_db();
+	success &= check_db_to_gain();
+
+	bench(iterations);
+
+	for (size_t c = 0; c < CHANNELS; c++) {
+		free(planes[c]);
+		free(ref_planes[c]);
+	}
+
+	printf("\n%s\n", success ? "all kernels within tolerance"
+				 : "MISMATCH: kernels out of tolerance");
+	return success ? 0 : 1;
+}
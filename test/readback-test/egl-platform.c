@@ -0,0 +1,166 @@
+/*
+ * Headless EGL platform for libobs-opengl, used in place of gl-x11.c so the
+ * OpenGL renderer can run without a display (for example under Mesa's
+ * software renderer).  Only offscreen rendering is supported, there are no
+ * swap chains.
+ */
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "gl-subsystem.h"
+
+struct gl_windowinfo {
+	int unused;
+};
+
+struct gl_platform {
+	EGLDisplay display;
+	EGLContext context;
+};
+
+static const EGLint ctx_attribs[] = {
+	EGL_CONTEXT_MAJOR_VERSION,
+	3,
+	EGL_CONTEXT_MINOR_VERSION,
+	3,
+	EGL_CONTEXT_OPENGL_PROFILE_MASK,
+	EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+	EGL_NONE,
+};
+
+struct gl_windowinfo *gl_windowinfo_create(const struct gs_init_data *info)
+{
+	UNUSED_PARAMETER(info);
+	return NULL;
+}
+
+void gl_windowinfo_destroy(struct gl_windowinfo *wi)
+{
+	UNUSED_PARAMETER(wi);
+}
+
+struct gl_platform *gl_platform_create(gs_device_t *device, uint32_t adapter)
+{
+	struct gl_platform *plat = bzalloc(sizeof(struct gl_platform));
+	EGLint major, minor;
+
+	UNUSED_PARAMETER(adapter);
+
+	plat->display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if (plat->display == EGL_NO_DISPLAY ||
+	    !eglInitialize(plat->display, &major, &minor)) {
+		blog(LOG_ERROR, "Failed to initialize EGL");
+		goto fail;
+	}
+
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		blog(LOG_ERROR, "EGL does not support desktop OpenGL");
+		goto fail;
+	}
+
+	/* no surface is needed, everything is rendered to textures */
+	plat->context = eglCreateContext(plat->display, EGL_NO_CONFIG_KHR,
+					 EGL_NO_CONTEXT, ctx_attribs);
+	if (plat->context == EGL_NO_CONTEXT) {
+		blog(LOG_ERROR, "Failed to create OpenGL 3.3 context: %#x",
+		     eglGetError());
+		goto fail;
+	}
+
+	if (!eglMakeCurrent(plat->display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+			    plat->context)) {
+		blog(LOG_ERROR, "Failed to make context current: %#x",
+		     eglGetError());
+		goto fail;
+	}
+
+	gladLoadGLLoader((GLADloadproc)eglGetProcAddress);
+	if (!GLAD_GL_VERSION_3_3) {
+		blog(LOG_ERROR, "Failed to load OpenGL entry functions.");
+		goto fail;
+	}
+
+	blog(LOG_INFO, "EGL %d.%d", major, minor);
+
+	device->plat = plat;
+	return plat;
+
+fail:
+	if (plat->context != EGL_NO_CONTEXT && plat->context)
+		eglDestroyContext(plat->display, plat->context);
+	if (plat->display != EGL_NO_DISPLAY)
+		eglTerminate(plat->display);
+	bfree(plat);
+	return NULL;
+}
+
+void gl_platform_destroy(struct gl_platform *plat)
+{
+	if (!plat)
+		return;
+
+	eglMakeCurrent(plat->display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+		       EGL_NO_CONTEXT);
+	eglDestroyContext(plat->display, plat->context);
+	eglTerminate(plat->display);
+	bfree(plat);
+}
+
+bool gl_platform_init_swapchain(struct gs_swap_chain *swap)
+{
+	UNUSED_PARAMETER(swap);
+	return false;
+}
+
+void gl_platform_cleanup_swapchain(struct gs_swap_chain *swap)
+{
+	UNUSED_PARAMETER(swap);
+}
+
+void device_enter_context(gs_device_t *device)
+{
+	if (!eglMakeCurrent(device->plat->display, EGL_NO_SURFACE,
+			    EGL_NO_SURFACE, device->plat->context))
+		blog(LOG_ERROR, "Failed to make context current.");
+}
+
+void device_leave_context(gs_device_t *device)
+{
+	if (!eglMakeCurrent(device->plat->display, EGL_NO_SURFACE,
+			    EGL_NO_SURFACE, EGL_NO_CONTEXT))
+		blog(LOG_ERROR, "Failed to reset current context.");
+}
+
+void *device_get_device_obj(gs_device_t *device)
+{
+	return device->plat->context;
+}
+
+void gl_getclientsize(const struct gs_swap_chain *swap, uint32_t *width,
+		      uint32_t *height)
+{
+	UNUSED_PARAMETER(swap);
+	*width = 0;
+	*height = 0;
+}
+
+void gl_clear_context(gs_device_t *device)
+{
+	device_leave_context(device);
+}
+
+void gl_update(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+void device_load_swapchain(gs_device_t *device, gs_swapchain_t *swap)
+{
+	device->cur_swap = swap;
+}
+
+void device_present(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
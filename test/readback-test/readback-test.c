@@ -0,0 +1,268 @@
+/*
+ * Runs the raw video readback of libobs-opengl on a headless EGL context,
+ * so it can run under Mesa's software renderer:
+ *
+ *   LIBGL_ALWAYS_SOFTWARE=1 EGL_PLATFORM=surfaceless readback-test
+ *
+ * The test is built with the libobs-opengl sources and an EGL platform in
+ * place of gl-x11.c, so textures are rendered, staged, polled and mapped by
+ * the real device_stage_texture, gs_stagesurface_ready and
+ * gs_stagesurface_map.  The frames are scheduled the way output_frame in
+ * obs-video.c schedules them (that code is static to libobs, so the
+ * scheduling is repeated here): the oldest staged frame is mapped once its
+ * surface is ready (otherwise it's deferred), and is only mapped
+ * unconditionally when its surface is about to be staged to again.  Every
+ * frame must be read back exactly once, in order, with the contents that
+ * were rendered to it.
+ *
+ * usage: readback-test [-n frames] [-d depth] [-s width height]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gl-subsystem.h"
+
+#define MAX_DEPTH 4
+
+struct surface {
+	gs_texture_t *texture;
+	gs_stagesurf_t *stagesurf;
+	bool copied;
+	uint32_t frame;
+};
+
+static uint32_t width = 1920;
+static uint32_t height = 1080;
+
+static uint32_t next_frame;
+static uint64_t frames_read;
+static uint64_t deferred;
+static uint64_t stalls;
+static uint64_t errors;
+
+/* ------------------------------------------------------------------------- */
+
+static bool surface_init(gs_device_t *device, struct surface *surf)
+{
+	surf->texture = device_texture_create(device, width, height, GS_RGBA,
+					      1, NULL, GS_RENDER_TARGET);
+	surf->stagesurf =
+		device_stagesurface_create(device, width, height, GS_RGBA);
+	return surf->texture && surf->stagesurf;
+}
+
+static void surface_free(struct surface *surf)
+{
+	gs_stagesurface_destroy(surf->stagesurf);
+	gs_texture_destroy(surf->texture);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline void frame_color(uint32_t frame, uint8_t color[4])
+{
+	color[0] = (uint8_t)frame;
+	color[1] = (uint8_t)(frame >> 8);
+	color[2] = (uint8_t)(frame >> 16);
+	color[3] = 0xFF;
+}
+
+static void render_frame(gs_device_t *device, struct surface *surf,
+			 uint32_t frame)
+{
+	struct vec4 clear_color;
+	uint8_t color[4];
+
+	frame_color(frame, color);
+	vec4_set(&clear_color, color[0] / 255.0f, color[1] / 255.0f,
+		 color[2] / 255.0f, color[3] / 255.0f);
+
+	device_set_render_target(device, surf->texture, NULL);
+	device_clear(device, GS_CLEAR_COLOR, &clear_color, 1.0f, 0);
+	device_set_render_target(device, NULL, NULL);
+}
+
+/* like stage_output_texture */
+static void stage_frame(gs_device_t *device, struct surface *surf,
+			uint32_t frame)
+{
+	device_stage_texture(device, surf->stagesurf, surf->texture);
+	surf->copied = true;
+	surf->frame = frame;
+}
+
+/* like map_frame, followed by unmap_last_surface */
+static void map_frame(struct surface *surf)
+{
+	uint8_t *data;
+	uint32_t linesize;
+	uint8_t color[4];
+
+	surf->copied = false;
+
+	if (!gs_stagesurface_map(surf->stagesurf, &data, &linesize)) {
+		fprintf(stderr, "Frame %u: gs_stagesurface_map failed\n",
+			surf->frame);
+		errors++;
+		goto next;
+	}
+
+	if (surf->frame != next_frame) {
+		fprintf(stderr, "Frame %u read back, expected %u\n",
+			surf->frame, next_frame);
+		errors++;
+	}
+
+	frame_color(surf->frame, color);
+	for (uint32_t y = 0; y < height; y++) {
+		const uint8_t *line = data + (size_t)y * linesize;
+
+		for (uint32_t x = 0; x < width; x++) {
+			const uint8_t *pixel = line + x * 4;
+			if (memcmp(pixel, color, 4) == 0)
+				continue;
+
+			fprintf(stderr,
+				"Frame %u: pixel %u,%u is %02x%02x%02x%02x, "
+				"expected %02x%02x%02x%02x\n",
+				surf->frame, x, y, pixel[0], pixel[1],
+				pixel[2], pixel[3], color[0], color[1],
+				color[2], color[3]);
+			errors++;
+			y = height;
+			break;
+		}
+	}
+
+	gs_stagesurface_unmap(surf->stagesurf);
+
+next:
+	next_frame = surf->frame + 1;
+	frames_read++;
+}
+
+/* like get_oldest_copied_texture */
+static int get_oldest_copied(struct surface *surfs, int depth, int cur)
+{
+	for (int i = 1; i < depth; i++) {
+		int idx = (cur + i) % depth;
+		if (surfs[idx].copied)
+			return idx;
+	}
+
+	return -1;
+}
+
+/* like output_frame */
+static void output_frame(gs_device_t *device, struct surface *surfs,
+			 int depth, int cur, uint32_t frame)
+{
+	struct surface *surf = &surfs[cur];
+
+	/* flush_oldest_frame */
+	if (surf->copied) {
+		if (!gs_stagesurface_ready(surf->stagesurf))
+			stalls++;
+		map_frame(surf);
+	}
+
+	render_frame(device, surf, frame);
+	stage_frame(device, surf, frame);
+
+	/* download_frame */
+	int oldest = get_oldest_copied(surfs, depth, cur);
+	if (oldest != -1) {
+		if (gs_stagesurface_ready(surfs[oldest].stagesurf))
+			map_frame(&surfs[oldest]);
+		else
+			deferred++;
+	}
+
+	device_flush(device);
+}
+
+/* ------------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+	struct surface surfs[MAX_DEPTH] = {0};
+	gs_device_t *device;
+	uint32_t frames = 300;
+	int depth = 2;
+	int cur = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			frames = (uint32_t)strtoul(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+			depth = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-s") == 0 && i + 2 < argc) {
+			width = (uint32_t)strtoul(argv[++i], NULL, 10);
+			height = (uint32_t)strtoul(argv[++i], NULL, 10);
+		} else {
+			fprintf(stderr,
+				"usage: %s [-n frames] [-d depth] "
+				"[-s width height]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+
+	if (depth < 2 || depth > MAX_DEPTH || !frames || !width || !height) {
+		fprintf(stderr, "Depth must be 2 to %d, frames and size must "
+				"not be 0\n",
+			MAX_DEPTH);
+		return 1;
+	}
+
+	if (device_create(&device, 0) != GS_SUCCESS) {
+		fprintf(stderr, "Failed to create the OpenGL device\n");
+		return 1;
+	}
+
+	device_enter_context(device);
+
+	for (int i = 0; i < depth; i++) {
+		if (!surface_init(device, &surfs[i])) {
+			fprintf(stderr, "Failed to create surfaces\n");
+			return 1;
+		}
+	}
+
+	for (uint32_t frame = 0; frame < frames; frame++) {
+		output_frame(device, surfs, depth, cur, frame);
+		if (++cur == depth)
+			cur = 0;
+	}
+
+	/* read back whatever is still staged, oldest first */
+	for (int i = 0; i < depth; i++) {
+		struct surface *surf = &surfs[(cur + i) % depth];
+		if (surf->copied) {
+			if (!gs_stagesurface_ready(surf->stagesurf))
+				stalls++;
+			map_frame(surf);
+		}
+	}
+
+	if (frames_read != frames) {
+		fprintf(stderr, "%llu of %u frames read back\n",
+			(unsigned long long)frames_read, frames);
+		errors++;
+	}
+
+	printf("%u frames at %ux%u, depth %d: %llu read back, %llu deferred "
+	       "until ready, %llu stalls, %llu errors\n",
+	       frames, width, height, depth, (unsigned long long)frames_read,
+	       (unsigned long long)deferred, (unsigned long long)stalls,
+	       (unsigned long long)errors);
+
+	for (int i = 0; i < depth; i++)
+		surface_free(&surfs[i]);
+
+	device_destroy(device);
+
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,153 @@
+#include <util/threading.h>
+#include <util/platform.h>
+#include <media-io/video-frame.h>
+#include <obs.h>
+
+/* Pushes 1080p frames through every async video format in turn.  The time
+ * the graphics thread spends uploading/converting each format shows up in
+ * the profiler as async_upload(...)/async_convert(...) entries. */
+
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+#define FRAMES_PER_FORMAT 600
+
+static const enum video_format bench_formats[] = {
+	VIDEO_FORMAT_BGRA, VIDEO_FORMAT_BGRX, VIDEO_FORMAT_RGBA,
+	VIDEO_FORMAT_I420, VIDEO_FORMAT_NV12, VIDEO_FORMAT_YVYU,
+	VIDEO_FORMAT_YUY2, VIDEO_FORMAT_UYVY, VIDEO_FORMAT_Y800,
+	VIDEO_FORMAT_I444, VIDEO_FORMAT_BGR3, VIDEO_FORMAT_I422,
+	VIDEO_FORMAT_I40A, VIDEO_FORMAT_I42A, VIDEO_FORMAT_YUVA,
+	VIDEO_FORMAT_AYUV,
+};
+
+#define NUM_BENCH_FORMATS \
+	(sizeof(bench_formats) / sizeof(bench_formats[0]))
+
+struct async_format_bench {
+	obs_source_t *source;
+	os_event_t *stop_signal;
+	pthread_t thread;
+	bool initialized;
+};
+
+static const char *afb_getname(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "Async Video Format Benchmark (Test)";
+}
+
+static void afb_destroy(void *data)
+{
+	struct async_format_bench *afb = data;
+
+	if (afb->initialized) {
+		os_event_signal(afb->stop_signal);
+		pthread_join(afb->thread, NULL);
+	}
+
+	os_event_destroy(afb->stop_signal);
+	bfree(afb);
+}
+
+static void init_frame(struct obs_source_frame *frame,
+		       struct video_frame *planes, enum video_format format,
+		       bool full_range)
+{
+	enum video_range_type range = full_range ? VIDEO_RANGE_FULL
+						 : VIDEO_RANGE_PARTIAL;
+
+	video_frame_free(planes);
+	video_frame_init(planes, format, BENCH_WIDTH, BENCH_HEIGHT);
+
+	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+		frame->data[i] = planes->data[i];
+		frame->linesize[i] = planes->linesize[i];
+	}
+
+	frame->width = BENCH_WIDTH;
+	frame->height = BENCH_HEIGHT;
+	frame->format = format;
+	frame->full_range = full_range;
+	video_format_get_parameters(VIDEO_CS_709, range, frame->color_matrix,
+				    frame->color_range_min,
+				    frame->color_range_max);
+}
+
+static void *video_thread(void *data)
+{
+	struct async_format_bench *afb = data;
+	struct obs_source_frame frame = {0};
+	struct video_frame planes = {0};
+	uint64_t interval = video_output_get_frame_time(obs_get_video());
+	uint64_t cur_time = os_gettime_ns();
+	size_t format_idx = 0;
+	bool full_range = true;
+	uint32_t count = 0;
+	uint8_t val = 0;
+
+	init_frame(&frame, &planes, bench_formats[0], full_range);
+	blog(LOG_INFO, "async format benchmark: %s (%s range)",
+	     get_video_format_name(frame.format),
+	     full_range ? "full" : "partial");
+
+	while (os_event_try(afb->stop_signal) == EAGAIN) {
+		/* touch the frame so every upload has new data */
+		for (size_t i = 0; i < MAX_AV_PLANES && frame.data[i]; i++)
+			frame.data[i][0] = val;
+		val++;
+
+		frame.timestamp = cur_time;
+		obs_source_output_video(afb->source, &frame);
+
+		if (++count == FRAMES_PER_FORMAT) {
+			count = 0;
+
+			if (++format_idx == NUM_BENCH_FORMATS) {
+				format_idx = 0;
+				full_range = !full_range;
+			}
+
+			init_frame(&frame, &planes, bench_formats[format_idx],
+				   full_range);
+			blog(LOG_INFO, "async format benchmark: %s (%s range)",
+			     get_video_format_name(frame.format),
+			     full_range ? "full" : "partial");
+		}
+
+		os_sleepto_ns(cur_time += interval);
+	}
+
+	video_frame_free(&planes);
+	return NULL;
+}
+
+static void *afb_create(obs_data_t *settings, obs_source_t *source)
+{
+	struct async_format_bench *afb =
+		bzalloc(sizeof(struct async_format_bench));
+	afb->source = source;
+
+	if (os_event_init(&afb->stop_signal, OS_EVENT_TYPE_MANUAL) != 0) {
+		afb_destroy(afb);
+		return NULL;
+	}
+
+	if (pthread_create(&afb->thread, NULL, video_thread, afb) != 0) {
+		afb_destroy(afb);
+		return NULL;
+	}
+
+	afb->initialized = true;
+
+	UNUSED_PARAMETER(settings);
+	return afb;
+}
+
+struct obs_source_info async_format_bench = {
+	.id = "async_format_bench",
+	.type = OBS_SOURCE_TYPE_INPUT,
+	.output_flags = OBS_SOURCE_ASYNC_VIDEO,
+	.get_name = afb_getname,
+	.create = afb_create,
+	.destroy = afb_destroy,
+};